@@ -0,0 +1,218 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Measure the throughput of persisting blobs and populating resource rundirs.
+ *
+ * A buffer of the requested size is written to a file through stdio, as blob
+ * persistence used to, and persisted with `vaccel_blob_from_buf()`. The file
+ * is then copied to resource rundirs with `vaccel_resource_init_from_blobs()`,
+ * once as a user file, which is copied, and once as a file owned by vAccel,
+ * which is hardlinked. Both are mapped read-only and shared, as files are only
+ * copied for such mappings. The files stay in the page cache between iterations,
+ * so this measures the copy paths rather than the storage.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vaccel.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_SIZE_MB 1024
+#define DEFAULT_ITERATIONS 3
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void print_throughput(const char *name, size_t size,
+			     size_t nr_iterations, uint64_t total)
+{
+	printf("%-12s %8.2f GB/s\n", name,
+	       (double)size * (double)nr_iterations / (double)total);
+}
+
+static int bench_stdio(const char *path, const uint8_t *buf, size_t size,
+		       uint64_t *elapsed)
+{
+	uint64_t start = now_ns();
+
+	FILE *fp = fopen(path, "wb");
+	if (!fp)
+		return VACCEL_EIO;
+
+	size_t written = fwrite(buf, 1, size, fp);
+	if (fclose(fp) || written != size) {
+		unlink(path);
+		return VACCEL_EIO;
+	}
+
+	*elapsed += now_ns() - start;
+
+	return unlink(path) ? VACCEL_EIO : VACCEL_OK;
+}
+
+static int bench_persist(const char *dir, const uint8_t *buf, size_t size,
+			 uint64_t *elapsed)
+{
+	struct vaccel_blob *blob;
+
+	uint64_t start = now_ns();
+	int ret = vaccel_blob_from_buf(&blob, buf, size, false, "blob", dir,
+				       true);
+	*elapsed += now_ns() - start;
+	if (ret)
+		return ret;
+
+	return vaccel_blob_delete(blob);
+}
+
+static int bench_rundir(const struct vaccel_blob *blob, uint64_t *elapsed)
+{
+	struct vaccel_resource res;
+
+	uint64_t start = now_ns();
+	int ret = vaccel_resource_init_from_blobs(&res, &blob, 1,
+						  VACCEL_RESOURCE_DATA);
+	*elapsed += now_ns() - start;
+	if (ret)
+		return ret;
+
+	return vaccel_resource_release(&res);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+
+	if (argc > 3) {
+		fprintf(stderr, "Usage: %s [size_mb] [iterations]\n", argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t size_mb = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+					    DEFAULT_SIZE_MB;
+	const size_t nr_iterations = (argc > 2) ?
+					     strtoul(argv[2], NULL, 10) :
+					     DEFAULT_ITERATIONS;
+	if (!size_mb || !nr_iterations) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	const size_t size = size_mb << 20;
+	uint8_t *buf = (uint8_t *)malloc(size);
+	if (!buf) {
+		fprintf(stderr, "Could not allocate %zu MB\n", size_mb);
+		return VACCEL_ENOMEM;
+	}
+	memset(buf, 0xab, size);
+
+	/* Resource rundirs are created under the vAccel rundir, so keep the
+	 * files on the same filesystem */
+	char dir[PATH_MAX];
+	ret = path_init_from_parts(dir, PATH_MAX, vaccel_rundir(),
+				   "blob-persist-XXXXXX", NULL);
+	if (ret || !mkdtemp(dir)) {
+		fprintf(stderr, "Could not create directory\n");
+		ret = VACCEL_EIO;
+		goto free_buf;
+	}
+
+	char path[PATH_MAX];
+	ret = path_init_from_parts(path, PATH_MAX, dir, "stdio", NULL);
+	if (ret) {
+		fprintf(stderr, "Could not generate path\n");
+		goto remove_dir;
+	}
+
+	uint64_t stdio_total = 0;
+	uint64_t persist_total = 0;
+	for (size_t i = 0; i < nr_iterations; i++) {
+		ret = bench_stdio(path, buf, size, &stdio_total);
+		if (ret) {
+			fprintf(stderr, "Could not write file with stdio\n");
+			goto remove_dir;
+		}
+
+		ret = bench_persist(dir, buf, size, &persist_total);
+		if (ret) {
+			fprintf(stderr, "Could not persist blob\n");
+			goto remove_dir;
+		}
+	}
+
+	/* The same file, seen as a user file and as one owned by vAccel */
+	struct vaccel_blob *owned_blob;
+	ret = vaccel_blob_from_buf(&owned_blob, buf, size, false, "blob", NULL,
+				   false);
+	if (ret) {
+		fprintf(stderr, "Could not create blob\n");
+		goto remove_dir;
+	}
+
+	owned_blob->map_flags = VACCEL_BLOB_MAP_SHARED;
+	ret = vaccel_blob_persist(owned_blob, dir, "blob", true);
+	if (ret) {
+		fprintf(stderr, "Could not persist blob\n");
+		goto delete_owned_blob;
+	}
+
+	struct vaccel_blob *user_blob;
+	ret = vaccel_blob_new(&user_blob, owned_blob->path);
+	if (ret) {
+		fprintf(stderr, "Could not create blob\n");
+		goto delete_owned_blob;
+	}
+
+	user_blob->map_flags = VACCEL_BLOB_MAP_SHARED;
+	ret = vaccel_blob_read(user_blob);
+	if (ret) {
+		fprintf(stderr, "Could not read blob\n");
+		goto delete_user_blob;
+	}
+
+	uint64_t copy_total = 0;
+	uint64_t link_total = 0;
+	for (size_t i = 0; i < nr_iterations; i++) {
+		ret = bench_rundir(user_blob, &copy_total);
+		if (ret) {
+			fprintf(stderr, "Could not copy blob to rundir\n");
+			goto delete_user_blob;
+		}
+
+		ret = bench_rundir(owned_blob, &link_total);
+		if (ret) {
+			fprintf(stderr, "Could not link blob to rundir\n");
+			goto delete_user_blob;
+		}
+	}
+
+	printf("%zu MB blobs, %zu iterations:\n", size_mb, nr_iterations);
+	print_throughput("stdio", size, nr_iterations, stdio_total);
+	print_throughput("persist", size, nr_iterations, persist_total);
+	print_throughput("rundir copy", size, nr_iterations, copy_total);
+	print_throughput("rundir link", size, nr_iterations, link_total);
+
+delete_user_blob:
+	if (vaccel_blob_delete(user_blob))
+		fprintf(stderr, "Could not delete blob\n");
+delete_owned_blob:
+	if (vaccel_blob_delete(owned_blob))
+		fprintf(stderr, "Could not delete blob\n");
+remove_dir:
+	rmdir(dir);
+free_buf:
+	free(buf);
+
+	return ret;
+}
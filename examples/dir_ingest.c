@@ -0,0 +1,148 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Measure registration of a directory resource with many files.
+ *
+ * A synthetic directory is created under a temporary path and registered
+ * repeatedly with a session. Registration creates a blob per file, which is
+ * what makes directory resources, like TF SavedModels with many variable
+ * shards, slow to register.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vaccel.h"
+#include <limits.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_FILES 1000
+#define DEFAULT_ITERATIONS 20
+#define FILE_SIZE 4096
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int create_files(const char *dir, size_t nr_files)
+{
+	char buf[FILE_SIZE];
+	memset(buf, 0xab, sizeof(buf));
+
+	for (size_t i = 0; i < nr_files; i++) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/shard-%05zu", dir, i);
+
+		FILE *fp = fopen(path, "wb");
+		if (!fp)
+			return VACCEL_EIO;
+
+		size_t written = fwrite(buf, 1, sizeof(buf), fp);
+		fclose(fp);
+		if (written != sizeof(buf))
+			return VACCEL_EIO;
+	}
+
+	return VACCEL_OK;
+}
+
+static void remove_files(const char *dir, size_t nr_files)
+{
+	for (size_t i = 0; i < nr_files; i++) {
+		char path[PATH_MAX];
+		snprintf(path, sizeof(path), "%s/shard-%05zu", dir, i);
+		unlink(path);
+	}
+	rmdir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+	struct vaccel_session sess;
+
+	if (argc > 3) {
+		fprintf(stderr, "Usage: %s [files] [iterations]\n", argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t nr_files = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+					     DEFAULT_FILES;
+	const size_t nr_iterations = (argc > 2) ?
+					     strtoul(argv[2], NULL, 10) :
+					     DEFAULT_ITERATIONS;
+	if (!nr_files || !nr_iterations) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	char dir[] = "/tmp/vaccel-dir-ingest-XXXXXX";
+	if (!mkdtemp(dir)) {
+		fprintf(stderr, "Could not create directory\n");
+		return VACCEL_EIO;
+	}
+
+	ret = create_files(dir, nr_files);
+	if (ret) {
+		fprintf(stderr, "Could not create files\n");
+		goto remove_dir;
+	}
+
+	ret = vaccel_session_init(&sess, 0);
+	if (ret) {
+		fprintf(stderr, "Could not initialize session\n");
+		goto remove_dir;
+	}
+
+	uint64_t total = 0;
+	for (size_t i = 0; i < nr_iterations; i++) {
+		struct vaccel_resource res;
+
+		ret = vaccel_resource_init(&res, dir, VACCEL_RESOURCE_DATA);
+		if (ret) {
+			fprintf(stderr, "Could not initialize resource\n");
+			goto release_session;
+		}
+
+		uint64_t start = now_ns();
+		ret = vaccel_resource_register(&res, &sess);
+		total += now_ns() - start;
+		if (ret) {
+			fprintf(stderr, "Could not register resource\n");
+			vaccel_resource_release(&res);
+			goto release_session;
+		}
+
+		if (res.nr_blobs != nr_files) {
+			fprintf(stderr, "Expected %zu blobs, got %zu\n",
+				nr_files, res.nr_blobs);
+			ret = VACCEL_EINVAL;
+		}
+
+		if (vaccel_resource_unregister(&res, &sess))
+			fprintf(stderr, "Could not unregister resource\n");
+		if (vaccel_resource_release(&res))
+			fprintf(stderr, "Could not release resource\n");
+		if (ret)
+			goto release_session;
+	}
+
+	printf("%zu files: %.2f ms/registration\n", nr_files,
+	       (double)total / 1e6 / (double)nr_iterations);
+
+release_session:
+	if (vaccel_session_release(&sess))
+		fprintf(stderr, "Could not release session\n");
+remove_dir:
+	remove_files(dir, nr_files);
+
+	return ret;
+}
@@ -0,0 +1,167 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Measure op dispatch throughput while scaling the number of threads.
+ *
+ * Every iteration looks up a plugin for the session hint and dispatches a noop
+ * to the session, so the benchmark exercises both plugin lookup and op func
+ * resolution.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "plugin.h"
+#include "vaccel.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_ITERATIONS 100000
+#define DEFAULT_MAX_THREADS 64
+
+struct dispatch_thread {
+	pthread_t thread;
+	size_t iterations;
+	pthread_barrier_t *barrier;
+	const bool *abort;
+	int ret;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static void *dispatch_worker(void *arg)
+{
+	struct dispatch_thread *t = arg;
+	struct vaccel_session sess;
+
+	t->ret = vaccel_session_init(&sess, 0);
+	if (t->ret)
+		fprintf(stderr, "Could not initialize session\n");
+	const bool initialized = !t->ret;
+
+	/* Wait for all threads to be ready */
+	pthread_barrier_wait(t->barrier);
+	pthread_barrier_wait(t->barrier);
+
+	for (size_t i = 0; i < t->iterations && !t->ret && !*t->abort; i++) {
+		if (!plugin_find(sess.hint)) {
+			fprintf(stderr, "Could not find plugin\n");
+			t->ret = VACCEL_ENOTSUP;
+			break;
+		}
+
+		t->ret = vaccel_noop(&sess);
+		if (t->ret) {
+			fprintf(stderr, "Could not run op: %d\n", t->ret);
+			break;
+		}
+	}
+
+	pthread_barrier_wait(t->barrier);
+
+	if (initialized && vaccel_session_release(&sess))
+		fprintf(stderr, "Could not release session\n");
+
+	return NULL;
+}
+
+static int run_dispatch(size_t nr_threads, size_t iterations)
+{
+	int ret = VACCEL_OK;
+	pthread_barrier_t barrier;
+	bool abort = false;
+
+	struct dispatch_thread *threads = calloc(nr_threads, sizeof(*threads));
+	if (!threads)
+		return VACCEL_ENOMEM;
+
+	/* The main thread takes part in the barrier to time the run */
+	pthread_barrier_init(&barrier, NULL, (unsigned int)nr_threads + 1);
+
+	size_t started = 0;
+	for (; started < nr_threads; started++) {
+		threads[started].iterations = iterations;
+		threads[started].barrier = &barrier;
+		threads[started].abort = &abort;
+		if (pthread_create(&threads[started].thread, NULL,
+				   dispatch_worker, &threads[started]))
+			break;
+	}
+	if (started != nr_threads) {
+		/* Can't release the barrier without all threads; bail out */
+		fprintf(stderr, "Could not create threads\n");
+		exit(EXIT_FAILURE);
+	}
+
+	/* Sessions initialized */
+	pthread_barrier_wait(&barrier);
+	for (size_t i = 0; i < nr_threads; i++) {
+		if (threads[i].ret)
+			ret = threads[i].ret;
+	}
+
+	abort = (ret != VACCEL_OK);
+
+	/* Start and wait for all threads to finish */
+	uint64_t start = now_ns();
+	pthread_barrier_wait(&barrier);
+	pthread_barrier_wait(&barrier);
+	uint64_t elapsed = now_ns() - start;
+
+	for (size_t i = 0; i < nr_threads; i++) {
+		pthread_join(threads[i].thread, NULL);
+		if (threads[i].ret)
+			ret = threads[i].ret;
+	}
+
+	if (!ret) {
+		double total = (double)nr_threads * (double)iterations;
+		double secs = (double)elapsed / 1e9;
+		printf("%3zu threads: %12.0f dispatches/s (%.1f ns/dispatch/thread)\n",
+		       nr_threads, total / secs,
+		       (double)elapsed / (double)iterations);
+	}
+
+	pthread_barrier_destroy(&barrier);
+	free(threads);
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = VACCEL_OK;
+
+	if (argc > 3) {
+		fprintf(stderr, "Usage: %s [iterations] [max_threads]\n",
+			argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t iterations = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+					       DEFAULT_ITERATIONS;
+	const size_t max_threads = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+						DEFAULT_MAX_THREADS;
+	if (!iterations || !max_threads) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	for (size_t n = 1; n <= max_threads; n *= 2) {
+		ret = run_dispatch(n, iterations);
+		if (ret)
+			break;
+	}
+
+	return ret;
+}
@@ -0,0 +1,169 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Keep many exec ops in flight from a single thread using asynchronous
+ * submission and a completion queue.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vaccel.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_OPS 1000
+#define DEFAULT_QUEUE_DEPTH 100
+#define BATCH 64
+
+enum { INPUT_VAL = 10 };
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+	struct vaccel_session sess;
+	struct vaccel_cq cq;
+	struct vaccel_completion completions[BATCH];
+	int32_t input = INPUT_VAL;
+	char *func = "mytestfunc";
+
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "Usage: %s <lib_file> [ops] [queue_depth]\n",
+			argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t nr_ops = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+					   DEFAULT_OPS;
+	const size_t depth = (argc > 3) ? strtoul(argv[3], NULL, 10) :
+					  DEFAULT_QUEUE_DEPTH;
+	if (!nr_ops || !depth) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	/* Every op in flight needs its own output */
+	int32_t *outputs = calloc(nr_ops, sizeof(*outputs));
+	struct vaccel_arg *writes = calloc(nr_ops, sizeof(*writes));
+	if (!outputs || !writes) {
+		free(outputs);
+		free(writes);
+		return VACCEL_ENOMEM;
+	}
+
+	ret = vaccel_session_init(&sess, 0);
+	if (ret) {
+		fprintf(stderr, "Could not initialize session\n");
+		goto free_bufs;
+	}
+
+	printf("Initialized session with id: %" PRId64 "\n", sess.id);
+
+	ret = vaccel_cq_init(&cq);
+	if (ret) {
+		fprintf(stderr, "Could not initialize completion queue\n");
+		goto release_session;
+	}
+
+	/* The read args are shared by all ops */
+	struct vaccel_arg_array read_args;
+	ret = vaccel_arg_array_init(&read_args, 4);
+	if (ret) {
+		fprintf(stderr, "Could not initialize read args array\n");
+		goto release_cq;
+	}
+
+	uint8_t op_type = (uint8_t)VACCEL_OP_EXEC;
+	if (vaccel_arg_array_add_uint8(&read_args, &op_type) ||
+	    vaccel_arg_array_add_string(&read_args, argv[1]) ||
+	    vaccel_arg_array_add_string(&read_args, func) ||
+	    vaccel_arg_array_add_int32(&read_args, &input)) {
+		fprintf(stderr, "Failed to pack read args\n");
+		ret = VACCEL_EINVAL;
+		goto release_read_args_array;
+	}
+
+	size_t submitted = 0;
+	size_t completed = 0;
+	size_t failed = 0;
+	size_t max_inflight = 0;
+	uint64_t start = now_ns();
+
+	while (completed < nr_ops) {
+		/* Keep the queue full */
+		while (submitted < nr_ops && submitted - completed < depth) {
+			size_t i = submitted;
+
+			ret = vaccel_arg_init_from_buf(&writes[i], &outputs[i],
+						       sizeof(outputs[i]),
+						       VACCEL_ARG_INT32, 0);
+			if (!ret)
+				ret = vaccel_op_submit(&sess, &cq,
+						       read_args.args,
+						       (int)read_args.count,
+						       &writes[i], 1,
+						       &outputs[i]);
+			if (ret) {
+				fprintf(stderr, "Could not submit op: %d\n",
+					ret);
+				goto wait_inflight;
+			}
+			submitted++;
+		}
+		if (submitted - completed > max_inflight)
+			max_inflight = submitted - completed;
+
+		size_t nr;
+		ret = vaccel_cq_wait(&cq, completions, BATCH, &nr, -1);
+		if (ret) {
+			fprintf(stderr, "Could not wait for ops: %d\n", ret);
+			goto wait_inflight;
+		}
+		for (size_t i = 0; i < nr; i++) {
+			if (completions[i].ret)
+				failed++;
+		}
+		completed += nr;
+	}
+
+	uint64_t elapsed = now_ns() - start;
+	printf("%zu ops (%zu failed), up to %zu in flight: %.0f ops/s\n",
+	       completed, failed, max_inflight,
+	       (double)completed / ((double)elapsed / 1e9));
+	if (failed)
+		ret = VACCEL_EIO;
+
+wait_inflight:
+	/* Ops must complete before their args and the queue are released */
+	while (submitted > completed) {
+		size_t nr;
+		if (vaccel_cq_wait(&cq, completions, BATCH, &nr, -1))
+			break;
+		completed += nr;
+	}
+
+release_read_args_array:
+	if (vaccel_arg_array_release(&read_args))
+		fprintf(stderr, "Could not release read args array\n");
+release_cq:
+	if (vaccel_cq_release(&cq))
+		fprintf(stderr, "Could not release completion queue\n");
+release_session:
+	if (vaccel_session_release(&sess))
+		fprintf(stderr, "Could not release session\n");
+free_bufs:
+	free(outputs);
+	free(writes);
+
+	return ret;
+}
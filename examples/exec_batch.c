@@ -0,0 +1,145 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Compare the throughput of dispatching exec ops one by one with
+ * `vaccel_genop()` against dispatching them in batches with
+ * `vaccel_genop_batch()`.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vaccel.h"
+#include <inttypes.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_OPS 100000
+#define DEFAULT_BATCH_SIZE 64
+
+enum { INPUT_VAL = 10 };
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static double ops_per_sec(size_t nr_ops, uint64_t elapsed)
+{
+	return (double)nr_ops / ((double)elapsed / 1e9);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+	struct vaccel_session sess;
+	int32_t input = INPUT_VAL;
+	char *func = "mytestfunc";
+
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "Usage: %s <lib_file> [ops] [batch_size]\n",
+			argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t nr_ops = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+					   DEFAULT_OPS;
+	const size_t batch_size = (argc > 3) ? strtoul(argv[3], NULL, 10) :
+					       DEFAULT_BATCH_SIZE;
+	if (!nr_ops || !batch_size) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	int32_t *outputs = calloc(batch_size, sizeof(*outputs));
+	struct vaccel_arg *writes = calloc(batch_size, sizeof(*writes));
+	struct vaccel_genop_req *reqs = calloc(batch_size, sizeof(*reqs));
+	if (!outputs || !writes || !reqs) {
+		ret = VACCEL_ENOMEM;
+		goto free_bufs;
+	}
+
+	ret = vaccel_session_init(&sess, 0);
+	if (ret) {
+		fprintf(stderr, "Could not initialize session\n");
+		goto free_bufs;
+	}
+
+	printf("Initialized session with id: %" PRId64 "\n", sess.id);
+
+	struct vaccel_arg_array read_args;
+	ret = vaccel_arg_array_init(&read_args, 4);
+	if (ret) {
+		fprintf(stderr, "Could not initialize read args array\n");
+		goto release_session;
+	}
+
+	uint8_t op_type = (uint8_t)VACCEL_OP_EXEC;
+	if (vaccel_arg_array_add_uint8(&read_args, &op_type) ||
+	    vaccel_arg_array_add_string(&read_args, argv[1]) ||
+	    vaccel_arg_array_add_string(&read_args, func) ||
+	    vaccel_arg_array_add_int32(&read_args, &input)) {
+		fprintf(stderr, "Failed to pack read args\n");
+		ret = VACCEL_EINVAL;
+		goto release_read_args_array;
+	}
+
+	for (size_t i = 0; i < batch_size; i++) {
+		ret = vaccel_arg_init_from_buf(&writes[i], &outputs[i],
+					       sizeof(outputs[i]),
+					       VACCEL_ARG_INT32, 0);
+		if (ret) {
+			fprintf(stderr, "Failed to pack output arg\n");
+			goto release_read_args_array;
+		}
+		reqs[i].read = read_args.args;
+		reqs[i].nr_read = (int)read_args.count;
+		reqs[i].write = &writes[i];
+		reqs[i].nr_write = 1;
+	}
+
+	uint64_t start = now_ns();
+	for (size_t i = 0; i < nr_ops; i++) {
+		ret = vaccel_genop(&sess, read_args.args, (int)read_args.count,
+				   &writes[i % batch_size], 1);
+		if (ret) {
+			fprintf(stderr, "Could not run op: %d\n", ret);
+			goto release_read_args_array;
+		}
+	}
+	const uint64_t single = now_ns() - start;
+
+	start = now_ns();
+	for (size_t done = 0; done < nr_ops; done += batch_size) {
+		size_t nr = (nr_ops - done < batch_size) ? nr_ops - done :
+							   batch_size;
+		ret = vaccel_genop_batch(&sess, reqs, nr);
+		if (ret) {
+			fprintf(stderr, "Could not run batch: %d\n", ret);
+			goto release_read_args_array;
+		}
+	}
+	const uint64_t batched = now_ns() - start;
+
+	printf("%zu ops, batch size %zu\n", nr_ops, batch_size);
+	printf("  single:  %.0f ops/s\n", ops_per_sec(nr_ops, single));
+	printf("  batched: %.0f ops/s (%.2fx)\n", ops_per_sec(nr_ops, batched),
+	       (double)single / (double)batched);
+
+release_read_args_array:
+	if (vaccel_arg_array_release(&read_args))
+		fprintf(stderr, "Could not release read args array\n");
+release_session:
+	if (vaccel_session_release(&sess))
+		fprintf(stderr, "Could not release session\n");
+free_bufs:
+	free(outputs);
+	free(writes);
+	free(reqs);
+
+	return ret;
+}
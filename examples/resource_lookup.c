@@ -0,0 +1,90 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Measure resource lookup by id with many live resources.
+ *
+ * Lookups go through `vaccel_resource_get_by_id()`, the path taken by every
+ * `VACCEL_OP_EXEC_WITH_RESOURCE` genop, and should cost the same regardless
+ * of how many resources exist.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vaccel.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_RESOURCES 2000
+#define DEFAULT_LOOKUPS 10000000
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = VACCEL_OK;
+
+	if (argc < 2 || argc > 4) {
+		fprintf(stderr, "Usage: %s <file> [resources] [lookups]\n",
+			argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t nr_resources = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+						 DEFAULT_RESOURCES;
+	const size_t nr_lookups = (argc > 3) ? strtoul(argv[3], NULL, 10) :
+					       DEFAULT_LOOKUPS;
+	if (!nr_resources || !nr_lookups) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	struct vaccel_resource *res = calloc(nr_resources, sizeof(*res));
+	if (!res)
+		return VACCEL_ENOMEM;
+
+	size_t nr_live = 0;
+	for (; nr_live < nr_resources; nr_live++) {
+		ret = vaccel_resource_init(&res[nr_live], argv[1],
+					   VACCEL_RESOURCE_DATA);
+		if (ret) {
+			fprintf(stderr, "Could not initialize resource %zu\n",
+				nr_live);
+			goto release_resources;
+		}
+	}
+
+	/* Look the resources up in a scattered order */
+	uint64_t start = now_ns();
+	for (size_t i = 0; i < nr_lookups; i++) {
+		struct vaccel_resource *r;
+		size_t idx = (i * 7919) % nr_live;
+
+		ret = vaccel_resource_get_by_id(&r, res[idx].id);
+		if (ret || r != &res[idx]) {
+			fprintf(stderr, "Lookup of resource %zu failed\n", idx);
+			ret = ret ? ret : VACCEL_EINVAL;
+			goto release_resources;
+		}
+	}
+	uint64_t elapsed = now_ns() - start;
+
+	printf("%zu lookups with %zu live resources: %.1f ns/lookup\n",
+	       nr_lookups, nr_live, (double)elapsed / (double)nr_lookups);
+
+release_resources:
+	for (size_t i = 0; i < nr_live; i++) {
+		if (vaccel_resource_release(&res[i]))
+			fprintf(stderr, "Could not release resource %zu\n", i);
+	}
+	free(res);
+
+	return ret;
+}
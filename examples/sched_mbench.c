@@ -0,0 +1,266 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Compare plugin scheduling policies with two instances of the mbench plugin,
+ * one of which is artificially slower.
+ *
+ * The slow instance is loaded first, so the static policy always selects it.
+ * The adaptive policy should move sessions to the fast instance once both have
+ * been measured. Finally, an override pins the op back to the slow instance.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "utils/fs.h"
+#include "vaccel.h"
+#include <dlfcn.h>
+#include <inttypes.h>
+#include <linux/limits.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+#define DEFAULT_TIME_MS "1"
+#define DEFAULT_DELAY_MS "10"
+#define DEFAULT_ITERATIONS 20
+#define DELAY_ENV "VACCEL_MBENCH_DELAY_MS"
+
+enum { INSTANCE_SLOW = 0, INSTANCE_FAST, INSTANCE_MAX };
+
+struct mbench_instance {
+	const char *label;
+	const char *delay_ms;
+	char path[PATH_MAX];
+	void *dl_handle;
+	size_t selected;
+};
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int instance_copy(struct mbench_instance *inst, const void *data,
+			 size_t size)
+{
+	int fd;
+
+	snprintf(inst->path, sizeof(inst->path), "%s/libvaccel-mbench.so",
+		 vaccel_rundir());
+	int ret = fs_file_create_unique(inst->path, sizeof(inst->path), NULL,
+					&fd);
+	if (ret)
+		return ret;
+
+	ssize_t written = write(fd, data, size);
+	close(fd);
+	if (written < 0 || (size_t)written != size) {
+		fs_file_remove(inst->path);
+		inst->path[0] = '\0';
+		return VACCEL_EIO;
+	}
+
+	return VACCEL_OK;
+}
+
+static int instance_load(struct mbench_instance *inst)
+{
+	if (setenv(DELAY_ENV, inst->delay_ms, 1))
+		return VACCEL_EINVAL;
+
+	int ret = vaccel_plugin_load(inst->path);
+	unsetenv(DELAY_ENV);
+	if (ret)
+		return ret;
+
+	/* Already loaded, so this only returns the handle to compare
+	 * sessions' plugins against */
+	inst->dl_handle = dlopen(inst->path, RTLD_LAZY);
+	if (!inst->dl_handle)
+		return VACCEL_ENOENT;
+
+	return VACCEL_OK;
+}
+
+static void instance_release(struct mbench_instance *inst)
+{
+	if (inst->dl_handle)
+		dlclose(inst->dl_handle);
+	inst->dl_handle = NULL;
+	inst->selected = 0;
+}
+
+static int bootstrap(vaccel_sched_policy_t policy)
+{
+	struct vaccel_config config;
+
+	int ret = vaccel_config_init_from_env(&config);
+	if (ret)
+		return ret;
+
+	free(config.plugins);
+	config.plugins = NULL;
+	config.sched_policy = policy;
+
+	ret = vaccel_bootstrap_with_config(&config);
+	vaccel_config_release(&config);
+
+	return ret;
+}
+
+static int run_policy(const char *name, vaccel_sched_policy_t policy,
+		      bool override, struct mbench_instance *instances,
+		      const void *lib, size_t lib_size, struct vaccel_arg *read,
+		      size_t iterations)
+{
+	int ret = bootstrap(policy);
+	if (ret) {
+		fprintf(stderr, "Could not bootstrap vAccel\n");
+		return ret;
+	}
+
+	for (size_t i = 0; i < INSTANCE_MAX; i++) {
+		ret = instance_copy(&instances[i], lib, lib_size);
+		if (ret) {
+			fprintf(stderr, "Could not copy plugin\n");
+			goto out;
+		}
+		ret = instance_load(&instances[i]);
+		if (ret) {
+			fprintf(stderr, "Could not load plugin %s\n",
+				instances[i].path);
+			goto out;
+		}
+	}
+
+	/* Both instances are named "mbench"; the override pins the op to the
+	 * first one registered, i.e. the slow instance */
+	if (override) {
+		ret = vaccel_sched_override(VACCEL_OP_EXEC, "mbench");
+		if (ret) {
+			fprintf(stderr, "Could not set override\n");
+			goto out;
+		}
+	}
+
+	uint64_t start = now_ns();
+	for (size_t it = 0; it < iterations; it++) {
+		struct vaccel_session sess;
+
+		ret = vaccel_session_init(&sess, VACCEL_SESSION_OP_ROUTING);
+		if (ret) {
+			fprintf(stderr, "Could not initialize session\n");
+			goto out;
+		}
+
+		const struct vaccel_plugin *plugin =
+			sess.op_plugins ? sess.op_plugins[VACCEL_OP_EXEC] :
+					  sess.plugin;
+		for (size_t i = 0; i < INSTANCE_MAX; i++) {
+			if (plugin &&
+			    plugin->dl_handle == instances[i].dl_handle)
+				instances[i].selected++;
+		}
+
+		ret = vaccel_exec(&sess, "mbench", "mbench", read, 2, NULL, 0);
+		if (vaccel_session_release(&sess))
+			fprintf(stderr, "Could not release session\n");
+		if (ret) {
+			fprintf(stderr, "Could not run op: %d\n", ret);
+			goto out;
+		}
+	}
+	uint64_t elapsed = now_ns() - start;
+
+	printf("%-18s total %8.2f ms |", name, (double)elapsed / 1e6);
+	for (size_t i = 0; i < INSTANCE_MAX; i++)
+		printf(" %s: %3zu/%zu", instances[i].label,
+		       instances[i].selected, iterations);
+	printf("\n");
+
+out:
+	vaccel_sched_override(VACCEL_OP_EXEC, NULL);
+
+	for (size_t i = 0; i < INSTANCE_MAX; i++)
+		instance_release(&instances[i]);
+
+	/* Unload the plugin copies before removing them */
+	if (vaccel_cleanup())
+		fprintf(stderr, "Could not cleanup vAccel\n");
+
+	for (size_t i = 0; i < INSTANCE_MAX; i++) {
+		if (instances[i].path[0] != '\0')
+			fs_file_remove(instances[i].path);
+		instances[i].path[0] = '\0';
+	}
+
+	return ret;
+}
+
+int main(int argc, char *argv[])
+{
+	int ret;
+	void *lib;
+	size_t lib_size;
+
+	if (argc < 2 || argc > 5) {
+		fprintf(stderr,
+			"Usage: %s <mbench_plugin> [time_ms] [delay_ms] [iterations]\n",
+			argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	char *time_ms = (argc > 2) ? argv[2] : DEFAULT_TIME_MS;
+	const char *delay_ms = (argc > 3) ? argv[3] : DEFAULT_DELAY_MS;
+	const size_t iterations = (argc > 4) ? strtoul(argv[4], NULL, 10) :
+					       DEFAULT_ITERATIONS;
+	if (!iterations) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	ret = fs_file_read(argv[1], &lib, &lib_size);
+	if (ret) {
+		fprintf(stderr, "Could not read plugin %s\n", argv[1]);
+		return ret;
+	}
+
+	/* mbench expects the time and a (unused) library argument */
+	struct vaccel_arg read[] = {
+		{ .size = strlen(time_ms) + 1, .buf = time_ms, .type = 0 },
+		{ .size = lib_size, .buf = lib, .type = 0 },
+	};
+
+	struct mbench_instance instances[INSTANCE_MAX] = {
+		[INSTANCE_SLOW] = { .label = "slow", .delay_ms = delay_ms },
+		[INSTANCE_FAST] = { .label = "fast", .delay_ms = "0" },
+	};
+
+	printf("mbench %s ms, slow instance delay %s ms, %zu sessions\n",
+	       time_ms, delay_ms, iterations);
+
+	ret = run_policy("static", VACCEL_SCHED_STATIC, false, instances, lib,
+			 lib_size, read, iterations);
+	if (ret)
+		goto out;
+
+	ret = run_policy("adaptive", VACCEL_SCHED_ADAPTIVE, false, instances,
+			 lib, lib_size, read, iterations);
+	if (ret)
+		goto out;
+
+	ret = run_policy("adaptive+override", VACCEL_SCHED_ADAPTIVE, true,
+			 instances, lib, lib_size, read, iterations);
+
+out:
+	free(lib);
+
+	return ret;
+}
@@ -0,0 +1,134 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * Compare session setup and teardown latency of creating a session per
+ * request with `vaccel_session_new()`/`vaccel_session_delete()` against
+ * reusing sessions from a `struct vaccel_session_pool`.
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "vaccel.h"
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#define DEFAULT_SESSIONS 10000
+#define DEFAULT_POOL_CAPACITY 16
+
+static uint64_t now_ns(void)
+{
+	struct timespec ts;
+
+	clock_gettime(CLOCK_MONOTONIC, &ts);
+	return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+}
+
+static int cmp_u64(const void *a, const void *b)
+{
+	uint64_t x = *(const uint64_t *)a;
+	uint64_t y = *(const uint64_t *)b;
+
+	return (x > y) - (x < y);
+}
+
+static void print_percentiles(const char *name, uint64_t *samples, size_t nr)
+{
+	qsort(samples, nr, sizeof(*samples), cmp_u64);
+	printf("%-8s p50 %8.1f us  p99 %8.1f us\n", name,
+	       (double)samples[nr / 2] / 1e3,
+	       (double)samples[(nr * 99) / 100] / 1e3);
+}
+
+int main(int argc, char *argv[])
+{
+	int ret = VACCEL_OK;
+	struct vaccel_session_pool pool;
+
+	if (argc > 3) {
+		fprintf(stderr, "Usage: %s [sessions] [pool_capacity]\n",
+			argv[0]);
+		return VACCEL_EINVAL;
+	}
+
+	const size_t nr_sessions = (argc > 1) ? strtoul(argv[1], NULL, 10) :
+						DEFAULT_SESSIONS;
+	const size_t capacity = (argc > 2) ? strtoul(argv[2], NULL, 10) :
+					     DEFAULT_POOL_CAPACITY;
+	if (!nr_sessions || !capacity) {
+		fprintf(stderr, "Invalid arguments\n");
+		return VACCEL_EINVAL;
+	}
+
+	uint64_t *setup = calloc(nr_sessions, sizeof(*setup));
+	uint64_t *teardown = calloc(nr_sessions, sizeof(*teardown));
+	if (!setup || !teardown) {
+		ret = VACCEL_ENOMEM;
+		goto free_samples;
+	}
+
+	for (size_t i = 0; i < nr_sessions; i++) {
+		struct vaccel_session *sess;
+
+		uint64_t start = now_ns();
+		ret = vaccel_session_new(&sess, 0);
+		setup[i] = now_ns() - start;
+		if (ret) {
+			fprintf(stderr, "Could not create session\n");
+			goto free_samples;
+		}
+
+		start = now_ns();
+		ret = vaccel_session_delete(sess);
+		teardown[i] = now_ns() - start;
+		if (ret) {
+			fprintf(stderr, "Could not delete session\n");
+			goto free_samples;
+		}
+	}
+
+	printf("%zu sessions\n", nr_sessions);
+	printf("Without pool:\n");
+	print_percentiles("setup", setup, nr_sessions);
+	print_percentiles("release", teardown, nr_sessions);
+
+	ret = vaccel_session_pool_init(&pool, 0, capacity);
+	if (ret) {
+		fprintf(stderr, "Could not initialize session pool\n");
+		goto free_samples;
+	}
+
+	for (size_t i = 0; i < nr_sessions; i++) {
+		struct vaccel_session *sess;
+
+		uint64_t start = now_ns();
+		ret = vaccel_session_pool_get(&pool, &sess);
+		setup[i] = now_ns() - start;
+		if (ret) {
+			fprintf(stderr, "Could not get pool session\n");
+			goto release_pool;
+		}
+
+		start = now_ns();
+		ret = vaccel_session_pool_put(&pool, sess);
+		teardown[i] = now_ns() - start;
+		if (ret) {
+			fprintf(stderr, "Could not return pool session\n");
+			goto release_pool;
+		}
+	}
+
+	printf("With pool (capacity %zu):\n", capacity);
+	print_percentiles("setup", setup, nr_sessions);
+	print_percentiles("release", teardown, nr_sessions);
+
+release_pool:
+	if (vaccel_session_pool_release(&pool))
+		fprintf(stderr, "Could not release session pool\n");
+free_samples:
+	free(setup);
+	free(teardown);
+
+	return ret;
+}
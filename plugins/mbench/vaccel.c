@@ -14,6 +14,10 @@ static struct vaccel_prof_region mbench_plugin_stats =
 #define NS_PER_SEC 1000000000L
 #define NS_PER_MS 1000000L
 #define MAX_TIME 300000
+#define DELAY_ENV "VACCEL_MBENCH_DELAY_MS"
+
+/* extra time (ms) added to every call, to emulate slower devices */
+static int mbench_delay;
 
 static int mbench(int time)
 {
@@ -61,7 +65,7 @@ static int mbench_unpack(struct vaccel_session *session, const char *library,
 	if (nr_read < 2)
 		return VACCEL_EINVAL;
 
-	time = atoi(read_args[0].buf);
+	time = atoi(read_args[0].buf) + mbench_delay;
 
 	vaccel_prof_region_start(&mbench_plugin_stats);
 
@@ -78,6 +82,18 @@ struct vaccel_op ops[] = {
 
 static int init(void)
 {
+	const char *delay = getenv(DELAY_ENV);
+	if (delay) {
+		mbench_delay = atoi(delay);
+		if (mbench_delay < 0 || mbench_delay > MAX_TIME) {
+			vaccel_error("[mbench] Invalid %s value: %s", DELAY_ENV,
+				     delay);
+			return VACCEL_EINVAL;
+		}
+		vaccel_debug("[mbench] Adding %d ms delay to every call",
+			     mbench_delay);
+	}
+
 	return vaccel_plugin_register_ops(ops, sizeof(ops) / sizeof(ops[0]));
 }
 
@@ -806,6 +806,103 @@ static int noop_opencv(struct vaccel_session *sess, struct vaccel_arg *read,
 	return VACCEL_OK;
 }
 
+static int noop_genop_batch_exec(struct vaccel_session *sess,
+				 struct vaccel_genop_req *req)
+{
+	struct vaccel_arg_array read_args;
+	uint8_t op_type;
+	char *library;
+	char *fn_symbol;
+	struct vaccel_arg *read;
+	size_t nr_read;
+
+	if (vaccel_arg_array_wrap(&read_args, req->read, req->nr_read) ||
+	    vaccel_arg_array_get_uint8(&read_args, &op_type) ||
+	    vaccel_arg_array_get_string(&read_args, &library) ||
+	    vaccel_arg_array_get_string(&read_args, &fn_symbol) ||
+	    vaccel_arg_array_get_remaining(&read_args, &read, &nr_read)) {
+		noop_error("Failed to unpack exec read args");
+		return VACCEL_EINVAL;
+	}
+
+	return noop_exec(sess, library, fn_symbol, read, nr_read, req->write,
+			 req->nr_write);
+}
+
+static int noop_genop_batch_minmax(struct vaccel_session *sess,
+				   struct vaccel_genop_req *req)
+{
+	if (req->nr_read != 5 || req->nr_write != 3) {
+		noop_error("Wrong number of arguments for minmax");
+		return VACCEL_EINVAL;
+	}
+
+	const struct vaccel_arg *read = req->read;
+	const struct vaccel_arg *write = req->write;
+	for (size_t i = 2; i < 5; i++) {
+		if (!read[i].buf || read[i].size < sizeof(int)) {
+			noop_error("Invalid minmax read argument %zu", i);
+			return VACCEL_EINVAL;
+		}
+	}
+
+	int ndata = *(int *)read[2].buf;
+	size_t data_size = (size_t)ndata * sizeof(double);
+	if (ndata < 0 || (ndata && (!read[1].buf || read[1].size < data_size ||
+				    !write[0].buf ||
+				    write[0].size < data_size))) {
+		noop_error("Invalid minmax data arguments");
+		return VACCEL_EINVAL;
+	}
+
+	for (size_t i = 1; i < 3; i++) {
+		if (!write[i].buf || write[i].size < sizeof(double)) {
+			noop_error("Invalid minmax write argument %zu", i);
+			return VACCEL_EINVAL;
+		}
+	}
+
+	return noop_minmax(sess, (double *)read[1].buf, ndata,
+			   *(int *)read[3].buf, *(int *)read[4].buf,
+			   (double *)write[0].buf, (double *)write[1].buf,
+			   (double *)write[2].buf);
+}
+
+static int noop_genop_batch(struct vaccel_session *sess,
+			    vaccel_op_type_t op_type,
+			    struct vaccel_genop_req *reqs, size_t nr_reqs)
+{
+	int (*fn)(struct vaccel_session *sess, struct vaccel_genop_req *req);
+
+	switch (op_type) {
+	case VACCEL_OP_EXEC:
+		fn = noop_genop_batch_exec;
+		break;
+	case VACCEL_OP_MINMAX:
+		fn = noop_genop_batch_minmax;
+		break;
+	default:
+		return VACCEL_ENOTSUP;
+	}
+
+	noop_debug("Calling batch of %zu %s ops for session %" PRId64 "",
+		   nr_reqs, vaccel_op_type_to_str(op_type), sess->id);
+
+	for (size_t i = 0; i < nr_reqs; i++)
+		reqs[i].ret = fn(sess, &reqs[i]);
+
+	return VACCEL_OK;
+}
+
+static int noop_resource_warmup(struct vaccel_resource *res,
+				struct vaccel_session *sess)
+{
+	noop_debug("Warming up resource %" PRId64 " for session %" PRId64 "",
+		   res->id, sess->id);
+
+	return VACCEL_OK;
+}
+
 struct vaccel_op ops[] = {
 	VACCEL_OP_INIT(ops[0], VACCEL_OP_NOOP, noop_noop),
 	VACCEL_OP_INIT(ops[1], VACCEL_OP_EXEC, noop_exec),
@@ -851,4 +948,5 @@ static int fini(void)
 
 VACCEL_PLUGIN(.name = "noop", .version = VACCEL_VERSION,
 	      .vaccel_version = VACCEL_VERSION, .type = VACCEL_PLUGIN_DEBUG,
-	      .init = init, .fini = fini)
+	      .init = init, .fini = fini, .genop_batch = noop_genop_batch,
+	      .resource_warmup = noop_resource_warmup)
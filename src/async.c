@@ -0,0 +1,435 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "async.h"
+#include "arg.h"
+#include "error.h"
+#include "list.h"
+#include "log.h"
+#include "op.h"
+#include "ops/genop.h"
+#include "plugin.h"
+#include "session.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+#define NS_PER_SEC 1000000000L
+#define NS_PER_MS 1000000L
+
+enum {
+	/* maximum number of worker threads running synchronous ops */
+	ASYNC_WORKERS_MAX = 64
+};
+
+struct async_request {
+	/* entry for the worker queue or the completion queue */
+	struct vaccel_list_entry entry;
+
+	/* session to run the op on */
+	struct vaccel_session *sess;
+
+	/* completion queue to report to */
+	struct vaccel_cq *cq;
+
+	/* genop arguments */
+	struct vaccel_arg *read;
+	int nr_read;
+	struct vaccel_arg *write;
+	int nr_write;
+
+	/* user data given at submission */
+	void *user_data;
+
+	/* return code of the op */
+	int ret;
+};
+
+static struct {
+	/* true if the pool is initialized */
+	bool initialized;
+
+	/* true if the workers have been asked to exit */
+	bool stopping;
+
+	/* requests waiting for a worker */
+	struct vaccel_list_entry queue;
+
+	/* worker threads, started on first use */
+	pthread_t workers[ASYNC_WORKERS_MAX];
+	size_t nr_workers;
+
+	/* lock for the pool */
+	pthread_mutex_t lock;
+
+	/* signaled when a request is queued or the pool stops */
+	pthread_cond_t cond;
+} async = { .initialized = false };
+
+static void async_op_complete(void *ctx, int ret)
+{
+	struct async_request *req = ctx;
+	struct vaccel_cq *cq = req->cq;
+
+	req->ret = ret;
+
+	pthread_mutex_lock(&cq->lock);
+	list_add_tail(&cq->completed, &req->entry);
+	cq->nr_inflight--;
+	cq->nr_completed++;
+	pthread_cond_broadcast(&cq->cond);
+	pthread_mutex_unlock(&cq->lock);
+}
+
+static void *async_worker(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&async.lock);
+	while (true) {
+		while (list_empty(&async.queue) && !async.stopping)
+			pthread_cond_wait(&async.cond, &async.lock);
+
+		/* Requests still queued are canceled by async_cleanup() */
+		if (async.stopping)
+			break;
+
+		struct async_request *req = list_get_container(
+			list_remove_head(&async.queue), struct async_request,
+			entry);
+		pthread_mutex_unlock(&async.lock);
+
+		int ret = vaccel_genop(req->sess, req->read, req->nr_read,
+				       req->write, req->nr_write);
+		async_op_complete(req, ret);
+
+		pthread_mutex_lock(&async.lock);
+	}
+	pthread_mutex_unlock(&async.lock);
+
+	return NULL;
+}
+
+/* Start the workers, if not already started. Must be called with the pool
+ * lock held. */
+static int async_workers_start(void)
+{
+	if (async.nr_workers)
+		return VACCEL_OK;
+
+	long nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t nr_workers = (nr_cpus > 0) ? (size_t)nr_cpus : 1;
+	if (nr_workers > ASYNC_WORKERS_MAX)
+		nr_workers = ASYNC_WORKERS_MAX;
+
+	for (size_t i = 0; i < nr_workers; i++) {
+		if (pthread_create(&async.workers[async.nr_workers], NULL,
+				   async_worker, NULL))
+			break;
+		async.nr_workers++;
+	}
+
+	if (!async.nr_workers) {
+		vaccel_error("Could not start async workers");
+		return VACCEL_EAGAIN;
+	}
+
+	vaccel_debug("Started %zu async workers", async.nr_workers);
+
+	return VACCEL_OK;
+}
+
+static int async_queue(struct async_request *req)
+{
+	pthread_mutex_lock(&async.lock);
+
+	if (async.stopping) {
+		pthread_mutex_unlock(&async.lock);
+		return VACCEL_ECANCELED;
+	}
+
+	int ret = async_workers_start();
+	if (ret) {
+		pthread_mutex_unlock(&async.lock);
+		return ret;
+	}
+
+	list_add_tail(&async.queue, &req->entry);
+	pthread_cond_signal(&async.cond);
+
+	pthread_mutex_unlock(&async.lock);
+
+	return VACCEL_OK;
+}
+
+int async_bootstrap(void)
+{
+	list_init(&async.queue);
+	async.nr_workers = 0;
+	async.stopping = false;
+	pthread_mutex_init(&async.lock, NULL);
+	pthread_cond_init(&async.cond, NULL);
+
+	async.initialized = true;
+
+	return VACCEL_OK;
+}
+
+int async_cleanup(void)
+{
+	if (!async.initialized)
+		return VACCEL_OK;
+
+	pthread_mutex_lock(&async.lock);
+	async.stopping = true;
+	pthread_cond_broadcast(&async.cond);
+	pthread_mutex_unlock(&async.lock);
+
+	/* Workers finish the ops they are running before exiting */
+	for (size_t i = 0; i < async.nr_workers; i++)
+		pthread_join(async.workers[i], NULL);
+	async.nr_workers = 0;
+
+	struct vaccel_list_entry *entry;
+	while ((entry = list_remove_head(&async.queue))) {
+		struct async_request *req = list_get_container(
+			entry, struct async_request, entry);
+		async_op_complete(req, VACCEL_ECANCELED);
+	}
+
+	pthread_cond_destroy(&async.cond);
+	pthread_mutex_destroy(&async.lock);
+
+	async.initialized = false;
+
+	return VACCEL_OK;
+}
+
+int vaccel_cq_init(struct vaccel_cq *cq)
+{
+	if (!cq)
+		return VACCEL_EINVAL;
+
+	pthread_condattr_t attr;
+	if (pthread_condattr_init(&attr))
+		return VACCEL_ENOMEM;
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	int ret = pthread_cond_init(&cq->cond, &attr);
+	pthread_condattr_destroy(&attr);
+	if (ret)
+		return VACCEL_ENOMEM;
+
+	pthread_mutex_init(&cq->lock, NULL);
+	list_init(&cq->completed);
+	cq->nr_completed = 0;
+	cq->nr_inflight = 0;
+
+	return VACCEL_OK;
+}
+
+int vaccel_cq_release(struct vaccel_cq *cq)
+{
+	if (!cq)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cq->lock);
+
+	if (cq->nr_inflight) {
+		pthread_mutex_unlock(&cq->lock);
+		vaccel_error("Completion queue has %zu ops in flight",
+			     cq->nr_inflight);
+		return VACCEL_EBUSY;
+	}
+
+	struct vaccel_list_entry *entry;
+	while ((entry = list_remove_head(&cq->completed)))
+		free(list_get_container(entry, struct async_request, entry));
+	cq->nr_completed = 0;
+
+	pthread_mutex_unlock(&cq->lock);
+
+	pthread_cond_destroy(&cq->cond);
+	pthread_mutex_destroy(&cq->lock);
+
+	return VACCEL_OK;
+}
+
+int vaccel_cq_new(struct vaccel_cq **cq)
+{
+	if (!cq)
+		return VACCEL_EINVAL;
+
+	struct vaccel_cq *c = (struct vaccel_cq *)malloc(sizeof(*c));
+	if (!c)
+		return VACCEL_ENOMEM;
+
+	int ret = vaccel_cq_init(c);
+	if (ret) {
+		free(c);
+		return ret;
+	}
+
+	*cq = c;
+
+	return VACCEL_OK;
+}
+
+int vaccel_cq_delete(struct vaccel_cq *cq)
+{
+	int ret = vaccel_cq_release(cq);
+	if (ret)
+		return ret;
+
+	free(cq);
+
+	return VACCEL_OK;
+}
+
+int vaccel_op_submit(struct vaccel_session *sess, struct vaccel_cq *cq,
+		     struct vaccel_arg *read, int nr_read,
+		     struct vaccel_arg *write, int nr_write, void *user_data)
+{
+	if (!sess || !cq)
+		return VACCEL_EINVAL;
+
+	if (!async.initialized)
+		return VACCEL_EBACKEND;
+
+	vaccel_op_type_t op_type;
+	int ret = genop_op_type(read, nr_read, &op_type);
+	if (ret)
+		return ret;
+
+	struct async_request *req =
+		(struct async_request *)malloc(sizeof(*req));
+	if (!req)
+		return VACCEL_ENOMEM;
+
+	list_init_entry(&req->entry);
+	req->sess = sess;
+	req->cq = cq;
+	req->read = read;
+	req->nr_read = nr_read;
+	req->write = write;
+	req->nr_write = nr_write;
+	req->user_data = user_data;
+	req->ret = VACCEL_EINPROGRESS;
+
+	pthread_mutex_lock(&cq->lock);
+	cq->nr_inflight++;
+	pthread_mutex_unlock(&cq->lock);
+
+	/* Prefer the plugin's own async implementation, if any */
+	struct vaccel_plugin *plugin = op_session_plugin(sess, op_type);
+	if (plugin && plugin->info->submit_async) {
+		ret = plugin->info->submit_async(sess, op_type, &read[1],
+						 nr_read - 1, write, nr_write,
+						 async_op_complete, req);
+		if (ret != VACCEL_ENOTSUP) {
+			if (ret)
+				goto undo;
+			return VACCEL_OK;
+		}
+	}
+
+	ret = async_queue(req);
+	if (ret)
+		goto undo;
+
+	return VACCEL_OK;
+
+undo:
+	pthread_mutex_lock(&cq->lock);
+	cq->nr_inflight--;
+	pthread_mutex_unlock(&cq->lock);
+	free(req);
+
+	return ret;
+}
+
+/* Reap completions. Must be called with the completion queue lock held. */
+static size_t cq_reap(struct vaccel_cq *cq,
+		      struct vaccel_completion *completions, size_t max)
+{
+	size_t nr = 0;
+
+	while (nr < max && cq->nr_completed) {
+		struct async_request *req = list_get_container(
+			list_remove_head(&cq->completed), struct async_request,
+			entry);
+		cq->nr_completed--;
+
+		completions[nr].user_data = req->user_data;
+		completions[nr].ret = req->ret;
+		nr++;
+
+		free(req);
+	}
+
+	return nr;
+}
+
+int vaccel_cq_poll(struct vaccel_cq *cq, struct vaccel_completion *completions,
+		   size_t max, size_t *nr_completions)
+{
+	if (!cq || !completions || !max || !nr_completions)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cq->lock);
+	*nr_completions = cq_reap(cq, completions, max);
+	pthread_mutex_unlock(&cq->lock);
+
+	return VACCEL_OK;
+}
+
+int vaccel_cq_wait(struct vaccel_cq *cq, struct vaccel_completion *completions,
+		   size_t max, size_t *nr_completions, int timeout_ms)
+{
+	int ret = VACCEL_OK;
+	struct timespec deadline;
+
+	if (!cq || !completions || !max || !nr_completions)
+		return VACCEL_EINVAL;
+
+	*nr_completions = 0;
+
+	if (timeout_ms >= 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout_ms / 1000;
+		deadline.tv_nsec += (long)(timeout_ms % 1000) * NS_PER_MS;
+		if (deadline.tv_nsec >= NS_PER_SEC) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= NS_PER_SEC;
+		}
+	}
+
+	pthread_mutex_lock(&cq->lock);
+
+	while (!cq->nr_completed) {
+		if (!cq->nr_inflight) {
+			ret = VACCEL_ENOENT;
+			goto out;
+		}
+
+		if (timeout_ms < 0) {
+			pthread_cond_wait(&cq->cond, &cq->lock);
+		} else if (pthread_cond_timedwait(&cq->cond, &cq->lock,
+						  &deadline) == ETIMEDOUT &&
+			   !cq->nr_completed) {
+			ret = VACCEL_EAGAIN;
+			goto out;
+		}
+	}
+
+	*nr_completions = cq_reap(cq, completions, max);
+
+out:
+	pthread_mutex_unlock(&cq->lock);
+
+	return ret;
+}
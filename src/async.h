@@ -0,0 +1,20 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/async.h" // IWYU pragma: export
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Initialize the async worker pool */
+int async_bootstrap(void);
+
+/* Stop the async worker pool. Queued ops that have not started yet complete
+ * with VACCEL_ECANCELED */
+int async_cleanup(void);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,6 +3,7 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "blob.h"
+#include "blob_cache.h"
 #include "error.h"
 #include "log.h"
 #include "utils/fs.h"
@@ -17,6 +18,45 @@
 #include <sys/mman.h>
 #include <unistd.h>
 
+/* Path of in-memory blob files, followed by the file descriptor */
+#define BLOB_MEMFD_PATH_PREFIX "/proc/self/fd/"
+
+/* Check if the data of a blob can be dropped from memory and read back from
+ * its file. Only read-only shared mappings qualify, as private ones may hold
+ * changes. In-memory files are not considered, as their data would stay in
+ * memory anyway */
+static bool blob_evictable(const struct vaccel_blob *blob)
+{
+	return blob->type == VACCEL_BLOB_MAPPED && blob->path &&
+	       blob->memfd < 0 && (blob->map_flags & VACCEL_BLOB_MAP_SHARED);
+}
+
+/* Count the data of a newly mapped blob against the blob cache budget */
+static void blob_mapped(struct vaccel_blob *blob)
+{
+	if (blob_evictable(blob))
+		blob_cache_add(blob);
+}
+
+/* Translate blob map flags to fs_file_mmap() flags */
+static unsigned int blob_mmap_flags(const struct vaccel_blob *blob)
+{
+	unsigned int flags = 0;
+
+	if (blob->map_flags & VACCEL_BLOB_MAP_SHARED)
+		flags |= FS_MMAP_SHARED;
+	if (blob->map_flags & VACCEL_BLOB_MAP_POPULATE)
+		flags |= FS_MMAP_POPULATE;
+	if (blob->map_flags & VACCEL_BLOB_MAP_WILLNEED)
+		flags |= FS_MMAP_WILLNEED;
+	if (blob->map_flags & VACCEL_BLOB_MAP_SEQUENTIAL)
+		flags |= FS_MMAP_SEQUENTIAL;
+	if (blob->map_flags & VACCEL_BLOB_MAP_HUGEPAGE)
+		flags |= FS_MMAP_HUGEPAGE;
+
+	return flags;
+}
+
 /* Persist a blob in the filesystem.
  *
  * For blobs that have been initialized from in-memory data, this
@@ -113,35 +153,24 @@ int vaccel_blob_persist(struct vaccel_blob *blob, const char *dir,
 
 	vaccel_debug("Persisting file %s to %s", blob->name, blob->path);
 
-	/* Write file->data buffer to the new file */
-	FILE *fp = fdopen(fd, "w+");
-	if (!fp) {
-		vaccel_error("Could not open file %s: %s", blob->path,
-			     strerror(errno));
-		close(fd);
-		ret = VACCEL_EIO;
-		goto free_name;
-	}
-
-	if (fwrite(blob->data, sizeof(char), blob->size, fp) != blob->size) {
+	/* Write file->data buffer to the new file in one go; a stdio buffer
+	 * would only split it up in small writes */
+	ret = fs_file_write(fd, blob->data, blob->size);
+	close(fd);
+	if (ret) {
 		vaccel_error("Could not persist file %s: %s", blob->path,
-			     strerror(errno));
-		fclose(fp);
+			     strerror(ret));
 		ret = VACCEL_EIO;
 		goto free_name;
 	}
 
-	/* fwrite() is a buffered operation so we need to fclose() here.
-	 * If we don't, we will have to fflush() to ensure data has been written
-	 * to disk before we try to mmap */
-	fclose(fp);
-
 	/* Deallocate the initial pointer and mmap a new one,
 	 * so that changes through the pointer are synced with the
 	 * file */
 	void *old_ptr = blob->data;
 	size_t old_size = blob->size;
-	ret = fs_file_read_mmap(blob->path, (void **)&blob->data, &blob->size);
+	ret = fs_file_mmap(blob->path, blob_mmap_flags(blob),
+			   (void **)&blob->data, &blob->size);
 	if (ret) {
 		vaccel_error("Could not re-map file");
 		blob->data = old_ptr;
@@ -156,6 +185,7 @@ int vaccel_blob_persist(struct vaccel_blob *blob, const char *dir,
 	/* The file is mmap'ed to data so the relevant memory is always owned */
 	blob->data_owned = true;
 	blob->type = VACCEL_BLOB_MAPPED;
+	blob_mapped(blob);
 
 	return VACCEL_OK;
 
@@ -172,6 +202,95 @@ remove_file:
 	return ret;
 }
 
+/* Persist a blob in an in-memory file.
+ *
+ * Similar to `vaccel_blob_persist()`, but the data are copied in a sealed
+ * anonymous file instead of a file under a directory. The blob path is set to
+ * `/proc/self/fd/<fd>`, so the file can be opened by plugins that need a path,
+ * and the data are mapped from the file without any further copies.
+ *
+ * It will fail if the file has been initialized through an existing
+ * path in the filesystem.
+ */
+int vaccel_blob_persist_memfd(struct vaccel_blob *blob, const char *filename)
+{
+	if (!blob || !blob->data || !blob->size ||
+	    blob->type >= VACCEL_BLOB_MAX) {
+		vaccel_error("Invalid blob");
+		return VACCEL_EINVAL;
+	}
+
+	if (!filename) {
+		vaccel_error("You need to provide a name for the blob");
+		return VACCEL_EINVAL;
+	}
+
+	if (blob->path) {
+		vaccel_error("Found path for vAccel blob. Not overwriting");
+		return VACCEL_EEXIST;
+	}
+
+	int fd;
+	int ret = fs_memfd_create(filename, blob->data, blob->size, &fd);
+	if (ret)
+		return ret;
+
+	char fpath[sizeof(BLOB_MEMFD_PATH_PREFIX) + 16];
+	snprintf(fpath, sizeof(fpath), BLOB_MEMFD_PATH_PREFIX "%d", fd);
+
+	char *name = NULL;
+	if (!blob->name || strcmp(blob->name, filename) != 0) {
+		name = strdup(filename);
+		if (!name) {
+			ret = VACCEL_ENOMEM;
+			goto close_file;
+		}
+	}
+
+	blob->path = strdup(fpath);
+	if (!blob->path) {
+		ret = VACCEL_ENOMEM;
+		goto free_name;
+	}
+
+	vaccel_debug("Persisting file %s to %s", filename, blob->path);
+
+	/* The file is sealed, so the mapping shares its pages */
+	void *old_ptr = blob->data;
+	ret = fs_file_mmap(blob->path, blob_mmap_flags(blob),
+			   (void **)&blob->data, &blob->size);
+	if (ret) {
+		vaccel_error("Could not map file");
+		blob->data = old_ptr;
+		free(blob->path);
+		blob->path = NULL;
+		goto free_name;
+	}
+
+	/* If the blob data was owned, free the allocated memory */
+	if (blob->type == VACCEL_BLOB_BUFFER && blob->data_owned)
+		free(old_ptr);
+
+	if (name) {
+		free(blob->name);
+		blob->name = name;
+	}
+
+	blob->path_owned = true;
+	blob->memfd = fd;
+	blob->data_owned = true;
+	blob->type = VACCEL_BLOB_MAPPED;
+
+	return VACCEL_OK;
+
+free_name:
+	free(name);
+close_file:
+	close(fd);
+
+	return ret;
+}
+
 /* Initialize a blob from an existing file in the filesystem.
  *
  * The file path will be copied and stored.
@@ -199,9 +318,12 @@ int vaccel_blob_init(struct vaccel_blob *blob, const char *path)
 
 	blob->type = VACCEL_BLOB_FILE;
 	blob->path_owned = false;
+	blob->memfd = -1;
 	blob->data_owned = false;
 	blob->data = NULL;
 	blob->size = 0;
+	blob->map_flags = 0;
+	blob->cache_entry = NULL;
 
 	return VACCEL_OK;
 }
@@ -232,8 +354,11 @@ int vaccel_blob_init_from_buf(struct vaccel_blob *blob, const uint8_t *buf,
 	blob->name = NULL;
 	blob->path = NULL;
 	blob->path_owned = false;
+	blob->memfd = -1;
 	blob->size = size;
 	blob->type = VACCEL_BLOB_BUFFER;
+	blob->map_flags = 0;
+	blob->cache_entry = NULL;
 
 	if (!dir) {
 		if (own) {
@@ -290,6 +415,8 @@ int vaccel_blob_release(struct vaccel_blob *blob)
 		free(blob->name);
 	blob->name = NULL;
 
+	blob_cache_remove(blob);
+
 	if (blob->data && blob->size && blob->data_owned) {
 		if (blob->type == VACCEL_BLOB_MAPPED) {
 			int ret = munmap(blob->data, blob->size);
@@ -311,8 +438,11 @@ int vaccel_blob_release(struct vaccel_blob *blob)
 
 	if (blob->path) {
 		/* If we own the path to the file, remove it from the
-		 * filesystem */
-		if (blob->path_owned) {
+		 * filesystem; in-memory files go away when closed */
+		if (blob->path_owned && blob->memfd >= 0) {
+			vaccel_debug("Closing file %s", blob->path);
+			close(blob->memfd);
+		} else if (blob->path_owned) {
 			vaccel_debug("Removing file %s", blob->path);
 			if (fs_file_remove(blob->path))
 				vaccel_warn("Could not remove file %s",
@@ -322,6 +452,7 @@ int vaccel_blob_release(struct vaccel_blob *blob)
 	}
 	blob->path = NULL;
 	blob->path_owned = false;
+	blob->memfd = -1;
 
 	blob->type = VACCEL_BLOB_MAX;
 
@@ -414,17 +545,94 @@ int vaccel_blob_read(struct vaccel_blob *blob)
 	if (!blob->path)
 		return VACCEL_EINVAL;
 
-	int ret = fs_file_read_mmap(blob->path, (void **)&blob->data,
-				    &blob->size);
-	if (ret == VACCEL_OK)
-		blob->type = VACCEL_BLOB_MAPPED;
+	int ret = fs_file_mmap(blob->path, blob_mmap_flags(blob),
+			       (void **)&blob->data, &blob->size);
+	if (ret)
+		return ret;
+
+	blob->type = VACCEL_BLOB_MAPPED;
+	blob_mapped(blob);
+
+	return VACCEL_OK;
+}
+
+/* Read many blobs in memory at once.
+ *
+ * This reads the content of the files of the blobs that have not already been
+ * read, batching the file operations where possible. If any of the blobs
+ * can't be read, none of them is.
+ */
+int vaccel_blob_read_multi(struct vaccel_blob **blobs, size_t nr_blobs)
+{
+	if (!blobs || !nr_blobs)
+		return VACCEL_EINVAL;
+
+	size_t nr_unread = 0;
+	for (size_t i = 0; i < nr_blobs; i++) {
+		if (!blobs[i] || blobs[i]->type >= VACCEL_BLOB_MAX)
+			return VACCEL_EINVAL;
+
+		if (blobs[i]->data)
+			continue;
+
+		if (!blobs[i]->path)
+			return VACCEL_EINVAL;
+
+		nr_unread++;
+	}
+
+	if (!nr_unread)
+		return VACCEL_OK;
+
+	int ret = VACCEL_ENOMEM;
+	struct vaccel_blob **unread = (struct vaccel_blob **)malloc(
+		nr_unread * sizeof(*unread));
+	const char **paths =
+		(const char **)malloc(nr_unread * sizeof(*paths));
+	unsigned int *flags =
+		(unsigned int *)malloc(nr_unread * sizeof(*flags));
+	void **data = (void **)malloc(nr_unread * sizeof(*data));
+	size_t *sizes = (size_t *)malloc(nr_unread * sizeof(*sizes));
+	if (!unread || !paths || !flags || !data || !sizes)
+		goto free;
+
+	size_t n = 0;
+	for (size_t i = 0; i < nr_blobs; i++) {
+		if (blobs[i]->data)
+			continue;
+
+		unread[n] = blobs[i];
+		paths[n] = blobs[i]->path;
+		flags[n] = blob_mmap_flags(blobs[i]);
+		n++;
+	}
+
+	ret = fs_files_mmap(paths, nr_unread, flags, data, sizes);
+	if (ret)
+		goto free;
+
+	for (size_t i = 0; i < nr_unread; i++) {
+		unread[i]->data = (uint8_t *)data[i];
+		unread[i]->size = sizes[i];
+		unread[i]->type = VACCEL_BLOB_MAPPED;
+		blob_mapped(unread[i]);
+	}
+
+free:
+	free(sizes);
+	free(data);
+	free(flags);
+	free(paths);
+	free(unread);
+
 	return ret;
 }
 
 /* Get the data of the blob.
  *
  * If the data have not been loaded to memory, this will do so through a call to
- * `vaccel_file_read()`.
+ * `vaccel_file_read()`. Accesses to mapped blob files are tracked against the
+ * blob cache budget.
  */
 uint8_t *vaccel_blob_data(struct vaccel_blob *blob, size_t *size)
 {
@@ -436,6 +644,10 @@ uint8_t *vaccel_blob_data(struct vaccel_blob *blob, size_t *size)
 		if (vaccel_blob_read(blob))
 			return NULL;
 
+	/* Only blobs tracked when mapped count against the budget */
+	if (blob->cache_entry)
+		blob_cache_access(blob);
+
 	if (size)
 		*size = blob->size;
 
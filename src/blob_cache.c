@@ -0,0 +1,271 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#define _POSIX_C_SOURCE 200809L
+#define _DEFAULT_SOURCE
+
+#include "blob_cache.h"
+#include "blob.h"
+#include "config.h"
+#include "core.h"
+#include "error.h"
+#include "list.h"
+#include "log.h"
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+
+struct blob_cache_entry {
+	/* blob the entry tracks */
+	struct vaccel_blob *blob;
+
+	/* mapped data of the blob, in bytes */
+	size_t size;
+
+	/* true if the data of the blob has been dropped from memory */
+	bool evicted;
+
+	/* entry for the cache's LRU or evicted list */
+	struct vaccel_list_entry entry;
+};
+
+static struct {
+	/* true if the blob cache has been initialized */
+	bool initialized;
+
+	/* blobs with data in memory, least recently used first */
+	struct vaccel_list_entry lru;
+
+	/* blobs with data dropped from memory */
+	struct vaccel_list_entry evicted;
+
+	/* memory budget in bytes; 0 for no limit */
+	size_t budget;
+
+	/* counters */
+	struct vaccel_blob_cache_stats stats;
+
+	/* lock for the entries and counters. Blob data is dropped with the
+	 * lock held, so blobs cannot be unmapped while being evicted */
+	pthread_mutex_t lock;
+} cache = { .initialized = false, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+#define blob_cache_for_each_safe(iter, tmp, list)           \
+	list_for_each_container_safe((iter), (tmp), (list), \
+				     struct blob_cache_entry, entry)
+
+int blob_cache_bootstrap(void)
+{
+	pthread_mutex_lock(&cache.lock);
+
+	list_init(&cache.lru);
+	list_init(&cache.evicted);
+	cache.budget = vaccel_config()->blob_cache_size;
+	cache.stats = (struct vaccel_blob_cache_stats){ 0 };
+	cache.initialized = true;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+/* Must be called with the lock held */
+static void entry_free(struct blob_cache_entry *e)
+{
+	list_unlink_entry(&e->entry);
+	if (!e->evicted) {
+		cache.stats.nr_blobs--;
+		cache.stats.size -= e->size;
+	}
+
+	e->blob->cache_entry = NULL;
+	free(e);
+}
+
+/* Drop the data of a blob from memory. The mapping is kept, so the data is
+ * read back from the blob file when accessed again. Only read-only shared
+ * mappings are tracked, so no changes are lost. Must be called with the lock
+ * held */
+static void entry_evict(struct blob_cache_entry *e)
+{
+	vaccel_debug("Evicting data of blob %s (%zu bytes)", e->blob->path,
+		     e->size);
+
+	if (madvise(e->blob->data, e->size, MADV_DONTNEED))
+		vaccel_warn("Could not drop data of blob %s: %s",
+			    e->blob->path, strerror(errno));
+
+	list_unlink_entry(&e->entry);
+	list_add_tail(&cache.evicted, &e->entry);
+	e->evicted = true;
+
+	cache.stats.nr_blobs--;
+	cache.stats.size -= e->size;
+	cache.stats.evictions++;
+}
+
+/* Evict the data of least recently used blobs, apart from `keep`, until the
+ * cache fits its budget. Must be called with the lock held */
+static void evict_over_budget(const struct blob_cache_entry *keep)
+{
+	if (!cache.budget)
+		return;
+
+	struct blob_cache_entry *e;
+	struct blob_cache_entry *tmp;
+	blob_cache_for_each_safe(e, tmp, &cache.lru)
+	{
+		if (cache.stats.size <= cache.budget)
+			break;
+
+		if (e == keep)
+			continue;
+
+		entry_evict(e);
+	}
+}
+
+int blob_cache_cleanup(void)
+{
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_OK;
+	}
+
+	struct blob_cache_entry *e;
+	struct blob_cache_entry *tmp;
+	blob_cache_for_each_safe(e, tmp, &cache.lru)
+	{
+		entry_free(e);
+	}
+	blob_cache_for_each_safe(e, tmp, &cache.evicted)
+	{
+		entry_free(e);
+	}
+	cache.initialized = false;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+void blob_cache_add(struct vaccel_blob *blob)
+{
+	if (!blob || !blob->data || !blob->size)
+		return;
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized || blob->cache_entry) {
+		pthread_mutex_unlock(&cache.lock);
+		return;
+	}
+
+	struct blob_cache_entry *e =
+		(struct blob_cache_entry *)malloc(sizeof(*e));
+	if (!e) {
+		pthread_mutex_unlock(&cache.lock);
+		return;
+	}
+
+	e->blob = blob;
+	e->size = blob->size;
+	e->evicted = false;
+	blob->cache_entry = e;
+
+	list_add_tail(&cache.lru, &e->entry);
+	cache.stats.nr_blobs++;
+	cache.stats.size += e->size;
+
+	evict_over_budget(e);
+
+	pthread_mutex_unlock(&cache.lock);
+}
+
+void blob_cache_access(struct vaccel_blob *blob)
+{
+	if (!blob)
+		return;
+
+	pthread_mutex_lock(&cache.lock);
+
+	struct blob_cache_entry *e = blob->cache_entry;
+	if (!cache.initialized || !e) {
+		pthread_mutex_unlock(&cache.lock);
+		return;
+	}
+
+	if (e->evicted) {
+		list_unlink_entry(&e->entry);
+		list_add_tail(&cache.lru, &e->entry);
+		e->evicted = false;
+
+		cache.stats.nr_blobs++;
+		cache.stats.size += e->size;
+		cache.stats.refaults++;
+
+		/* Read back eagerly what was asked to be read eagerly when
+		 * mapped */
+		if ((blob->map_flags &
+		     (VACCEL_BLOB_MAP_POPULATE | VACCEL_BLOB_MAP_WILLNEED)) &&
+		    madvise(blob->data, e->size, MADV_WILLNEED))
+			vaccel_debug("Could not advise read of blob %s: %s",
+				     blob->path, strerror(errno));
+	} else {
+		/* Keep the LRU order */
+		list_unlink_entry(&e->entry);
+		list_add_tail(&cache.lru, &e->entry);
+	}
+
+	evict_over_budget(e);
+
+	pthread_mutex_unlock(&cache.lock);
+}
+
+void blob_cache_remove(struct vaccel_blob *blob)
+{
+	if (!blob)
+		return;
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (blob->cache_entry)
+		entry_free(blob->cache_entry);
+
+	pthread_mutex_unlock(&cache.lock);
+}
+
+int vaccel_blob_cache_set_budget(size_t size)
+{
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_EPERM;
+	}
+
+	cache.budget = size;
+	evict_over_budget(NULL);
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+int vaccel_blob_cache_stats(struct vaccel_blob_cache_stats *stats)
+{
+	if (!stats)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cache.lock);
+	*stats = cache.stats;
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
@@ -0,0 +1,29 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "blob.h"
+#include "include/vaccel/blob_cache.h" // IWYU pragma: export
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int blob_cache_bootstrap(void);
+int blob_cache_cleanup(void);
+
+/* Start tracking the data of a newly mapped blob, evicting the data of others
+ * to stay within the budget. Only for blob files mapped read-only and shared,
+ * so that dropped data can be read back unchanged. */
+void blob_cache_add(struct vaccel_blob *blob);
+
+/* Mark a tracked blob as most recently used, reading back its data if it had
+ * been dropped and evicting the data of others to stay within the budget */
+void blob_cache_access(struct vaccel_blob *blob);
+
+/* Stop tracking a blob that is being released */
+void blob_cache_remove(struct vaccel_blob *blob);
+
+#ifdef __cplusplus
+}
+#endif
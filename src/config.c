@@ -10,6 +10,7 @@
 #include <limits.h>
 #include <linux/limits.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
@@ -70,6 +71,22 @@ static int config_str_from_env(char **config_str, const char *str_env,
 	return VACCEL_OK;
 }
 
+/* Ids of sessions/resources are limited to 32 bits */
+static int config_max_from_env(size_t *config_max, const char *max_env,
+			       size_t max_default)
+{
+	unsigned long max_ul;
+	int ret = config_ulong_from_env(&max_ul, max_env, max_default);
+	if (ret)
+		return ret;
+	if (!max_ul || max_ul > UINT32_MAX)
+		return VACCEL_EINVAL;
+
+	*config_max = (size_t)max_ul;
+
+	return VACCEL_OK;
+}
+
 static inline const char *config_deprecate_env(const char *old, const char *new)
 {
 	if (getenv(old) && !getenv(new)) {
@@ -97,6 +114,15 @@ int vaccel_config_init(struct vaccel_config *config, const char *plugins,
 		return VACCEL_ENOMEM;
 	config->profiling_enabled = profiling_enabled;
 	config->version_ignore = version_ignore;
+	config->sched_policy = CONFIG_SCHED_POLICY_DEFAULT;
+	config->max_sessions = CONFIG_MAX_SESSIONS_DEFAULT;
+	config->max_resources = CONFIG_MAX_RESOURCES_DEFAULT;
+	config->model_cache_size = CONFIG_MODEL_CACHE_SIZE_DEFAULT;
+	config->download_cache_dir = CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT;
+	config->download_cache_size = CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT;
+	config->download_in_memory = CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT;
+	config->blobs_in_memory = CONFIG_BLOBS_IN_MEMORY_DEFAULT;
+	config->blob_cache_size = CONFIG_BLOB_CACHE_SIZE_DEFAULT;
 
 	return VACCEL_OK;
 }
@@ -140,6 +166,69 @@ int vaccel_config_init_from_env(struct vaccel_config *config)
 	if (ret)
 		return ret;
 
+	unsigned long sched_policy_ul;
+	ret = config_ulong_from_env(&sched_policy_ul, CONFIG_SCHED_POLICY_ENV,
+				    (unsigned long)CONFIG_SCHED_POLICY_DEFAULT);
+	if (ret)
+		return ret;
+	if (sched_policy_ul >= VACCEL_SCHED_MAX)
+		return VACCEL_EINVAL;
+	config->sched_policy = (vaccel_sched_policy_t)sched_policy_ul;
+
+	ret = config_max_from_env(&config->max_sessions,
+				  CONFIG_MAX_SESSIONS_ENV,
+				  CONFIG_MAX_SESSIONS_DEFAULT);
+	if (ret)
+		return ret;
+
+	ret = config_max_from_env(&config->max_resources,
+				  CONFIG_MAX_RESOURCES_ENV,
+				  CONFIG_MAX_RESOURCES_DEFAULT);
+	if (ret)
+		return ret;
+
+	unsigned long model_cache_size_ul;
+	ret = config_ulong_from_env(&model_cache_size_ul,
+				    CONFIG_MODEL_CACHE_SIZE_ENV,
+				    CONFIG_MODEL_CACHE_SIZE_DEFAULT);
+	if (ret)
+		return ret;
+	config->model_cache_size = (size_t)model_cache_size_ul;
+
+	ret = config_str_from_env(&config->download_cache_dir,
+				  CONFIG_DOWNLOAD_CACHE_DIR_ENV,
+				  CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT);
+	if (ret)
+		return ret;
+
+	unsigned long download_cache_size_ul;
+	ret = config_ulong_from_env(&download_cache_size_ul,
+				    CONFIG_DOWNLOAD_CACHE_SIZE_ENV,
+				    CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT);
+	if (ret)
+		return ret;
+	config->download_cache_size = (size_t)download_cache_size_ul;
+
+	ret = config_bool_from_env(&config->download_in_memory,
+				   CONFIG_DOWNLOAD_IN_MEMORY_ENV,
+				   CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT);
+	if (ret)
+		return ret;
+
+	ret = config_bool_from_env(&config->blobs_in_memory,
+				   CONFIG_BLOBS_IN_MEMORY_ENV,
+				   CONFIG_BLOBS_IN_MEMORY_DEFAULT);
+	if (ret)
+		return ret;
+
+	unsigned long blob_cache_size_ul;
+	ret = config_ulong_from_env(&blob_cache_size_ul,
+				    CONFIG_BLOB_CACHE_SIZE_ENV,
+				    CONFIG_BLOB_CACHE_SIZE_DEFAULT);
+	if (ret)
+		return ret;
+	config->blob_cache_size = (size_t)blob_cache_size_ul;
+
 	return VACCEL_OK;
 }
 
@@ -160,6 +249,20 @@ int vaccel_config_init_from(struct vaccel_config *config,
 		return VACCEL_ENOMEM;
 	config->profiling_enabled = config_src->profiling_enabled;
 	config->version_ignore = config_src->version_ignore;
+	config->sched_policy = config_src->sched_policy;
+	config->max_sessions = config_src->max_sessions;
+	config->max_resources = config_src->max_resources;
+	config->model_cache_size = config_src->model_cache_size;
+	config->download_cache_dir =
+		config_src->download_cache_dir ?
+			strdup(config_src->download_cache_dir) :
+			NULL;
+	if (config_src->download_cache_dir && !config->download_cache_dir)
+		return VACCEL_ENOMEM;
+	config->download_cache_size = config_src->download_cache_size;
+	config->download_in_memory = config_src->download_in_memory;
+	config->blobs_in_memory = config_src->blobs_in_memory;
+	config->blob_cache_size = config_src->blob_cache_size;
 
 	return VACCEL_OK;
 }
@@ -173,12 +276,23 @@ int vaccel_config_release(struct vaccel_config *config)
 		free(config->plugins);
 	if (config->log_file)
 		free(config->log_file);
+	if (config->download_cache_dir)
+		free(config->download_cache_dir);
 
 	config->plugins = CONFIG_PLUGINS_DEFAULT;
 	config->log_level = CONFIG_LOG_LEVEL_DEFAULT;
 	config->log_file = CONFIG_LOG_FILE_DEFAULT;
 	config->profiling_enabled = CONFIG_PROFILING_ENABLED_DEFAULT;
 	config->version_ignore = CONFIG_VERSION_IGNORE_DEFAULT;
+	config->sched_policy = CONFIG_SCHED_POLICY_DEFAULT;
+	config->max_sessions = CONFIG_MAX_SESSIONS_DEFAULT;
+	config->max_resources = CONFIG_MAX_RESOURCES_DEFAULT;
+	config->model_cache_size = CONFIG_MODEL_CACHE_SIZE_DEFAULT;
+	config->download_cache_dir = CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT;
+	config->download_cache_size = CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT;
+	config->download_in_memory = CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT;
+	config->blobs_in_memory = CONFIG_BLOBS_IN_MEMORY_DEFAULT;
+	config->blob_cache_size = CONFIG_BLOB_CACHE_SIZE_DEFAULT;
 
 	return VACCEL_OK;
 }
@@ -281,4 +395,20 @@ void vaccel_config_print_debug(struct vaccel_config *config)
 		     config->profiling_enabled ? "true" : "false");
 	vaccel_debug("  version_ignore = %s",
 		     config->version_ignore ? "true" : "false");
+
+	char sched_policy_str[NAME_MAX];
+	vaccel_debug("  sched_policy = %s",
+		     vaccel_sched_policy_name(config->sched_policy,
+					      sched_policy_str, NAME_MAX));
+	vaccel_debug("  max_sessions = %zu", config->max_sessions);
+	vaccel_debug("  max_resources = %zu", config->max_resources);
+	vaccel_debug("  model_cache_size = %zu", config->model_cache_size);
+	vaccel_debug("  download_cache_dir = %s", config->download_cache_dir);
+	vaccel_debug("  download_cache_size = %zu",
+		     config->download_cache_size);
+	vaccel_debug("  download_in_memory = %s",
+		     config->download_in_memory ? "true" : "false");
+	vaccel_debug("  blobs_in_memory = %s",
+		     config->blobs_in_memory ? "true" : "false");
+	vaccel_debug("  blob_cache_size = %zu", config->blob_cache_size);
 }
@@ -11,6 +11,15 @@
 #define CONFIG_PLUGINS_DEFAULT NULL
 #define CONFIG_PROFILING_ENABLED_DEFAULT false
 #define CONFIG_VERSION_IGNORE_DEFAULT false
+#define CONFIG_SCHED_POLICY_DEFAULT VACCEL_SCHED_STATIC
+#define CONFIG_MAX_SESSIONS_DEFAULT ((size_t)1 << 20)
+#define CONFIG_MAX_RESOURCES_DEFAULT ((size_t)1 << 20)
+#define CONFIG_MODEL_CACHE_SIZE_DEFAULT 0
+#define CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT NULL
+#define CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT 0
+#define CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT false
+#define CONFIG_BLOBS_IN_MEMORY_DEFAULT false
+#define CONFIG_BLOB_CACHE_SIZE_DEFAULT 0
 
 #define CONFIG_LOG_LEVEL_ENV "VACCEL_LOG_LEVEL"
 #define CONFIG_LOG_LEVEL_OLD_ENV "VACCEL_DEBUG_LEVEL"
@@ -20,3 +29,12 @@
 #define CONFIG_PROFILING_ENABLED_ENV "VACCEL_PROFILING_ENABLED"
 #define CONFIG_VERSION_IGNORE_ENV "VACCEL_VERSION_IGNORE"
 #define CONFIG_VERSION_IGNORE_OLD_ENV "VACCEL_IGNORE_VERSION"
+#define CONFIG_SCHED_POLICY_ENV "VACCEL_SCHED_POLICY"
+#define CONFIG_MAX_SESSIONS_ENV "VACCEL_MAX_SESSIONS"
+#define CONFIG_MAX_RESOURCES_ENV "VACCEL_MAX_RESOURCES"
+#define CONFIG_MODEL_CACHE_SIZE_ENV "VACCEL_MODEL_CACHE_SIZE"
+#define CONFIG_DOWNLOAD_CACHE_DIR_ENV "VACCEL_DOWNLOAD_CACHE_DIR"
+#define CONFIG_DOWNLOAD_CACHE_SIZE_ENV "VACCEL_DOWNLOAD_CACHE_SIZE"
+#define CONFIG_DOWNLOAD_IN_MEMORY_ENV "VACCEL_DOWNLOAD_IN_MEMORY"
+#define CONFIG_BLOBS_IN_MEMORY_ENV "VACCEL_BLOBS_IN_MEMORY"
+#define CONFIG_BLOB_CACHE_SIZE_ENV "VACCEL_BLOB_CACHE_SIZE"
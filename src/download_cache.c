@@ -0,0 +1,557 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "download_cache.h"
+#include "config.h"
+#include "core.h"
+#include "error.h"
+#include "log.h"
+#include "utils/fs.h"
+#include "utils/net.h"
+#include "utils/path.h"
+#include <errno.h>
+#include <fcntl.h>
+#include <inttypes.h>
+#include <limits.h>
+#include <linux/limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
+
+/* Cached files are kept as two files in the cache directory:
+ * - `<url key>.meta`, with the URL, its validators and the data file name
+ * - `<url key>-<version key>.data`, with the contents of the URL
+ * A new version of a URL gets a new data file. Files are replaced with
+ * renames, so processes sharing the directory never see partial ones. Data
+ * is copied in and out of the cache (reflinked where the filesystem can), so
+ * users writing to their files never change the cached ones, and vice
+ * versa. */
+#define META_SUFFIX ".meta"
+#define DATA_SUFFIX ".data"
+#define TMP_SUFFIX ".tmp"
+
+static struct {
+	/* true if the download cache has been initialized */
+	bool initialized;
+
+	/* cache directory; NULL if the cache is disabled */
+	char *dir;
+
+	/* size limit in bytes; 0 for no limit */
+	size_t budget;
+
+	/* counters */
+	struct vaccel_download_cache_stats stats;
+
+	/* lock for the cache files and counters */
+	pthread_mutex_t lock;
+} cache = { .initialized = false, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+#define FNV_OFFSET_BASIS 14695981039346656037ULL
+#define FNV_PRIME 1099511628211ULL
+
+/* FNV-1a hash of a string, including its terminator so consecutive strings
+ * can be hashed together unambiguously */
+static uint64_t hash_str(uint64_t hash, const char *str)
+{
+	const unsigned char *p = (const unsigned char *)str;
+	do {
+		hash ^= *p;
+		hash *= FNV_PRIME;
+	} while (*p++);
+
+	return hash;
+}
+
+static int meta_path_init(char *path, size_t size, const char *url)
+{
+	char name[NAME_MAX];
+	snprintf(name, sizeof(name), "%016" PRIx64 META_SUFFIX,
+		 hash_str(FNV_OFFSET_BASIS, url));
+
+	return path_init_from_parts(path, size, cache.dir, name, NULL);
+}
+
+static void data_name_init(char *name, size_t size, const char *url,
+			   const struct net_file_validators *v)
+{
+	uint64_t version = hash_str(FNV_OFFSET_BASIS, url);
+	version = hash_str(version, v->etag);
+	version = hash_str(version, v->last_modified);
+
+	snprintf(name, size, "%016" PRIx64 "-%016" PRIx64 DATA_SUFFIX,
+		 hash_str(FNV_OFFSET_BASIS, url), version);
+}
+
+/* Read a line without its newline into buf */
+static bool meta_line_read(FILE *fp, char *buf, size_t size)
+{
+	if (!fgets(buf, (int)size, fp))
+		return false;
+
+	size_t len = strcspn(buf, "\n");
+	if (buf[len] != '\n')
+		return false;
+	buf[len] = '\0';
+
+	return true;
+}
+
+/* Read the validators and data file name of a URL from its meta file */
+static int meta_read(const char *meta_path, const char *url,
+		     struct net_file_validators *v, char *data_name,
+		     size_t size)
+{
+	FILE *fp = fopen(meta_path, "r");
+	if (!fp)
+		return VACCEL_ENOENT;
+
+	int ret = VACCEL_OK;
+	char line[PATH_MAX];
+	if (!meta_line_read(fp, line, sizeof(line)) ||
+	    strcmp(line, url) != 0 ||
+	    !meta_line_read(fp, v->etag, sizeof(v->etag)) ||
+	    !meta_line_read(fp, v->last_modified, sizeof(v->last_modified)) ||
+	    !meta_line_read(fp, data_name, size))
+		ret = VACCEL_ENOENT;
+
+	fclose(fp);
+
+	if (ret) {
+		v->etag[0] = '\0';
+		v->last_modified[0] = '\0';
+	}
+
+	return ret;
+}
+
+static int meta_write(const char *meta_path, const char *url,
+		      const struct net_file_validators *v,
+		      const char *data_name)
+{
+	char tmp_path[PATH_MAX];
+	int len = snprintf(tmp_path, sizeof(tmp_path), "%s.%d" TMP_SUFFIX,
+			   meta_path, (int)getpid());
+	if (len < 0 || (size_t)len >= sizeof(tmp_path))
+		return VACCEL_ENAMETOOLONG;
+
+	FILE *fp = fopen(tmp_path, "w");
+	if (!fp)
+		return errno;
+
+	fprintf(fp, "%s\n%s\n%s\n%s\n", url, v->etag, v->last_modified,
+		data_name);
+
+	int ret = VACCEL_OK;
+	if (fclose(fp))
+		ret = errno;
+	else if (rename(tmp_path, meta_path))
+		ret = errno;
+
+	if (ret)
+		remove(tmp_path);
+
+	return ret;
+}
+
+/* Look up a URL, returning the validators to revalidate it with and the
+ * cached data file. Must be called with the lock held */
+static int entry_load(const char *url, struct net_file_validators *v,
+		      char *data_path, size_t size)
+{
+	char meta_path[PATH_MAX];
+	int ret = meta_path_init(meta_path, sizeof(meta_path), url);
+	if (ret)
+		return ret;
+
+	char data_name[NAME_MAX];
+	ret = meta_read(meta_path, url, v, data_name, sizeof(data_name));
+	if (ret)
+		return ret;
+
+	ret = path_init_from_parts(data_path, size, cache.dir, data_name,
+				   NULL);
+	if (ret || !fs_path_is_file(data_path)) {
+		v->etag[0] = '\0';
+		v->last_modified[0] = '\0';
+		return VACCEL_ENOENT;
+	}
+
+	return VACCEL_OK;
+}
+
+/* Add a downloaded file to the cache. Must be called with the lock held */
+static int entry_store(const char *url, const char *download_path,
+		       const struct net_file_validators *v)
+{
+	/* Files without validators can't be revalidated */
+	if (!v->etag[0] && !v->last_modified[0])
+		return VACCEL_OK;
+
+	char meta_path[PATH_MAX];
+	int ret = meta_path_init(meta_path, sizeof(meta_path), url);
+	if (ret)
+		return ret;
+
+	char data_name[NAME_MAX];
+	data_name_init(data_name, sizeof(data_name), url, v);
+
+	char data_path[PATH_MAX];
+	ret = path_init_from_parts(data_path, sizeof(data_path), cache.dir,
+				   data_name, NULL);
+	if (ret)
+		return ret;
+
+	if (!fs_path_is_file(data_path)) {
+		char tmp_path[PATH_MAX];
+		int len = snprintf(tmp_path, sizeof(tmp_path),
+				   "%s.%d" TMP_SUFFIX, data_path,
+				   (int)getpid());
+		if (len < 0 || (size_t)len >= sizeof(tmp_path))
+			return VACCEL_ENAMETOOLONG;
+
+		ret = fs_file_copy(download_path, tmp_path);
+		if (ret)
+			return ret;
+
+		if (rename(tmp_path, data_path)) {
+			ret = errno;
+			remove(tmp_path);
+			return ret;
+		}
+	}
+
+	/* Keep the previous version until the new one is in place */
+	struct net_file_validators old_v;
+	char old_data_name[NAME_MAX];
+	bool replaced = !meta_read(meta_path, url, &old_v, old_data_name,
+				   sizeof(old_data_name)) &&
+			strcmp(old_data_name, data_name) != 0;
+
+	ret = meta_write(meta_path, url, v, data_name);
+	if (ret) {
+		remove(data_path);
+		return ret;
+	}
+
+	if (replaced) {
+		char old_data_path[PATH_MAX];
+		if (!path_init_from_parts(old_data_path, sizeof(old_data_path),
+					  cache.dir, old_data_name, NULL))
+			remove(old_data_path);
+	}
+
+	/* Stored files are the most recently used */
+	utimensat(AT_FDCWD, data_path, NULL, 0);
+
+	return VACCEL_OK;
+}
+
+struct data_file {
+	char *path;
+	off_t size;
+	struct timespec mtime;
+};
+
+static int data_file_cmp(const void *a, const void *b)
+{
+	const struct timespec *ta = &((const struct data_file *)a)->mtime;
+	const struct timespec *tb = &((const struct data_file *)b)->mtime;
+
+	if (ta->tv_sec != tb->tv_sec)
+		return (ta->tv_sec < tb->tv_sec) ? -1 : 1;
+	if (ta->tv_nsec != tb->tv_nsec)
+		return (ta->tv_nsec < tb->tv_nsec) ? -1 : 1;
+	return 0;
+}
+
+static bool str_has_suffix(const char *str, const char *suffix)
+{
+	size_t len = strlen(str);
+	size_t suffix_len = strlen(suffix);
+
+	return len >= suffix_len &&
+	       strcmp(str + len - suffix_len, suffix) == 0;
+}
+
+/* Remove a data file and the meta file naming it */
+static void data_file_remove(const char *data_path)
+{
+	char meta_path[PATH_MAX];
+	const char *name = strrchr(data_path, '/');
+	name = name ? name + 1 : data_path;
+
+	/* The URL key is the first part of the data file name */
+	const char *sep = strchr(name, '-');
+	if (sep) {
+		char meta_name[NAME_MAX];
+		snprintf(meta_name, sizeof(meta_name), "%.*s" META_SUFFIX,
+			 (int)(sep - name), name);
+
+		FILE *fp = NULL;
+		if (!path_init_from_parts(meta_path, sizeof(meta_path),
+					  cache.dir, meta_name, NULL))
+			fp = fopen(meta_path, "r");
+		if (fp) {
+			/* The data file name is on the last line */
+			char line[PATH_MAX];
+			bool names_data = false;
+			while (meta_line_read(fp, line, sizeof(line)))
+				names_data = strcmp(line, name) == 0;
+			fclose(fp);
+
+			if (names_data)
+				remove(meta_path);
+		}
+	}
+
+	remove(data_path);
+}
+
+/* Recount the cached files and evict least recently used ones until the
+ * cache fits its budget. Other processes may share the directory, so the
+ * files are always scanned. Must be called with the lock held */
+static int scan_and_evict(void)
+{
+	char **files;
+	size_t nr_files;
+	int ret = fs_dir_list_files(cache.dir, &files, &nr_files);
+	if (ret)
+		return ret;
+
+	struct data_file *data = NULL;
+	if (nr_files) {
+		data = (struct data_file *)malloc(nr_files * sizeof(*data));
+		if (!data) {
+			ret = VACCEL_ENOMEM;
+			goto free_files;
+		}
+	}
+
+	size_t nr_data = 0;
+	size_t size = 0;
+	for (size_t i = 0; i < nr_files; i++) {
+		struct stat st;
+		if (!str_has_suffix(files[i], DATA_SUFFIX) ||
+		    stat(files[i], &st))
+			continue;
+
+		data[nr_data].path = files[i];
+		data[nr_data].size = st.st_size;
+		data[nr_data].mtime = st.st_mtim;
+		size += (size_t)st.st_size;
+		nr_data++;
+	}
+
+	size_t nr_evicted = 0;
+	if (cache.budget && size > cache.budget) {
+		qsort(data, nr_data, sizeof(*data), data_file_cmp);
+
+		for (; nr_evicted < nr_data && size > cache.budget;
+		     nr_evicted++) {
+			struct data_file *d = &data[nr_evicted];
+
+			vaccel_debug("Evicting %s from download cache",
+				     d->path);
+			data_file_remove(d->path);
+			size -= (size_t)d->size;
+			cache.stats.evictions++;
+		}
+	}
+
+	cache.stats.nr_files = nr_data - nr_evicted;
+	cache.stats.size = size;
+
+	free(data);
+free_files:
+	for (size_t i = 0; i < nr_files; i++)
+		free(files[i]);
+	free(files);
+
+	return ret;
+}
+
+int download_cache_bootstrap(void)
+{
+	const struct vaccel_config *config = vaccel_config();
+
+	pthread_mutex_lock(&cache.lock);
+
+	cache.dir = NULL;
+	cache.budget = config->download_cache_size;
+	cache.stats = (struct vaccel_download_cache_stats){ 0 };
+	cache.initialized = true;
+
+	if (!config->download_cache_dir)
+		goto unlock;
+
+	/* The cache only saves downloads; vAccel works without it */
+	int ret = fs_dir_create(config->download_cache_dir);
+	if (ret && ret != VACCEL_EEXIST) {
+		vaccel_warn("Could not create download cache dir %s; disabling download cache",
+			    config->download_cache_dir);
+		goto unlock;
+	}
+
+	cache.dir = strdup(config->download_cache_dir);
+	if (!cache.dir) {
+		vaccel_warn("Could not allocate download cache dir; disabling download cache");
+		goto unlock;
+	}
+
+	if (scan_and_evict())
+		vaccel_warn("Could not scan download cache dir %s", cache.dir);
+
+	vaccel_debug("Download cache at %s with %zu files (%zu bytes)",
+		     cache.dir, cache.stats.nr_files, cache.stats.size);
+
+unlock:
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+int download_cache_cleanup(void)
+{
+	pthread_mutex_lock(&cache.lock);
+
+	free(cache.dir);
+	cache.dir = NULL;
+	cache.initialized = false;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+/* Remove the downloaded files of a failed download */
+static void download_paths_remove(const char **download_paths,
+				  size_t nr_files)
+{
+	for (size_t i = 0; i < nr_files; i++) {
+		if (fs_path_is_file(download_paths[i]))
+			fs_file_remove(download_paths[i]);
+	}
+}
+
+int download_cache_files_download(const char **paths,
+				  const char **download_paths,
+				  size_t nr_files)
+{
+	if (!paths || !download_paths || !nr_files)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cache.lock);
+	if (!cache.dir) {
+		pthread_mutex_unlock(&cache.lock);
+		return net_files_download(paths, download_paths, nr_files);
+	}
+
+	int ret;
+	struct net_file_validators *validators =
+		(struct net_file_validators *)calloc(nr_files,
+						     sizeof(*validators));
+	char(*data_paths)[PATH_MAX] =
+		(char(*)[PATH_MAX])calloc(nr_files, sizeof(*data_paths));
+	if (!validators || !data_paths) {
+		pthread_mutex_unlock(&cache.lock);
+		ret = VACCEL_ENOMEM;
+		goto free;
+	}
+
+	for (size_t i = 0; i < nr_files; i++) {
+		if (!paths[i]) {
+			pthread_mutex_unlock(&cache.lock);
+			ret = VACCEL_EINVAL;
+			goto free;
+		}
+		entry_load(paths[i], &validators[i], data_paths[i],
+			   sizeof(data_paths[i]));
+	}
+
+	/* Don't hold the lock over the network */
+	pthread_mutex_unlock(&cache.lock);
+
+	ret = net_files_download_validated(paths, download_paths, validators,
+					   nr_files);
+	if (ret)
+		goto free;
+
+	pthread_mutex_lock(&cache.lock);
+
+	/* Files that were validated but are no longer cached */
+	size_t nr_refetch = 0;
+	for (size_t i = 0; i < nr_files; i++) {
+		if (!validators[i].not_modified) {
+			cache.stats.misses++;
+			if (entry_store(paths[i], download_paths[i],
+					&validators[i]))
+				vaccel_warn("Could not add %s to download cache",
+					    paths[i]);
+			continue;
+		}
+
+		if (!fs_file_copy(data_paths[i], download_paths[i])) {
+			cache.stats.hits++;
+			utimensat(AT_FDCWD, data_paths[i], NULL, 0);
+			validators[i].not_modified = false;
+			continue;
+		}
+
+		cache.stats.misses++;
+		nr_refetch++;
+	}
+
+	if (scan_and_evict())
+		vaccel_warn("Could not scan download cache dir %s", cache.dir);
+
+	pthread_mutex_unlock(&cache.lock);
+
+	/* Another process evicted them in the meantime */
+	for (size_t i = 0; nr_refetch && i < nr_files; i++) {
+		if (!validators[i].not_modified)
+			continue;
+
+		vaccel_debug("Could not use cached %s; downloading it",
+			     paths[i]);
+		ret = net_file_download(paths[i], download_paths[i]);
+		if (ret) {
+			download_paths_remove(download_paths, nr_files);
+			goto free;
+		}
+	}
+
+free:
+	free(data_paths);
+	free(validators);
+
+	return ret;
+}
+
+int vaccel_download_cache_stats(struct vaccel_download_cache_stats *stats)
+{
+	if (!stats)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_EPERM;
+	}
+
+	*stats = cache.stats;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
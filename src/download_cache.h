@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/download_cache.h" // IWYU pragma: export
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int download_cache_bootstrap(void);
+int download_cache_cleanup(void);
+
+/* Download files like net_files_download(), through the cache if it is
+ * enabled. Cached files are revalidated with the server and copied to the
+ * download paths if not modified; downloaded ones are added to the cache. */
+int download_cache_files_download(const char **paths,
+				  const char **download_paths,
+				  size_t nr_files);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,350 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "graph.h"
+#include "arg.h"
+#include "async.h"
+#include "error.h"
+#include "log.h"
+#include "op.h"
+#include "ops/genop.h"
+#include "session.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum { GRAPH_MIN_CAPACITY = 8, GRAPH_WAIT_BATCH = 16 };
+
+int vaccel_graph_init(struct vaccel_graph *graph)
+{
+	if (!graph)
+		return VACCEL_EINVAL;
+
+	graph->nodes = NULL;
+	graph->nr_nodes = 0;
+	graph->nodes_capacity = 0;
+	graph->edges = NULL;
+	graph->nr_edges = 0;
+	graph->edges_capacity = 0;
+
+	return VACCEL_OK;
+}
+
+int vaccel_graph_release(struct vaccel_graph *graph)
+{
+	if (!graph)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < graph->nr_nodes; i++)
+		free(graph->nodes[i].read);
+	free(graph->nodes);
+	free(graph->edges);
+
+	return vaccel_graph_init(graph);
+}
+
+int vaccel_graph_new(struct vaccel_graph **graph)
+{
+	if (!graph)
+		return VACCEL_EINVAL;
+
+	struct vaccel_graph *g =
+		(struct vaccel_graph *)malloc(sizeof(struct vaccel_graph));
+	if (!g)
+		return VACCEL_ENOMEM;
+
+	int ret = vaccel_graph_init(g);
+	if (ret) {
+		free(g);
+		return ret;
+	}
+
+	*graph = g;
+
+	return VACCEL_OK;
+}
+
+int vaccel_graph_delete(struct vaccel_graph *graph)
+{
+	int ret = vaccel_graph_release(graph);
+	if (ret)
+		return ret;
+
+	free(graph);
+
+	return VACCEL_OK;
+}
+
+static int graph_grow(void **array, size_t *capacity, size_t elem_size)
+{
+	size_t new_capacity = (*capacity) ? *capacity * 2 : GRAPH_MIN_CAPACITY;
+
+	void *new_array = realloc(*array, new_capacity * elem_size);
+	if (!new_array)
+		return VACCEL_ENOMEM;
+
+	*array = new_array;
+	*capacity = new_capacity;
+
+	return VACCEL_OK;
+}
+
+int vaccel_graph_add_node(struct vaccel_graph *graph, struct vaccel_arg *read,
+			  int nr_read, struct vaccel_arg *write, int nr_write,
+			  size_t *node)
+{
+	if (!graph || !read || nr_read < 1 || nr_write < 0 ||
+	    (nr_write && !write))
+		return VACCEL_EINVAL;
+
+	if (graph->nr_nodes == graph->nodes_capacity) {
+		int ret = graph_grow((void **)&graph->nodes,
+				     &graph->nodes_capacity,
+				     sizeof(*graph->nodes));
+		if (ret)
+			return ret;
+	}
+
+	struct vaccel_arg *node_read = (struct vaccel_arg *)malloc(
+		(size_t)nr_read * sizeof(*node_read));
+	if (!node_read)
+		return VACCEL_ENOMEM;
+	memcpy(node_read, read, (size_t)nr_read * sizeof(*node_read));
+
+	/* The graph only references the arg buffers */
+	for (int i = 0; i < nr_read; i++)
+		node_read[i].owned = false;
+
+	struct vaccel_graph_node *n = &graph->nodes[graph->nr_nodes];
+	n->read = node_read;
+	n->nr_read = nr_read;
+	n->write = write;
+	n->nr_write = nr_write;
+	n->ret = VACCEL_ECANCELED;
+
+	if (node)
+		*node = graph->nr_nodes;
+	graph->nr_nodes++;
+
+	return VACCEL_OK;
+}
+
+static int graph_add_edge(struct vaccel_graph *graph, size_t src,
+			  int src_write, size_t dst, int dst_read)
+{
+	if (!graph || src >= graph->nr_nodes || dst >= graph->nr_nodes ||
+	    src == dst)
+		return VACCEL_EINVAL;
+
+	if (graph->nr_edges == graph->edges_capacity) {
+		int ret = graph_grow((void **)&graph->edges,
+				     &graph->edges_capacity,
+				     sizeof(*graph->edges));
+		if (ret)
+			return ret;
+	}
+
+	struct vaccel_graph_edge *e = &graph->edges[graph->nr_edges++];
+	e->src = src;
+	e->dst = dst;
+	e->src_write = src_write;
+	e->dst_read = dst_read;
+
+	return VACCEL_OK;
+}
+
+int vaccel_graph_connect(struct vaccel_graph *graph, size_t src, int src_write,
+			 size_t dst, int dst_read)
+{
+	if (!graph || src >= graph->nr_nodes || dst >= graph->nr_nodes)
+		return VACCEL_EINVAL;
+
+	/* The first read arg is the op type and can't be rewired */
+	if (src_write < 0 || src_write >= graph->nodes[src].nr_write ||
+	    dst_read < 1 || dst_read >= graph->nodes[dst].nr_read) {
+		vaccel_error("Invalid args for graph connection %zu -> %zu",
+			     src, dst);
+		return VACCEL_EINVAL;
+	}
+
+	return graph_add_edge(graph, src, src_write, dst, dst_read);
+}
+
+int vaccel_graph_depend(struct vaccel_graph *graph, size_t src, size_t dst)
+{
+	return graph_add_edge(graph, src, -1, dst, -1);
+}
+
+/* Check that the graph has no cycles, using the in-degree of each node */
+static bool graph_is_acyclic(const struct vaccel_graph *graph,
+			     const size_t *indegree, size_t *scratch)
+{
+	size_t *ready = scratch;
+	size_t nr_ready = 0;
+	size_t nr_visited = 0;
+	size_t *deg = &scratch[graph->nr_nodes];
+
+	for (size_t i = 0; i < graph->nr_nodes; i++) {
+		deg[i] = indegree[i];
+		if (!deg[i])
+			ready[nr_ready++] = i;
+	}
+
+	while (nr_ready) {
+		size_t n = ready[--nr_ready];
+		nr_visited++;
+
+		for (size_t i = 0; i < graph->nr_edges; i++) {
+			if (graph->edges[i].src == n &&
+			    !--deg[graph->edges[i].dst])
+				ready[nr_ready++] = graph->edges[i].dst;
+		}
+	}
+
+	return nr_visited == graph->nr_nodes;
+}
+
+/* Pass the connected write args of completed nodes to a node about to run */
+static void graph_node_wire(struct vaccel_graph *graph, size_t node)
+{
+	for (size_t i = 0; i < graph->nr_edges; i++) {
+		const struct vaccel_graph_edge *e = &graph->edges[i];
+		if (e->dst != node || e->src_write < 0)
+			continue;
+
+		struct vaccel_arg *arg =
+			&graph->nodes[node].read[e->dst_read];
+		*arg = graph->nodes[e->src].write[e->src_write];
+		arg->owned = false;
+	}
+}
+
+/* Record the completion of a node and queue the nodes it unblocks. Once a
+ * node fails no new nodes are queued. */
+static void graph_node_done(struct vaccel_graph *graph,
+			    struct vaccel_graph_node *node, int node_ret,
+			    size_t *indegree, size_t *ready, size_t *nr_ready,
+			    int *ret)
+{
+	const size_t n = (size_t)(node - graph->nodes);
+
+	node->ret = node_ret;
+	if (node_ret && !*ret)
+		*ret = node_ret;
+
+	for (size_t i = 0; i < graph->nr_edges; i++) {
+		size_t dst = graph->edges[i].dst;
+		if (graph->edges[i].src == n && !--indegree[dst] && !*ret)
+			ready[(*nr_ready)++] = dst;
+	}
+}
+
+int vaccel_graph_run(struct vaccel_session *sess, struct vaccel_graph *graph)
+{
+	int ret;
+	struct vaccel_cq cq;
+	struct vaccel_completion completions[GRAPH_WAIT_BATCH];
+
+	if (!sess || !graph)
+		return VACCEL_EINVAL;
+
+	if (!graph->nr_nodes)
+		return VACCEL_OK;
+
+	for (size_t i = 0; i < graph->nr_nodes; i++) {
+		vaccel_op_type_t op_type;
+
+		graph->nodes[i].ret = VACCEL_ECANCELED;
+		ret = genop_op_type(graph->nodes[i].read,
+				    graph->nodes[i].nr_read, &op_type);
+		if (ret) {
+			vaccel_error("Invalid op for graph node %zu", i);
+			return ret;
+		}
+	}
+
+	/* In-degrees, followed by scratch space for the ready list and cycle
+	 * detection */
+	size_t *indegree =
+		(size_t *)calloc(3 * graph->nr_nodes, sizeof(*indegree));
+	if (!indegree)
+		return VACCEL_ENOMEM;
+	size_t *ready = &indegree[graph->nr_nodes];
+	size_t nr_ready = 0;
+
+	for (size_t i = 0; i < graph->nr_edges; i++)
+		indegree[graph->edges[i].dst]++;
+
+	if (!graph_is_acyclic(graph, indegree, ready)) {
+		vaccel_error("Graph has cycles");
+		ret = VACCEL_EINVAL;
+		goto free_indegree;
+	}
+
+	ret = vaccel_cq_init(&cq);
+	if (ret)
+		goto free_indegree;
+
+	for (size_t i = 0; i < graph->nr_nodes; i++) {
+		if (!indegree[i])
+			ready[nr_ready++] = i;
+	}
+
+	size_t nr_inflight = 0;
+	while (nr_ready || nr_inflight) {
+		/* Run a single ready node in the caller when nothing else is
+		 * running, so linear pipelines avoid the worker handoff */
+		if (nr_ready == 1 && !nr_inflight) {
+			struct vaccel_graph_node *node =
+				&graph->nodes[ready[--nr_ready]];
+
+			graph_node_wire(graph, (size_t)(node - graph->nodes));
+			int node_ret = vaccel_genop(sess, node->read,
+						    node->nr_read, node->write,
+						    node->nr_write);
+			graph_node_done(graph, node, node_ret, indegree, ready,
+					&nr_ready, &ret);
+			continue;
+		}
+
+		while (nr_ready) {
+			struct vaccel_graph_node *node =
+				&graph->nodes[ready[--nr_ready]];
+
+			graph_node_wire(graph, (size_t)(node - graph->nodes));
+			int node_ret = vaccel_op_submit(sess, &cq, node->read,
+							node->nr_read,
+							node->write,
+							node->nr_write, node);
+			if (node_ret)
+				graph_node_done(graph, node, node_ret,
+						indegree, ready, &nr_ready,
+						&ret);
+			else
+				nr_inflight++;
+		}
+
+		if (!nr_inflight)
+			continue;
+
+		/* Can only fail with no ops in flight */
+		size_t nr;
+		if (vaccel_cq_wait(&cq, completions, GRAPH_WAIT_BATCH, &nr, -1))
+			break;
+		nr_inflight -= nr;
+
+		for (size_t i = 0; i < nr; i++)
+			graph_node_done(graph, completions[i].user_data,
+					completions[i].ret, indegree, ready,
+					&nr_ready, &ret);
+	}
+
+	if (vaccel_cq_release(&cq))
+		vaccel_warn("Could not release graph completion queue");
+
+free_indegree:
+	free(indegree);
+
+	return ret;
+}
@@ -0,0 +1,5 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/graph.h" // IWYU pragma: export
@@ -5,20 +5,140 @@
 #include "log.h"
 #include <inttypes.h>
 #include <stdbool.h>
+#include <stdint.h>
 #include <stdlib.h>
 
+#define BITS_PER_WORD 64
+#define CHUNK_WORDS (ID_POOL_CHUNK_IDS / BITS_PER_WORD)
+
+struct id_pool_chunk {
+	/* Bitmap of `ids` words that may have available ids. Bits are set
+	 * when an id is returned and cleared lazily when a word is found
+	 * empty */
+	atomic_uint64_t summary;
+
+	/* Bitmap of available ids; a set bit marks an available id */
+	atomic_uint64_t ids[CHUNK_WORDS];
+};
+
+_Static_assert(CHUNK_WORDS == BITS_PER_WORD,
+	       "A chunk's summary must cover all of its words");
+
+struct id_pool_dir {
+	id_pool_chunk_ptr_t chunks[ID_POOL_DIR_CHUNKS];
+};
+
+static inline size_t nr_chunks(vaccel_id_t nr_ids)
+{
+	return ((size_t)nr_ids + ID_POOL_CHUNK_IDS - 1) / ID_POOL_CHUNK_IDS;
+}
+
+static inline size_t nr_dirs(vaccel_id_t nr_ids)
+{
+	return (nr_chunks(nr_ids) + ID_POOL_DIR_CHUNKS - 1) /
+	       ID_POOL_DIR_CHUNKS;
+}
+
+/* Get the slot of chunk `c`, allocating its directory block if `alloc` is
+ * set. Returns NULL if the block is not allocated or can't be. */
+static id_pool_chunk_ptr_t *chunk_slot(id_pool_t *pool, size_t c, bool alloc)
+{
+	id_pool_dir_ptr_t *dir_slot = &pool->dirs[c / ID_POOL_DIR_CHUNKS];
+	struct id_pool_dir *dir = atomic_load(dir_slot);
+	if (!dir) {
+		if (!alloc)
+			return NULL;
+
+		dir = malloc(sizeof(*dir));
+		if (!dir)
+			return NULL;
+
+		for (size_t i = 0; i < ID_POOL_DIR_CHUNKS; i++)
+			atomic_init(&dir->chunks[i], NULL);
+
+		/* Another thread may have installed the block meanwhile */
+		struct id_pool_dir *expected = NULL;
+		if (!atomic_compare_exchange_strong(dir_slot, &expected, dir)) {
+			free(dir);
+			dir = expected;
+		}
+	}
+
+	return &dir->chunks[c % ID_POOL_DIR_CHUNKS];
+}
+
+/* Get chunk `c`, or NULL if it is not allocated */
+static inline struct id_pool_chunk *chunk_get(id_pool_t *pool, size_t c)
+{
+	id_pool_chunk_ptr_t *slot = chunk_slot(pool, c, false);
+
+	return slot ? atomic_load(slot) : NULL;
+}
+
+/* Mask of the bits of a word at or above `bit` */
+static inline uint64_t mask_from(size_t bit)
+{
+	return ~(uint64_t)0 << bit;
+}
+
+/* Allocate the chunk starting at id index `first`, with all its ids up to
+ * `max` available */
+static struct id_pool_chunk *chunk_new(vaccel_id_t first, vaccel_id_t max)
+{
+	struct id_pool_chunk *chunk = malloc(sizeof(*chunk));
+	if (!chunk)
+		return NULL;
+
+	const size_t nr_ids = (max - first < ID_POOL_CHUNK_IDS) ?
+				      (size_t)(max - first) :
+				      ID_POOL_CHUNK_IDS;
+	uint64_t summary = 0;
+
+	/* Bits past the last id stay clear */
+	for (size_t w = 0; w < CHUNK_WORDS; w++) {
+		size_t base = w * BITS_PER_WORD;
+		size_t left = (nr_ids > base) ? nr_ids - base : 0;
+		uint64_t word = (left >= BITS_PER_WORD) ? ~(uint64_t)0 :
+							  ~mask_from(left);
+
+		atomic_init(&chunk->ids[w], word);
+		if (word)
+			summary |= (uint64_t)1 << w;
+	}
+	atomic_init(&chunk->summary, summary);
+
+	return chunk;
+}
+
 int id_pool_init(id_pool_t *pool, vaccel_id_t nr_ids)
 {
 	if (!pool || nr_ids <= 0)
 		return VACCEL_EINVAL;
 
-	pool->ids = calloc(nr_ids, sizeof(*pool->ids));
-	if (!pool->ids)
+	const size_t nr = nr_dirs(nr_ids);
+
+	pool->dirs = malloc(nr * sizeof(*pool->dirs));
+	if (!pool->dirs)
 		return VACCEL_ENOMEM;
 
-	for (vaccel_id_t i = 0; i < nr_ids; i++)
-		atomic_init(&pool->ids[i], true);
+	for (size_t d = 0; d < nr; d++)
+		atomic_init(&pool->dirs[d], NULL);
+
+	/* Only the first chunk is allocated up front */
+	id_pool_chunk_ptr_t *slot = chunk_slot(pool, 0, true);
+	struct id_pool_chunk *chunk = chunk_new(0, nr_ids);
+	if (!slot || !chunk) {
+		free(chunk);
+		free(atomic_load(&pool->dirs[0]));
+		free(pool->dirs);
+		pool->dirs = NULL;
+		return VACCEL_ENOMEM;
+	}
+	atomic_store(slot, chunk);
 
+	atomic_init(&pool->size, (nr_ids < ID_POOL_CHUNK_IDS) ?
+					 nr_ids :
+					 ID_POOL_CHUNK_IDS);
 	pool->max = nr_ids;
 	atomic_init(&pool->last, 0);
 
@@ -30,8 +150,19 @@ int id_pool_release(id_pool_t *pool)
 	if (!pool)
 		return VACCEL_EINVAL;
 
-	if (pool->ids)
-		free(pool->ids);
+	if (pool->dirs) {
+		for (size_t d = 0; d < nr_dirs(pool->max); d++) {
+			struct id_pool_dir *dir = atomic_load(&pool->dirs[d]);
+			if (!dir)
+				continue;
+
+			for (size_t c = 0; c < ID_POOL_DIR_CHUNKS; c++)
+				free(atomic_load(&dir->chunks[c]));
+			free(dir);
+		}
+		free(pool->dirs);
+		pool->dirs = NULL;
+	}
 
 	return VACCEL_OK;
 }
@@ -67,40 +198,159 @@ int id_pool_delete(id_pool_t *pool)
 	return VACCEL_OK;
 }
 
-vaccel_id_t id_pool_get(id_pool_t *pool)
+/* Clear the summary bit of an `ids` word found empty. The word is checked
+ * again afterwards, so an id returned concurrently is never hidden. */
+static void summary_clear(struct id_pool_chunk *chunk, size_t w)
 {
-	if (!pool)
-		return -VACCEL_EINVAL;
+	const uint64_t bit = (uint64_t)1 << w;
+
+	atomic_fetch_and(&chunk->summary, ~bit);
+	if (atomic_load(&chunk->ids[w]))
+		atomic_fetch_or(&chunk->summary, bit);
+}
+
+/* Find an available id index of a chunk at or after `start`, or -1 if there
+ * is none */
+static int64_t chunk_find_from(struct id_pool_chunk *chunk, size_t start)
+{
+	size_t w = start / BITS_PER_WORD;
+
+	uint64_t word = atomic_load(&chunk->ids[w]) &
+			mask_from(start % BITS_PER_WORD);
+	if (word)
+		return (int64_t)(w * BITS_PER_WORD) + __builtin_ctzll(word);
+
+	/* Use the summary to skip over full words */
+	if (++w == CHUNK_WORDS)
+		return -1;
+
+	uint64_t summary = atomic_load(&chunk->summary) & mask_from(w);
+	while (summary) {
+		size_t sw = (size_t)__builtin_ctzll(summary);
+		summary &= summary - 1;
+
+		word = atomic_load(&chunk->ids[sw]);
+		if (word)
+			return (int64_t)(sw * BITS_PER_WORD) +
+			       __builtin_ctzll(word);
+
+		summary_clear(chunk, sw);
+	}
+
+	return -1;
+}
+
+/* Find an available id index at or after `start` and below `size`, or -1 if
+ * there is none */
+static int64_t find_from(id_pool_t *pool, size_t start, vaccel_id_t size)
+{
+	const size_t first = start / ID_POOL_CHUNK_IDS;
+
+	/* Chunks are published before the size is grown past them */
+	for (size_t c = first; c < nr_chunks(size); c++) {
+		struct id_pool_chunk *chunk = chunk_get(pool, c);
+		size_t from = (c == first) ? start % ID_POOL_CHUNK_IDS : 0;
+
+		int64_t idx = chunk_find_from(chunk, from);
+		if (idx >= 0)
+			return (int64_t)(c * ID_POOL_CHUNK_IDS) + idx;
+	}
+
+	return -1;
+}
+
+/* Take an available id below `size`, or return 0 if there is none */
+static vaccel_id_t get_below(id_pool_t *pool, vaccel_id_t size)
+{
+	vaccel_id_t last = atomic_load(&pool->last);
+	size_t start = (last < size) ? (size_t)last : 0;
+	bool wrapped = (start == 0);
 
-	vaccel_id_t cur = atomic_load(&pool->last);
+	/* Hand out ids in order after the last one, so recently returned ids
+	 * are not reused right away */
+	while (true) {
+		int64_t idx = find_from(pool, start, size);
+		if (idx < 0) {
+			if (wrapped)
+				return 0;
+			start = 0;
+			wrapped = true;
+			continue;
+		}
 
-	/* Try finding an available ID sequentially first */
-	for (vaccel_id_t id = cur; id < pool->max; id++) {
-		bool available = true;
-		vaccel_id_t next = id + 1;
-		if (atomic_compare_exchange_strong(&pool->ids[id], &available,
-						   false)) {
-			atomic_store(&pool->last, next);
-			return next;
+		struct id_pool_chunk *chunk =
+			chunk_get(pool, (size_t)idx / ID_POOL_CHUNK_IDS);
+		const size_t chunk_idx = (size_t)idx % ID_POOL_CHUNK_IDS;
+		atomic_uint64_t *word = &chunk->ids[chunk_idx / BITS_PER_WORD];
+		const uint64_t bit = (uint64_t)1 << (chunk_idx % BITS_PER_WORD);
+		uint64_t cur = atomic_load(word);
+		while (cur & bit) {
+			if (atomic_compare_exchange_weak(word, &cur,
+							 cur & ~bit)) {
+				vaccel_id_t id = idx + 1;
+				atomic_store(&pool->last, id);
+				return id;
+			}
 		}
+
+		/* Taken by someone else; keep looking from there */
+		start = (size_t)idx;
 	}
+}
+
+/* Grow the pool by one chunk, unless it has already grown past `size`.
+ * Concurrent callers race to install the chunk and the losers free theirs, so
+ * ids keep being handed out and returned while the pool grows. */
+static int grow(id_pool_t *pool, vaccel_id_t size)
+{
+	if (size >= pool->max)
+		return VACCEL_EUSERS;
+
+	id_pool_chunk_ptr_t *slot =
+		chunk_slot(pool, (size_t)size / ID_POOL_CHUNK_IDS, true);
+	if (!slot)
+		return VACCEL_ENOMEM;
+
+	if (!atomic_load(slot)) {
+		struct id_pool_chunk *chunk = chunk_new(size, pool->max);
+		if (!chunk)
+			return VACCEL_ENOMEM;
+
+		struct id_pool_chunk *expected = NULL;
+		if (!atomic_compare_exchange_strong(slot, &expected, chunk))
+			free(chunk);
+	}
+
+	vaccel_id_t new_size = (pool->max - size < ID_POOL_CHUNK_IDS) ?
+				       pool->max :
+				       size + ID_POOL_CHUNK_IDS;
+	atomic_compare_exchange_strong(&pool->size, &size, new_size);
 
-	vaccel_warn("Reached max ID (%" PRId64 ")", pool->max);
-	vaccel_warn("Trying to reclaim lower IDs");
+	return VACCEL_OK;
+}
 
-	/* If max ID has been reached, reset `last` */
-	if (cur == pool->max)
-		atomic_store(&pool->last, 0);
+vaccel_id_t id_pool_get(id_pool_t *pool)
+{
+	if (!pool)
+		return -VACCEL_EINVAL;
 
-	/* If no sequential ID is available, search for any freed IDs */
-	for (vaccel_id_t id = 0; id < cur; id++) {
-		bool available = true;
-		vaccel_id_t next = id + 1;
-		if (atomic_compare_exchange_strong(&pool->ids[id], &available,
-						   false))
-			return next;
+	while (true) {
+		vaccel_id_t size = atomic_load(&pool->size);
+
+		vaccel_id_t id = get_below(pool, size);
+		if (id > 0)
+			return id;
+
+		/* All ids handed out so far are in use */
+		int ret = grow(pool, size);
+		if (ret == VACCEL_EUSERS)
+			break;
+		if (ret)
+			return -ret;
 	}
 
+	vaccel_warn("No available IDs (max %" PRId64 ")", pool->max);
+
 	return -VACCEL_EUSERS;
 }
 
@@ -109,13 +359,22 @@ int id_pool_put(id_pool_t *pool, vaccel_id_t id)
 	if (!pool || !id || id > pool->max || id <= 0)
 		return VACCEL_EINVAL;
 
-	vaccel_id_t idx = id - 1;
+	const size_t idx = (size_t)(id - 1);
+	struct id_pool_chunk *chunk = chunk_get(pool, idx / ID_POOL_CHUNK_IDS);
+	if (!chunk)
+		return VACCEL_EINVAL;
+
+	const size_t chunk_idx = idx % ID_POOL_CHUNK_IDS;
+	const size_t w = chunk_idx / BITS_PER_WORD;
+	const uint64_t bit = (uint64_t)1 << (chunk_idx % BITS_PER_WORD);
 
-	vaccel_id_t available = atomic_load(&pool->ids[idx]);
-	if (available)
+	uint64_t prev = atomic_fetch_or(&chunk->ids[w], bit);
+	if (prev & bit)
 		return VACCEL_EPERM;
 
-	atomic_store(&pool->ids[idx], true);
+	/* The summary bit is only cleared for empty words */
+	if (!prev)
+		atomic_fetch_or(&chunk->summary, (uint64_t)1 << w);
 
 	return VACCEL_OK;
 }
@@ -8,17 +8,37 @@
 
 #ifdef __cplusplus
 #include <atomic>
-#ifndef atomic_bool
-typedef std::atomic<bool> atomic_bool;
-#endif
 #ifndef atomic_int64_t
 typedef std::atomic<int64_t> atomic_int64_t;
 #endif
+#ifndef atomic_uint64_t
+typedef std::atomic<uint64_t> atomic_uint64_t;
+#endif
 #else
 #include <stdatomic.h>
 #ifndef atomic_int64_t
 typedef _Atomic int64_t atomic_int64_t;
 #endif
+#ifndef atomic_uint64_t
+typedef _Atomic uint64_t atomic_uint64_t;
+#endif
+#endif
+
+/* Number of ids covered by a chunk of the pool's bitmap */
+#define ID_POOL_CHUNK_IDS 4096
+
+/* Number of chunks in a block of the pool's chunk directory */
+#define ID_POOL_DIR_CHUNKS 512
+
+struct id_pool_chunk;
+struct id_pool_dir;
+
+#ifdef __cplusplus
+typedef std::atomic<struct id_pool_chunk *> id_pool_chunk_ptr_t;
+typedef std::atomic<struct id_pool_dir *> id_pool_dir_ptr_t;
+#else
+typedef _Atomic(struct id_pool_chunk *) id_pool_chunk_ptr_t;
+typedef _Atomic(struct id_pool_dir *) id_pool_dir_ptr_t;
 #endif
 
 #ifdef __cplusplus
@@ -26,8 +46,13 @@ extern "C" {
 #endif
 
 typedef struct id_pool {
-	/* Pool of ids */
-	atomic_bool *ids;
+	/* Blocks of `ID_POOL_DIR_CHUNKS` pointers to chunks of the bitmap of
+	 * available ids. Both are allocated as the pool grows. */
+	id_pool_dir_ptr_t *dirs;
+
+	/* Number of ids the pool has grown to. New chunks are only added
+	 * when all ids below this are in use. */
+	atomic_int64_t size;
 
 	/* Maximum ids available in this pool */
 	vaccel_id_t max;
@@ -36,7 +61,8 @@ typedef struct id_pool {
 	atomic_int64_t last;
 } id_pool_t;
 
-/* Initialize id pool */
+/* Initialize id pool. Memory is only allocated for the first
+ * `ID_POOL_CHUNK_IDS` ids; the pool grows up to `nr_ids` on demand. */
 int id_pool_init(id_pool_t *pool, vaccel_id_t nr_ids);
 
 /* Release id pool data */
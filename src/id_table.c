@@ -0,0 +1,262 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "id_table.h"
+#include "error.h"
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct id_table_entry {
+	/* Generation of the slot, bumped every time its object is cleared */
+	_Atomic uint32_t gen;
+
+	/* Published object, or NULL */
+	_Atomic(void *) ptr;
+};
+
+struct id_table_chunk {
+	struct id_table_entry entries[ID_TABLE_CHUNK_ENTRIES];
+};
+
+struct id_table_dir {
+	id_table_chunk_ptr_t chunks[ID_TABLE_DIR_CHUNKS];
+};
+
+static inline size_t nr_chunks(vaccel_id_t size)
+{
+	return ((size_t)size + ID_TABLE_CHUNK_ENTRIES - 1) /
+	       ID_TABLE_CHUNK_ENTRIES;
+}
+
+static inline size_t nr_dirs(vaccel_id_t size)
+{
+	return (nr_chunks(size) + ID_TABLE_DIR_CHUNKS - 1) /
+	       ID_TABLE_DIR_CHUNKS;
+}
+
+static inline uint32_t id_gen(vaccel_id_t id)
+{
+	return (uint32_t)((uint64_t)id >> ID_TABLE_SLOT_BITS);
+}
+
+static inline bool id_table_slot_valid(const id_table_t *table,
+				       vaccel_id_t slot)
+{
+	return table && table->dirs && slot > 0 && slot <= table->size;
+}
+
+/* Get the chunk slot of an entry index, allocating its directory block if
+ * `alloc` is set. Returns NULL if the block is not allocated or can't be. */
+static id_table_chunk_ptr_t *id_table_chunk_slot(const id_table_t *table,
+						 size_t idx, bool alloc)
+{
+	const size_t c = idx / ID_TABLE_CHUNK_ENTRIES;
+	id_table_dir_ptr_t *dir_slot = &table->dirs[c / ID_TABLE_DIR_CHUNKS];
+	struct id_table_dir *dir =
+		atomic_load_explicit(dir_slot, memory_order_acquire);
+	if (!dir) {
+		if (!alloc)
+			return NULL;
+
+		dir = malloc(sizeof(*dir));
+		if (!dir)
+			return NULL;
+
+		for (size_t i = 0; i < ID_TABLE_DIR_CHUNKS; i++)
+			atomic_init(&dir->chunks[i], NULL);
+
+		/* Another thread may have installed the block meanwhile */
+		struct id_table_dir *expected = NULL;
+		if (!atomic_compare_exchange_strong_explicit(
+			    dir_slot, &expected, dir, memory_order_acq_rel,
+			    memory_order_acquire)) {
+			free(dir);
+			dir = expected;
+		}
+	}
+
+	return &dir->chunks[c % ID_TABLE_DIR_CHUNKS];
+}
+
+/* Get the entry of an id's slot, or NULL if out of range or not allocated */
+static inline struct id_table_entry *id_table_entry(const id_table_t *table,
+						    vaccel_id_t id)
+{
+	vaccel_id_t slot = id_table_slot(id);
+
+	if (!id_table_slot_valid(table, slot))
+		return NULL;
+
+	const size_t idx = (size_t)(slot - 1);
+	id_table_chunk_ptr_t *chunk_slot =
+		id_table_chunk_slot(table, idx, false);
+	if (!chunk_slot)
+		return NULL;
+
+	struct id_table_chunk *chunk =
+		atomic_load_explicit(chunk_slot, memory_order_acquire);
+	if (!chunk)
+		return NULL;
+
+	return &chunk->entries[idx % ID_TABLE_CHUNK_ENTRIES];
+}
+
+/* Get the entry of an id's slot, allocating its chunk if needed */
+static struct id_table_entry *id_table_entry_alloc(id_table_t *table,
+						   vaccel_id_t id)
+{
+	vaccel_id_t slot = id_table_slot(id);
+
+	if (!id_table_slot_valid(table, slot))
+		return NULL;
+
+	struct id_table_entry *e = id_table_entry(table, id);
+	if (e)
+		return e;
+
+	const size_t idx = (size_t)(slot - 1);
+	id_table_chunk_ptr_t *chunk_slot = id_table_chunk_slot(table, idx, true);
+	if (!chunk_slot)
+		return NULL;
+
+	struct id_table_chunk *chunk = malloc(sizeof(*chunk));
+	if (!chunk)
+		return NULL;
+
+	for (size_t i = 0; i < ID_TABLE_CHUNK_ENTRIES; i++) {
+		atomic_init(&chunk->entries[i].gen, 0);
+		atomic_init(&chunk->entries[i].ptr, NULL);
+	}
+
+	/* Another thread may have installed the chunk meanwhile */
+	struct id_table_chunk *expected = NULL;
+	if (!atomic_compare_exchange_strong_explicit(chunk_slot, &expected,
+						     chunk,
+						     memory_order_acq_rel,
+						     memory_order_acquire))
+		free(chunk);
+
+	return id_table_entry(table, id);
+}
+
+int id_table_init(id_table_t *table, vaccel_id_t size)
+{
+	if (!table || size <= 0 || size > ID_TABLE_SLOT_MASK)
+		return VACCEL_EINVAL;
+
+	const size_t nr = nr_dirs(size);
+
+	table->dirs = malloc(nr * sizeof(*table->dirs));
+	if (!table->dirs)
+		return VACCEL_ENOMEM;
+
+	for (size_t d = 0; d < nr; d++)
+		atomic_init(&table->dirs[d], NULL);
+
+	table->size = size;
+
+	return VACCEL_OK;
+}
+
+int id_table_release(id_table_t *table)
+{
+	if (!table)
+		return VACCEL_EINVAL;
+
+	if (table->dirs) {
+		for (size_t d = 0; d < nr_dirs(table->size); d++) {
+			struct id_table_dir *dir = atomic_load(&table->dirs[d]);
+			if (!dir)
+				continue;
+
+			for (size_t c = 0; c < ID_TABLE_DIR_CHUNKS; c++)
+				free(atomic_load(&dir->chunks[c]));
+			free(dir);
+		}
+		free(table->dirs);
+	}
+	table->dirs = NULL;
+	table->size = 0;
+
+	return VACCEL_OK;
+}
+
+vaccel_id_t id_table_id(const id_table_t *table, vaccel_id_t slot)
+{
+	if (slot <= 0)
+		return slot;
+
+	if (!id_table_slot_valid(table, slot))
+		return -VACCEL_EINVAL;
+
+	/* Slots of chunks not allocated yet are on their first generation */
+	struct id_table_entry *e = id_table_entry(table, slot);
+	vaccel_id_t gen =
+		e ? atomic_load_explicit(&e->gen, memory_order_relaxed) : 0;
+
+	return (gen << ID_TABLE_SLOT_BITS) | slot;
+}
+
+int id_table_set(id_table_t *table, vaccel_id_t id, void *ptr)
+{
+	if (!id_table_slot_valid(table, id_table_slot(id)) || !ptr)
+		return VACCEL_EINVAL;
+
+	struct id_table_entry *e = id_table_entry_alloc(table, id);
+	if (!e)
+		return VACCEL_ENOMEM;
+
+	if (atomic_load_explicit(&e->gen, memory_order_relaxed) != id_gen(id))
+		return VACCEL_EINVAL;
+
+	void *expected = NULL;
+	if (!atomic_compare_exchange_strong_explicit(&e->ptr, &expected, ptr,
+						     memory_order_release,
+						     memory_order_relaxed))
+		return VACCEL_EBUSY;
+
+	return VACCEL_OK;
+}
+
+int id_table_clear(id_table_t *table, vaccel_id_t id)
+{
+	if (!id_table_slot_valid(table, id_table_slot(id)))
+		return VACCEL_EINVAL;
+
+	/* Nothing was ever published in a chunk not allocated yet */
+	struct id_table_entry *e = id_table_entry(table, id);
+	if (!e)
+		return VACCEL_ENOENT;
+
+	uint32_t gen = id_gen(id);
+	if (atomic_load_explicit(&e->gen, memory_order_relaxed) != gen)
+		return VACCEL_ENOENT;
+
+	atomic_store_explicit(&e->ptr, NULL, memory_order_relaxed);
+	atomic_store_explicit(&e->gen, (gen + 1) & ID_TABLE_GEN_MASK,
+			      memory_order_release);
+
+	return VACCEL_OK;
+}
+
+void *id_table_get(const id_table_t *table, vaccel_id_t id)
+{
+	struct id_table_entry *e = id_table_entry(table, id);
+	if (!e)
+		return NULL;
+
+	/* The generation is checked after loading the object, so an object
+	 * cleared and replaced meanwhile is not returned for a stale id */
+	uint32_t gen = id_gen(id);
+	if (atomic_load_explicit(&e->gen, memory_order_acquire) != gen)
+		return NULL;
+
+	void *ptr = atomic_load_explicit(&e->ptr, memory_order_acquire);
+
+	if (atomic_load_explicit(&e->gen, memory_order_acquire) != gen)
+		return NULL;
+
+	return ptr;
+}
@@ -0,0 +1,81 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/id.h" // IWYU pragma: export
+#include <stdint.h>
+
+#ifdef __cplusplus
+#include <atomic>
+#else
+#include <stdatomic.h>
+#endif
+
+/* Number of low id bits holding the id pool slot; the bits above hold the
+ * slot's generation */
+#define ID_TABLE_SLOT_BITS 32
+#define ID_TABLE_SLOT_MASK ((vaccel_id_t)UINT32_MAX)
+#define ID_TABLE_GEN_MASK ((uint32_t)INT32_MAX)
+
+/* Number of entries in a chunk of the table */
+#define ID_TABLE_CHUNK_ENTRIES 1024
+
+/* Number of chunks in a block of the table's chunk directory */
+#define ID_TABLE_DIR_CHUNKS 512
+
+struct id_table_chunk;
+struct id_table_dir;
+
+#ifdef __cplusplus
+typedef std::atomic<struct id_table_chunk *> id_table_chunk_ptr_t;
+typedef std::atomic<struct id_table_dir *> id_table_dir_ptr_t;
+#else
+typedef _Atomic(struct id_table_chunk *) id_table_chunk_ptr_t;
+typedef _Atomic(struct id_table_dir *) id_table_dir_ptr_t;
+#endif
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct id_table {
+	/* Blocks of `ID_TABLE_DIR_CHUNKS` pointers to chunks of entries indexed
+	 * by id pool slot. Both are allocated when an object is first
+	 * published in them. */
+	id_table_dir_ptr_t *dirs;
+
+	/* Number of entries */
+	vaccel_id_t size;
+} id_table_t;
+
+/* Initialize id table for slots 1 to `size`. Entries are allocated in
+ * chunks of `ID_TABLE_CHUNK_ENTRIES` as they are used. */
+int id_table_init(id_table_t *table, vaccel_id_t size);
+
+/* Release id table data */
+int id_table_release(id_table_t *table);
+
+/* Get the id for an id pool slot, tagged with the slot's current generation.
+ * Negative values (errors from the id pool) are passed through. */
+vaccel_id_t id_table_id(const id_table_t *table, vaccel_id_t slot);
+
+/* Publish an object under an id returned by `id_table_id()` */
+int id_table_set(id_table_t *table, vaccel_id_t id, void *ptr);
+
+/* Unpublish the object of an id. The slot's generation is bumped so the id
+ * can't be looked up again, even after the slot is reused. */
+int id_table_clear(id_table_t *table, vaccel_id_t id);
+
+/* Look up the object of an id. Returns NULL if the id is not published or
+ * belongs to an older generation of the slot. Never blocks. */
+void *id_table_get(const id_table_t *table, vaccel_id_t id);
+
+/* Get the id pool slot of an id */
+static inline vaccel_id_t id_table_slot(vaccel_id_t id)
+{
+	return (id > 0) ? (id & ID_TABLE_SLOT_MASK) : id;
+}
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,73 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "arg.h"
+#include "list.h"
+#include "session.h"
+#include <pthread.h>
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vaccel_completion {
+	/* user data given when the op was submitted */
+	void *user_data;
+
+	/* return code of the op */
+	int ret;
+};
+
+struct vaccel_cq {
+	/* submitted ops that have not completed yet */
+	size_t nr_inflight;
+
+	/* list of completed ops that have not been reaped yet */
+	struct vaccel_list_entry completed;
+
+	/* number of completed ops that have not been reaped yet */
+	size_t nr_completed;
+
+	/* lock for the completion queue */
+	pthread_mutex_t lock;
+
+	/* signaled when an op completes */
+	pthread_cond_t cond;
+};
+
+/* Initialize completion queue */
+int vaccel_cq_init(struct vaccel_cq *cq);
+
+/* Release completion queue data. Fails with VACCEL_EBUSY if there are ops
+ * in flight; completions that have not been reaped are dropped. */
+int vaccel_cq_release(struct vaccel_cq *cq);
+
+/* Allocate and initialize completion queue */
+int vaccel_cq_new(struct vaccel_cq **cq);
+
+/* Release completion queue data and free completion queue created with
+ * `vaccel_cq_new()` */
+int vaccel_cq_delete(struct vaccel_cq *cq);
+
+/* Submit an op without waiting for it to complete. Arguments are given as for
+ * `vaccel_genop()` and, along with the session, must remain valid until the
+ * op's completion is reaped from `cq`. */
+int vaccel_op_submit(struct vaccel_session *sess, struct vaccel_cq *cq,
+		     struct vaccel_arg *read, int nr_read,
+		     struct vaccel_arg *write, int nr_write, void *user_data);
+
+/* Reap up to `max` completions without blocking */
+int vaccel_cq_poll(struct vaccel_cq *cq, struct vaccel_completion *completions,
+		   size_t max, size_t *nr_completions);
+
+/* Reap up to `max` completions, blocking until at least one is available or
+ * `timeout_ms` expires (VACCEL_EAGAIN). A negative timeout waits forever.
+ * Returns VACCEL_ENOENT if there are no ops to wait for. */
+int vaccel_cq_wait(struct vaccel_cq *cq, struct vaccel_completion *completions,
+		   size_t max, size_t *nr_completions, int timeout_ms);
+
+#ifdef __cplusplus
+}
+#endif
@@ -23,7 +23,20 @@ VACCEL_ENUM_DEF_WITH_STR_FUNCS(vaccel_blob_type, _ENUM_PREFIX,
 			       VACCEL_BLOB_TYPE_ENUM_LIST)
 #undef _ENUM_PREFIX
 
+/* Blob map flags: map the blob file read-only and shared with other mappings
+ * of it, instead of privately with copy-on-write */
+#define VACCEL_BLOB_MAP_SHARED 0x1
+/* Blob map flag: prefault the whole mapping when the blob is read */
+#define VACCEL_BLOB_MAP_POPULATE 0x2
+/* Blob map flag: advise that the data will be accessed soon */
+#define VACCEL_BLOB_MAP_WILLNEED 0x4
+/* Blob map flag: advise that the data will be accessed sequentially */
+#define VACCEL_BLOB_MAP_SEQUENTIAL 0x8
+/* Blob map flag: advise that the mapping should be backed by huge pages */
+#define VACCEL_BLOB_MAP_HUGEPAGE 0x10
+
 struct vaccel_resource;
+struct blob_cache_entry;
 
 struct vaccel_blob {
 	/* blob type */
@@ -32,12 +45,17 @@ struct vaccel_blob {
 	/* name of the blob */
 	char *name;
 
-	/* path to the blob file; only set for non-buffer blobs */
+	/* path to the blob file; only set for non-buffer blobs. For blobs
+	 * persisted in memory this is `/proc/self/fd/<fd>` */
 	char *path;
 
 	/* true if the struct owns the blob file */
 	bool path_owned;
 
+	/* descriptor of the in-memory blob file; -1 if the blob is not
+	 * persisted in memory */
+	int memfd;
+
 	/* data content of the blob; can be `NULL` if a blob file has not been
 	 * read */
 	uint8_t *data;
@@ -48,12 +66,21 @@ struct vaccel_blob {
 	/* data size of the blob; can be `0` if a blob file has not been
 	 * read */
 	size_t size;
+
+	/* VACCEL_BLOB_MAP_* flags for mapping the blob file in memory */
+	uint32_t map_flags;
+
+	/* memory budget tracking of the mapped data; NULL if untracked */
+	struct blob_cache_entry *cache_entry;
 };
 
 /* Persist a blob in the filesystem */
 int vaccel_blob_persist(struct vaccel_blob *blob, const char *dir,
 			const char *filename, bool randomize);
 
+/* Persist a blob in an in-memory file */
+int vaccel_blob_persist_memfd(struct vaccel_blob *blob, const char *filename);
+
 /* Initialize a blob from an existing file in the filesystem */
 int vaccel_blob_init(struct vaccel_blob *blob, const char *path);
 
@@ -79,6 +106,9 @@ int vaccel_blob_delete(struct vaccel_blob *blob);
 /* Read the blob in memory */
 int vaccel_blob_read(struct vaccel_blob *blob);
 
+/* Read many blobs in memory at once */
+int vaccel_blob_read_multi(struct vaccel_blob **blobs, size_t nr_blobs);
+
 /* Get the data of the blob */
 uint8_t *vaccel_blob_data(struct vaccel_blob *blob, size_t *size);
 
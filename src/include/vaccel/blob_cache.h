@@ -0,0 +1,39 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vaccel_blob_cache_stats {
+	/* blobs whose data was dropped from memory to stay within the
+	 * memory budget */
+	uint64_t evictions;
+
+	/* accesses to blobs whose data had been dropped */
+	uint64_t refaults;
+
+	/* number of tracked blobs with data in memory */
+	size_t nr_blobs;
+
+	/* mapped data of the blobs, in bytes */
+	size_t size;
+};
+
+/* Set the memory budget of mapped blob file data, in bytes, dropping the data
+ * of least recently used blobs from memory to fit. Dropped data is read back
+ * from the blob file on the next access, so data pointers stay valid. Only
+ * blob files mapped with `VACCEL_BLOB_MAP_SHARED` are tracked; private
+ * mappings may hold changes that could not be read back. 0 means no limit. */
+int vaccel_blob_cache_set_budget(size_t size);
+
+/* Get the cache counters */
+int vaccel_blob_cache_stats(struct vaccel_blob_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -3,7 +3,9 @@
 #pragma once
 
 #include "log.h"
+#include "scheduler.h"
 #include <stdbool.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -24,6 +26,38 @@ struct vaccel_config {
 
 	/* if true plugins' vaccel version check is skipped */
 	bool version_ignore;
+
+	/* policy for selecting plugins for sessions/ops */
+	vaccel_sched_policy_t sched_policy;
+
+	/* maximum number of live sessions */
+	size_t max_sessions;
+
+	/* maximum number of live resources */
+	size_t max_resources;
+
+	/* memory budget of models loaded by plugins, in bytes; 0 for no
+	 * limit */
+	size_t model_cache_size;
+
+	/* directory to keep downloaded files in across runs; NULL to
+	 * disable the download cache */
+	char *download_cache_dir;
+
+	/* size limit of the download cache, in bytes; 0 for no limit */
+	size_t download_cache_size;
+
+	/* if true remote files are downloaded into memory instead of the
+	 * rundir, bypassing the download cache */
+	bool download_in_memory;
+
+	/* if true in-memory blobs are persisted in sealed memory files
+	 * instead of the rundir */
+	bool blobs_in_memory;
+
+	/* memory budget of blob file data mapped read-only and shared, in
+	 * bytes; 0 for no limit */
+	size_t blob_cache_size;
 };
 
 /* Initialize config */
@@ -0,0 +1,35 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vaccel_download_cache_stats {
+	/* downloads served from the cache after revalidation */
+	uint64_t hits;
+
+	/* downloads fetched from the network */
+	uint64_t misses;
+
+	/* files removed to stay within the size limit */
+	uint64_t evictions;
+
+	/* number of cached files */
+	size_t nr_files;
+
+	/* size of the cached files, in bytes */
+	size_t size;
+};
+
+/* Get the download cache counters. The cache is enabled by setting
+ * `download_cache_dir` in the config. */
+int vaccel_download_cache_stats(struct vaccel_download_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
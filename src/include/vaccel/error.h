@@ -37,4 +37,5 @@ enum {
 	VACCEL_ERANGE = ERANGE, /* Out of range */
 	VACCEL_EAGAIN = EAGAIN, /* Resource temporarily unavailable */
 	VACCEL_ENOSYS = ENOSYS, /* Function not implemented */
+	VACCEL_ECANCELED = ECANCELED, /* Operation Canceled */
 };
@@ -0,0 +1,87 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "arg.h"
+#include "session.h"
+#include <stddef.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vaccel_graph_node {
+	/* read arguments, as for `vaccel_genop()`. The graph keeps its own
+	 * copy of the arg descriptors so connected args can be rewired
+	 * without modifying the caller's array */
+	struct vaccel_arg *read;
+	int nr_read;
+
+	/* write arguments, as for `vaccel_genop()` */
+	struct vaccel_arg *write;
+	int nr_write;
+
+	/* return code of the op; VACCEL_ECANCELED if the node did not run */
+	int ret;
+};
+
+struct vaccel_graph_edge {
+	/* node that must complete first */
+	size_t src;
+
+	/* node that depends on `src` */
+	size_t dst;
+
+	/* write arg of `src` passed as read arg of `dst`, or -1 for an
+	 * ordering-only edge */
+	int src_write;
+	int dst_read;
+};
+
+struct vaccel_graph {
+	/* nodes of the graph */
+	struct vaccel_graph_node *nodes;
+	size_t nr_nodes;
+	size_t nodes_capacity;
+
+	/* edges of the graph */
+	struct vaccel_graph_edge *edges;
+	size_t nr_edges;
+	size_t edges_capacity;
+};
+
+/* Initialize graph */
+int vaccel_graph_init(struct vaccel_graph *graph);
+
+/* Release graph data */
+int vaccel_graph_release(struct vaccel_graph *graph);
+
+/* Allocate and initialize graph */
+int vaccel_graph_new(struct vaccel_graph **graph);
+
+/* Release graph data and free graph created with `vaccel_graph_new()` */
+int vaccel_graph_delete(struct vaccel_graph *graph);
+
+/* Add a genop node to the graph. Write args, and the buffers of all args, must
+ * remain valid until the graph is run. The index of the new node is returned
+ * in `node`. */
+int vaccel_graph_add_node(struct vaccel_graph *graph, struct vaccel_arg *read,
+			  int nr_read, struct vaccel_arg *write, int nr_write,
+			  size_t *node);
+
+/* Pass write arg `src_write` of node `src` by reference as read arg
+ * `dst_read` of node `dst`. `dst` runs after `src` completes. */
+int vaccel_graph_connect(struct vaccel_graph *graph, size_t src, int src_write,
+			 size_t dst, int dst_read);
+
+/* Run node `dst` after node `src` completes, without passing any args */
+int vaccel_graph_depend(struct vaccel_graph *graph, size_t src, size_t dst);
+
+/* Run all nodes of the graph in dependency order, with independent nodes
+ * running concurrently. Nodes depending on a failed node are not run. Returns
+ * the return code of the first failed node, if any. */
+int vaccel_graph_run(struct vaccel_session *sess, struct vaccel_graph *graph);
+
+#ifdef __cplusplus
+}
+#endif
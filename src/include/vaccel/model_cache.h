@@ -0,0 +1,63 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "resource.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Unload a model that leaves the cache */
+typedef void (*vaccel_model_unload_fn_t)(void *model);
+
+struct vaccel_model_cache_stats {
+	/* lookups that found a loaded model */
+	uint64_t hits;
+
+	/* lookups that did not */
+	uint64_t misses;
+
+	/* models unloaded to stay within the memory budget */
+	uint64_t evictions;
+
+	/* number of loaded models */
+	size_t nr_models;
+
+	/* memory of the loaded models, in bytes */
+	size_t size;
+};
+
+/* Get the model `owner` has loaded for a resource and take a reference to it.
+ * Returns VACCEL_ENOENT if there is none; the caller should then load the
+ * model and add it with `vaccel_model_cache_add()`. */
+int vaccel_model_cache_get(const struct vaccel_resource *res,
+			   const void *owner, void **model);
+
+/* Add a model `owner` has loaded for a resource, with a reference taken.
+ * `size` counts towards the memory budget and `unload` is called when the
+ * model leaves the cache. Returns VACCEL_EEXIST if a model was added for the
+ * resource in the meantime; the caller should then unload its own and use
+ * `vaccel_model_cache_get()`. */
+int vaccel_model_cache_add(const struct vaccel_resource *res,
+			   const void *owner, void *model, size_t size,
+			   vaccel_model_unload_fn_t unload);
+
+/* Drop a reference to a cached model. Models with no references stay loaded
+ * while their resource is registered with a session and the cache is within
+ * its budget, so later sessions get them without loading them again. */
+int vaccel_model_cache_put(const struct vaccel_resource *res,
+			   const void *owner);
+
+/* Set the memory budget of the cache, in bytes, evicting least recently used
+ * models with no references to fit. 0 means no limit. */
+int vaccel_model_cache_set_budget(size_t size);
+
+/* Get the cache counters */
+int vaccel_model_cache_stats(struct vaccel_model_cache_stats *stats);
+
+#ifdef __cplusplus
+}
+#endif
@@ -69,6 +69,33 @@ extern struct vaccel_plugin vaccel_this_plugin;
 #define VACCEL_OP_INIT(name, type, func) \
 	{ (type), (func), (&vaccel_this_plugin) }
 
+/* Callback through which asynchronous op implementations report that an op
+ * has completed */
+typedef void (*vaccel_op_complete_fn_t)(void *ctx, int ret);
+
+struct vaccel_session;
+struct vaccel_prof_region;
+struct vaccel_op_handle {
+	/* session the handle was prepared for */
+	struct vaccel_session *sess;
+
+	/* operation type */
+	vaccel_op_type_t type;
+
+	/* plugin function implementing the operation */
+	void *func;
+
+	/* profiling region of the operation */
+	struct vaccel_prof_region *prof;
+};
+
+/* Resolve the plugin function implementing an operation for a session, so
+ * that it can be called repeatedly through the `vaccel_op_call_*()` variants
+ * without any lookup. The handle stays valid for as long as the session is
+ * not updated or released. */
+int vaccel_op_prepare(struct vaccel_session *sess, vaccel_op_type_t op_type,
+		      struct vaccel_op_handle *handle);
+
 #ifdef __cplusplus
 }
 #endif
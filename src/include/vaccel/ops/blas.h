@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "vaccel/op.h"
 #include "vaccel/session.h"
 #include <stddef.h>
 #include <stdint.h>
@@ -15,6 +16,12 @@ int vaccel_sgemm(struct vaccel_session *sess, int64_t m, int64_t n, int64_t k,
 		 float alpha, float *a, int64_t lda, float *b, int64_t ldb,
 		 float beta, float *c, int64_t ldc);
 
+/* Prepared handle variant of vaccel_sgemm() */
+int vaccel_op_call_sgemm(const struct vaccel_op_handle *handle, int64_t m,
+			 int64_t n, int64_t k, float alpha, float *a,
+			 int64_t lda, float *b, int64_t ldb, float beta,
+			 float *c, int64_t ldc);
+
 #ifdef __cplusplus
 }
 #endif
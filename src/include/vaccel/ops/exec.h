@@ -3,6 +3,7 @@
 #pragma once
 
 #include "vaccel/arg.h"
+#include "vaccel/op.h"
 #include "vaccel/resource.h"
 #include "vaccel/session.h"
 #include <stddef.h>
@@ -21,6 +22,18 @@ int vaccel_exec_with_resource(struct vaccel_session *sess,
 			      size_t nr_read, struct vaccel_arg *write,
 			      size_t nr_write);
 
+/* Prepared handle variants; see vaccel_op_prepare() */
+int vaccel_op_call_exec(const struct vaccel_op_handle *handle,
+			const char *library, const char *fn_symbol,
+			struct vaccel_arg *read, size_t nr_read,
+			struct vaccel_arg *write, size_t nr_write);
+
+int vaccel_op_call_exec_with_resource(const struct vaccel_op_handle *handle,
+				      struct vaccel_resource *resource,
+				      const char *fn_symbol,
+				      struct vaccel_arg *read, size_t nr_read,
+				      struct vaccel_arg *write, size_t nr_write);
+
 #ifdef __cplusplus
 }
 #endif
@@ -4,17 +4,36 @@
 
 #include "vaccel/session.h"
 #include "vaccel/arg.h"
+#include <stddef.h>
 #include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+struct vaccel_genop_req {
+	/* read and write arguments, as for `vaccel_genop()` */
+	struct vaccel_arg *read;
+	int nr_read;
+	struct vaccel_arg *write;
+	int nr_write;
+
+	/* return code of the op */
+	int ret;
+};
+
 /* Call one of the supported functions, given an op code and a set of arbitrary
  * arguments */
 int vaccel_genop(struct vaccel_session *sess, struct vaccel_arg *read,
 		 int nr_read, struct vaccel_arg *write, int nr_write);
 
+/* Call a batch of generic ops. All requests are validated before any op is
+ * run; if one is invalid nothing is run and the rest are marked with
+ * VACCEL_ECANCELED. Each request's `ret` is set to the return code of its op
+ * and the return code of the first failed op, if any, is returned. */
+int vaccel_genop_batch(struct vaccel_session *sess,
+		       struct vaccel_genop_req *reqs, size_t nr_reqs);
+
 #ifdef __cplusplus
 }
 #endif
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "vaccel/op.h"
 #include "vaccel/session.h"
 #include <stddef.h>
 
@@ -30,6 +31,13 @@ int vaccel_image_depth(struct vaccel_session *sess, const void *img,
 		       unsigned char *out_imgname, size_t len_img,
 		       size_t len_out_imgname);
 
+/* Prepared handle variant for any of the image ops; `out_text` is only used
+ * by classification and can be NULL otherwise */
+int vaccel_op_call_image(const struct vaccel_op_handle *handle,
+			 const void *img, unsigned char *out_text,
+			 unsigned char *out_imgname, size_t len_img,
+			 size_t len_out_text, size_t len_out_imgname);
+
 #ifdef __cplusplus
 }
 #endif
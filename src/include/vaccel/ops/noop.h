@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "vaccel/op.h"
 #include "vaccel/session.h"
 
 #ifdef __cplusplus
@@ -9,6 +10,7 @@ extern "C" {
 #endif
 
 int vaccel_noop(struct vaccel_session *sess);
+int vaccel_op_call_noop(const struct vaccel_op_handle *handle);
 
 #ifdef __cplusplus
 }
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "vaccel/op.h"
 #include "vaccel/resource.h"
 #include "vaccel/session.h"
 #include <stdbool.h>
@@ -178,6 +179,17 @@ int vaccel_tf_model_run(struct vaccel_session *sess,
 			struct vaccel_tf_tensor **out_tensors, int nr_outputs,
 			struct vaccel_tf_status *status);
 
+/* Prepared handle variant of vaccel_tf_model_run() */
+int vaccel_op_call_tf_model_run(const struct vaccel_op_handle *handle,
+				struct vaccel_resource *model,
+				const struct vaccel_tf_buffer *run_options,
+				const struct vaccel_tf_node *in_nodes,
+				struct vaccel_tf_tensor *const *in_tensors,
+				int nr_inputs,
+				const struct vaccel_tf_node *out_nodes,
+				struct vaccel_tf_tensor **out_tensors,
+				int nr_outputs, struct vaccel_tf_status *status);
+
 /* Unload loaded TF model */
 int vaccel_tf_model_unload(struct vaccel_session *sess,
 			   struct vaccel_resource *model,
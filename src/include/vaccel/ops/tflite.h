@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "vaccel/op.h"
 #include "vaccel/resource.h"
 #include "vaccel/session.h"
 #include <stdbool.h>
@@ -97,6 +98,14 @@ int vaccel_tflite_model_run(struct vaccel_session *sess,
 			    struct vaccel_tflite_tensor **outputs,
 			    int nr_outputs, uint8_t *status);
 
+/* Prepared handle variant of vaccel_tflite_model_run() */
+int vaccel_op_call_tflite_model_run(const struct vaccel_op_handle *handle,
+				    struct vaccel_resource *model,
+				    struct vaccel_tflite_tensor *const *inputs,
+				    int nr_inputs,
+				    struct vaccel_tflite_tensor **outputs,
+				    int nr_outputs, uint8_t *status);
+
 /* Unload loaded TFLite model */
 int vaccel_tflite_model_unload(struct vaccel_session *sess,
 			       struct vaccel_resource *model);
@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "vaccel/op.h"
 #include "vaccel/resource.h"
 #include "vaccel/session.h"
 #include <stddef.h>
@@ -118,6 +119,15 @@ int vaccel_torch_model_run(struct vaccel_session *sess,
 			   int nr_inputs, struct vaccel_torch_tensor **outputs,
 			   int nr_outputs);
 
+/* Prepared handle variant of vaccel_torch_model_run() */
+int vaccel_op_call_torch_model_run(const struct vaccel_op_handle *handle,
+				   struct vaccel_resource *model,
+				   const struct vaccel_torch_buffer *run_options,
+				   struct vaccel_torch_tensor *const *inputs,
+				   int nr_inputs,
+				   struct vaccel_torch_tensor **outputs,
+				   int nr_outputs);
+
 /* Perform Torch SGEMM */
 __attribute__((
 	deprecated("The function will be removed in a future release"))) int
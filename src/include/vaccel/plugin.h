@@ -2,6 +2,7 @@
 
 #pragma once
 
+#include "arg.h"
 #include "list.h"
 #include "op.h"
 #include "resource.h"
@@ -16,6 +17,8 @@
 extern "C" {
 #endif
 
+struct vaccel_genop_req;
+
 /* Define vaccel_plugin_type_t, vaccel_plugin_type_to_str() and
  * vaccel_plugin_type_to_base_str() */
 #define _ENUM_PREFIX VACCEL_PLUGIN
@@ -69,6 +72,31 @@ struct vaccel_plugin_info {
 				   struct vaccel_session *sess);
 	int (*resource_sync)(struct vaccel_resource *res,
 			     struct vaccel_session *sess);
+
+	/* optional asynchronous op submission. Arguments are as for genop,
+	 * without the op type. On success, `complete(ctx, ret)` must be
+	 * called exactly once when the op finishes. Returning VACCEL_ENOTSUP
+	 * falls back to running the op synchronously in a core worker */
+	int (*submit_async)(struct vaccel_session *sess,
+			    vaccel_op_type_t op_type, struct vaccel_arg *read,
+			    int nr_read, struct vaccel_arg *write, int nr_write,
+			    vaccel_op_complete_fn_t complete, void *ctx);
+
+	/* optional batched genop dispatch. All requests are of `op_type` and
+	 * their arguments are as for genop, including the op type. The
+	 * plugin sets the return code of each request. Returning
+	 * VACCEL_ENOTSUP falls back to dispatching the ops one by one */
+	int (*genop_batch)(struct vaccel_session *sess,
+			   vaccel_op_type_t op_type,
+			   struct vaccel_genop_req *reqs, size_t nr_reqs);
+
+	/* optional warmup of a resource registered with a session, e.g.
+	 * loading a model ahead of the first request. Called from a
+	 * background thread by `vaccel_resource_prefetch()` with the
+	 * registrations of the resource locked, so it can't be unregistered
+	 * from the session meanwhile */
+	int (*resource_warmup)(struct vaccel_resource *res,
+			       struct vaccel_session *sess);
 };
 
 struct vaccel_plugin {
@@ -8,6 +8,7 @@
 #include "utils/enum.h"
 #include "utils/path.h"
 #include <stddef.h>
+#include <stdint.h>
 #include <sys/types.h>
 
 #ifdef __cplusplus
@@ -35,6 +36,13 @@ VACCEL_ENUM_DEF_WITH_STR_FUNCS(vaccel_resource_type, _ENUM_PREFIX,
 			       VACCEL_RESOURCE_TYPE_ENUM_LIST)
 #undef _ENUM_PREFIX
 
+/* Resource prefetch flag: once the blobs have been read ahead, let the
+ * plugins of the sessions the resource is registered with warm it up */
+#define VACCEL_RESOURCE_PREFETCH_WARMUP 0x1
+
+struct resource_share;
+struct resource_prefetch;
+
 struct vaccel_resource {
 	/* resource id */
 	vaccel_id_t id;
@@ -63,6 +71,9 @@ struct vaccel_resource {
 	/* number of blob entities represented by the resource */
 	size_t nr_blobs;
 
+	/* VACCEL_BLOB_MAP_* flags for mapping the resource blob files */
+	uint32_t map_flags;
+
 	/* entry for global resources list */
 	struct vaccel_list_entry entry;
 
@@ -72,12 +83,26 @@ struct vaccel_resource {
 	/* lock for session list */
 	pthread_mutex_t sessions_lock;
 
+	/* lock for loading the blobs and rundir on registration */
+	pthread_mutex_t load_lock;
+
 	/* reference counter representing the number of sessions
 	 * the resource is registered with */
 	atomic_uint refcount;
 
 	/* plugin private data */
 	void *plugin_priv;
+
+	/* cache entry of a shared resource; NULL if the resource is not
+	 * shared */
+	struct resource_share *share;
+
+	/* background prefetch of the resource; NULL if none has been
+	 * started */
+	struct resource_prefetch *prefetch;
+
+	/* lock for starting, detaching and referencing the prefetch */
+	pthread_mutex_t prefetch_lock;
 };
 
 /* Get resource by index from created resources */
@@ -114,7 +139,13 @@ int vaccel_resource_init_from_blobs(struct vaccel_resource *res,
 				    size_t nr_blobs,
 				    vaccel_resource_type_t type);
 
-/* Release resource data */
+/* Set how the blob files of a resource are mapped in memory, using
+ * VACCEL_BLOB_MAP_* flags. Applies to blob files mapped after the call, so it
+ * should be set before registering the resource */
+int vaccel_resource_set_map_flags(struct vaccel_resource *res, uint32_t flags);
+
+/* Release resource data. Shared resources still referenced by others are
+ * busy and have to be dropped with vaccel_resource_delete_shared() */
 int vaccel_resource_release(struct vaccel_resource *res);
 
 /* Allocate and initialize resource */
@@ -139,6 +170,24 @@ int vaccel_resource_from_blobs(struct vaccel_resource **res,
  * vaccel_resource_new*() or vaccel_resource_from_*() */
 int vaccel_resource_delete(struct vaccel_resource *res);
 
+/* Get the shared resource with the same content as the given path, allocating
+ * and initializing it if there is none. Local paths must be regular files and
+ * are matched by device/inode/mtime/size, and URLs are matched by value */
+int vaccel_resource_new_shared(struct vaccel_resource **res, const char *path,
+			       vaccel_resource_type_t type);
+
+/* Get the shared resource with the same content as the given in-memory data,
+ * allocating and initializing it if there is none. Data is matched by hash
+ * and compared before sharing */
+int vaccel_resource_from_buf_shared(struct vaccel_resource **res,
+				    const void *buf, size_t nr_bytes,
+				    vaccel_resource_type_t type,
+				    const char *filename, bool mem_only);
+
+/* Drop a reference to a resource returned by vaccel_resource_*_shared(),
+ * releasing and freeing it along with the last one */
+int vaccel_resource_delete_shared(struct vaccel_resource *res);
+
 struct vaccel_session;
 
 /* Register resource with session */
@@ -153,6 +202,24 @@ int vaccel_resource_unregister(struct vaccel_resource *res,
 int vaccel_resource_sync(struct vaccel_resource *res,
 			 struct vaccel_session *sess);
 
+/* Read ahead the blobs of a resource on a background thread, so the first
+ * access doesn't fault them in on the request path. With
+ * VACCEL_RESOURCE_PREFETCH_WARMUP, the plugins of the sessions the resource
+ * is registered with are then asked to warm it up. Fails with VACCEL_EBUSY if
+ * a prefetch is already in progress */
+int vaccel_resource_prefetch(struct vaccel_resource *res, uint32_t flags);
+
+/* Check if the prefetch of a resource has completed without blocking.
+ * Returns VACCEL_EAGAIN while in progress, VACCEL_ENOENT if no prefetch has
+ * been started, or the result of the prefetch */
+int vaccel_resource_prefetch_poll(struct vaccel_resource *res);
+
+/* Wait for the prefetch of a resource to complete, for up to `timeout_ms`
+ * (VACCEL_EAGAIN). A negative timeout waits forever. Returns as
+ * `vaccel_resource_prefetch_poll()` */
+int vaccel_resource_prefetch_wait(struct vaccel_resource *res,
+				  int timeout_ms);
+
 /* Get directory of a resource created from a directory.
  * If an alloc_path is provided, the resulting path string will be allocated and
  * returned there. If not, the path will be copied to out_path.
@@ -0,0 +1,32 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "op.h"
+#include "utils/enum.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Define vaccel_sched_policy_t, vaccel_sched_policy_to_str() and
+ * vaccel_sched_policy_to_base_str() */
+#define _ENUM_PREFIX VACCEL_SCHED
+#define VACCEL_SCHED_POLICY_ENUM_LIST(VACCEL_ENUM_ITEM) \
+	VACCEL_ENUM_ITEM(STATIC, 0, _ENUM_PREFIX)       \
+	VACCEL_ENUM_ITEM(ADAPTIVE, _ENUM_PREFIX)
+
+VACCEL_ENUM_DEF_WITH_STR_FUNCS(vaccel_sched_policy, _ENUM_PREFIX,
+			       VACCEL_SCHED_POLICY_ENUM_LIST)
+#undef _ENUM_PREFIX
+
+/* Always route an op to the (first) local plugin with the given name, if it
+ * implements the op, regardless of the scheduling policy. Overrides only apply
+ * to sessions created with `VACCEL_SESSION_OP_ROUTING`, when their ops are
+ * routed; other sessions use a single plugin for all ops. Pass a NULL name to
+ * remove the override. */
+int vaccel_sched_override(vaccel_op_type_t op_type, const char *plugin_name);
+
+#ifdef __cplusplus
+}
+#endif
@@ -11,10 +11,26 @@
 #include <stdint.h>
 #include <sys/types.h>
 
+#ifdef __cplusplus
+#include <atomic>
+#ifndef atomic_bool
+typedef std::atomic<bool> atomic_bool;
+#endif
+#else
+#include <stdatomic.h>
+#endif
+
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/* Session flag: route each op to the best registered plugin implementing it,
+ * instead of using a single plugin for the whole session. Only applies to
+ * local sessions. Resources are registered with every plugin the session
+ * routes to, so the routing can't be updated while resources are
+ * registered. */
+#define VACCEL_SESSION_OP_ROUTING 0x10000
+
 struct vaccel_plugin;
 
 struct vaccel_session {
@@ -30,9 +46,13 @@ struct vaccel_session {
 	/* local or virtio option */
 	bool is_virtio;
 
-	/* fs run directory */
+	/* fs run directory path. The directory is only created when first
+	 * requested with `vaccel_session_rundir()` */
 	char rundir[PATH_MAX];
 
+	/* true if the fs run directory has been created */
+	atomic_bool rundir_created;
+
 	/* entry for global sessions list */
 	struct vaccel_list_entry entry;
 
@@ -48,6 +68,9 @@ struct vaccel_session {
 	/* plugin providing the session operations */
 	struct vaccel_plugin *plugin;
 
+	/* per-op plugin dispatch table, if op routing is enabled */
+	struct vaccel_plugin **op_plugins;
+
 	/* backend private data */
 	void *priv;
 };
@@ -67,6 +90,10 @@ int vaccel_session_new(struct vaccel_session **sess, uint32_t flags);
 /* Release session data and free session created with `vaccel_session_new()` */
 int vaccel_session_delete(struct vaccel_session *sess);
 
+/* Get the fs run directory of a session, creating it if needed. Returns NULL
+ * on failure. */
+const char *vaccel_session_rundir(struct vaccel_session *sess);
+
 /* Check if a resource is registered with a session */
 bool vaccel_session_has_resource(struct vaccel_session *sess,
 				 struct vaccel_resource *res);
@@ -0,0 +1,59 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "session.h"
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vaccel_session_pool {
+	/* flags the pool's sessions are initialized with */
+	uint32_t flags;
+
+	/* idle sessions, ready to be handed out */
+	struct vaccel_session **idle;
+	size_t nr_idle;
+
+	/* maximum number of idle sessions kept */
+	size_t capacity;
+
+	/* lock for the idle sessions */
+	pthread_mutex_t lock;
+};
+
+/* Initialize session pool, creating `capacity` sessions with `flags` up front.
+ * Pools must be released before `vaccel_cleanup()`. */
+int vaccel_session_pool_init(struct vaccel_session_pool *pool, uint32_t flags,
+			     size_t capacity);
+
+/* Release session pool data, deleting its idle sessions */
+int vaccel_session_pool_release(struct vaccel_session_pool *pool);
+
+/* Allocate and initialize session pool */
+int vaccel_session_pool_new(struct vaccel_session_pool **pool, uint32_t flags,
+			    size_t capacity);
+
+/* Release session pool data and free session pool created with
+ * `vaccel_session_pool_new()` */
+int vaccel_session_pool_delete(struct vaccel_session_pool *pool);
+
+/* Get an idle session from the pool, or create a new one if there is none */
+int vaccel_session_pool_get(struct vaccel_session_pool *pool,
+			    struct vaccel_session **sess);
+
+/* Return a session got with `vaccel_session_pool_get()` to the pool. Its
+ * resources are unregistered, its rundir is removed and it is kept under a
+ * new id for the next `vaccel_session_pool_get()`. If the pool is full, or the
+ * session is remote or has private data set, the session is deleted
+ * instead. */
+int vaccel_session_pool_put(struct vaccel_session_pool *pool,
+			    struct vaccel_session *sess);
+
+#ifdef __cplusplus
+}
+#endif
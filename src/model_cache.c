@@ -0,0 +1,372 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "model_cache.h"
+#include "config.h"
+#include "core.h"
+#include "error.h"
+#include "list.h"
+#include "log.h"
+#include "resource.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+struct model_cache_entry {
+	/* resource the model was loaded for */
+	const struct vaccel_resource *res;
+	vaccel_id_t res_id;
+
+	/* caller that loaded the model, typically a plugin */
+	const void *owner;
+
+	/* the loaded model and its unload function */
+	void *model;
+	vaccel_model_unload_fn_t unload;
+
+	/* memory of the model, in bytes */
+	size_t size;
+
+	/* number of users of the model */
+	unsigned int nr_refs;
+
+	/* entry for the cache's LRU list */
+	struct vaccel_list_entry entry;
+};
+
+static struct {
+	/* true if the model cache has been initialized */
+	bool initialized;
+
+	/* loaded models, least recently used first */
+	struct vaccel_list_entry lru;
+
+	/* memory budget in bytes; 0 for no limit */
+	size_t budget;
+
+	/* counters */
+	struct vaccel_model_cache_stats stats;
+
+	/* lock for the models and counters */
+	pthread_mutex_t lock;
+} cache = { .initialized = false, .lock = PTHREAD_MUTEX_INITIALIZER };
+
+#define model_cache_for_each_safe(iter, tmp, list)          \
+	list_for_each_container_safe((iter), (tmp), (list), \
+				     struct model_cache_entry, entry)
+
+int model_cache_bootstrap(void)
+{
+	pthread_mutex_lock(&cache.lock);
+
+	list_init(&cache.lru);
+	cache.budget = vaccel_config()->model_cache_size;
+	cache.stats = (struct vaccel_model_cache_stats){ 0 };
+	cache.initialized = true;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+/* Move an entry out of the cache, to be unloaded after the lock is dropped.
+ * Must be called with the lock held */
+static void entry_remove(struct model_cache_entry *e,
+			 struct vaccel_list_entry *unloaded)
+{
+	list_unlink_entry(&e->entry);
+	list_add_tail(unloaded, &e->entry);
+
+	cache.stats.nr_models--;
+	cache.stats.size -= e->size;
+}
+
+/* Unload entries removed from the cache. Plugins may take long to unload
+ * models, so this is done without the lock held. */
+static void entries_unload(struct vaccel_list_entry *unloaded)
+{
+	struct model_cache_entry *e;
+	struct model_cache_entry *tmp;
+	model_cache_for_each_safe(e, tmp, unloaded)
+	{
+		vaccel_debug("Unloading cached model of resource %" PRId64,
+			     e->res_id);
+
+		list_unlink_entry(&e->entry);
+		if (e->unload)
+			e->unload(e->model);
+		free(e);
+	}
+}
+
+/* Evict least recently used models with no references until the cache fits
+ * its budget. Must be called with the lock held */
+static void evict_over_budget(struct vaccel_list_entry *unloaded)
+{
+	if (!cache.budget)
+		return;
+
+	struct model_cache_entry *e;
+	struct model_cache_entry *tmp;
+	model_cache_for_each_safe(e, tmp, &cache.lru)
+	{
+		if (cache.stats.size <= cache.budget)
+			break;
+
+		if (e->nr_refs)
+			continue;
+
+		entry_remove(e, unloaded);
+		cache.stats.evictions++;
+	}
+}
+
+int model_cache_cleanup(void)
+{
+	struct vaccel_list_entry unloaded;
+	list_init(&unloaded);
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_OK;
+	}
+
+	struct model_cache_entry *e;
+	struct model_cache_entry *tmp;
+	model_cache_for_each_safe(e, tmp, &cache.lru)
+	{
+		entry_remove(e, &unloaded);
+	}
+	cache.initialized = false;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	entries_unload(&unloaded);
+
+	return VACCEL_OK;
+}
+
+/* Must be called with the lock held */
+static struct model_cache_entry *entry_find(const struct vaccel_resource *res,
+					    const void *owner)
+{
+	struct model_cache_entry *e;
+	list_for_each_container(e, &cache.lru, struct model_cache_entry, entry)
+	{
+		if (e->res == res && e->res_id == res->id && e->owner == owner)
+			return e;
+	}
+
+	return NULL;
+}
+
+int vaccel_model_cache_get(const struct vaccel_resource *res,
+			   const void *owner, void **model)
+{
+	if (!res || !model)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_EPERM;
+	}
+
+	struct model_cache_entry *e = entry_find(res, owner);
+	if (!e) {
+		cache.stats.misses++;
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_ENOENT;
+	}
+
+	e->nr_refs++;
+	cache.stats.hits++;
+
+	/* Keep the LRU order */
+	list_unlink_entry(&e->entry);
+	list_add_tail(&cache.lru, &e->entry);
+
+	*model = e->model;
+
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+int vaccel_model_cache_add(const struct vaccel_resource *res,
+			   const void *owner, void *model, size_t size,
+			   vaccel_model_unload_fn_t unload)
+{
+	if (!res || res->id <= 0 || !model)
+		return VACCEL_EINVAL;
+
+	struct model_cache_entry *e =
+		(struct model_cache_entry *)malloc(sizeof(*e));
+	if (!e)
+		return VACCEL_ENOMEM;
+
+	e->res = res;
+	e->res_id = res->id;
+	e->owner = owner;
+	e->model = model;
+	e->unload = unload;
+	e->size = size;
+	e->nr_refs = 1;
+
+	struct vaccel_list_entry unloaded;
+	list_init(&unloaded);
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		free(e);
+		return VACCEL_EPERM;
+	}
+
+	if (entry_find(res, owner)) {
+		pthread_mutex_unlock(&cache.lock);
+		free(e);
+		return VACCEL_EEXIST;
+	}
+
+	list_add_tail(&cache.lru, &e->entry);
+	cache.stats.nr_models++;
+	cache.stats.size += size;
+
+	evict_over_budget(&unloaded);
+
+	pthread_mutex_unlock(&cache.lock);
+
+	entries_unload(&unloaded);
+
+	vaccel_debug("Cached model of resource %" PRId64 " (%zu bytes)",
+		     res->id, size);
+
+	return VACCEL_OK;
+}
+
+int vaccel_model_cache_put(const struct vaccel_resource *res,
+			   const void *owner)
+{
+	if (!res)
+		return VACCEL_EINVAL;
+
+	struct vaccel_list_entry unloaded;
+	list_init(&unloaded);
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_EPERM;
+	}
+
+	struct model_cache_entry *e = entry_find(res, owner);
+	if (!e || !e->nr_refs) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_EINVAL;
+	}
+
+	/* With no sessions left to reuse it, the model goes with the last
+	 * reference */
+	if (!--e->nr_refs && !vaccel_resource_refcount(res))
+		entry_remove(e, &unloaded);
+	else
+		evict_over_budget(&unloaded);
+
+	pthread_mutex_unlock(&cache.lock);
+
+	entries_unload(&unloaded);
+
+	return VACCEL_OK;
+}
+
+int vaccel_model_cache_set_budget(size_t size)
+{
+	struct vaccel_list_entry unloaded;
+	list_init(&unloaded);
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return VACCEL_EPERM;
+	}
+
+	cache.budget = size;
+	evict_over_budget(&unloaded);
+
+	pthread_mutex_unlock(&cache.lock);
+
+	entries_unload(&unloaded);
+
+	return VACCEL_OK;
+}
+
+int vaccel_model_cache_stats(struct vaccel_model_cache_stats *stats)
+{
+	if (!stats)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&cache.lock);
+	*stats = cache.stats;
+	pthread_mutex_unlock(&cache.lock);
+
+	return VACCEL_OK;
+}
+
+/* Remove the models of a resource, all of them or only the ones with no
+ * references */
+static void drop(const struct vaccel_resource *res, bool referenced)
+{
+	struct vaccel_list_entry unloaded;
+	list_init(&unloaded);
+
+	pthread_mutex_lock(&cache.lock);
+
+	if (!cache.initialized) {
+		pthread_mutex_unlock(&cache.lock);
+		return;
+	}
+
+	struct model_cache_entry *e;
+	struct model_cache_entry *tmp;
+	model_cache_for_each_safe(e, tmp, &cache.lru)
+	{
+		if (e->res != res || e->res_id != res->id)
+			continue;
+
+		if (e->nr_refs) {
+			if (!referenced)
+				continue;
+
+			vaccel_warn("Unloading model of resource %" PRId64
+				    " with %u references",
+				    res->id, e->nr_refs);
+		}
+
+		entry_remove(e, &unloaded);
+	}
+
+	pthread_mutex_unlock(&cache.lock);
+
+	entries_unload(&unloaded);
+}
+
+void model_cache_drop_idle(const struct vaccel_resource *res)
+{
+	if (res)
+		drop(res, false);
+}
+
+void model_cache_drop(const struct vaccel_resource *res)
+{
+	if (res)
+		drop(res, true);
+}
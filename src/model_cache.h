@@ -0,0 +1,24 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/model_cache.h" // IWYU pragma: export
+#include "resource.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+int model_cache_bootstrap(void);
+int model_cache_cleanup(void);
+
+/* Unload the models of a resource that have no references, once the resource
+ * is no longer registered with any session */
+void model_cache_drop_idle(const struct vaccel_resource *res);
+
+/* Unload all models of a resource that is being released */
+void model_cache_drop(const struct vaccel_resource *res);
+
+#ifdef __cplusplus
+}
+#endif
@@ -0,0 +1,42 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "op.h"
+#include "error.h"
+#include "log.h"
+#include "plugin.h"
+#include "prof.h"
+#include "session.h"
+#include <stddef.h>
+
+/* Per-op profiling regions, registered by the op wrappers at load time */
+static struct vaccel_prof_region *op_prof_regions[VACCEL_OP_MAX];
+
+void op_register_prof_region(vaccel_op_type_t op_type,
+			     struct vaccel_prof_region *region)
+{
+	if (op_type >= VACCEL_OP_MAX)
+		return;
+
+	op_prof_regions[op_type] = region;
+}
+
+int vaccel_op_prepare(struct vaccel_session *sess, vaccel_op_type_t op_type,
+		      struct vaccel_op_handle *handle)
+{
+	if (!sess || !handle || op_type >= VACCEL_OP_MAX)
+		return VACCEL_EINVAL;
+
+	op_debug_plugin_lookup(sess, op_type);
+
+	void *func =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
+	if (!func)
+		return VACCEL_ENOTSUP;
+
+	handle->sess = sess;
+	handle->type = op_type;
+	handle->func = func;
+	handle->prof = op_prof_regions[op_type];
+
+	return VACCEL_OK;
+}
@@ -5,8 +5,17 @@
 #include "include/vaccel/op.h" // IWYU pragma: export
 #include "inttypes.h"
 #include "log.h"
+#include "prof.h"
 #include "session.h"
 #include "utils/enum.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+void op_register_prof_region(vaccel_op_type_t op_type,
+			     struct vaccel_prof_region *region);
 
 static inline void op_debug_plugin_lookup(const struct vaccel_session *sess,
 					  vaccel_op_type_t op_type)
@@ -17,3 +26,27 @@ static inline void op_debug_plugin_lookup(const struct vaccel_session *sess,
 		     vaccel_op_type_name(op_type, op_name,
 					 VACCEL_ENUM_STR_MAX));
 }
+
+/* Get the plugin implementing an op for a session, taking into account the
+ * session's per-op routing table, if any */
+static inline struct vaccel_plugin *
+op_session_plugin(const struct vaccel_session *sess, vaccel_op_type_t op_type)
+{
+	if (sess->op_plugins && op_type < VACCEL_OP_MAX &&
+	    sess->op_plugins[op_type])
+		return sess->op_plugins[op_type];
+
+	return sess->plugin;
+}
+
+/* Validate a prepared handle for the given op type */
+static inline bool op_handle_valid(const struct vaccel_op_handle *handle,
+				   vaccel_op_type_t op_type)
+{
+	return handle && handle->sess && handle->func &&
+	       handle->type == op_type;
+}
+
+#ifdef __cplusplus
+}
+#endif
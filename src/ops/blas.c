@@ -7,6 +7,7 @@
 #include "op.h"
 #include "plugin.h"
 #include "prof.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stddef.h>
@@ -34,13 +35,16 @@ int vaccel_sgemm(struct vaccel_session *sess, int64_t m, int64_t n, int64_t k,
 
 	vaccel_prof_region_start(&blas_op_stats);
 
-	sgemm_fn_t plugin_sgemm = plugin_get_op_func(sess->plugin, op_type);
+	sgemm_fn_t plugin_sgemm =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_sgemm) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_sgemm(sess, m, n, k, alpha, a, lda, b, ldb, beta, c, ldc);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&blas_op_stats);
@@ -48,6 +52,29 @@ out:
 	return ret;
 }
 
+int vaccel_op_call_sgemm(const struct vaccel_op_handle *handle, int64_t m,
+			 int64_t n, int64_t k, float alpha, float *a,
+			 int64_t lda, float *b, int64_t ldb, float beta,
+			 float *c, int64_t ldc)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_BLAS_SGEMM))
+		return VACCEL_EINVAL;
+
+	vaccel_prof_region_start(handle->prof);
+
+	sgemm_fn_t plugin_sgemm = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_sgemm(handle->sess, m, n, k, alpha, a, lda, b, ldb, beta,
+			   c, ldc);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 int vaccel_sgemm_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 			int nr_read, struct vaccel_arg *write, int nr_write)
 {
@@ -159,6 +186,7 @@ int vaccel_sgemm_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_BLAS_SGEMM, &blas_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
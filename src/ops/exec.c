@@ -9,6 +9,7 @@
 #include "plugin.h"
 #include "prof.h"
 #include "resource.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -35,14 +36,17 @@ int vaccel_exec(struct vaccel_session *sess, const char *library,
 
 	vaccel_prof_region_start(&exec_op_stats);
 
-	exec_fn_t plugin_exec = plugin_get_op_func(sess->plugin, op_type);
+	exec_fn_t plugin_exec =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_exec) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_exec(sess, library, fn_symbol, read, nr_read, write,
 			  nr_write);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&exec_op_stats);
@@ -50,6 +54,29 @@ out:
 	return ret;
 }
 
+int vaccel_op_call_exec(const struct vaccel_op_handle *handle,
+			const char *library, const char *fn_symbol,
+			struct vaccel_arg *read, size_t nr_read,
+			struct vaccel_arg *write, size_t nr_write)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_EXEC))
+		return VACCEL_EINVAL;
+
+	vaccel_prof_region_start(handle->prof);
+
+	exec_fn_t plugin_exec = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_exec(handle->sess, library, fn_symbol, read, nr_read,
+			  write, nr_write);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 int vaccel_exec_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 		       int nr_read, struct vaccel_arg *write, int nr_write)
 {
@@ -135,14 +162,16 @@ int vaccel_exec_with_resource(struct vaccel_session *sess,
 	vaccel_prof_region_start(&exec_res_op_stats);
 
 	exec_with_resource_fn_t plugin_exec_with_resource =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_exec_with_resource) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_exec_with_resource(sess, resource, fn_symbol, read,
 					nr_read, write, nr_write);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&exec_res_op_stats);
@@ -150,6 +179,44 @@ out:
 	return ret;
 }
 
+int vaccel_op_call_exec_with_resource(const struct vaccel_op_handle *handle,
+				      struct vaccel_resource *resource,
+				      const char *fn_symbol,
+				      struct vaccel_arg *read, size_t nr_read,
+				      struct vaccel_arg *write, size_t nr_write)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_EXEC_WITH_RESOURCE) ||
+	    !resource)
+		return VACCEL_EINVAL;
+
+	if (resource->type != VACCEL_RESOURCE_LIB) {
+		vaccel_error(
+			"Invalid resource type: expected VACCEL_RESOURCE_LIB");
+		return VACCEL_EINVAL;
+	}
+
+	if (!vaccel_session_has_resource(handle->sess, resource)) {
+		vaccel_error("Resource %" PRId64
+			     " is not registered to session %" PRId64 "",
+			     resource->id, handle->sess->id);
+		return VACCEL_EPERM;
+	}
+
+	vaccel_prof_region_start(handle->prof);
+
+	exec_with_resource_fn_t plugin_exec_with_resource = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_exec_with_resource(handle->sess, resource, fn_symbol,
+					read, nr_read, write, nr_write);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 int vaccel_exec_with_res_unpack(struct vaccel_session *sess,
 				struct vaccel_arg *read, int nr_read,
 				struct vaccel_arg *write, int nr_write)
@@ -210,6 +277,9 @@ int vaccel_exec_with_res_unpack(struct vaccel_session *sess,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_EXEC, &exec_op_stats);
+	op_register_prof_region(VACCEL_OP_EXEC_WITH_RESOURCE,
+				&exec_res_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
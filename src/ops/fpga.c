@@ -9,6 +9,7 @@
 #include "op.h"
 #include "plugin.h"
 #include "prof.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -33,13 +34,15 @@ int vaccel_fpga_arraycopy(struct vaccel_session *sess, int a[], int out_a[],
 	vaccel_prof_region_start(&fpga_arraycopy_op_stats);
 
 	fpga_arraycopy_fn_t plugin_fpga_arraycopy =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_fpga_arraycopy) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_fpga_arraycopy(sess, a, out_a, len_a);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&fpga_arraycopy_op_stats);
@@ -92,13 +95,15 @@ int vaccel_fpga_mmult(struct vaccel_session *sess, float a[], float b[],
 	vaccel_prof_region_start(&fpga_mmult_op_stats);
 
 	fpga_mmult_fn_t plugin_fpga_mmult =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_fpga_mmult) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_fpga_mmult(sess, a, b, c, len_a);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&fpga_mmult_op_stats);
@@ -152,13 +157,15 @@ int vaccel_fpga_parallel(struct vaccel_session *sess, float a[], float b[],
 	vaccel_prof_region_start(&fpga_parallel_op_stats);
 
 	fpga_parallel_fn_t plugin_fpga_parallel =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_fpga_parallel) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_fpga_parallel(sess, a, b, add_output, mult_output, len_a);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&fpga_parallel_op_stats);
@@ -213,13 +220,15 @@ int vaccel_fpga_vadd(struct vaccel_session *sess, float a[], float b[],
 	vaccel_prof_region_start(&fpga_vadd_op_stats);
 
 	fpga_vadd_t plugin_fpga_vadd =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_fpga_vadd) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_fpga_vadd(sess, a, b, c, len_a, len_b);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&fpga_vadd_op_stats);
@@ -256,6 +265,10 @@ int vaccel_fpga_vadd_unpack(struct vaccel_session *sess,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_FPGA_ARRAYCOPY, &fpga_arraycopy_op_stats);
+	op_register_prof_region(VACCEL_OP_FPGA_MMULT, &fpga_mmult_op_stats);
+	op_register_prof_region(VACCEL_OP_FPGA_PARALLEL, &fpga_parallel_op_stats);
+	op_register_prof_region(VACCEL_OP_FPGA_VECTORADD, &fpga_vadd_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
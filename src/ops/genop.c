@@ -12,7 +12,10 @@
 #include "noop.h"
 #include "op.h"
 #include "opencv.h"
+#include "plugin.h"
+#include "scheduler.h"
 #include "session.h"
+#include <stddef.h>
 #include <stdint.h>
 
 typedef int (*unpack_func_t)(struct vaccel_session *sess,
@@ -37,8 +40,8 @@ static unpack_func_t callbacks[VACCEL_OP_MAX] = {
 	[VACCEL_OP_OPENCV] = vaccel_opencv_unpack,
 };
 
-int vaccel_genop(struct vaccel_session *sess, struct vaccel_arg *read,
-		 int nr_read, struct vaccel_arg *write, int nr_write)
+int genop_op_type(struct vaccel_arg *read, int nr_read,
+		  vaccel_op_type_t *op_type)
 {
 	if (nr_read < 1) {
 		vaccel_error("Missing operation type");
@@ -59,17 +62,118 @@ int vaccel_genop(struct vaccel_session *sess, struct vaccel_arg *read,
 		return VACCEL_EINVAL;
 	}
 
-	vaccel_op_type_t op_type = (vaccel_op_type_t)u_op_type;
-	if (!op_type || op_type >= VACCEL_OP_MAX) {
+	*op_type = (vaccel_op_type_t)u_op_type;
+	if (!*op_type || *op_type >= VACCEL_OP_MAX) {
 		vaccel_error("Invalid operation type");
 		return VACCEL_EINVAL;
 	}
 
-	if (!callbacks[op_type]) {
+	if (!callbacks[*op_type]) {
 		vaccel_error("Operation not implemented for %s",
-			     vaccel_op_type_to_str(op_type));
+			     vaccel_op_type_to_str(*op_type));
 		return VACCEL_ENOTSUP;
 	}
 
+	return VACCEL_OK;
+}
+
+int vaccel_genop(struct vaccel_session *sess, struct vaccel_arg *read,
+		 int nr_read, struct vaccel_arg *write, int nr_write)
+{
+	vaccel_op_type_t op_type;
+
+	int ret = genop_op_type(read, nr_read, &op_type);
+	if (ret)
+		return ret;
+
 	return callbacks[op_type](sess, &read[1], nr_read - 1, write, nr_write);
 }
+
+/* Op type of a request already validated with genop_op_type() */
+static inline vaccel_op_type_t genop_req_op_type(struct vaccel_genop_req *req)
+{
+	return (vaccel_op_type_t)(*(uint8_t *)req->read[0].buf);
+}
+
+/* Dispatch a run of requests of the same op type */
+static void genop_batch_dispatch(struct vaccel_session *sess,
+				 vaccel_op_type_t op_type,
+				 struct vaccel_genop_req *reqs, size_t nr_reqs)
+{
+	struct vaccel_plugin *plugin = op_session_plugin(sess, op_type);
+
+	/* Let the plugin handle the whole run, if it can. Each request counts
+	 * as a call of the op, so the batch does not skew the op's latency. */
+	if (plugin && plugin->info->genop_batch) {
+		unsigned int nr_ops = (unsigned int)nr_reqs;
+		uint64_t sched_ts = sched_ops_start(plugin, op_type, nr_ops);
+		int ret = plugin->info->genop_batch(sess, op_type, reqs,
+						    nr_reqs);
+		if (ret == VACCEL_ENOTSUP) {
+			/* Requests are run (and accounted) one by one below */
+			sched_ops_cancel(plugin, op_type, sched_ts, nr_ops);
+		} else {
+			sched_ops_stop(plugin, op_type, sched_ts, nr_ops);
+		}
+		if (ret == VACCEL_OK)
+			return;
+
+		if (ret != VACCEL_ENOTSUP) {
+			for (size_t i = 0; i < nr_reqs; i++)
+				reqs[i].ret = ret;
+			return;
+		}
+	}
+
+	for (size_t i = 0; i < nr_reqs; i++)
+		reqs[i].ret = callbacks[op_type](sess, &reqs[i].read[1],
+						 reqs[i].nr_read - 1,
+						 reqs[i].write,
+						 reqs[i].nr_write);
+}
+
+int vaccel_genop_batch(struct vaccel_session *sess,
+		       struct vaccel_genop_req *reqs, size_t nr_reqs)
+{
+	int ret = VACCEL_OK;
+	vaccel_op_type_t op_type;
+
+	if (!sess || !reqs || !nr_reqs)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < nr_reqs; i++) {
+		reqs[i].ret = genop_op_type(reqs[i].read, reqs[i].nr_read,
+					    &op_type);
+		if (reqs[i].ret && !ret)
+			ret = reqs[i].ret;
+	}
+
+	if (ret) {
+		vaccel_error("Invalid genop batch request");
+		for (size_t i = 0; i < nr_reqs; i++) {
+			if (!reqs[i].ret)
+				reqs[i].ret = VACCEL_ECANCELED;
+		}
+		return ret;
+	}
+
+	/* Dispatch consecutive requests of the same op type together */
+	size_t start = 0;
+	while (start < nr_reqs) {
+		op_type = genop_req_op_type(&reqs[start]);
+
+		size_t end = start + 1;
+		while (end < nr_reqs && genop_req_op_type(&reqs[end]) == op_type)
+			end++;
+
+		genop_batch_dispatch(sess, op_type, &reqs[start], end - start);
+		start = end;
+	}
+
+	for (size_t i = 0; i < nr_reqs; i++) {
+		if (reqs[i].ret)
+			return reqs[i].ret;
+	}
+
+	return VACCEL_OK;
+}
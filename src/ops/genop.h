@@ -3,3 +3,17 @@
 #pragma once
 
 #include "include/vaccel/ops/genop.h" // IWYU pragma: export
+#include "arg.h"
+#include "op.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Get and validate the op type of a set of genop arguments */
+int genop_op_type(struct vaccel_arg *read, int nr_read,
+		  vaccel_op_type_t *op_type);
+
+#ifdef __cplusplus
+}
+#endif
@@ -7,9 +7,11 @@
 #include "op.h"
 #include "plugin.h"
 #include "prof.h"
+#include "scheduler.h"
 #include "session.h"
 #include "utils/enum.h"
 #include <inttypes.h>
+#include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 
@@ -39,12 +41,14 @@ int vaccel_image_op(vaccel_op_type_t op_type, struct vaccel_session *sess,
 
 	vaccel_prof_region_start(&image_op_stats);
 
-	int (*plugin_image_op)() = plugin_get_op_func(sess->plugin, op_type);
+	int (*plugin_image_op)() =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_image_op) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	if (out_text != NULL && len_out_text > 0) {
 		ret = ((image_op_fn_t)plugin_image_op)(sess, img, out_text,
 						       out_imgname, len_img,
@@ -54,6 +58,7 @@ int vaccel_image_op(vaccel_op_type_t op_type, struct vaccel_session *sess,
 		ret = ((image_op_no_text_fn_t)plugin_image_op)(
 			sess, img, out_imgname, len_img, len_out_imgname);
 	}
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&image_op_stats);
@@ -61,6 +66,50 @@ out:
 	return ret;
 }
 
+static bool image_op_type_valid(vaccel_op_type_t op_type)
+{
+	switch (op_type) {
+	case VACCEL_OP_IMAGE_CLASSIFY:
+	case VACCEL_OP_IMAGE_DETECT:
+	case VACCEL_OP_IMAGE_SEGMENT:
+	case VACCEL_OP_IMAGE_POSE:
+	case VACCEL_OP_IMAGE_DEPTH:
+		return true;
+	default:
+		return false;
+	}
+}
+
+int vaccel_op_call_image(const struct vaccel_op_handle *handle,
+			 const void *img, unsigned char *out_text,
+			 unsigned char *out_imgname, size_t len_img,
+			 size_t len_out_text, size_t len_out_imgname)
+{
+	int ret;
+
+	if (!handle || !image_op_type_valid(handle->type) ||
+	    !op_handle_valid(handle, handle->type))
+		return VACCEL_EINVAL;
+
+	vaccel_prof_region_start(handle->prof);
+
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	if (out_text != NULL && len_out_text > 0) {
+		image_op_fn_t plugin_image_op = handle->func;
+		ret = plugin_image_op(handle->sess, img, out_text, out_imgname,
+				      len_img, len_out_text, len_out_imgname);
+	} else {
+		image_op_no_text_fn_t plugin_image_op = handle->func;
+		ret = plugin_image_op(handle->sess, img, out_imgname, len_img,
+				      len_out_imgname);
+	}
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 #define vaccel_image_op_no_text(op_type, sess, img, out_imgname, len_img,  \
 				len_out_imgname)                           \
 	vaccel_image_op(op_type, sess, img, NULL, out_imgname, len_img, 0, \
@@ -218,6 +267,11 @@ int vaccel_image_depth_unpack(struct vaccel_session *sess,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_IMAGE_CLASSIFY, &image_op_stats);
+	op_register_prof_region(VACCEL_OP_IMAGE_DETECT, &image_op_stats);
+	op_register_prof_region(VACCEL_OP_IMAGE_SEGMENT, &image_op_stats);
+	op_register_prof_region(VACCEL_OP_IMAGE_POSE, &image_op_stats);
+	op_register_prof_region(VACCEL_OP_IMAGE_DEPTH, &image_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
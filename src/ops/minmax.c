@@ -9,6 +9,7 @@
 #include "op.h"
 #include "plugin.h"
 #include "prof.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -34,14 +35,17 @@ int vaccel_minmax(struct vaccel_session *sess, const double *indata, int ndata,
 
 	vaccel_prof_region_start(&minmax_op_stats);
 
-	minmax_fn_t plugin_minmax = plugin_get_op_func(sess->plugin, op_type);
+	minmax_fn_t plugin_minmax =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_minmax) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_minmax(sess, indata, ndata, low_threshold, high_threshold,
 			    outdata, min, max);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&minmax_op_stats);
@@ -79,6 +83,7 @@ int vaccel_minmax_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_MINMAX, &minmax_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
@@ -7,6 +7,7 @@
 #include "op.h"
 #include "plugin.h"
 #include "prof.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -28,17 +29,39 @@ int vaccel_noop(struct vaccel_session *sess)
 
 	vaccel_prof_region_start(&noop_op_stats);
 
-	noop_fn_t plugin_noop = plugin_get_op_func(sess->plugin, op_type);
+	noop_fn_t plugin_noop =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_noop)
 		return VACCEL_ENOTSUP;
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_noop(sess);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 	vaccel_prof_region_stop(&noop_op_stats);
 
 	return ret;
 }
 
+int vaccel_op_call_noop(const struct vaccel_op_handle *handle)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_NOOP))
+		return VACCEL_EINVAL;
+
+	vaccel_prof_region_start(handle->prof);
+
+	noop_fn_t plugin_noop = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_noop(handle->sess);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 int vaccel_noop_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 		       int nr_read, struct vaccel_arg *write, int nr_write)
 {
@@ -59,6 +82,7 @@ int vaccel_noop_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_NOOP, &noop_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
@@ -5,6 +5,7 @@
 #include "op.h"
 #include "plugin.h"
 #include "prof.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -28,13 +29,16 @@ int vaccel_opencv(struct vaccel_session *sess, struct vaccel_arg *read,
 
 	vaccel_prof_region_start(&opencv_op_stats);
 
-	opencv_fn_t plugin_opencv = plugin_get_op_func(sess->plugin, op_type);
+	opencv_fn_t plugin_opencv =
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_opencv) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_opencv(sess, read, nr_read, write, nr_write);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&opencv_op_stats);
@@ -64,6 +68,7 @@ int vaccel_opencv_unpack(struct vaccel_session *sess, struct vaccel_arg *read,
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_OPENCV, &opencv_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
@@ -9,6 +9,7 @@
 #include "plugin.h"
 #include "prof.h"
 #include "resource.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -373,13 +374,15 @@ int vaccel_tf_model_load(struct vaccel_session *sess,
 	vaccel_prof_region_start(&tf_model_load_op_stats);
 
 	tf_model_load_fn_t plugin_tf_model_load =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_tf_model_load) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_tf_model_load(sess, model, status);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&tf_model_load_op_stats);
@@ -422,13 +425,15 @@ int vaccel_tf_model_unload(struct vaccel_session *sess,
 	vaccel_prof_region_start(&tf_model_unload_op_stats);
 
 	tf_model_unload_fn_t plugin_tf_model_unload =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_tf_model_unload) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_tf_model_unload(sess, model, status);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&tf_model_unload_op_stats);
@@ -482,15 +487,17 @@ int vaccel_tf_model_run(struct vaccel_session *sess,
 	vaccel_prof_region_start(&tf_model_run_op_stats);
 
 	tf_model_run_fn_t plugin_tf_model_run =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_tf_model_run) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_tf_model_run(sess, model, run_options, in_nodes,
 				  in_tensors, nr_inputs, out_nodes, out_tensors,
 				  nr_outputs, status);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&tf_model_run_op_stats);
@@ -498,8 +505,53 @@ out:
 	return ret;
 }
 
+int vaccel_op_call_tf_model_run(const struct vaccel_op_handle *handle,
+				struct vaccel_resource *model,
+				const struct vaccel_tf_buffer *run_options,
+				const struct vaccel_tf_node *in_nodes,
+				struct vaccel_tf_tensor *const *in_tensors,
+				int nr_inputs,
+				const struct vaccel_tf_node *out_nodes,
+				struct vaccel_tf_tensor **out_tensors,
+				int nr_outputs, struct vaccel_tf_status *status)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_TF_MODEL_RUN) || !model)
+		return VACCEL_EINVAL;
+
+	if (model->type != VACCEL_RESOURCE_MODEL) {
+		vaccel_error(
+			"Invalid resource type: expected VACCEL_RESOURCE_MODEL");
+		return VACCEL_EINVAL;
+	}
+
+	if (!vaccel_session_has_resource(handle->sess, model)) {
+		vaccel_error("Resource %" PRId64
+			     " is not registered to session %" PRId64 "",
+			     model->id, handle->sess->id);
+		return VACCEL_EPERM;
+	}
+
+	vaccel_prof_region_start(handle->prof);
+
+	tf_model_run_fn_t plugin_tf_model_run = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_tf_model_run(handle->sess, model, run_options, in_nodes,
+				  in_tensors, nr_inputs, out_nodes, out_tensors,
+				  nr_outputs, status);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 __attribute__((constructor)) static void vaccel_tf_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_TF_MODEL_LOAD, &tf_model_load_op_stats);
+	op_register_prof_region(VACCEL_OP_TF_MODEL_UNLOAD, &tf_model_unload_op_stats);
+	op_register_prof_region(VACCEL_OP_TF_MODEL_RUN, &tf_model_run_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_tf_ops_fini(void)
@@ -9,6 +9,7 @@
 #include "plugin.h"
 #include "prof.h"
 #include "resource.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -183,13 +184,15 @@ int vaccel_tflite_model_load(struct vaccel_session *sess,
 	vaccel_prof_region_start(&tflite_model_load_op_stats);
 
 	tflite_model_load_fn_t plugin_tflite_model_load =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_tflite_model_load) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_tflite_model_load(sess, model);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&tflite_model_load_op_stats);
@@ -230,13 +233,15 @@ int vaccel_tflite_model_unload(struct vaccel_session *sess,
 	vaccel_prof_region_start(&tflite_model_unload_op_stats);
 
 	tflite_model_unload_fn_t plugin_tflite_model_unload =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_tflite_model_unload) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_tflite_model_unload(sess, model);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&tflite_model_unload_op_stats);
@@ -285,14 +290,16 @@ int vaccel_tflite_model_run(struct vaccel_session *sess,
 	vaccel_prof_region_start(&tflite_model_run_op_stats);
 
 	tflite_model_run_fn_t plugin_tflite_model =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_tflite_model) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_tflite_model(sess, model, inputs, nr_inputs, outputs,
 				  nr_outputs, status);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&tflite_model_run_op_stats);
@@ -300,8 +307,49 @@ out:
 	return ret;
 }
 
+int vaccel_op_call_tflite_model_run(const struct vaccel_op_handle *handle,
+				    struct vaccel_resource *model,
+				    struct vaccel_tflite_tensor *const *inputs,
+				    int nr_inputs,
+				    struct vaccel_tflite_tensor **outputs,
+				    int nr_outputs, uint8_t *status)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_TFLITE_MODEL_RUN) || !model)
+		return VACCEL_EINVAL;
+
+	if (model->type != VACCEL_RESOURCE_MODEL) {
+		vaccel_error(
+			"Invalid resource type: expected VACCEL_RESOURCE_MODEL");
+		return VACCEL_EINVAL;
+	}
+
+	if (!vaccel_session_has_resource(handle->sess, model)) {
+		vaccel_error("Resource %" PRId64
+			     " is not registered to session %" PRId64 "",
+			     model->id, handle->sess->id);
+		return VACCEL_EPERM;
+	}
+
+	vaccel_prof_region_start(handle->prof);
+
+	tflite_model_run_fn_t plugin_tflite_model = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_tflite_model(handle->sess, model, inputs, nr_inputs,
+				  outputs, nr_outputs, status);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 __attribute__((constructor)) static void vaccel_tflite_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_TFLITE_MODEL_LOAD, &tflite_model_load_op_stats);
+	op_register_prof_region(VACCEL_OP_TFLITE_MODEL_UNLOAD, &tflite_model_unload_op_stats);
+	op_register_prof_region(VACCEL_OP_TFLITE_MODEL_RUN, &tflite_model_run_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_tflite_ops_fini(void)
@@ -7,6 +7,7 @@
 #include "plugin.h"
 #include "prof.h"
 #include "resource.h"
+#include "scheduler.h"
 #include "session.h"
 #include <inttypes.h>
 #include <stdint.h>
@@ -253,13 +254,15 @@ int vaccel_torch_model_load(struct vaccel_session *sess,
 	vaccel_prof_region_start(&torch_model_load_op_stats);
 
 	torch_model_load_fn_t plugin_torch_model_load =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_torch_model_load) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_torch_model_load(sess, model);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&torch_model_load_op_stats);
@@ -307,14 +310,16 @@ int vaccel_torch_model_run(struct vaccel_session *sess,
 	vaccel_prof_region_start(&torch_model_run_op_stats);
 
 	torch_model_run_fn_t plugin_torch_model_run =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_torch_model_run) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_torch_model_run(sess, model, run_options, inputs,
 				     nr_inputs, outputs, nr_outputs);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&torch_model_run_op_stats);
@@ -322,6 +327,45 @@ out:
 	return ret;
 }
 
+int vaccel_op_call_torch_model_run(const struct vaccel_op_handle *handle,
+				   struct vaccel_resource *model,
+				   const struct vaccel_torch_buffer *run_options,
+				   struct vaccel_torch_tensor *const *inputs,
+				   int nr_inputs,
+				   struct vaccel_torch_tensor **outputs,
+				   int nr_outputs)
+{
+	int ret;
+
+	if (!op_handle_valid(handle, VACCEL_OP_TORCH_MODEL_RUN) || !model)
+		return VACCEL_EINVAL;
+
+	if (model->type != VACCEL_RESOURCE_MODEL) {
+		vaccel_error(
+			"Invalid resource type: expected VACCEL_RESOURCE_MODEL");
+		return VACCEL_EINVAL;
+	}
+
+	if (!vaccel_session_has_resource(handle->sess, model)) {
+		vaccel_error("Resource %" PRId64
+			     " is not registered to session %" PRId64 "",
+			     model->id, handle->sess->id);
+		return VACCEL_EPERM;
+	}
+
+	vaccel_prof_region_start(handle->prof);
+
+	torch_model_run_fn_t plugin_torch_model_run = handle->func;
+	uint64_t sched_ts = sched_session_op_start(handle->sess, handle->type);
+	ret = plugin_torch_model_run(handle->sess, model, run_options, inputs,
+				     nr_inputs, outputs, nr_outputs);
+	sched_session_op_stop(handle->sess, handle->type, sched_ts);
+
+	vaccel_prof_region_stop(handle->prof);
+
+	return ret;
+}
+
 static struct vaccel_prof_region torch_sgemm_op_stats =
 	VACCEL_PROF_REGION_INIT("vaccel_sgemm_op");
 
@@ -348,13 +392,15 @@ int vaccel_torch_sgemm(struct vaccel_session *sess,
 	vaccel_prof_region_start(&torch_sgemm_op_stats);
 
 	torch_sgemm_fn_t plugin_torch_sgemm =
-		plugin_get_op_func(sess->plugin, op_type);
+		plugin_get_op_func(op_session_plugin(sess, op_type), op_type);
 	if (!plugin_torch_sgemm) {
 		ret = VACCEL_ENOTSUP;
 		goto out;
 	}
 
+	uint64_t sched_ts = sched_session_op_start(sess, op_type);
 	ret = plugin_torch_sgemm(sess, in_A, in_B, in_C, M, N, K, out);
+	sched_session_op_stop(sess, op_type, sched_ts);
 
 out:
 	vaccel_prof_region_stop(&torch_sgemm_op_stats);
@@ -364,6 +410,9 @@ out:
 
 __attribute__((constructor)) static void vaccel_ops_init(void)
 {
+	op_register_prof_region(VACCEL_OP_TORCH_MODEL_LOAD, &torch_model_load_op_stats);
+	op_register_prof_region(VACCEL_OP_TORCH_MODEL_RUN, &torch_model_run_op_stats);
+	op_register_prof_region(VACCEL_OP_TORCH_SGEMM, &torch_sgemm_op_stats);
 }
 
 __attribute__((destructor)) static void vaccel_ops_fini(void)
@@ -3,15 +3,32 @@
 #define _POSIX_C_SOURCE 200809L
 
 #include "plugin.h"
+#include "scheduler.h"
 #include "vaccel.h"
 #include <assert.h>
 #include <dlfcn.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+/* Immutable, read-only view of the registered plugins. A new snapshot is
+ * published on every register/unregister so that lookups never need to take
+ * the plugins lock. Replaced snapshots are kept in a retired list and freed on
+ * cleanup, since readers may still be walking them. */
+struct plugin_snapshot {
+	/* next snapshot in the retired list */
+	struct plugin_snapshot *retired;
+
+	/* number of plugins in the snapshot */
+	size_t count;
+
+	/* registered plugins, in registration order */
+	struct vaccel_plugin *plugins[];
+};
+
 static struct {
 	/* true if the plugins component is initialized */
 	bool initialized;
@@ -22,15 +39,69 @@ static struct {
 	/* counter for all registered plugins */
 	size_t count;
 
-	/* lock for list/counter */
+	/* current snapshot of the registered plugins, read without locking */
+	_Atomic(struct plugin_snapshot *) snapshot;
+
+	/* snapshots replaced by a newer one, pending release */
+	struct plugin_snapshot *retired;
+
+	/* lock for list/counter/snapshot updates */
 	pthread_mutex_t lock;
 } plugins = { .initialized = false };
 
+/* Publish a snapshot of the registered plugins, leaving out `skip` if set,
+ * so a plugin can be unpublished before it is unlinked from the list.
+ * Must be called with plugins.lock held */
+static int plugins_publish_snapshot(const struct vaccel_plugin *skip)
+{
+	const size_t count = skip ? plugins.count - 1 : plugins.count;
+	struct plugin_snapshot *snap =
+		malloc(sizeof(*snap) + count * sizeof(struct vaccel_plugin *));
+	if (!snap)
+		return VACCEL_ENOMEM;
+
+	snap->retired = NULL;
+	snap->count = 0;
+
+	struct vaccel_plugin *plugin;
+	plugin_for_each(plugin, &plugins.all)
+	{
+		if (plugin != skip)
+			snap->plugins[snap->count++] = plugin;
+	}
+	assert(snap->count == count);
+
+	struct plugin_snapshot *old = atomic_exchange_explicit(
+		&plugins.snapshot, snap, memory_order_acq_rel);
+	if (old) {
+		old->retired = plugins.retired;
+		plugins.retired = old;
+	}
+
+	return VACCEL_OK;
+}
+
+static void plugins_release_snapshots(void)
+{
+	struct plugin_snapshot *snap = atomic_exchange_explicit(
+		&plugins.snapshot, NULL, memory_order_acq_rel);
+	free(snap);
+
+	while (plugins.retired) {
+		snap = plugins.retired;
+		plugins.retired = snap->retired;
+		free(snap);
+	}
+}
+
 int plugins_bootstrap()
 {
 	list_init(&plugins.all);
 	plugins.count = 0;
+	atomic_init(&plugins.snapshot, NULL);
+	plugins.retired = NULL;
 	pthread_mutex_init(&plugins.lock, NULL);
+	sched_reset();
 
 	plugins.initialized = true;
 	return VACCEL_OK;
@@ -56,8 +127,12 @@ int plugins_cleanup()
 		pthread_mutex_lock(&plugins.lock);
 	}
 
+	plugins_release_snapshots();
+
 	pthread_mutex_unlock(&plugins.lock);
 
+	sched_reset();
+
 	pthread_mutex_destroy(&plugins.lock);
 	plugins.initialized = false;
 
@@ -213,8 +288,19 @@ int plugin_register(struct vaccel_plugin *plugin)
 	pthread_mutex_lock(&plugins.lock);
 	list_add_tail(&plugins.all, &plugin->entry);
 	plugins.count++;
+	ret = plugins_publish_snapshot(NULL);
+	if (ret) {
+		list_unlink_entry(&plugin->entry);
+		plugins.count--;
+		pthread_mutex_unlock(&plugins.lock);
+		vaccel_error("Could not publish plugin %s", info->name);
+		return ret;
+	}
 	pthread_mutex_unlock(&plugins.lock);
 
+	/* Scheduling still works for untracked plugins, only without stats */
+	sched_plugin_add(plugin);
+
 	vaccel_info("Registered plugin %s %s", info->name, info->version);
 
 	if (info->is_virtio)
@@ -241,11 +327,21 @@ int plugin_unregister(struct vaccel_plugin *plugin)
 		return VACCEL_EINVAL;
 	}
 
+	/* Publish first, so a failure leaves the plugin list untouched */
 	pthread_mutex_lock(&plugins.lock);
+	int ret = plugins_publish_snapshot(plugin);
+	if (ret) {
+		pthread_mutex_unlock(&plugins.lock);
+		vaccel_error("Could not unpublish plugin %s",
+			     plugin->info->name);
+		return ret;
+	}
 	list_unlink_entry(&plugin->entry);
 	plugins.count--;
 	pthread_mutex_unlock(&plugins.lock);
 
+	sched_plugin_remove(plugin);
+
 	/* Clean-up plugin's resources */
 	plugin->info->fini();
 
@@ -283,15 +379,81 @@ int vaccel_plugin_register_ops(struct vaccel_op *ops, size_t nr_ops)
 	return VACCEL_OK;
 }
 
+static inline struct plugin_snapshot *plugins_snapshot(void)
+{
+	return atomic_load_explicit(&plugins.snapshot, memory_order_acquire);
+}
+
+/* Check if a plugin is expected to complete the ops it has in common with
+ * another plugin faster. Plugins with no ops in common are not comparable */
+static bool plugin_faster(const struct vaccel_plugin *plugin,
+			  const struct vaccel_plugin *other)
+{
+	uint64_t plugin_ns = 0;
+	uint64_t other_ns = 0;
+	bool common = false;
+
+	for (size_t op = 0; op < VACCEL_OP_MAX; op++) {
+		if (!plugin->ops[op] || !other->ops[op])
+			continue;
+
+		plugin_ns += sched_expected_ns(plugin, op);
+		other_ns += sched_expected_ns(other, op);
+		common = true;
+	}
+
+	return common && plugin_ns < other_ns;
+}
+
+/* Select among the plugins of a snapshot that match `type_mask` (any type if
+ * 0) and implement `op_type` (any op if VACCEL_OP_MAX). This returns the first
+ * such plugin or, with the adaptive scheduling policy, the one with the lowest
+ * expected completion time. For any op, plugins are compared only on the ops
+ * they both implement, so latencies of unrelated ops don't decide */
+static struct vaccel_plugin *plugins_select(const struct plugin_snapshot *snap,
+					    unsigned int type_mask,
+					    vaccel_op_type_t op_type,
+					    bool local_only)
+{
+	const bool adaptive = sched_adaptive();
+	struct vaccel_plugin *selected = NULL;
+	uint64_t selected_ns = 0;
+
+	for (size_t i = 0; i < snap->count; i++) {
+		struct vaccel_plugin *plugin = snap->plugins[i];
+
+		if (local_only && plugin->info->is_virtio)
+			continue;
+		if (type_mask && !(type_mask & plugin->info->type))
+			continue;
+		if (op_type < VACCEL_OP_MAX && !plugin->ops[op_type])
+			continue;
+
+		if (!adaptive)
+			return plugin;
+
+		if (op_type < VACCEL_OP_MAX) {
+			uint64_t expected_ns =
+				sched_expected_ns(plugin, op_type);
+			if (!selected || expected_ns < selected_ns) {
+				selected = plugin;
+				selected_ns = expected_ns;
+			}
+		} else if (!selected || plugin_faster(plugin, selected)) {
+			selected = plugin;
+		}
+	}
+
+	return selected;
+}
+
 struct vaccel_plugin *plugin_find(unsigned int hint)
 {
 	unsigned int env_priority = hint & (~VACCEL_PLUGIN_REMOTE);
-	struct vaccel_plugin *plugin = NULL;
-
-	pthread_mutex_lock(&plugins.lock);
+	const struct plugin_snapshot *snap = plugins_snapshot();
+	struct vaccel_plugin *plugin;
 
-	if (list_empty(&plugins.all)) {
-		pthread_mutex_unlock(&plugins.lock);
+	if (!snap || !snap->count) {
 		vaccel_error("No plugins registered");
 		return NULL;
 	}
@@ -301,46 +463,92 @@ struct vaccel_plugin *plugin_find(unsigned int hint)
 	 * layers. If we get a match, return this plugin operation
 	 */
 	if (VACCEL_PLUGIN_REMOTE & hint) {
-		plugin_for_each(plugin, &plugins.all)
-		{
-			if (plugin->info->is_virtio) {
-				pthread_mutex_unlock(&plugins.lock);
-				return plugin;
-			}
+		for (size_t i = 0; i < snap->count; i++) {
+			if (snap->plugins[i]->info->is_virtio)
+				return snap->plugins[i];
 		}
 
-		pthread_mutex_unlock(&plugins.lock);
 		vaccel_error(
 			"Could not select plugin, no VirtIO plugin registered");
 		return NULL;
 	}
 
 	if (env_priority) {
-		plugin_for_each(plugin, &plugins.all)
-		{
-			if ((env_priority & plugin->info->type) != 0) {
-				pthread_mutex_unlock(&plugins.lock);
-				return plugin;
-			}
-		}
+		plugin = plugins_select(snap, env_priority, VACCEL_OP_MAX,
+					false);
+		if (plugin)
+			return plugin;
 	}
 
 	// If priority check fails, just return the first (local) implementation we find
 	// or any implementation if it's a single one
-	plugin_for_each(plugin, &plugins.all)
-	{
-		if (!plugin->info->is_virtio || plugins.count == 1) {
-			pthread_mutex_unlock(&plugins.lock);
-			return plugin;
-		}
-	}
+	plugin = plugins_select(snap, 0, VACCEL_OP_MAX, true);
+	if (plugin)
+		return plugin;
+	if (snap->count == 1)
+		return snap->plugins[0];
 
-	pthread_mutex_unlock(&plugins.lock);
 	vaccel_error("Could not select plugin, no local plugin registered");
 
 	return NULL;
 }
 
+static struct vaccel_plugin *
+plugins_select_override(const struct plugin_snapshot *snap,
+			vaccel_op_type_t op_type)
+{
+	if (!sched_override_check(op_type, NULL, NULL))
+		return NULL;
+
+	for (size_t i = 0; i < snap->count; i++) {
+		struct vaccel_plugin *plugin = snap->plugins[i];
+		bool pinned = false;
+
+		if (plugin->info->is_virtio || !plugin->ops[op_type])
+			continue;
+
+		sched_override_check(op_type, plugin, &pinned);
+		if (pinned)
+			return plugin;
+	}
+
+	char op_name[VACCEL_ENUM_STR_MAX];
+	vaccel_warn("No plugin matches the override for op %s; ignoring",
+		    vaccel_op_type_name(op_type, op_name, VACCEL_ENUM_STR_MAX));
+	return NULL;
+}
+
+size_t plugin_route_ops(unsigned int hint, struct vaccel_plugin **op_plugins)
+{
+	unsigned int env_priority = hint & (~VACCEL_PLUGIN_REMOTE);
+	const struct plugin_snapshot *snap = plugins_snapshot();
+	size_t nr_routed = 0;
+
+	if (!op_plugins)
+		return 0;
+
+	for (vaccel_op_type_t op = 0; op < VACCEL_OP_MAX; op++) {
+		op_plugins[op] = NULL;
+		if (!snap)
+			continue;
+
+		/* Use the plugin the op is pinned to, if any. Otherwise prefer
+		 * a local plugin implementing the op that matches the hint,
+		 * else fall back to any local plugin implementing it */
+		op_plugins[op] = plugins_select_override(snap, op);
+		if (!op_plugins[op] && env_priority)
+			op_plugins[op] =
+				plugins_select(snap, env_priority, op, true);
+		if (!op_plugins[op])
+			op_plugins[op] = plugins_select(snap, 0, op, true);
+
+		if (op_plugins[op])
+			nr_routed++;
+	}
+
+	return nr_routed;
+}
+
 void *plugin_get_op_func(struct vaccel_plugin *plugin, vaccel_op_type_t op_type)
 {
 	if (!plugin)
@@ -369,10 +577,8 @@ void *plugin_get_op_func(struct vaccel_plugin *plugin, vaccel_op_type_t op_type)
 
 size_t plugin_count()
 {
-	pthread_mutex_lock(&plugins.lock);
-	size_t count = plugins.count;
-	pthread_mutex_unlock(&plugins.lock);
-	return count;
+	const struct plugin_snapshot *snap = plugins_snapshot();
+	return snap ? snap->count : 0;
 }
 
 int vaccel_plugin_load(const char *lib)
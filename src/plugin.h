@@ -18,6 +18,7 @@ int plugin_parse_version(int *major, int *minor1, int *minor2, char **extra,
 int plugin_register(struct vaccel_plugin *plugin);
 int plugin_unregister(struct vaccel_plugin *plugin);
 struct vaccel_plugin *plugin_find(unsigned int hint);
+size_t plugin_route_ops(unsigned int hint, struct vaccel_plugin **op_plugins);
 void *plugin_get_op_func(struct vaccel_plugin *plugin,
 			 vaccel_op_type_t op_type);
 size_t plugin_count();
@@ -0,0 +1,237 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "reaper.h"
+#include "core.h"
+#include "error.h"
+#include "log.h"
+#include "utils/fs.h"
+#include "utils/path.h"
+#include <errno.h>
+#include <inttypes.h>
+#include <linux/limits.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+enum {
+	/* maximum number of buried directories waiting to be removed */
+	REAPER_QUEUE_MAX = 256
+};
+
+static struct {
+	/* true if the reaper is initialized */
+	bool initialized;
+
+	/* true if the reaper thread has been asked to exit */
+	bool stopping;
+
+	/* directory buried directories are moved to, created on first use */
+	char graveyard[PATH_MAX];
+	bool graveyard_created;
+
+	/* sequence number for naming buried directories */
+	uint64_t seq;
+
+	/* ring of buried directories waiting to be removed */
+	char *queue[REAPER_QUEUE_MAX];
+	size_t head;
+	size_t nr_queued;
+
+	/* true while the reaper thread removes a directory */
+	bool busy;
+
+	/* reaper thread, started on first use */
+	pthread_t thread;
+	bool started;
+
+	/* lock for the reaper */
+	pthread_mutex_t lock;
+
+	/* signaled when a directory is queued or the reaper stops */
+	pthread_cond_t cond;
+
+	/* signaled when all queued directories have been removed */
+	pthread_cond_t drained;
+} reaper = {
+	.initialized = false,
+	.lock = PTHREAD_MUTEX_INITIALIZER,
+	.cond = PTHREAD_COND_INITIALIZER,
+	.drained = PTHREAD_COND_INITIALIZER,
+};
+
+static void reaper_remove(const char *path)
+{
+	int ret = fs_dir_remove_all(path);
+	if (ret)
+		vaccel_warn("Could not remove %s: %s", path, strerror(ret));
+}
+
+static void *reaper_thread(void *arg)
+{
+	(void)arg;
+
+	pthread_mutex_lock(&reaper.lock);
+	while (true) {
+		while (!reaper.nr_queued && !reaper.stopping)
+			pthread_cond_wait(&reaper.cond, &reaper.lock);
+
+		/* The queue is drained before exiting */
+		if (!reaper.nr_queued)
+			break;
+
+		char *path = reaper.queue[reaper.head];
+		reaper.head = (reaper.head + 1) % REAPER_QUEUE_MAX;
+		reaper.nr_queued--;
+		reaper.busy = true;
+		pthread_mutex_unlock(&reaper.lock);
+
+		reaper_remove(path);
+		free(path);
+
+		pthread_mutex_lock(&reaper.lock);
+		reaper.busy = false;
+		if (!reaper.nr_queued)
+			pthread_cond_broadcast(&reaper.drained);
+	}
+	pthread_mutex_unlock(&reaper.lock);
+
+	return NULL;
+}
+
+/* Create the graveyard and start the reaper thread, if not already done. Must
+ * be called with the reaper lock held. */
+static int reaper_start(void)
+{
+	if (reaper.started)
+		return VACCEL_OK;
+
+	if (!reaper.graveyard_created) {
+		int ret = path_init_from_parts(reaper.graveyard, PATH_MAX,
+					       vaccel_rundir(), "graveyard",
+					       NULL);
+		if (ret)
+			return ret;
+
+		ret = fs_dir_create(reaper.graveyard);
+		if (ret && ret != VACCEL_EEXIST) {
+			vaccel_error("Could not create graveyard %s",
+				     reaper.graveyard);
+			return ret;
+		}
+		reaper.graveyard_created = true;
+	}
+
+	if (pthread_create(&reaper.thread, NULL, reaper_thread, NULL)) {
+		vaccel_error("Could not start rundir reaper");
+		return VACCEL_EAGAIN;
+	}
+	reaper.started = true;
+
+	return VACCEL_OK;
+}
+
+int reaper_bury(const char *path)
+{
+	if (!path)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&reaper.lock);
+
+	if (!reaper.initialized || reaper.stopping ||
+	    reaper.nr_queued == REAPER_QUEUE_MAX || reaper_start())
+		goto remove_inline;
+
+	char grave[PATH_MAX];
+	int len = snprintf(grave, PATH_MAX, "%s/%" PRIu64, reaper.graveyard,
+			   reaper.seq);
+	if (len < 0 || len >= PATH_MAX)
+		goto remove_inline;
+
+	char *grave_path = strdup(grave);
+	if (!grave_path)
+		goto remove_inline;
+
+	/* Renaming within the top-level rundir is atomic, so the directory is
+	 * gone from its original path before returning */
+	if (rename(path, grave_path)) {
+		int ret = errno;
+		free(grave_path);
+		pthread_mutex_unlock(&reaper.lock);
+		return ret;
+	}
+	reaper.seq++;
+
+	size_t tail = (reaper.head + reaper.nr_queued) % REAPER_QUEUE_MAX;
+	reaper.queue[tail] = grave_path;
+	reaper.nr_queued++;
+	pthread_cond_signal(&reaper.cond);
+
+	pthread_mutex_unlock(&reaper.lock);
+
+	return VACCEL_OK;
+
+remove_inline:
+	pthread_mutex_unlock(&reaper.lock);
+
+	return fs_dir_remove_all(path);
+}
+
+int reaper_flush(void)
+{
+	pthread_mutex_lock(&reaper.lock);
+	while (reaper.nr_queued || reaper.busy)
+		pthread_cond_wait(&reaper.drained, &reaper.lock);
+	pthread_mutex_unlock(&reaper.lock);
+
+	return VACCEL_OK;
+}
+
+int reaper_bootstrap(void)
+{
+	pthread_mutex_lock(&reaper.lock);
+
+	reaper.stopping = false;
+	reaper.graveyard_created = false;
+	reaper.seq = 0;
+	reaper.head = 0;
+	reaper.nr_queued = 0;
+	reaper.busy = false;
+	reaper.started = false;
+	reaper.initialized = true;
+
+	pthread_mutex_unlock(&reaper.lock);
+
+	return VACCEL_OK;
+}
+
+int reaper_cleanup(void)
+{
+	if (!reaper.initialized)
+		return VACCEL_OK;
+
+	pthread_mutex_lock(&reaper.lock);
+	reaper.stopping = true;
+	pthread_cond_broadcast(&reaper.cond);
+	bool started = reaper.started;
+	pthread_mutex_unlock(&reaper.lock);
+
+	/* The thread removes all queued directories before exiting */
+	if (started)
+		pthread_join(reaper.thread, NULL);
+
+	pthread_mutex_lock(&reaper.lock);
+	if (reaper.graveyard_created && fs_dir_remove(reaper.graveyard))
+		vaccel_warn("Could not remove graveyard %s", reaper.graveyard);
+	reaper.graveyard_created = false;
+	reaper.started = false;
+	reaper.initialized = false;
+	pthread_mutex_unlock(&reaper.lock);
+
+	return VACCEL_OK;
+}
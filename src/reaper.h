@@ -0,0 +1,25 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Initialize the rundir reaper */
+int reaper_bootstrap(void);
+
+/* Stop the reaper, after removing all directories buried so far */
+int reaper_cleanup(void);
+
+/* Move a directory under the top-level rundir out of the way and remove it,
+ * with all of its contents, in the background. If the reaper is not running
+ * or its queue is full the directory is removed before returning. */
+int reaper_bury(const char *path);
+
+/* Wait until all directories buried so far have been removed */
+int reaper_flush(void);
+
+#ifdef __cplusplus
+}
+#endif
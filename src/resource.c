@@ -5,12 +5,17 @@
 
 #include "resource.h"
 #include "blob.h"
+#include "config.h"
 #include "core.h"
+#include "download_cache.h"
 #include "error.h"
 #include "id_pool.h"
+#include "id_table.h"
 #include "list.h"
 #include "log.h"
+#include "model_cache.h"
 #include "plugin.h"
+#include "reaper.h"
 #include "resource_registration.h"
 #include "session.h"
 #include "utils/fs.h"
@@ -22,13 +27,95 @@
 #include <limits.h>
 #include <linux/limits.h>
 #include <pthread.h>
-#include <stdarg.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <time.h>
+#include <unistd.h>
 
-enum { VACCEL_RESOURCES_MAX = 2048 };
+#define RESOURCE_SHARED_BUCKETS 64
+
+/* Threads creating blobs for the files of a directory resource */
+#define RESOURCE_INGEST_WORKERS_MAX 8
+#define RESOURCE_INGEST_FILES_PER_WORKER 32
+/* Files a worker creates and reads blobs for at once */
+#define RESOURCE_INGEST_BATCH 16
+
+#define NS_PER_SEC 1000000000L
+#define NS_PER_MS 1000000L
+
+/* Identity of the content of a shared resource */
+struct resource_key {
+	vaccel_resource_type_t type;
+
+	/* type of the resource path; VACCEL_PATH_MAX for in-memory data */
+	vaccel_path_type_t path_type;
+
+	/* file identity of local paths */
+	dev_t dev;
+	ino_t ino;
+	struct timespec mtime;
+
+	/* size of local files or in-memory data */
+	size_t size;
+
+	/* true for in-memory data that is not persisted in the rundir */
+	bool mem_only;
+
+	/* hash of the identity fields, URL or data; selects the bucket */
+	uint64_t hash;
+};
+
+/* Background prefetch of a resource */
+struct resource_prefetch {
+	/* the resource being prefetched */
+	struct vaccel_resource *resource;
+
+	/* VACCEL_RESOURCE_PREFETCH_* flags */
+	uint32_t flags;
+
+	/* mapped data of the blobs, or paths of the blob files that haven't
+	 * been mapped yet, taken when the prefetch started */
+	const uint8_t **data;
+	size_t *sizes;
+	char **paths;
+	size_t nr_blobs;
+
+	/* thread running the prefetch */
+	pthread_t thread;
+
+	/* true once the prefetch has completed, with its result */
+	bool done;
+	int ret;
+
+	/* lock for the completion state */
+	pthread_mutex_t lock;
+
+	/* signaled when the prefetch completes */
+	pthread_cond_t cond;
+
+	/* references to the prefetch: one held by the resource and one by
+	 * each waiter. Taken under the resource's prefetch lock */
+	atomic_uint nr_refs;
+};
+
+struct resource_share {
+	/* content key the resource was created with */
+	struct resource_key key;
+
+	/* the shared resource */
+	struct vaccel_resource *resource;
+
+	/* number of vaccel_resource_*_shared() references */
+	unsigned int nr_refs;
+
+	/* entry for the shared resources bucket */
+	struct vaccel_list_entry entry;
+};
 
 static struct {
 	/* true if the resources component has been initialized */
@@ -37,6 +124,9 @@ static struct {
 	/* available resource ids */
 	id_pool_t id_pool;
 
+	/* resources indexed by id, for lock-free lookups */
+	id_table_t table;
+
 	/* array of per-type lists of all the created resources */
 	struct vaccel_list_entry all[VACCEL_RESOURCE_MAX];
 
@@ -45,20 +135,39 @@ static struct {
 
 	/* lock for lists/counters */
 	pthread_mutex_t lock;
+
+	/* hash buckets of shared resources */
+	struct vaccel_list_entry shared[RESOURCE_SHARED_BUCKETS];
+
+	/* lock for shared resources and their references */
+	pthread_mutex_t shared_lock;
 } resources = { .initialized = false };
 
 int resources_bootstrap(void)
 {
-	int ret = id_pool_init(&resources.id_pool, VACCEL_RESOURCES_MAX);
+	/* Ids and their table grow on demand up to the configured maximum */
+	const vaccel_id_t max = (vaccel_id_t)vaccel_config()->max_resources;
+
+	int ret = id_pool_init(&resources.id_pool, max);
 	if (ret)
 		return ret;
 
+	ret = id_table_init(&resources.table, max);
+	if (ret) {
+		id_pool_release(&resources.id_pool);
+		return ret;
+	}
+
 	for (int i = 0; i < VACCEL_RESOURCE_MAX; ++i) {
 		list_init(&resources.all[i]);
 		resources.count[i] = 0;
 	}
 	pthread_mutex_init(&resources.lock, NULL);
 
+	for (int i = 0; i < RESOURCE_SHARED_BUCKETS; ++i)
+		list_init(&resources.shared[i]);
+	pthread_mutex_init(&resources.shared_lock, NULL);
+
 	resources.initialized = true;
 	return VACCEL_OK;
 }
@@ -70,6 +179,30 @@ int resources_cleanup(void)
 
 	vaccel_debug("Cleaning up resources");
 
+	/* Shared resources are allocated by us, so free them along with any
+	 * references left */
+	pthread_mutex_lock(&resources.shared_lock);
+
+	for (int i = 0; i < RESOURCE_SHARED_BUCKETS; ++i) {
+		while (!list_empty(&resources.shared[i])) {
+			struct resource_share *share = list_get_container(
+				resources.shared[i].next, struct resource_share,
+				entry);
+			struct vaccel_resource *res = share->resource;
+
+			list_unlink_entry(&share->entry);
+			res->share = NULL;
+			free(share);
+
+			pthread_mutex_unlock(&resources.shared_lock);
+			vaccel_resource_delete(res);
+			pthread_mutex_lock(&resources.shared_lock);
+		}
+	}
+
+	pthread_mutex_unlock(&resources.shared_lock);
+	pthread_mutex_destroy(&resources.shared_lock);
+
 	pthread_mutex_lock(&resources.lock);
 
 	for (int i = 0; i < VACCEL_RESOURCE_MAX; ++i) {
@@ -88,6 +221,7 @@ int resources_cleanup(void)
 	pthread_mutex_destroy(&resources.lock);
 	resources.initialized = false;
 
+	id_table_release(&resources.table);
 	return id_pool_release(&resources.id_pool);
 }
 
@@ -99,22 +233,12 @@ int vaccel_resource_get_by_id(struct vaccel_resource **res, vaccel_id_t id)
 	if (!res)
 		return VACCEL_EINVAL;
 
-	pthread_mutex_lock(&resources.lock);
-
-	for (int i = 0; i < VACCEL_RESOURCE_MAX; ++i) {
-		struct vaccel_resource *r;
-		resource_for_each(r, &resources.all[i])
-		{
-			if (id == r->id) {
-				*res = r;
-				pthread_mutex_unlock(&resources.lock);
-				return VACCEL_OK;
-			}
-		}
-	}
+	struct vaccel_resource *r = id_table_get(&resources.table, id);
+	if (!r)
+		return VACCEL_ENOENT;
 
-	pthread_mutex_unlock(&resources.lock);
-	return VACCEL_ENOENT;
+	*res = r;
+	return VACCEL_OK;
 }
 
 int vaccel_resource_get_by_type(struct vaccel_resource **res,
@@ -184,12 +308,13 @@ int vaccel_resource_get_all_by_type(struct vaccel_resource ***res,
 
 static void get_resource_id(struct vaccel_resource *res)
 {
-	res->id = id_pool_get(&resources.id_pool);
+	res->id =
+		id_table_id(&resources.table, id_pool_get(&resources.id_pool));
 }
 
 static void put_resource_id(struct vaccel_resource *res)
 {
-	if (id_pool_put(&resources.id_pool, res->id))
+	if (id_pool_put(&resources.id_pool, id_table_slot(res->id)))
 		vaccel_warn("Could not return resource ID to pool");
 	res->id = 0;
 }
@@ -231,6 +356,9 @@ int resource_create_rundir(struct vaccel_resource *res)
 		return VACCEL_EINVAL;
 	}
 
+	if (res->rundir)
+		return VACCEL_OK;
+
 	char res_dir[NAME_MAX];
 	int ret = snprintf(res_dir, NAME_MAX, "resource.%" PRId64, res->id);
 	if (ret < 0) {
@@ -272,14 +400,34 @@ int resource_create_rundir(struct vaccel_resource *res)
 
 void resource_destroy_rundir(struct vaccel_resource *res)
 {
-	if (fs_dir_remove(res->rundir))
+	int ret = reaper_bury(res->rundir);
+	if (ret)
 		vaccel_warn("Could not remove rundir %s: %s", res->rundir,
-			    strerror(errno));
+			    strerror(ret));
 
 	free(res->rundir);
 	res->rundir = NULL;
 }
 
+/* Stop owning blob files in the rundir, so they are removed along with it
+ * instead of one by one */
+static void disown_rundir_blobs(struct vaccel_resource *res)
+{
+	if (!res->rundir || !res->blobs)
+		return;
+
+	const size_t rundir_len = strlen(res->rundir);
+	for (size_t i = 0; i < res->nr_blobs; i++) {
+		struct vaccel_blob *blob = res->blobs[i];
+		if (!blob || !blob->path_owned || !blob->path)
+			continue;
+
+		if (strncmp(blob->path, res->rundir, rundir_len) == 0 &&
+		    blob->path[rundir_len] == '/')
+			blob->path_owned = false;
+	}
+}
+
 static void delete_blobs(struct vaccel_blob **blobs, size_t nr_blobs)
 {
 	if (!blobs)
@@ -303,42 +451,117 @@ static int resource_populate_blob_data(struct vaccel_resource *res)
 	if (!res || !res->blobs || !res->nr_blobs)
 		return VACCEL_EINVAL;
 
-	for (size_t i = 0; i < res->nr_blobs; i++) {
-		if (!res->blobs[i])
-			return VACCEL_EINVAL;
+	return vaccel_blob_read_multi(res->blobs, res->nr_blobs);
+}
 
-		int ret = vaccel_blob_read(res->blobs[i]);
-		if (ret)
-			return ret;
-	}
+struct blobs_ingest {
+	/* files to create blobs for, and the blobs, in the same order */
+	char **files;
+	struct vaccel_blob **blobs;
+	size_t nr_files;
 
-	return VACCEL_OK;
-}
+	/* true if blob data should be read in memory */
+	bool with_data;
+
+	/* flags for mapping the blob files */
+	uint32_t map_flags;
 
-static int add_dir_files_callback(const char *path, int idx, va_list args)
+	/* index of the next file to process */
+	atomic_size_t next;
+
+	/* first error encountered; stops all workers */
+	atomic_int ret;
+};
+
+static void *blobs_ingest_worker(void *arg)
 {
-	if (!path || idx < 0)
-		return VACCEL_EINVAL;
+	struct blobs_ingest *ingest = (struct blobs_ingest *)arg;
 
-	struct vaccel_resource *res = va_arg(args, struct vaccel_resource *);
-	if (res == NULL)
-		return VACCEL_EINVAL;
-	int nr_files = va_arg(args, int);
-	if (nr_files <= 0)
-		return VACCEL_EINVAL;
+	while (!atomic_load(&ingest->ret)) {
+		size_t first = atomic_fetch_add(&ingest->next,
+						RESOURCE_INGEST_BATCH);
+		if (first >= ingest->nr_files)
+			break;
 
-	if (idx >= nr_files) {
-		vaccel_error(
-			"Files to process are more than expected (%s vs %zu)",
-			idx, nr_files);
-		return VACCEL_EINVAL;
+		size_t nr = ingest->nr_files - first;
+		if (nr > RESOURCE_INGEST_BATCH)
+			nr = RESOURCE_INGEST_BATCH;
+
+		int ret = VACCEL_OK;
+		for (size_t i = first; i < first + nr; i++) {
+			ret = vaccel_blob_new(&ingest->blobs[i],
+					      ingest->files[i]);
+			if (ret) {
+				vaccel_error(
+					"Could not create vaccel_blob for %s",
+					ingest->files[i]);
+				break;
+			}
+			ingest->blobs[i]->map_flags = ingest->map_flags;
+		}
+
+		/* Read the files of the batch at once */
+		if (!ret && ingest->with_data) {
+			ret = vaccel_blob_read_multi(&ingest->blobs[first],
+						     nr);
+			if (ret)
+				vaccel_error("Could not read files from %s",
+					     ingest->files[first]);
+		}
+
+		if (ret) {
+			int expected = 0;
+			atomic_compare_exchange_strong(&ingest->ret, &expected,
+						       ret);
+		}
 	}
 
-	int ret = vaccel_blob_new(&res->blobs[idx], path);
-	if (ret)
-		vaccel_error("Could not create vaccel_blob for %s", path);
+	return NULL;
+}
 
-	return ret;
+/* Create blobs for files on a bounded number of threads. Each blob is stored
+ * at the index of its file, so the order does not depend on scheduling. */
+static int create_file_blobs(struct vaccel_blob **blobs, char **files,
+			     size_t nr_files, bool with_data,
+			     uint32_t map_flags)
+{
+	struct blobs_ingest ingest = {
+		.files = files,
+		.blobs = blobs,
+		.nr_files = nr_files,
+		.with_data = with_data,
+		.map_flags = map_flags,
+	};
+	atomic_init(&ingest.next, 0);
+	atomic_init(&ingest.ret, 0);
+
+	long nr_cpus = sysconf(_SC_NPROCESSORS_ONLN);
+	size_t nr_workers = (nr_cpus > 0) ? (size_t)nr_cpus : 1;
+	if (nr_workers > RESOURCE_INGEST_WORKERS_MAX)
+		nr_workers = RESOURCE_INGEST_WORKERS_MAX;
+
+	/* Small directories are not worth the threads */
+	size_t max_workers = (nr_files + RESOURCE_INGEST_FILES_PER_WORKER - 1) /
+			     RESOURCE_INGEST_FILES_PER_WORKER;
+	if (nr_workers > max_workers)
+		nr_workers = max_workers;
+
+	/* The calling thread is one of the workers */
+	pthread_t threads[RESOURCE_INGEST_WORKERS_MAX];
+	size_t nr_threads = 0;
+	for (size_t i = 1; i < nr_workers; i++) {
+		if (pthread_create(&threads[nr_threads], NULL,
+				   blobs_ingest_worker, &ingest))
+			break;
+		nr_threads++;
+	}
+
+	blobs_ingest_worker(&ingest);
+
+	for (size_t i = 0; i < nr_threads; i++)
+		pthread_join(threads[i], NULL);
+
+	return atomic_load(&ingest.ret);
 }
 
 static int resource_add_blobs_from_dir(struct vaccel_resource *res,
@@ -357,74 +580,102 @@ static int resource_add_blobs_from_dir(struct vaccel_resource *res,
 	if (!res->paths || !res->paths[0] || res->nr_paths != 1)
 		return VACCEL_EINVAL;
 
-	/* Get number of dir files */
-	int nr_dirfiles = fs_dir_process_files(res->paths[0], NULL);
-	if (nr_dirfiles < 0) {
-		vaccel_error("Could not get number of files in %s",
+	char **files;
+	size_t nr_files;
+	int ret = fs_dir_list_files(res->paths[0], &files, &nr_files);
+	if (ret) {
+		vaccel_error("Could not process files from dir %s",
 			     res->paths[0]);
-		return VACCEL_EINVAL;
+		return ret;
 	}
 
-	res->blobs = (struct vaccel_blob **)malloc(
-		nr_dirfiles * sizeof(struct vaccel_blob *));
-	if (!res->blobs)
-		return VACCEL_ENOMEM;
+	if (!nr_files) {
+		vaccel_error("No files found in dir %s", res->paths[0]);
+		ret = VACCEL_EINVAL;
+		goto free_files;
+	}
 
-	for (int i = 0; i < nr_dirfiles; i++)
-		res->blobs[i] = NULL;
+	res->blobs = (struct vaccel_blob **)calloc(
+		nr_files, sizeof(struct vaccel_blob *));
+	if (!res->blobs) {
+		ret = VACCEL_ENOMEM;
+		goto free_files;
+	}
 
 	/* Create vaccel_blob struct for file paths. If the files are in
 	 * subdirectories they will be persisted in a flat directory remotely */
-	int ret = fs_dir_process_files(res->paths[0], add_dir_files_callback,
-				       res, nr_dirfiles, NULL);
-	if (ret < 0) {
-		vaccel_error("Could not process files from dir %s",
+	ret = create_file_blobs(res->blobs, files, nr_files, with_data,
+				res->map_flags);
+	if (ret) {
+		vaccel_error("Could not create blobs for dir %s",
 			     res->paths[0]);
-		goto free;
+		delete_blobs(res->blobs, nr_files);
+		free(res->blobs);
+		res->blobs = NULL;
+		goto free_files;
 	}
 
-	assert(nr_dirfiles == ret);
-	res->nr_blobs = nr_dirfiles;
+	res->nr_blobs = nr_files;
 
-	if (with_data) {
-		ret = resource_populate_blob_data(res);
-		if (ret) {
-			vaccel_error("Could not populate resource blob data");
-			goto free;
-		}
-	}
+free_files:
+	for (size_t i = 0; i < nr_files; i++)
+		free(files[i]);
+	free(files);
 
-	return VACCEL_OK;
+	return ret;
+}
 
-free:
-	delete_blobs(res->blobs, res->nr_blobs);
-	free(res->blobs);
-	res->blobs = NULL;
-	res->nr_blobs = 0;
+static void free_paths(char **paths, size_t nr_paths)
+{
+	if (!paths)
+		return;
 
-	return ret;
+	for (size_t i = 0; i < nr_paths; i++)
+		free(paths[i]);
+	free(paths);
 }
 
-static int download_file(const char *path, const char *fs_dir,
-			 size_t fs_path_size, char *fs_path)
+/* Download all remote paths of a resource in its rundir at once. The
+ * downloaded file paths are allocated and returned in `fs_paths` */
+static int download_files(struct vaccel_resource *res, char ***fs_paths)
 {
-	char filename[NAME_MAX];
-	int ret = path_file_name(path, filename, NAME_MAX, NULL);
-	if (ret)
-		return ret;
+	char **paths = (char **)calloc(res->nr_paths, sizeof(char *));
+	if (!paths)
+		return VACCEL_ENOMEM;
 
-	ret = path_init_from_parts(fs_path, fs_path_size, fs_dir, filename,
-				   NULL);
-	if (ret)
-		return ret;
+	int ret;
+	for (size_t i = 0; i < res->nr_paths; i++) {
+		if (!res->paths[i]) {
+			ret = VACCEL_EINVAL;
+			goto free;
+		}
+
+		char filename[NAME_MAX];
+		ret = path_file_name(res->paths[i], filename, NAME_MAX, NULL);
+		if (ret)
+			goto free;
+
+		ret = path_from_parts(&paths[i], res->rundir, filename, NULL);
+		if (ret)
+			goto free;
+	}
 
-	ret = net_file_download(path, fs_path);
+	ret = download_cache_files_download((const char **)res->paths,
+					    (const char **)paths,
+					    res->nr_paths);
 	if (ret) {
-		if (ret == VACCEL_EREMOTEIO)
-			fs_file_remove(fs_path);
-		return ret;
+		vaccel_error("Could not download files for resource %" PRId64,
+			     res->id);
+		goto free;
 	}
 
+	*fs_paths = paths;
+
+	return VACCEL_OK;
+
+free:
+	free_paths(paths, res->nr_paths);
+
 	return ret;
 }
 
@@ -443,62 +694,57 @@ static int resource_add_blobs(struct vaccel_resource *res, bool remote,
 	if (remote && !download)
 		return VACCEL_OK;
 
+	/* Only downloaded files need a rundir */
 	int ret;
-	if (!res->rundir) {
+	char **fs_paths = NULL;
+	if (remote) {
 		ret = resource_create_rundir(res);
 		if (ret)
-			goto cleanup_rundir;
+			return ret;
+
+		ret = download_files(res, &fs_paths);
+		if (ret)
+			goto destroy_rundir;
 	}
 
 	res->blobs = (struct vaccel_blob **)malloc(
 		res->nr_paths * sizeof(struct vaccel_blob *));
-	if (!res->blobs)
-		return VACCEL_ENOMEM;
+	if (!res->blobs) {
+		ret = VACCEL_ENOMEM;
+		goto destroy_rundir;
+	}
 
 	for (size_t i = 0; i < res->nr_paths; i++)
 		res->blobs[i] = NULL;
 
 	size_t nr_blobs = 0;
 	for (size_t i = 0; i < res->nr_paths; i++) {
-		if (!res->paths[i]) {
+		const char *path = remote ? fs_paths[i] : res->paths[i];
+		if (!path) {
 			ret = VACCEL_EINVAL;
 			goto free;
 		}
 
-		if (remote) {
-			char path[PATH_MAX];
-			ret = download_file(res->paths[i], res->rundir,
-					    PATH_MAX, path);
-			if (ret) {
-				vaccel_error("Could not download file from %s",
-					     res->paths[i]);
-				goto free;
-			}
+		ret = vaccel_blob_new(&res->blobs[i], path);
+		if (ret) {
+			vaccel_error("Could not create vaccel_blob for %s",
+				     path);
+			goto free;
+		}
+		res->blobs[i]->map_flags = res->map_flags;
 
-			ret = vaccel_blob_new(&res->blobs[i], path);
-			if (ret) {
-				vaccel_error(
-					"Could not create vaccel_blob for %s",
-					path);
-				goto free;
-			}
-			/* Mark the path as owned so it will be deleted on release */
+		/* Mark downloaded paths as owned so they will be deleted on
+		 * release */
+		if (remote)
 			res->blobs[i]->path_owned = true;
-		} else {
-			ret = vaccel_blob_new(&res->blobs[i], res->paths[i]);
-			if (ret) {
-				vaccel_error(
-					"Could not create vaccel_blob for %s",
-					res->paths[i]);
-				goto free;
-			}
-		}
 
 		++nr_blobs;
 	}
 	assert(res->nr_paths == nr_blobs);
 	res->nr_blobs = nr_blobs;
 
+	free_paths(fs_paths, res->nr_paths);
+
 	return VACCEL_OK;
 
 free:
@@ -506,8 +752,10 @@ free:
 	free(res->blobs);
 	res->blobs = NULL;
 	res->nr_blobs = 0;
-cleanup_rundir:
-	resource_destroy_rundir(res);
+destroy_rundir:
+	free_paths(fs_paths, res->nr_paths);
+	if (res->rundir)
+		resource_destroy_rundir(res);
 
 	return ret;
 }
@@ -528,79 +776,254 @@ static int resource_add_blobs_from_local(struct vaccel_resource *res,
 	return VACCEL_OK;
 }
 
-static int resource_add_blobs_from_remote(struct vaccel_resource *res,
-					  bool download)
-{
-	if (!res)
-		return VACCEL_EINVAL;
-
-	return resource_add_blobs(res, true, download);
-}
-
-static int resource_init_with_paths(struct vaccel_resource *res,
-				    vaccel_resource_type_t type)
+/* Create a blob from in-memory data, persisted in a sealed in-memory file
+ * instead of the rundir. If `take` is true the blob takes over the buffer and
+ * frees it once copied; on failure it stays with the caller. */
+static int blob_from_buf_memfd(struct vaccel_blob **blob, const uint8_t *buf,
+			       size_t size, bool take, const char *name)
 {
-	if (!res || !res->paths || !res->nr_paths || !res->paths[0] ||
-	    type >= VACCEL_RESOURCE_MAX)
-		return VACCEL_EINVAL;
-
-	res->remote_id = 0;
-	res->type = type;
-	res->blobs = NULL;
-	res->nr_blobs = 0;
-	res->rundir = NULL;
-
-	list_init(&res->sessions);
-	pthread_mutex_init(&res->sessions_lock, NULL);
-	atomic_init(&res->refcount, 0);
+	struct vaccel_blob *b;
+	int ret = vaccel_blob_from_buf(&b, buf, size, false, name, NULL, false);
+	if (ret)
+		return ret;
 
-	pthread_mutex_lock(&resources.lock);
-	list_add_tail(&resources.all[res->type], &res->entry);
-	resources.count[res->type]++;
-	pthread_mutex_unlock(&resources.lock);
+	b->data_owned = take;
+	ret = vaccel_blob_persist_memfd(b, name);
+	if (ret) {
+		b->data_owned = false;
+		vaccel_blob_delete(b);
+		return ret;
+	}
 
-	vaccel_debug("Initialized resource %" PRId64, res->id);
+	*blob = b;
 
 	return VACCEL_OK;
 }
 
-static int resource_init_with_blobs(struct vaccel_resource *res,
-				    vaccel_resource_type_t type)
+/* Create a blob in dir from the file of a mapped blob. The file is copied in
+ * the kernel instead of through the mapped data, so this is only for blobs
+ * mapped read-only and shared, whose data always matches the file. Files owned
+ * by vAccel are never modified in place, so those are hardlinked where
+ * possible. */
+static int blob_from_mapped_file(struct vaccel_blob **blob,
+				 const struct vaccel_blob *src, const char *dir)
 {
-	if (!res || !res->blobs || !res->nr_blobs ||
-	    type >= VACCEL_RESOURCE_MAX || res->id <= 0)
-		return VACCEL_EINVAL;
+	char *path;
+	int ret = path_from_parts(&path, dir, src->name, NULL);
+	if (ret)
+		return ret;
 
-	res->remote_id = 0;
-	res->type = type;
-	res->path_type = VACCEL_PATH_LOCAL_FILE;
-	res->paths = NULL;
-	res->nr_paths = 0;
+	ret = src->path_owned ? fs_file_clone(src->path, path) :
+				fs_file_copy(src->path, path);
+	if (ret)
+		goto free_path;
 
-	list_init(&res->sessions);
-	pthread_mutex_init(&res->sessions_lock, NULL);
-	atomic_init(&res->refcount, 0);
+	struct vaccel_blob *b;
+	ret = vaccel_blob_new(&b, path);
+	if (ret) {
+		fs_file_remove(path);
+		goto free_path;
+	}
+	b->path_owned = true;
 
-	pthread_mutex_lock(&resources.lock);
-	list_add_tail(&resources.all[res->type], &res->entry);
-	resources.count[res->type]++;
-	pthread_mutex_unlock(&resources.lock);
+	ret = vaccel_blob_read(b);
+	if (ret) {
+		vaccel_blob_delete(b);
+		goto free_path;
+	}
 
-	vaccel_debug("Initialized resource %" PRId64, res->id);
+	/* As for persisted blobs, the mapping is owned */
+	b->data_owned = true;
+	*blob = b;
 
-	return VACCEL_OK;
-}
+free_path:
+	free(path);
 
-int vaccel_resource_init(struct vaccel_resource *res, const char *path,
-			 vaccel_resource_type_t type)
-{
-	return vaccel_resource_init_multi(res, &path, 1, type);
+	return ret;
 }
 
-int vaccel_resource_init_multi(struct vaccel_resource *res, const char **paths,
-			       size_t nr_paths, vaccel_resource_type_t type)
+/* Download all remote paths of a resource straight into buffer blobs, so
+ * the files never touch the rundir. If blobs are kept in memory files the
+ * buffers are moved there, so plugins can also open them by path. */
+static int resource_add_blobs_in_memory(struct vaccel_resource *res)
 {
-	int ret;
+	if (res->blobs && res->nr_blobs)
+		return VACCEL_OK;
+
+	if (!res->paths || !res->nr_paths)
+		return VACCEL_EINVAL;
+
+	uint8_t **data = (uint8_t **)calloc(res->nr_paths, sizeof(uint8_t *));
+	size_t *sizes = (size_t *)calloc(res->nr_paths, sizeof(size_t));
+	res->blobs = (struct vaccel_blob **)calloc(
+		res->nr_paths, sizeof(struct vaccel_blob *));
+	int ret;
+	if (!data || !sizes || !res->blobs) {
+		ret = VACCEL_ENOMEM;
+		goto free;
+	}
+
+	ret = net_files_download_to_buf((const char **)res->paths, data,
+					sizes, res->nr_paths);
+	if (ret) {
+		vaccel_error("Could not download files for resource %" PRId64,
+			     res->id);
+		goto free;
+	}
+
+	size_t nr_blobs = 0;
+	for (size_t i = 0; i < res->nr_paths; i++) {
+		char filename[NAME_MAX];
+		ret = path_file_name(res->paths[i], filename, NAME_MAX, NULL);
+		if (ret)
+			goto free_blobs;
+
+		if (vaccel_config()->blobs_in_memory) {
+			ret = blob_from_buf_memfd(&res->blobs[i], data[i],
+						  sizes[i], true, filename);
+		} else {
+			ret = vaccel_blob_from_buf(&res->blobs[i], data[i],
+						   sizes[i], false, filename,
+						   NULL, false);
+			/* Hand the downloaded buffer over to the blob */
+			if (!ret)
+				res->blobs[i]->data_owned = true;
+		}
+		if (ret) {
+			vaccel_error("Could not create vaccel_blob for %s",
+				     res->paths[i]);
+			goto free_blobs;
+		}
+		data[i] = NULL;
+
+		++nr_blobs;
+	}
+	res->nr_blobs = nr_blobs;
+
+	free(sizes);
+	free(data);
+
+	return VACCEL_OK;
+
+free_blobs:
+	delete_blobs(res->blobs, nr_blobs);
+	for (size_t i = 0; i < res->nr_paths; i++)
+		free(data[i]);
+free:
+	free(res->blobs);
+	res->blobs = NULL;
+	res->nr_blobs = 0;
+	free(sizes);
+	free(data);
+
+	return ret;
+}
+
+static int resource_add_blobs_from_remote(struct vaccel_resource *res,
+					  bool download)
+{
+	if (!res)
+		return VACCEL_EINVAL;
+
+	if (download && vaccel_config()->download_in_memory)
+		return resource_add_blobs_in_memory(res);
+
+	return resource_add_blobs(res, true, download);
+}
+
+/* Index a newly initialized resource and add it to the resource lists. On
+ * failure, the locks set up by the caller are destroyed. */
+static int resource_publish(struct vaccel_resource *res)
+{
+	int ret = id_table_set(&resources.table, res->id, res);
+	if (ret) {
+		vaccel_error("Could not index resource %" PRId64, res->id);
+		pthread_mutex_destroy(&res->prefetch_lock);
+		pthread_mutex_destroy(&res->load_lock);
+		pthread_mutex_destroy(&res->sessions_lock);
+		return ret;
+	}
+
+	pthread_mutex_lock(&resources.lock);
+	list_add_tail(&resources.all[res->type], &res->entry);
+	resources.count[res->type]++;
+	pthread_mutex_unlock(&resources.lock);
+
+	return VACCEL_OK;
+}
+
+static int resource_init_with_paths(struct vaccel_resource *res,
+				    vaccel_resource_type_t type)
+{
+	if (!res || !res->paths || !res->nr_paths || !res->paths[0] ||
+	    type >= VACCEL_RESOURCE_MAX)
+		return VACCEL_EINVAL;
+
+	res->remote_id = 0;
+	res->type = type;
+	res->blobs = NULL;
+	res->nr_blobs = 0;
+	res->map_flags = 0;
+	res->rundir = NULL;
+
+	list_init(&res->sessions);
+	pthread_mutex_init(&res->sessions_lock, NULL);
+	pthread_mutex_init(&res->load_lock, NULL);
+	atomic_init(&res->refcount, 0);
+	res->share = NULL;
+	res->prefetch = NULL;
+	pthread_mutex_init(&res->prefetch_lock, NULL);
+
+	int ret = resource_publish(res);
+	if (ret)
+		return ret;
+
+	vaccel_debug("Initialized resource %" PRId64, res->id);
+
+	return VACCEL_OK;
+}
+
+static int resource_init_with_blobs(struct vaccel_resource *res,
+				    vaccel_resource_type_t type)
+{
+	if (!res || !res->blobs || !res->nr_blobs ||
+	    type >= VACCEL_RESOURCE_MAX || res->id <= 0)
+		return VACCEL_EINVAL;
+
+	res->remote_id = 0;
+	res->type = type;
+	res->path_type = VACCEL_PATH_LOCAL_FILE;
+	res->paths = NULL;
+	res->nr_paths = 0;
+	res->map_flags = 0;
+
+	list_init(&res->sessions);
+	pthread_mutex_init(&res->sessions_lock, NULL);
+	pthread_mutex_init(&res->load_lock, NULL);
+	atomic_init(&res->refcount, 0);
+	res->share = NULL;
+	res->prefetch = NULL;
+	pthread_mutex_init(&res->prefetch_lock, NULL);
+
+	int ret = resource_publish(res);
+	if (ret)
+		return ret;
+
+	vaccel_debug("Initialized resource %" PRId64, res->id);
+
+	return VACCEL_OK;
+}
+
+int vaccel_resource_init(struct vaccel_resource *res, const char *path,
+			 vaccel_resource_type_t type)
+{
+	return vaccel_resource_init_multi(res, &path, 1, type);
+}
+
+int vaccel_resource_init_multi(struct vaccel_resource *res, const char **paths,
+			       size_t nr_paths, vaccel_resource_type_t type)
+{
+	int ret;
 
 	if (!resources.initialized)
 		return VACCEL_EPERM;
@@ -707,18 +1130,23 @@ int vaccel_resource_init_from_buf(struct vaccel_resource *res, const void *buf,
 		goto release_id;
 	}
 
-	if (!mem_only) {
+	/* Data kept in memory files need no rundir */
+	bool memfd = !mem_only && vaccel_config()->blobs_in_memory;
+	res->rundir = NULL;
+	if (!mem_only && !memfd) {
 		ret = resource_create_rundir(res);
 		if (ret)
 			goto free_blobs;
-	} else {
-		res->rundir = NULL;
 	}
 
 	bool rand = (filename == NULL);
 	const char *name = rand ? "file" : filename;
-	ret = vaccel_blob_from_buf(&res->blobs[0], buf, nr_bytes, false, name,
-				   res->rundir, rand);
+	if (memfd)
+		ret = blob_from_buf_memfd(&res->blobs[0], buf, nr_bytes, false,
+					  name);
+	else
+		ret = vaccel_blob_from_buf(&res->blobs[0], buf, nr_bytes,
+					   false, name, res->rundir, rand);
 	if (ret) {
 		vaccel_error("Could not create vaccel_blob from buffer");
 		goto cleanup_rundir;
@@ -783,21 +1211,24 @@ int vaccel_resource_init_from_blobs(struct vaccel_resource *res,
 	for (size_t i = 0; i != nr_blobs; i++)
 		res->blobs[i] = NULL;
 
-	/* Check if rundir should be created */
+	/* Check if rundir should be created; mapped blobs kept in memory
+	 * files don't need one */
+	bool memfd = vaccel_config()->blobs_in_memory;
 	bool create_rundir = false;
 	for (size_t i = 0; i != nr_blobs; i++) {
-		if (blobs[i]->type != VACCEL_BLOB_BUFFER) {
-			create_rundir = true;
-			break;
-		}
+		if (blobs[i]->type == VACCEL_BLOB_BUFFER ||
+		    (memfd && blobs[i]->type == VACCEL_BLOB_MAPPED))
+			continue;
+
+		create_rundir = true;
+		break;
 	}
 
+	res->rundir = NULL;
 	if (create_rundir) {
 		ret = resource_create_rundir(res);
 		if (ret)
 			goto free_blobs;
-	} else {
-		res->rundir = NULL;
 	}
 
 	bool randomize = false;
@@ -805,6 +1236,19 @@ int vaccel_resource_init_from_blobs(struct vaccel_resource *res,
 	for (size_t i = 0; i < nr_blobs; i++) {
 		if (blobs[i]->type == VACCEL_BLOB_FILE) {
 			ret = vaccel_blob_new(&res->blobs[i], blobs[i]->path);
+		} else if (memfd && blobs[i]->type == VACCEL_BLOB_MAPPED) {
+			ret = blob_from_buf_memfd(&res->blobs[i],
+						  blobs[i]->data,
+						  blobs[i]->size, false,
+						  blobs[i]->name);
+		} else if (blobs[i]->type == VACCEL_BLOB_MAPPED &&
+			   blobs[i]->path &&
+			   (blobs[i]->map_flags & VACCEL_BLOB_MAP_SHARED) &&
+			   !blob_from_mapped_file(&res->blobs[i], blobs[i],
+						  res->rundir)) {
+			/* Files that can't be copied, e.g. on name clashes,
+			 * are persisted from their data instead */
+			ret = VACCEL_OK;
 		} else {
 			const char *dir = blobs[i]->type == VACCEL_BLOB_BUFFER ?
 						  NULL :
@@ -849,6 +1293,28 @@ empty_attributes:
 	return ret;
 }
 
+int vaccel_resource_set_map_flags(struct vaccel_resource *res, uint32_t flags)
+{
+	if (!res)
+		return VACCEL_EINVAL;
+
+	if (res->id <= 0) {
+		vaccel_error("Cannot set map flags of uninitialized resource");
+		return VACCEL_EINVAL;
+	}
+
+	/* Blobs already mapped keep the flags they were mapped with */
+	res->map_flags = flags;
+	for (size_t i = 0; i < res->nr_blobs; i++) {
+		if (res->blobs[i] && !res->blobs[i]->data)
+			res->blobs[i]->map_flags = flags;
+	}
+
+	return VACCEL_OK;
+}
+
+static void resource_prefetch_reap(struct vaccel_resource *res);
+
 int vaccel_resource_release(struct vaccel_resource *res)
 {
 	if (!resources.initialized)
@@ -862,14 +1328,48 @@ int vaccel_resource_release(struct vaccel_resource *res)
 		return VACCEL_EINVAL;
 	}
 
+	/* Stop sharing the resource first, so no new references to it can be
+	 * taken while it is released */
+	struct resource_share *share = res->share;
+	if (share) {
+		pthread_mutex_lock(&resources.shared_lock);
+		if (share->nr_refs > 1) {
+			pthread_mutex_unlock(&resources.shared_lock);
+			vaccel_error("Resource %" PRId64
+				     " is shared; drop it with vaccel_resource_delete_shared()",
+				     res->id);
+			return VACCEL_EBUSY;
+		}
+		if (list_entry_linked(&share->entry))
+			list_unlink_entry(&share->entry);
+		pthread_mutex_unlock(&resources.shared_lock);
+	}
+
+	/* The prefetch uses the blobs, so it has to finish first */
+	resource_prefetch_reap(res);
+
 	int ret = resource_registration_foreach_session(
 		res, vaccel_resource_unregister);
-	if (ret)
+	if (ret) {
+		/* The resource is left intact, so share it again */
+		if (share) {
+			pthread_mutex_lock(&resources.shared_lock);
+			list_add_tail(&resources.shared[share->key.hash %
+							RESOURCE_SHARED_BUCKETS],
+				      &share->entry);
+			pthread_mutex_unlock(&resources.shared_lock);
+		}
 		return ret;
+	}
 
+	model_cache_drop(res);
+
+	pthread_mutex_destroy(&res->prefetch_lock);
 	pthread_mutex_destroy(&res->sessions_lock);
+	pthread_mutex_destroy(&res->load_lock);
 
 	if (res->blobs) {
+		disown_rundir_blobs(res);
 		delete_blobs(res->blobs, res->nr_blobs);
 		free(res->blobs);
 		res->blobs = NULL;
@@ -894,6 +1394,12 @@ int vaccel_resource_release(struct vaccel_resource *res)
 	res->nr_paths = 0;
 	res->plugin_priv = NULL;
 
+	free(share);
+	res->share = NULL;
+
+	if (id_table_clear(&resources.table, res->id))
+		vaccel_warn("Could not unindex resource %" PRId64, res->id);
+
 	pthread_mutex_lock(&resources.lock);
 	list_unlink_entry(&res->entry);
 	resources.count[res->type]--;
@@ -992,13 +1498,302 @@ int vaccel_resource_delete(struct vaccel_resource *res)
 	return VACCEL_OK;
 }
 
+#define FNV_OFFSET_BASIS 0xcbf29ce484222325ULL
+#define FNV_PRIME 0x100000001b3ULL
+
+/* FNV-1a hash of a buffer, continuing from `hash` */
+static uint64_t hash_bytes(uint64_t hash, const void *buf, size_t size)
+{
+	const uint8_t *bytes = (const uint8_t *)buf;
+
+	for (size_t i = 0; i < size; i++) {
+		hash ^= bytes[i];
+		hash *= FNV_PRIME;
+	}
+
+	return hash;
+}
+
+/* Generate the key of a resource path. The parsed path is returned in
+ * `uri_path` to compare URLs on lookup */
+static int key_from_path(struct resource_key *key, char **uri_path,
+			 const char *path, vaccel_resource_type_t type)
+{
+	memset(key, 0, sizeof(*key));
+	key->type = type;
+
+	int ret = path_from_uri(uri_path, &key->path_type, path);
+	if (ret) {
+		vaccel_error("Could not parse URI for %s", path);
+		return ret;
+	}
+
+	if (key->path_type == VACCEL_PATH_REMOTE_FILE) {
+		key->hash = hash_bytes(FNV_OFFSET_BASIS, *uri_path,
+				       strlen(*uri_path));
+		return VACCEL_OK;
+	}
+
+	struct stat st;
+	if (stat(*uri_path, &st)) {
+		ret = errno;
+		vaccel_error("Could not stat %s: %s", *uri_path, strerror(ret));
+		free(*uri_path);
+		*uri_path = NULL;
+		return ret;
+	}
+
+	/* A directory's inode doesn't change with the files in it, so it
+	 * can't tell if the resource is still the same */
+	if (!S_ISREG(st.st_mode)) {
+		vaccel_error("Cannot share %s; not a regular file", *uri_path);
+		free(*uri_path);
+		*uri_path = NULL;
+		return VACCEL_ENOTSUP;
+	}
+
+	key->dev = st.st_dev;
+	key->ino = st.st_ino;
+	key->mtime = st.st_mtim;
+	key->size = (size_t)st.st_size;
+
+	uint64_t hash = hash_bytes(FNV_OFFSET_BASIS, &key->dev,
+				   sizeof(key->dev));
+	key->hash = hash_bytes(hash, &key->ino, sizeof(key->ino));
+
+	return VACCEL_OK;
+}
+
+static void key_from_buf(struct resource_key *key, const void *buf,
+			 size_t nr_bytes, vaccel_resource_type_t type,
+			 const char *filename, bool mem_only)
+{
+	memset(key, 0, sizeof(*key));
+	key->type = type;
+	key->path_type = VACCEL_PATH_MAX;
+	key->size = nr_bytes;
+	key->mem_only = mem_only;
+
+	uint64_t hash = hash_bytes(FNV_OFFSET_BASIS, buf, nr_bytes);
+	if (filename)
+		hash = hash_bytes(hash, filename, strlen(filename));
+	key->hash = hash;
+}
+
+static bool key_equal(const struct resource_key *a,
+		      const struct resource_key *b)
+{
+	return a->type == b->type && a->path_type == b->path_type &&
+	       a->dev == b->dev && a->ino == b->ino &&
+	       a->mtime.tv_sec == b->mtime.tv_sec &&
+	       a->mtime.tv_nsec == b->mtime.tv_nsec && a->size == b->size &&
+	       a->mem_only == b->mem_only && a->hash == b->hash;
+}
+
+/* Find the shared resource with the given key. URLs and data are compared
+ * too, since only their hash is part of the key. Must be called with the
+ * shared lock held */
+static struct resource_share *share_find(const struct resource_key *key,
+					 const char *uri_path, const void *buf)
+{
+	struct vaccel_list_entry *bucket =
+		&resources.shared[key->hash % RESOURCE_SHARED_BUCKETS];
+
+	struct resource_share *share;
+	list_for_each_container(share, bucket, struct resource_share, entry)
+	{
+		if (!key_equal(&share->key, key))
+			continue;
+
+		struct vaccel_resource *res = share->resource;
+		if (key->path_type == VACCEL_PATH_REMOTE_FILE &&
+		    strcmp(res->paths[0], uri_path) != 0)
+			continue;
+
+		if (buf) {
+			const struct vaccel_blob *blob = res->blobs[0];
+			if (!blob->data || blob->size != key->size ||
+			    memcmp(blob->data, buf, key->size) != 0)
+				continue;
+		}
+
+		return share;
+	}
+
+	return NULL;
+}
+
+/* Add a new resource to the shared resources. Must be called with the shared
+ * lock held */
+static int share_add(struct vaccel_resource *res,
+		     const struct resource_key *key)
+{
+	struct resource_share *share =
+		(struct resource_share *)malloc(sizeof(*share));
+	if (!share)
+		return VACCEL_ENOMEM;
+
+	share->key = *key;
+	share->resource = res;
+	share->nr_refs = 1;
+	list_add_tail(&resources.shared[key->hash % RESOURCE_SHARED_BUCKETS],
+		      &share->entry);
+	res->share = share;
+
+	return VACCEL_OK;
+}
+
+int vaccel_resource_new_shared(struct vaccel_resource **res, const char *path,
+			       vaccel_resource_type_t type)
+{
+	if (!resources.initialized)
+		return VACCEL_EPERM;
+
+	if (!res || !path || type >= VACCEL_RESOURCE_MAX)
+		return VACCEL_EINVAL;
+
+	struct resource_key key;
+	char *uri_path;
+	int ret = key_from_path(&key, &uri_path, path, type);
+	if (ret)
+		return ret;
+
+	pthread_mutex_lock(&resources.shared_lock);
+
+	struct resource_share *share = share_find(&key, uri_path, NULL);
+	if (share) {
+		share->nr_refs++;
+		*res = share->resource;
+		goto unlock;
+	}
+
+	/* Created with the lock held, so concurrent callers with the same
+	 * path get a single resource */
+	struct vaccel_resource *r;
+	ret = vaccel_resource_new(&r, path, type);
+	if (ret)
+		goto unlock;
+
+	ret = share_add(r, &key);
+	if (ret) {
+		vaccel_resource_delete(r);
+		goto unlock;
+	}
+
+	*res = r;
+	vaccel_debug("Sharing resource %" PRId64 " for %s", r->id, path);
+
+unlock:
+	pthread_mutex_unlock(&resources.shared_lock);
+	free(uri_path);
+
+	return ret;
+}
+
+int vaccel_resource_from_buf_shared(struct vaccel_resource **res,
+				    const void *buf, size_t nr_bytes,
+				    vaccel_resource_type_t type,
+				    const char *filename, bool mem_only)
+{
+	if (!resources.initialized)
+		return VACCEL_EPERM;
+
+	if (!res || !buf || !nr_bytes || type >= VACCEL_RESOURCE_MAX)
+		return VACCEL_EINVAL;
+
+	struct resource_key key;
+	key_from_buf(&key, buf, nr_bytes, type, filename, mem_only);
+
+	pthread_mutex_lock(&resources.shared_lock);
+
+	int ret = VACCEL_OK;
+	struct resource_share *share = share_find(&key, NULL, buf);
+	if (share) {
+		share->nr_refs++;
+		*res = share->resource;
+		goto unlock;
+	}
+
+	/* Memory-only resources reference the buffer, which has to outlive
+	 * every user of the shared resource, so keep a copy instead */
+	struct vaccel_resource *r;
+	if (mem_only) {
+		const struct vaccel_blob blob = {
+			.type = VACCEL_BLOB_BUFFER,
+			.name = (char *)(filename ? filename : "file"),
+			.data = (uint8_t *)buf,
+			.data_owned = true,
+			.size = nr_bytes,
+		};
+		const struct vaccel_blob *blobs[] = { &blob };
+		ret = vaccel_resource_from_blobs(&r, blobs, 1, type);
+	} else {
+		ret = vaccel_resource_from_buf(&r, buf, nr_bytes, type,
+					       filename, false);
+	}
+	if (ret)
+		goto unlock;
+
+	ret = share_add(r, &key);
+	if (ret) {
+		vaccel_resource_delete(r);
+		goto unlock;
+	}
+
+	*res = r;
+	vaccel_debug("Sharing resource %" PRId64 " for %zu bytes", r->id,
+		     nr_bytes);
+
+unlock:
+	pthread_mutex_unlock(&resources.shared_lock);
+
+	return ret;
+}
+
+int vaccel_resource_delete_shared(struct vaccel_resource *res)
+{
+	if (!resources.initialized)
+		return VACCEL_EPERM;
+
+	if (!res || !res->share)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&resources.shared_lock);
+
+	struct resource_share *share = res->share;
+	if (--share->nr_refs) {
+		pthread_mutex_unlock(&resources.shared_lock);
+		return VACCEL_OK;
+	}
+
+	/* Stop sharing the resource before dropping the lock, so it is not
+	 * handed out again while it is deleted */
+	list_unlink_entry(&share->entry);
+
+	pthread_mutex_unlock(&resources.shared_lock);
+
+	/* The share is freed along with the resource. If that fails, the
+	 * resource is shared again and the caller keeps its reference. */
+	int ret = vaccel_resource_delete(res);
+	if (ret) {
+		pthread_mutex_lock(&resources.shared_lock);
+		share->nr_refs++;
+		pthread_mutex_unlock(&resources.shared_lock);
+	}
+
+	return ret;
+}
+
 static int resource_load_data(struct vaccel_resource *res,
 			      struct vaccel_session *sess)
 {
 	if (!res || res->path_type >= VACCEL_PATH_MAX || !sess)
 		return VACCEL_EINVAL;
 
-	int ret;
+	/* Sessions registering the resource concurrently load its data once */
+	pthread_mutex_lock(&res->load_lock);
+
+	int ret = VACCEL_EINVAL;
 	switch (res->path_type) {
 	case VACCEL_PATH_LOCAL_FILE:
 		ret = resource_add_blobs_from_local(res, sess->is_virtio);
@@ -1014,13 +1809,43 @@ static int resource_load_data(struct vaccel_resource *res,
 		break;
 	case VACCEL_PATH_MAX:
 		vaccel_error("Invalid path type");
-		ret = VACCEL_EINVAL;
 		break;
 	}
 
+	pthread_mutex_unlock(&res->load_lock);
+
 	return ret;
 }
 
+/* Collect the distinct plugins serving a session: its default plugin first,
+ * followed by any plugin the session routes ops to. Resources have to be
+ * known to all of them, since any routed op may use them */
+static size_t session_plugins(struct vaccel_session *sess,
+			      struct vaccel_plugin **plugins)
+{
+	size_t nr_plugins = 0;
+
+	plugins[nr_plugins++] = sess->plugin;
+	if (!sess->op_plugins)
+		return nr_plugins;
+
+	for (size_t op = 0; op < VACCEL_OP_MAX; op++) {
+		struct vaccel_plugin *plugin = sess->op_plugins[op];
+		if (!plugin)
+			continue;
+
+		size_t i;
+		for (i = 0; i < nr_plugins; i++) {
+			if (plugins[i] == plugin)
+				break;
+		}
+		if (i == nr_plugins)
+			plugins[nr_plugins++] = plugin;
+	}
+
+	return nr_plugins;
+}
+
 int vaccel_resource_register(struct vaccel_resource *res,
 			     struct vaccel_session *sess)
 {
@@ -1038,8 +1863,13 @@ int vaccel_resource_register(struct vaccel_resource *res,
 		return ret;
 	}
 
-	if (sess->plugin->info->resource_register) {
-		ret = sess->plugin->info->resource_register(res, sess);
+	struct vaccel_plugin *plugins[VACCEL_OP_MAX + 1];
+	size_t nr_plugins = session_plugins(sess, plugins);
+	for (size_t i = 0; i < nr_plugins; i++) {
+		if (!plugins[i]->info->resource_register)
+			continue;
+
+		ret = plugins[i]->info->resource_register(res, sess);
 		if (ret || (sess->is_virtio && res->remote_id <= 0)) {
 			vaccel_id_t res_id = sess->is_virtio ? res->remote_id :
 							       res->id;
@@ -1047,9 +1877,16 @@ int vaccel_resource_register(struct vaccel_resource *res,
 			vaccel_error("session:%" PRId64
 				     " Failed to register %sresource %" PRId64,
 				     sess->id, rem_str, res_id);
+			/* Undo the registration with the preceding plugins */
+			while (i-- > 0) {
+				if (plugins[i]->info->resource_unregister)
+					plugins[i]->info->resource_unregister(
+						res, sess);
+			}
 			return ret;
 		}
-	} else if (sess->is_virtio) {
+	}
+	if (!plugins[0]->info->resource_register && sess->is_virtio) {
 		vaccel_error(
 			"session:%" PRId64
 			" Cannot register remote resource; no VirtIO plugin loaded yet",
@@ -1119,9 +1956,14 @@ int vaccel_resource_unregister(struct vaccel_resource *res,
 		return ret;
 	}
 
-	if (sess->plugin->info->resource_unregister) {
-		ret = sess->plugin->info->resource_unregister(res, sess);
-		if (ret) {
+	struct vaccel_plugin *plugins[VACCEL_OP_MAX + 1];
+	size_t nr_plugins = session_plugins(sess, plugins);
+	for (size_t i = 0; i < nr_plugins; i++) {
+		if (!plugins[i]->info->resource_unregister)
+			continue;
+
+		int pret = plugins[i]->info->resource_unregister(res, sess);
+		if (pret) {
 			vaccel_id_t res_id = sess->is_virtio ? res->remote_id :
 							       res->id;
 			const char *rem_str = sess->is_virtio ? "remote " : "";
@@ -1129,9 +1971,13 @@ int vaccel_resource_unregister(struct vaccel_resource *res,
 				"session:%" PRId64
 				" Failed to unregister %sresource %" PRId64,
 				sess->id, rem_str, res_id);
-			return ret;
+			ret = pret;
 		}
-	} else if (sess->is_virtio) {
+	}
+	if (ret)
+		return ret;
+
+	if (!plugins[0]->info->resource_unregister && sess->is_virtio) {
 		vaccel_error("session:%" PRId64
 			     " Cannot unregister remote resource %" PRId64
 			     "; no VirtIO plugin loaded yet",
@@ -1139,6 +1985,10 @@ int vaccel_resource_unregister(struct vaccel_resource *res,
 		return VACCEL_ENOTSUP;
 	}
 
+	/* Models kept loaded for other sessions are of no use anymore */
+	if (!vaccel_resource_refcount(res))
+		model_cache_drop_idle(res);
+
 	vaccel_debug("session:%" PRId64 " Unregistered resource %" PRId64,
 		     sess->id, res->id);
 
@@ -1168,8 +2018,13 @@ int vaccel_resource_sync(struct vaccel_resource *res,
 		return VACCEL_EINVAL;
 	}
 
-	if (sess->plugin->info->resource_sync) {
-		ret = sess->plugin->info->resource_sync(res, sess);
+	struct vaccel_plugin *plugins[VACCEL_OP_MAX + 1];
+	size_t nr_plugins = session_plugins(sess, plugins);
+	for (size_t i = 0; i < nr_plugins; i++) {
+		if (!plugins[i]->info->resource_sync)
+			continue;
+
+		ret = plugins[i]->info->resource_sync(res, sess);
 		if (ret) {
 			vaccel_id_t res_id = sess->is_virtio ? res->remote_id :
 							       res->id;
@@ -1180,7 +2035,8 @@ int vaccel_resource_sync(struct vaccel_resource *res,
 				sess->id, rem_str, res_id);
 			return ret;
 		}
-	} else if (sess->is_virtio) {
+	}
+	if (!plugins[0]->info->resource_sync && sess->is_virtio) {
 		vaccel_error(
 			"session:%" PRId64
 			" Cannot synchronize remote resource; no VirtIO plugin loaded yet",
@@ -1191,6 +2047,322 @@ int vaccel_resource_sync(struct vaccel_resource *res,
 	return VACCEL_OK;
 }
 
+/* Fault in the pages of mapped data by reading a byte from each */
+static void prefetch_mapped(const uint8_t *data, size_t size)
+{
+	const long page_size = sysconf(_SC_PAGESIZE);
+	const volatile uint8_t *p = data;
+	uint8_t sum = 0;
+
+	for (size_t off = 0; off < size; off += (size_t)page_size)
+		sum += p[off];
+	(void)sum;
+}
+
+/* Let the plugins of the sessions the resource is registered with warm it
+ * up. The registrations are held meanwhile, so the resource can't be
+ * unregistered from a session, nor the session released, while its plugin is
+ * warming it up. The sessions lock itself is not held across the plugin
+ * callbacks */
+static int resource_warmup(struct vaccel_resource *res)
+{
+	struct resource_registration **regs;
+	size_t nr_regs;
+
+	int ret = resource_registration_hold_all(res, &regs, &nr_regs);
+	if (ret)
+		return ret;
+
+	for (size_t i = 0; i < nr_regs; i++) {
+		struct vaccel_session *sess = regs[i]->session;
+		if (!sess->plugin || !sess->plugin->info->resource_warmup)
+			continue;
+
+		int wret = sess->plugin->info->resource_warmup(res, sess);
+		if (wret) {
+			vaccel_error("session:%" PRId64
+				     " Failed to warm up resource %" PRId64,
+				     sess->id, res->id);
+			if (!ret)
+				ret = wret;
+		}
+	}
+
+	resource_registration_drop_all(regs, nr_regs);
+
+	return ret;
+}
+
+static void *resource_prefetch_worker(void *arg)
+{
+	struct resource_prefetch *prefetch = (struct resource_prefetch *)arg;
+	int ret = VACCEL_OK;
+
+	for (size_t i = 0; i < prefetch->nr_blobs; i++) {
+		if (prefetch->data[i]) {
+			prefetch_mapped(prefetch->data[i], prefetch->sizes[i]);
+		} else if (prefetch->paths[i]) {
+			int rret = fs_file_readahead(prefetch->paths[i]);
+			if (rret && !ret)
+				ret = rret;
+		}
+	}
+
+	if (!ret && (prefetch->flags & VACCEL_RESOURCE_PREFETCH_WARMUP))
+		ret = resource_warmup(prefetch->resource);
+
+	vaccel_debug("Prefetched resource %" PRId64 ": %s",
+		     prefetch->resource->id, strerror(ret));
+
+	pthread_mutex_lock(&prefetch->lock);
+	prefetch->ret = ret;
+	prefetch->done = true;
+	pthread_cond_broadcast(&prefetch->cond);
+	pthread_mutex_unlock(&prefetch->lock);
+
+	return NULL;
+}
+
+static void resource_prefetch_free(struct resource_prefetch *prefetch)
+{
+	if (prefetch->paths) {
+		for (size_t i = 0; i < prefetch->nr_blobs; i++)
+			free(prefetch->paths[i]);
+	}
+	free(prefetch->paths);
+	free(prefetch->sizes);
+	free((void *)prefetch->data);
+	pthread_cond_destroy(&prefetch->cond);
+	pthread_mutex_destroy(&prefetch->lock);
+	free(prefetch);
+}
+
+/* Get a reference to the prefetch of a resource, if any */
+static struct resource_prefetch *
+resource_prefetch_get(struct vaccel_resource *res)
+{
+	pthread_mutex_lock(&res->prefetch_lock);
+
+	struct resource_prefetch *prefetch = res->prefetch;
+	if (prefetch)
+		atomic_fetch_add(&prefetch->nr_refs, 1);
+
+	pthread_mutex_unlock(&res->prefetch_lock);
+
+	return prefetch;
+}
+
+/* Drop a reference to a prefetch, freeing it along with the last one. The
+ * prefetch thread must have been joined by then */
+static void resource_prefetch_put(struct resource_prefetch *prefetch)
+{
+	if (atomic_fetch_sub(&prefetch->nr_refs, 1) == 1)
+		resource_prefetch_free(prefetch);
+}
+
+/* Wait for a prefetch detached from its resource to finish and drop the
+ * resource's reference to it */
+static void resource_prefetch_join(struct resource_prefetch *prefetch)
+{
+	pthread_join(prefetch->thread, NULL);
+	resource_prefetch_put(prefetch);
+}
+
+/* Detach the prefetch of a resource, if any, and wait for it to finish */
+static void resource_prefetch_reap(struct vaccel_resource *res)
+{
+	pthread_mutex_lock(&res->prefetch_lock);
+
+	struct resource_prefetch *prefetch = res->prefetch;
+	res->prefetch = NULL;
+
+	pthread_mutex_unlock(&res->prefetch_lock);
+
+	if (prefetch)
+		resource_prefetch_join(prefetch);
+}
+
+/* Take what has to be read ahead for each blob: the data of mapped blobs,
+ * or the path of blob files that haven't been mapped yet. Buffer blobs are
+ * already in memory */
+static int resource_prefetch_snapshot(struct resource_prefetch *prefetch,
+				      struct vaccel_resource *res)
+{
+	int ret = VACCEL_OK;
+
+	/* Blobs are not swapped while the data of the resource is loaded */
+	pthread_mutex_lock(&res->load_lock);
+
+	if (!res->blobs || !res->nr_blobs) {
+		vaccel_error("Resource %" PRId64
+			     " has no blobs to prefetch; register it first",
+			     res->id);
+		ret = VACCEL_EINVAL;
+		goto unlock;
+	}
+
+	const size_t nr_blobs = res->nr_blobs;
+
+	prefetch->data = (const uint8_t **)calloc(nr_blobs, sizeof(uint8_t *));
+	prefetch->sizes = (size_t *)calloc(nr_blobs, sizeof(size_t));
+	prefetch->paths = (char **)calloc(nr_blobs, sizeof(char *));
+	if (!prefetch->data || !prefetch->sizes || !prefetch->paths) {
+		ret = VACCEL_ENOMEM;
+		goto unlock;
+	}
+	prefetch->nr_blobs = nr_blobs;
+
+	for (size_t i = 0; i < nr_blobs; i++) {
+		struct vaccel_blob *blob = res->blobs[i];
+		if (!blob || blob->type == VACCEL_BLOB_BUFFER)
+			continue;
+
+		if (blob->data && blob->size) {
+			prefetch->data[i] = blob->data;
+			prefetch->sizes[i] = blob->size;
+		} else if (blob->path) {
+			prefetch->paths[i] = strdup(blob->path);
+			if (!prefetch->paths[i]) {
+				ret = VACCEL_ENOMEM;
+				goto unlock;
+			}
+		}
+	}
+
+unlock:
+	pthread_mutex_unlock(&res->load_lock);
+
+	return ret;
+}
+
+int vaccel_resource_prefetch(struct vaccel_resource *res, uint32_t flags)
+{
+	if (!resources.initialized)
+		return VACCEL_EPERM;
+
+	if (!res)
+		return VACCEL_EINVAL;
+
+	if (res->id <= 0) {
+		vaccel_error("Cannot prefetch uninitialized resource");
+		return VACCEL_EINVAL;
+	}
+
+	struct resource_prefetch *prefetch =
+		(struct resource_prefetch *)calloc(1, sizeof(*prefetch));
+	if (!prefetch)
+		return VACCEL_ENOMEM;
+
+	prefetch->resource = res;
+	prefetch->flags = flags;
+	atomic_init(&prefetch->nr_refs, 1);
+	pthread_mutex_init(&prefetch->lock, NULL);
+
+	pthread_condattr_t attr;
+	pthread_condattr_init(&attr);
+	pthread_condattr_setclock(&attr, CLOCK_MONOTONIC);
+	pthread_cond_init(&prefetch->cond, &attr);
+	pthread_condattr_destroy(&attr);
+
+	int ret;
+	struct resource_prefetch *prev = NULL;
+
+	pthread_mutex_lock(&res->prefetch_lock);
+
+	/* A completed prefetch is replaced; a running one is left alone */
+	if (res->prefetch) {
+		pthread_mutex_lock(&res->prefetch->lock);
+		const bool done = res->prefetch->done;
+		pthread_mutex_unlock(&res->prefetch->lock);
+
+		if (!done) {
+			vaccel_error("Resource %" PRId64
+				     " is already being prefetched",
+				     res->id);
+			ret = VACCEL_EBUSY;
+			goto unlock;
+		}
+		prev = res->prefetch;
+		res->prefetch = NULL;
+	}
+
+	ret = resource_prefetch_snapshot(prefetch, res);
+	if (ret)
+		goto unlock;
+
+	ret = pthread_create(&prefetch->thread, NULL, resource_prefetch_worker,
+			     prefetch);
+	if (ret) {
+		vaccel_error("Could not start prefetch thread for resource %" PRId64,
+			     res->id);
+		goto unlock;
+	}
+
+	res->prefetch = prefetch;
+	prefetch = NULL;
+	vaccel_debug("Prefetching resource %" PRId64, res->id);
+
+unlock:
+	pthread_mutex_unlock(&res->prefetch_lock);
+
+	if (prev)
+		resource_prefetch_join(prev);
+	if (prefetch)
+		resource_prefetch_free(prefetch);
+
+	return ret;
+}
+
+int vaccel_resource_prefetch_poll(struct vaccel_resource *res)
+{
+	return vaccel_resource_prefetch_wait(res, 0);
+}
+
+int vaccel_resource_prefetch_wait(struct vaccel_resource *res, int timeout_ms)
+{
+	struct timespec deadline;
+
+	if (!res)
+		return VACCEL_EINVAL;
+
+	struct resource_prefetch *prefetch = resource_prefetch_get(res);
+	if (!prefetch)
+		return VACCEL_ENOENT;
+
+	if (timeout_ms >= 0) {
+		clock_gettime(CLOCK_MONOTONIC, &deadline);
+		deadline.tv_sec += timeout_ms / 1000;
+		deadline.tv_nsec += (long)(timeout_ms % 1000) * NS_PER_MS;
+		if (deadline.tv_nsec >= NS_PER_SEC) {
+			deadline.tv_sec++;
+			deadline.tv_nsec -= NS_PER_SEC;
+		}
+	}
+
+	int ret;
+	pthread_mutex_lock(&prefetch->lock);
+
+	while (!prefetch->done) {
+		if (timeout_ms < 0) {
+			pthread_cond_wait(&prefetch->cond, &prefetch->lock);
+		} else if (pthread_cond_timedwait(&prefetch->cond,
+						  &prefetch->lock,
+						  &deadline) == ETIMEDOUT &&
+			   !prefetch->done) {
+			ret = VACCEL_EAGAIN;
+			goto out;
+		}
+	}
+
+	ret = prefetch->ret;
+
+out:
+	pthread_mutex_unlock(&prefetch->lock);
+	resource_prefetch_put(prefetch);
+
+	return ret;
+}
+
 int vaccel_resource_directory(struct vaccel_resource *res, char *out_path,
 			      size_t out_path_size, char **alloc_path)
 {
@@ -28,6 +28,8 @@ int resource_registration_new(struct resource_registration **reg,
 
 	(*reg)->resource = res;
 	(*reg)->session = sess;
+	(*reg)->nr_users = 0;
+	pthread_cond_init(&(*reg)->idle, NULL);
 
 	return VACCEL_OK;
 }
@@ -37,6 +39,14 @@ int resource_registration_delete(struct resource_registration *reg)
 	if (!reg)
 		return VACCEL_EINVAL;
 
+	struct vaccel_resource *res = reg->resource;
+
+	pthread_mutex_lock(&res->sessions_lock);
+	while (reg->nr_users)
+		pthread_cond_wait(&reg->idle, &res->sessions_lock);
+	pthread_mutex_unlock(&res->sessions_lock);
+
+	pthread_cond_destroy(&reg->idle);
 	free(reg);
 	return VACCEL_OK;
 }
@@ -157,6 +167,69 @@ resource_registration_find_and_unlink(struct vaccel_resource *res,
 	return NULL;
 }
 
+int resource_registration_hold_all(struct vaccel_resource *res,
+				   struct resource_registration ***regs,
+				   size_t *nr_regs)
+{
+	if (!res || !regs || !nr_regs)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&res->sessions_lock);
+
+	size_t nr = 0;
+	struct resource_registration *reg;
+	list_for_each_container(reg, &res->sessions,
+				struct resource_registration, resource_entry)
+	{
+		nr++;
+	}
+
+	struct resource_registration **arr = NULL;
+	if (nr) {
+		arr = (struct resource_registration **)malloc(nr *
+							      sizeof(*arr));
+		if (!arr) {
+			pthread_mutex_unlock(&res->sessions_lock);
+			return VACCEL_ENOMEM;
+		}
+	}
+
+	size_t cnt = 0;
+	list_for_each_container(reg, &res->sessions,
+				struct resource_registration, resource_entry)
+	{
+		reg->nr_users++;
+		arr[cnt++] = reg;
+	}
+
+	pthread_mutex_unlock(&res->sessions_lock);
+
+	*regs = arr;
+	*nr_regs = cnt;
+
+	return VACCEL_OK;
+}
+
+void resource_registration_drop_all(struct resource_registration **regs,
+				    size_t nr_regs)
+{
+	if (!regs)
+		return;
+
+	/* All the registrations belong to the same resource */
+	struct vaccel_resource *res = nr_regs ? regs[0]->resource : NULL;
+	if (res) {
+		pthread_mutex_lock(&res->sessions_lock);
+		for (size_t i = 0; i < nr_regs; i++) {
+			if (!--regs[i]->nr_users)
+				pthread_cond_broadcast(&regs[i]->idle);
+		}
+		pthread_mutex_unlock(&res->sessions_lock);
+	}
+
+	free(regs);
+}
+
 int resource_registration_foreach_session(
 	struct vaccel_resource *res,
 	int (*callback)(struct vaccel_resource *res,
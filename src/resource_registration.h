@@ -5,6 +5,8 @@
 #include "list.h"
 #include "resource.h"
 #include "session.h"
+#include <pthread.h>
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -23,6 +25,13 @@ struct resource_registration {
 
 	/* entry for session's registered resources list */
 	struct vaccel_list_entry session_entry;
+
+	/* number of references held by users of the registration outside the
+	 * resource's sessions lock. Protected by the sessions lock */
+	unsigned int nr_users;
+
+	/* signaled when the last reference is dropped */
+	pthread_cond_t idle;
 };
 
 /* Allocate and initialize resource registration */
@@ -31,7 +40,7 @@ int resource_registration_new(struct resource_registration **reg,
 			      struct vaccel_session *sess);
 
 /* Release resource registration data and free registration created with
- * `resource_registration_new()` */
+ * `resource_registration_new()`. Waits for any references to be dropped */
 int resource_registration_delete(struct resource_registration *reg);
 
 /* Link resource registration to session/resource lists */
@@ -51,6 +60,17 @@ struct resource_registration *
 resource_registration_find_and_unlink(struct vaccel_resource *res,
 				      struct vaccel_session *sess);
 
+/* Take a reference to every registration of a resource, so its sessions
+ * stay registered, and alive, until the references are dropped */
+int resource_registration_hold_all(struct vaccel_resource *res,
+				   struct resource_registration ***regs,
+				   size_t *nr_regs);
+
+/* Drop the references taken with `resource_registration_hold_all()` and free
+ * the registrations array */
+void resource_registration_drop_all(struct resource_registration **regs,
+				    size_t nr_regs);
+
 /* Iterate resource's list of resource registrations and execute callback
  * function */
 int resource_registration_foreach_session(
@@ -0,0 +1,301 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#define _POSIX_C_SOURCE 200809L
+
+#include "scheduler.h"
+#include "config.h"
+#include "core.h"
+#include "error.h"
+#include "log.h"
+#include "plugin.h"
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define NS_PER_SEC 1000000000L
+
+enum {
+	/* maximum number of plugins tracked concurrently */
+	SCHED_PLUGINS_MAX = 64,
+
+	/* EWMA weight of a new sample is 1/2^SCHED_EWMA_SHIFT */
+	SCHED_EWMA_SHIFT = 3,
+
+	/* samples past which the EWMA has converged to a repeated sample */
+	SCHED_EWMA_SAMPLES_MAX = 64
+};
+
+struct sched_op_stats {
+	/* exponentially weighted moving average of the op latency (nsec) */
+	atomic_uint_fast64_t ewma_ns;
+
+	/* calls currently executing */
+	atomic_uint inflight;
+};
+
+struct sched_plugin_stats {
+	/* tracked plugin, NULL if the slot is free */
+	_Atomic(const struct vaccel_plugin *) plugin;
+
+	/* per-op stats; the last entry accumulates all ops */
+	struct sched_op_stats ops[VACCEL_OP_MAX + 1];
+};
+
+static struct {
+	/* per-plugin statistics, looked up without locking */
+	struct sched_plugin_stats plugins[SCHED_PLUGINS_MAX];
+
+	/* names of the plugins each op is pinned to */
+	char *overrides[VACCEL_OP_MAX];
+
+	/* lock for overrides */
+	pthread_mutex_t lock;
+} sched = { .lock = PTHREAD_MUTEX_INITIALIZER };
+
+static uint64_t sched_tstamp_ns(void)
+{
+	struct timespec tp;
+
+	clock_gettime(CLOCK_MONOTONIC, &tp);
+
+	return (uint64_t)tp.tv_sec * NS_PER_SEC + (uint64_t)tp.tv_nsec;
+}
+
+static struct sched_plugin_stats *
+sched_plugin_stats(const struct vaccel_plugin *plugin)
+{
+	if (!plugin)
+		return NULL;
+
+	for (size_t i = 0; i < SCHED_PLUGINS_MAX; i++) {
+		if (atomic_load_explicit(&sched.plugins[i].plugin,
+					 memory_order_acquire) == plugin)
+			return &sched.plugins[i];
+	}
+
+	return NULL;
+}
+
+static void sched_stats_reset(struct sched_plugin_stats *stats)
+{
+	for (size_t op = 0; op <= VACCEL_OP_MAX; op++) {
+		atomic_store(&stats->ops[op].ewma_ns, 0);
+		atomic_store(&stats->ops[op].inflight, 0);
+	}
+}
+
+void sched_reset(void)
+{
+	for (size_t i = 0; i < SCHED_PLUGINS_MAX; i++) {
+		atomic_store(&sched.plugins[i].plugin, NULL);
+		sched_stats_reset(&sched.plugins[i]);
+	}
+
+	pthread_mutex_lock(&sched.lock);
+	for (size_t op = 0; op < VACCEL_OP_MAX; op++) {
+		free(sched.overrides[op]);
+		sched.overrides[op] = NULL;
+	}
+	pthread_mutex_unlock(&sched.lock);
+}
+
+int sched_plugin_add(const struct vaccel_plugin *plugin)
+{
+	if (!plugin)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < SCHED_PLUGINS_MAX; i++) {
+		const struct vaccel_plugin *expected = NULL;
+		struct sched_plugin_stats *stats = &sched.plugins[i];
+
+		if (atomic_compare_exchange_strong(&stats->plugin, &expected,
+						   plugin)) {
+			sched_stats_reset(stats);
+			return VACCEL_OK;
+		}
+	}
+
+	vaccel_warn("[sched] Too many plugins, %s will not be tracked",
+		    plugin->info->name);
+	return VACCEL_ENOSPC;
+}
+
+void sched_plugin_remove(const struct vaccel_plugin *plugin)
+{
+	struct sched_plugin_stats *stats = sched_plugin_stats(plugin);
+	if (stats)
+		atomic_store(&stats->plugin, NULL);
+}
+
+bool sched_adaptive(void)
+{
+	return vaccel_config()->sched_policy == VACCEL_SCHED_ADAPTIVE;
+}
+
+static void sched_ewma_update(struct sched_op_stats *stats, uint64_t sample)
+{
+	/* Concurrent updates may drop a sample, which is fine for an
+	 * estimate */
+	uint64_t ewma = atomic_load_explicit(&stats->ewma_ns,
+					     memory_order_relaxed);
+	if (!ewma)
+		ewma = sample;
+	else if (sample >= ewma)
+		ewma += (sample - ewma) >> SCHED_EWMA_SHIFT;
+	else
+		ewma -= (ewma - sample) >> SCHED_EWMA_SHIFT;
+
+	/* Keep 0 for "no samples yet" */
+	atomic_store_explicit(&stats->ewma_ns, ewma ? ewma : 1,
+			      memory_order_relaxed);
+}
+
+uint64_t sched_ops_start(const struct vaccel_plugin *plugin,
+			 vaccel_op_type_t op_type, unsigned int nr_ops)
+{
+	if (op_type >= VACCEL_OP_MAX || !nr_ops || !sched_adaptive())
+		return 0;
+
+	struct sched_plugin_stats *stats = sched_plugin_stats(plugin);
+	if (!stats)
+		return 0;
+
+	atomic_fetch_add_explicit(&stats->ops[op_type].inflight, nr_ops,
+				  memory_order_relaxed);
+	atomic_fetch_add_explicit(&stats->ops[VACCEL_OP_MAX].inflight, nr_ops,
+				  memory_order_relaxed);
+
+	return sched_tstamp_ns();
+}
+
+void sched_ops_stop(const struct vaccel_plugin *plugin,
+		    vaccel_op_type_t op_type, uint64_t start,
+		    unsigned int nr_ops)
+{
+	if (!start || op_type >= VACCEL_OP_MAX || !nr_ops)
+		return;
+
+	struct sched_plugin_stats *stats = sched_plugin_stats(plugin);
+	if (!stats)
+		return;
+
+	/* Ops completed together count as one sample each, of an equal share
+	 * of the total time */
+	uint64_t sample = (sched_tstamp_ns() - start) / nr_ops;
+	unsigned int nr_samples = nr_ops < SCHED_EWMA_SAMPLES_MAX ?
+					  nr_ops :
+					  SCHED_EWMA_SAMPLES_MAX;
+
+	for (unsigned int i = 0; i < nr_samples; i++) {
+		sched_ewma_update(&stats->ops[op_type], sample);
+		sched_ewma_update(&stats->ops[VACCEL_OP_MAX], sample);
+	}
+
+	atomic_fetch_sub_explicit(&stats->ops[op_type].inflight, nr_ops,
+				  memory_order_relaxed);
+	atomic_fetch_sub_explicit(&stats->ops[VACCEL_OP_MAX].inflight, nr_ops,
+				  memory_order_relaxed);
+}
+
+void sched_ops_cancel(const struct vaccel_plugin *plugin,
+		      vaccel_op_type_t op_type, uint64_t start,
+		      unsigned int nr_ops)
+{
+	if (!start || op_type >= VACCEL_OP_MAX || !nr_ops)
+		return;
+
+	struct sched_plugin_stats *stats = sched_plugin_stats(plugin);
+	if (!stats)
+		return;
+
+	atomic_fetch_sub_explicit(&stats->ops[op_type].inflight, nr_ops,
+				  memory_order_relaxed);
+	atomic_fetch_sub_explicit(&stats->ops[VACCEL_OP_MAX].inflight, nr_ops,
+				  memory_order_relaxed);
+}
+
+uint64_t sched_latency_ns(const struct vaccel_plugin *plugin,
+			  vaccel_op_type_t op_type)
+{
+	if (op_type > VACCEL_OP_MAX)
+		return 0;
+
+	const struct sched_plugin_stats *stats = sched_plugin_stats(plugin);
+	if (!stats)
+		return 0;
+
+	return atomic_load_explicit(&stats->ops[op_type].ewma_ns,
+				    memory_order_relaxed);
+}
+
+unsigned int sched_inflight(const struct vaccel_plugin *plugin,
+			    vaccel_op_type_t op_type)
+{
+	if (op_type > VACCEL_OP_MAX)
+		return 0;
+
+	const struct sched_plugin_stats *stats = sched_plugin_stats(plugin);
+	if (!stats)
+		return 0;
+
+	return atomic_load_explicit(&stats->ops[op_type].inflight,
+				    memory_order_relaxed);
+}
+
+uint64_t sched_expected_ns(const struct vaccel_plugin *plugin,
+			   vaccel_op_type_t op_type)
+{
+	/* Plugins with no samples yet are expected to complete immediately,
+	 * so that every candidate gets measured at least once */
+	return sched_latency_ns(plugin, op_type) *
+	       ((uint64_t)sched_inflight(plugin, op_type) + 1);
+}
+
+bool sched_override_check(vaccel_op_type_t op_type,
+			  const struct vaccel_plugin *plugin, bool *pinned)
+{
+	if (op_type >= VACCEL_OP_MAX)
+		return false;
+
+	pthread_mutex_lock(&sched.lock);
+
+	const char *name = sched.overrides[op_type];
+	if (name && pinned)
+		*pinned = plugin && plugin->info &&
+			  strcmp(plugin->info->name, name) == 0;
+
+	pthread_mutex_unlock(&sched.lock);
+
+	return name != NULL;
+}
+
+int vaccel_sched_override(vaccel_op_type_t op_type, const char *plugin_name)
+{
+	if (op_type >= VACCEL_OP_MAX)
+		return VACCEL_EINVAL;
+
+	char *name = NULL;
+	if (plugin_name) {
+		name = strdup(plugin_name);
+		if (!name)
+			return VACCEL_ENOMEM;
+	}
+
+	pthread_mutex_lock(&sched.lock);
+	free(sched.overrides[op_type]);
+	sched.overrides[op_type] = name;
+	pthread_mutex_unlock(&sched.lock);
+
+	char op_name[VACCEL_ENUM_STR_MAX];
+	vaccel_debug("[sched] Op %s %s%s",
+		     vaccel_op_type_name(op_type, op_name, VACCEL_ENUM_STR_MAX),
+		     name ? "pinned to plugin " : "override removed",
+		     name ? name : "");
+
+	return VACCEL_OK;
+}
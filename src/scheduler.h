@@ -0,0 +1,85 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/scheduler.h" // IWYU pragma: export
+#include "op.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+struct vaccel_plugin;
+
+/* Reset all scheduler statistics and overrides */
+void sched_reset(void);
+
+/* Start/stop tracking statistics for a plugin */
+int sched_plugin_add(const struct vaccel_plugin *plugin);
+void sched_plugin_remove(const struct vaccel_plugin *plugin);
+
+/* True if the adaptive scheduling policy is configured */
+bool sched_adaptive(void);
+
+/* Account for `nr_ops` calls of an op on a plugin that run and complete
+ * together, e.g. a batch. sched_ops_start() returns a timestamp to be passed
+ * to sched_ops_stop(), or 0 if nothing is tracked. sched_ops_cancel() drops
+ * the calls without recording a latency sample, for calls that did not run. */
+uint64_t sched_ops_start(const struct vaccel_plugin *plugin,
+			 vaccel_op_type_t op_type, unsigned int nr_ops);
+void sched_ops_stop(const struct vaccel_plugin *plugin,
+		    vaccel_op_type_t op_type, uint64_t start,
+		    unsigned int nr_ops);
+void sched_ops_cancel(const struct vaccel_plugin *plugin,
+		      vaccel_op_type_t op_type, uint64_t start,
+		      unsigned int nr_ops);
+
+/* Account for an op call on a plugin */
+static inline uint64_t sched_op_start(const struct vaccel_plugin *plugin,
+				      vaccel_op_type_t op_type)
+{
+	return sched_ops_start(plugin, op_type, 1);
+}
+
+static inline void sched_op_stop(const struct vaccel_plugin *plugin,
+				 vaccel_op_type_t op_type, uint64_t start)
+{
+	sched_ops_stop(plugin, op_type, start, 1);
+}
+
+/* Expected completion time (nsec) of a new call of an op on a plugin, based on
+ * the op's average latency and the calls currently in flight. Passing
+ * VACCEL_OP_MAX as the op returns the estimate over all ops of the plugin. */
+uint64_t sched_expected_ns(const struct vaccel_plugin *plugin,
+			   vaccel_op_type_t op_type);
+
+/* Average (EWMA) latency (nsec) and in-flight calls of an op on a plugin */
+uint64_t sched_latency_ns(const struct vaccel_plugin *plugin,
+			  vaccel_op_type_t op_type);
+unsigned int sched_inflight(const struct vaccel_plugin *plugin,
+			    vaccel_op_type_t op_type);
+
+/* Check if an op is pinned to a plugin with an override. If `pinned` is not
+ * NULL, it is set to whether `plugin` is the one the op is pinned to. */
+bool sched_override_check(vaccel_op_type_t op_type,
+			  const struct vaccel_plugin *plugin, bool *pinned);
+
+/* Account for an op call on the plugin that implements the op for a session */
+static inline uint64_t sched_session_op_start(const struct vaccel_session *sess,
+					      vaccel_op_type_t op_type)
+{
+	return sched_op_start(op_session_plugin(sess, op_type), op_type);
+}
+
+static inline void sched_session_op_stop(const struct vaccel_session *sess,
+					 vaccel_op_type_t op_type,
+					 uint64_t start)
+{
+	sched_op_stop(op_session_plugin(sess, op_type), op_type, start);
+}
+
+#ifdef __cplusplus
+}
+#endif
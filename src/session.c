@@ -1,12 +1,15 @@
 // SPDX-License-Identifier: Apache-2.0
 
 #include "session.h"
+#include "config.h"
 #include "core.h"
 #include "error.h"
 #include "id_pool.h"
+#include "id_table.h"
 #include "list.h"
 #include "log.h"
 #include "plugin.h"
+#include "reaper.h"
 #include "resource.h"
 #include "resource_registration.h"
 #include "utils/fs.h"
@@ -21,8 +24,6 @@
 #include <stdlib.h>
 #include <string.h>
 
-enum { VACCEL_SESSIONS_MAX = 1024 };
-
 static struct {
 	/* true if the sessions component has been initialized */
 	bool initialized;
@@ -30,6 +31,9 @@ static struct {
 	/* available session ids */
 	id_pool_t ids;
 
+	/* sessions indexed by id, for lock-free lookups */
+	id_table_t table;
+
 	/* list of all the created sessions */
 	struct vaccel_list_entry all;
 
@@ -42,22 +46,31 @@ static struct {
 
 static void get_session_id(struct vaccel_session *sess)
 {
-	sess->id = id_pool_get(&sessions.ids);
+	sess->id = id_table_id(&sessions.table, id_pool_get(&sessions.ids));
 }
 
 static void put_session_id(struct vaccel_session *sess)
 {
-	if (id_pool_put(&sessions.ids, sess->id))
+	if (id_pool_put(&sessions.ids, id_table_slot(sess->id)))
 		vaccel_warn("Could not return resource ID to pool");
 	sess->id = 0;
 }
 
 int sessions_bootstrap(void)
 {
-	int ret = id_pool_init(&sessions.ids, VACCEL_SESSIONS_MAX);
+	/* Ids and their table grow on demand up to the configured maximum */
+	const vaccel_id_t max = (vaccel_id_t)vaccel_config()->max_sessions;
+
+	int ret = id_pool_init(&sessions.ids, max);
 	if (ret)
 		return ret;
 
+	ret = id_table_init(&sessions.table, max);
+	if (ret) {
+		id_pool_release(&sessions.ids);
+		return ret;
+	}
+
 	list_init(&sessions.all);
 	sessions.count = 0;
 	pthread_mutex_init(&sessions.lock, NULL);
@@ -89,6 +102,7 @@ int sessions_cleanup(void)
 	pthread_mutex_destroy(&sessions.lock);
 	sessions.initialized = false;
 
+	id_table_release(&sessions.table);
 	return id_pool_release(&sessions.ids);
 }
 
@@ -100,26 +114,19 @@ int vaccel_session_get_by_id(struct vaccel_session **sess, vaccel_id_t id)
 	if (!sess)
 		return VACCEL_EINVAL;
 
-	pthread_mutex_lock(&sessions.lock);
-
-	struct vaccel_session *s;
-	session_for_each(s, &sessions.all)
-	{
-		if (id == s->id) {
-			*sess = s;
-			pthread_mutex_unlock(&sessions.lock);
-			return VACCEL_OK;
-		}
-	}
+	struct vaccel_session *s = id_table_get(&sessions.table, id);
+	if (!s)
+		return VACCEL_ENOENT;
 
-	pthread_mutex_unlock(&sessions.lock);
-	return VACCEL_ENOENT;
+	*sess = s;
+	return VACCEL_OK;
 }
 
-static int session_create_rundir(struct vaccel_session *sess)
+/* Generate the rundir path of a session, without creating it */
+static int session_init_rundir(struct vaccel_session *sess)
 {
 	if (!sess || sess->id <= 0) {
-		vaccel_error("Trying to create rundir for invalid session");
+		vaccel_error("Trying to init rundir for invalid session");
 		return VACCEL_EINVAL;
 	}
 
@@ -146,15 +153,27 @@ static int session_create_rundir(struct vaccel_session *sess)
 		return ret;
 	}
 
-	ret = fs_dir_create(sess->rundir);
-	if (ret) {
+	atomic_init(&sess->rundir_created, false);
+
+	return VACCEL_OK;
+}
+
+static int session_create_rundir(struct vaccel_session *sess)
+{
+	if (atomic_load(&sess->rundir_created))
+		return VACCEL_OK;
+
+	/* Concurrent callers may race to create the directory */
+	int ret = fs_dir_create(sess->rundir);
+	if (ret && ret != VACCEL_EEXIST) {
 		vaccel_error("Could not create rundir for session %" PRId64,
 			     sess->id);
 		return ret;
 	}
 
-	vaccel_debug("New rundir for session %" PRId64 ": %s", sess->id,
-		     sess->rundir);
+	if (!atomic_exchange(&sess->rundir_created, true))
+		vaccel_debug("New rundir for session %" PRId64 ": %s",
+			     sess->id, sess->rundir);
 
 	return VACCEL_OK;
 }
@@ -164,7 +183,11 @@ static int session_destroy_rundir(struct vaccel_session *sess)
 	if (!sess)
 		return VACCEL_EINVAL;
 
-	if (fs_dir_remove(sess->rundir))
+	/* Nothing to do if the rundir was never used */
+	if (!atomic_exchange(&sess->rundir_created, false))
+		return VACCEL_OK;
+
+	if (reaper_bury(sess->rundir))
 		vaccel_warn(
 			"Could not cleanup rundir '%s' for session %" PRId64,
 			sess->rundir, sess->id);
@@ -172,6 +195,34 @@ static int session_destroy_rundir(struct vaccel_session *sess)
 	return VACCEL_OK;
 }
 
+const char *vaccel_session_rundir(struct vaccel_session *sess)
+{
+	if (!sess || sess->id <= 0)
+		return NULL;
+
+	if (session_create_rundir(sess))
+		return NULL;
+
+	return sess->rundir;
+}
+
+static int session_route_ops(struct vaccel_session *sess, uint32_t flags)
+{
+	if (!sess->op_plugins) {
+		sess->op_plugins =
+			calloc(VACCEL_OP_MAX, sizeof(*sess->op_plugins));
+		if (!sess->op_plugins)
+			return VACCEL_ENOMEM;
+	}
+
+	size_t nr_routed = plugin_route_ops(
+		flags & (~VACCEL_SESSION_OP_ROUTING), sess->op_plugins);
+	vaccel_debug("session:%" PRId64 " Routed %zu ops across plugins",
+		     sess->id, nr_routed);
+
+	return VACCEL_OK;
+}
+
 int vaccel_session_init(struct vaccel_session *sess, uint32_t flags)
 {
 	int ret;
@@ -186,13 +237,14 @@ int vaccel_session_init(struct vaccel_session *sess, uint32_t flags)
 	if (sess->id < 0)
 		return -(int)sess->id;
 
-	sess->plugin = plugin_find(flags);
+	sess->plugin = plugin_find(flags & (~VACCEL_SESSION_OP_ROUTING));
 	if (!sess->plugin) {
 		ret = VACCEL_ENOTSUP;
 		goto release_id;
 	}
 
 	sess->priv = NULL;
+	sess->op_plugins = NULL;
 
 	if ((flags & VACCEL_PLUGIN_REMOTE) ||
 	    (plugin_count() == 1 && sess->plugin->info->is_virtio)) {
@@ -210,7 +262,8 @@ int vaccel_session_init(struct vaccel_session *sess, uint32_t flags)
 		}
 
 		ret = sess->plugin->info->session_init(
-			sess, flags & (~VACCEL_PLUGIN_REMOTE));
+			sess, flags & ~(VACCEL_PLUGIN_REMOTE |
+				       VACCEL_SESSION_OP_ROUTING));
 		if (ret) {
 			vaccel_error("Failed to initialize remote session");
 			goto release_id;
@@ -221,7 +274,18 @@ int vaccel_session_init(struct vaccel_session *sess, uint32_t flags)
 		sess->is_virtio = false;
 	}
 
-	ret = session_create_rundir(sess);
+	if (flags & VACCEL_SESSION_OP_ROUTING) {
+		if (sess->is_virtio) {
+			vaccel_warn(
+				"Op routing is not supported for remote sessions; ignoring");
+		} else {
+			ret = session_route_ops(sess, flags);
+			if (ret)
+				goto cleanup_session;
+		}
+	}
+
+	ret = session_init_rundir(sess);
 	if (ret)
 		goto cleanup_session;
 
@@ -233,6 +297,12 @@ int vaccel_session_init(struct vaccel_session *sess, uint32_t flags)
 
 	sess->hint = flags;
 
+	ret = id_table_set(&sessions.table, sess->id, sess);
+	if (ret) {
+		vaccel_error("Could not index session %" PRId64, sess->id);
+		goto destroy_lock;
+	}
+
 	pthread_mutex_lock(&sessions.lock);
 	list_add_tail(&sessions.all, &sess->entry);
 	sessions.count++;
@@ -249,11 +319,15 @@ int vaccel_session_init(struct vaccel_session *sess, uint32_t flags)
 
 	return VACCEL_OK;
 
+destroy_lock:
+	pthread_mutex_destroy(&sess->resources_lock);
 cleanup_session:
 	if (sess->is_virtio) {
 		if (sess->plugin->info->session_release(sess))
 			vaccel_error("Could not release remote session");
 	}
+	free(sess->op_plugins);
+	sess->op_plugins = NULL;
 release_id:
 	sess->plugin = NULL;
 	put_session_id(sess);
@@ -261,21 +335,14 @@ release_id:
 	return ret;
 }
 
+/* Must be called with the session's resources lock held */
 static bool session_has_resources(struct vaccel_session *sess)
 {
-	if (!sess)
-		return false;
-
-	pthread_mutex_lock(&sess->resources_lock);
-
 	for (size_t type = 0; type < VACCEL_RESOURCE_MAX; type++) {
-		if (sess->resource_counts[type] > 0) {
-			pthread_mutex_unlock(&sess->resources_lock);
+		if (sess->resource_counts[type] > 0)
 			return true;
-		}
 	}
 
-	pthread_mutex_unlock(&sess->resources_lock);
 	return false;
 }
 
@@ -301,28 +368,53 @@ int vaccel_session_update(struct vaccel_session *sess, uint32_t flags)
 		}
 
 		int ret = sess->plugin->info->session_update(
-			sess, flags & (~VACCEL_PLUGIN_REMOTE));
+			sess, flags & ~(VACCEL_PLUGIN_REMOTE |
+				       VACCEL_SESSION_OP_ROUTING));
 		if (ret)
 			vaccel_error("Failed to update remote session");
 
 		return ret;
 	}
 
+	/* Registered resources are known only to the plugins the session used
+	 * when they were registered, so neither its plugin nor its routing can
+	 * change while any is registered. The resources lock is held throughout,
+	 * so no registration can be linked meanwhile */
+	int ret = VACCEL_OK;
+	pthread_mutex_lock(&sess->resources_lock);
+
 	if (session_has_resources(sess)) {
 		vaccel_error(
 			"Cannot update a session with registered resources");
-		return VACCEL_ENOTSUP;
+		ret = VACCEL_ENOTSUP;
+		goto unlock;
 	}
 
-	sess->plugin = plugin_find(flags);
-	if (!sess->plugin)
-		return VACCEL_ENOTSUP;
+	struct vaccel_plugin *plugin =
+		plugin_find(flags & (~VACCEL_SESSION_OP_ROUTING));
+	if (!plugin) {
+		ret = VACCEL_ENOTSUP;
+		goto unlock;
+	}
+
+	if (flags & VACCEL_SESSION_OP_ROUTING) {
+		ret = session_route_ops(sess, flags);
+		if (ret)
+			goto unlock;
+	} else {
+		free(sess->op_plugins);
+		sess->op_plugins = NULL;
+	}
 
+	sess->plugin = plugin;
 	sess->hint = flags;
 	vaccel_debug("session:%" PRId64 " Selected plugin %s", sess->id,
 		     sess->plugin->info->name);
 
-	return VACCEL_OK;
+unlock:
+	pthread_mutex_unlock(&sess->resources_lock);
+
+	return ret;
 }
 
 int vaccel_session_release(struct vaccel_session *sess)
@@ -372,6 +464,11 @@ int vaccel_session_release(struct vaccel_session *sess)
 
 	sess->priv = NULL;
 	sess->plugin = NULL;
+	free(sess->op_plugins);
+	sess->op_plugins = NULL;
+
+	if (id_table_clear(&sessions.table, sess->id))
+		vaccel_warn("Could not unindex session %" PRId64, sess->id);
 
 	pthread_mutex_lock(&sessions.lock);
 	list_unlink_entry(&sess->entry);
@@ -385,6 +482,72 @@ int vaccel_session_release(struct vaccel_session *sess)
 	return VACCEL_OK;
 }
 
+int session_reset(struct vaccel_session *sess)
+{
+	if (!sess)
+		return VACCEL_EINVAL;
+
+	if (!sessions.initialized)
+		return VACCEL_ESESS;
+
+	if (sess->id <= 0) {
+		vaccel_error("Cannot reset uninitialized session");
+		return VACCEL_EINVAL;
+	}
+
+	/* State kept by a remote host or by the user can't be reset here */
+	if (sess->is_virtio || sess->priv) {
+		vaccel_debug("Cannot reset session %" PRId64
+			     " with remote or private state",
+			     sess->id);
+		return VACCEL_ENOTSUP;
+	}
+
+	int ret = resource_registration_foreach_resource(
+		sess, vaccel_resource_unregister);
+	if (ret) {
+		vaccel_error("Could not unregister session resources");
+		return ret;
+	}
+
+	/* Leave nothing from the previous user behind */
+	ret = session_destroy_rundir(sess);
+	if (ret)
+		return ret;
+
+	/* Re-publish the session under the next generation of its slot, so ids
+	 * held by the previous user no longer resolve to it */
+	const vaccel_id_t old_id = sess->id;
+	ret = id_table_clear(&sessions.table, old_id);
+	if (ret) {
+		vaccel_error("Could not unindex session %" PRId64, old_id);
+		return ret;
+	}
+
+	sess->id = id_table_id(&sessions.table, id_table_slot(old_id));
+	if (sess->id <= 0) {
+		vaccel_error("Could not get new id for session %" PRId64,
+			     old_id);
+		sess->id = old_id;
+		return VACCEL_EINVAL;
+	}
+
+	ret = id_table_set(&sessions.table, sess->id, sess);
+	if (ret) {
+		vaccel_error("Could not index session %" PRId64, sess->id);
+		return ret;
+	}
+
+	ret = session_init_rundir(sess);
+	if (ret)
+		return ret;
+
+	vaccel_debug("Reset session %" PRId64 " (was %" PRId64 ")", sess->id,
+		     old_id);
+
+	return VACCEL_OK;
+}
+
 int vaccel_session_new(struct vaccel_session **sess, uint32_t flags)
 {
 	if (!sess)
@@ -15,6 +15,12 @@ int sessions_bootstrap(void);
 /* Cleanup shared session objects */
 int sessions_cleanup(void);
 
+/* Unregister all resources of a session and clear its rundir, so it can be
+ * reused without releasing it. The session gets a new id, so ids held by the
+ * previous user no longer resolve to it. Remote sessions and sessions with
+ * private data can't be reset and return VACCEL_ENOTSUP. */
+int session_reset(struct vaccel_session *sess);
+
 /* Helper macros for iterating lists of containers */
 #define session_for_each(iter, list) \
 	list_for_each_container((iter), (list), struct vaccel_session, entry)
@@ -0,0 +1,143 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "session_pool.h"
+#include "error.h"
+#include "log.h"
+#include "session.h"
+#include <inttypes.h>
+#include <pthread.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdlib.h>
+
+int vaccel_session_pool_init(struct vaccel_session_pool *pool, uint32_t flags,
+			     size_t capacity)
+{
+	if (!pool || !capacity)
+		return VACCEL_EINVAL;
+
+	pool->idle = malloc(capacity * sizeof(*pool->idle));
+	if (!pool->idle)
+		return VACCEL_ENOMEM;
+
+	pool->flags = flags;
+	pool->nr_idle = 0;
+	pool->capacity = capacity;
+	pthread_mutex_init(&pool->lock, NULL);
+
+	/* Pay for session setup up front */
+	for (size_t i = 0; i < capacity; i++) {
+		int ret = vaccel_session_new(&pool->idle[i], flags);
+		if (ret) {
+			vaccel_error("Could not create pool session");
+			vaccel_session_pool_release(pool);
+			return ret;
+		}
+		pool->nr_idle++;
+	}
+
+	return VACCEL_OK;
+}
+
+int vaccel_session_pool_release(struct vaccel_session_pool *pool)
+{
+	if (!pool)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < pool->nr_idle; i++) {
+		if (vaccel_session_delete(pool->idle[i]))
+			vaccel_warn("Could not delete pool session");
+	}
+
+	free(pool->idle);
+	pool->idle = NULL;
+	pool->nr_idle = 0;
+	pool->capacity = 0;
+	pthread_mutex_destroy(&pool->lock);
+
+	return VACCEL_OK;
+}
+
+int vaccel_session_pool_new(struct vaccel_session_pool **pool, uint32_t flags,
+			    size_t capacity)
+{
+	if (!pool)
+		return VACCEL_EINVAL;
+
+	struct vaccel_session_pool *p = (struct vaccel_session_pool *)malloc(
+		sizeof(struct vaccel_session_pool));
+	if (!p)
+		return VACCEL_ENOMEM;
+
+	int ret = vaccel_session_pool_init(p, flags, capacity);
+	if (ret) {
+		free(p);
+		return ret;
+	}
+
+	*pool = p;
+
+	return VACCEL_OK;
+}
+
+int vaccel_session_pool_delete(struct vaccel_session_pool *pool)
+{
+	int ret = vaccel_session_pool_release(pool);
+	if (ret)
+		return ret;
+
+	free(pool);
+
+	return VACCEL_OK;
+}
+
+int vaccel_session_pool_get(struct vaccel_session_pool *pool,
+			    struct vaccel_session **sess)
+{
+	if (!pool || !sess)
+		return VACCEL_EINVAL;
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->nr_idle) {
+		*sess = pool->idle[--pool->nr_idle];
+		pthread_mutex_unlock(&pool->lock);
+		return VACCEL_OK;
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	/* Pool is drained; fall back to a new session, which is kept on put
+	 * if there is room */
+	return vaccel_session_new(sess, pool->flags);
+}
+
+int vaccel_session_pool_put(struct vaccel_session_pool *pool,
+			    struct vaccel_session *sess)
+{
+	if (!pool || !sess)
+		return VACCEL_EINVAL;
+
+	/* Sessions updated with other flags can't serve pool users */
+	if (sess->hint != pool->flags)
+		return vaccel_session_delete(sess);
+
+	/* Sessions that can't be reset (e.g. remote ones or ones with private
+	 * data) are not pooled */
+	int ret = session_reset(sess);
+	if (ret) {
+		if (ret != VACCEL_ENOTSUP)
+			vaccel_warn("Could not reset session %" PRId64
+				    "; deleting it",
+				    sess->id);
+		return vaccel_session_delete(sess);
+	}
+
+	pthread_mutex_lock(&pool->lock);
+	if (pool->nr_idle < pool->capacity) {
+		pool->idle[pool->nr_idle++] = sess;
+		pthread_mutex_unlock(&pool->lock);
+		return VACCEL_OK;
+	}
+	pthread_mutex_unlock(&pool->lock);
+
+	return vaccel_session_delete(sess);
+}
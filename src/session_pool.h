@@ -0,0 +1,5 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include "include/vaccel/session_pool.h" // IWYU pragma: export
@@ -2,6 +2,7 @@
 
 #define _POSIX_C_SOURCE 200809L
 #define _DEFAULT_SOURCE
+#define _GNU_SOURCE
 
 #include "error.h"
 #include "fs.h"
@@ -11,6 +12,7 @@
 #include <errno.h>
 #include <fcntl.h>
 #include <libgen.h>
+#include <linux/fs.h>
 #include <limits.h>
 #include <linux/limits.h>
 #include <stdarg.h>
@@ -18,10 +20,26 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <sys/ioctl.h>
 #include <sys/mman.h>
+#include <sys/sendfile.h>
 #include <sys/stat.h>
 #include <unistd.h>
 
+#ifdef USE_LIBURING
+#include <liburing.h>
+#include <stdint.h>
+
+/* Number of files opened, stat'ed and closed per io_uring submission */
+#define FILES_URING_BATCH 32
+#endif
+
+/* Bytes to copy per call when files are copied in the kernel */
+#define FILE_COPY_CHUNK ((size_t)1 << 30)
+
+/* Size of the buffer files are otherwise copied through */
+#define FILE_COPY_BUF_SIZE ((size_t)1 << 20)
+
 bool fs_path_exists(const char *path)
 {
 	if (!path)
@@ -134,6 +152,60 @@ int fs_dir_process_files(const char *path, fs_path_callback_t func, ...)
 	return ret;
 }
 
+struct file_list {
+	char **files;
+	size_t nr_files;
+	size_t capacity;
+};
+
+static int list_files_callback(const char *path, int idx, va_list args)
+{
+	(void)idx;
+
+	struct file_list *list = va_arg(args, struct file_list *);
+
+	if (list->nr_files == list->capacity) {
+		size_t capacity = list->capacity ? list->capacity * 2 : 64;
+		char **files = (char **)realloc(list->files,
+						capacity * sizeof(char *));
+		if (!files)
+			return VACCEL_ENOMEM;
+
+		list->files = files;
+		list->capacity = capacity;
+	}
+
+	char *file = strdup(path);
+	if (!file)
+		return VACCEL_ENOMEM;
+
+	list->files[list->nr_files++] = file;
+
+	return VACCEL_OK;
+}
+
+int fs_dir_list_files(const char *path, char ***files, size_t *nr_files)
+{
+	if (!path || !files || !nr_files)
+		return VACCEL_EINVAL;
+
+	struct file_list list = { .files = NULL, .nr_files = 0, .capacity = 0 };
+
+	/* A single walk, instead of counting the files first */
+	int ret = fs_dir_process_files(path, list_files_callback, &list);
+	if (ret < 0) {
+		for (size_t i = 0; i < list.nr_files; i++)
+			free(list.files[i]);
+		free(list.files);
+		return -ret;
+	}
+
+	*files = list.files;
+	*nr_files = list.nr_files;
+
+	return VACCEL_OK;
+}
+
 int fs_dir_create(const char *path)
 {
 	if (!path)
@@ -310,6 +382,52 @@ int fs_dir_remove(const char *path)
 	return VACCEL_OK;
 }
 
+int fs_dir_remove_all(const char *path)
+{
+	if (!path)
+		return VACCEL_EINVAL;
+
+	DIR *dir = opendir(path);
+	if (!dir)
+		return errno;
+
+	int ret = VACCEL_OK;
+	struct dirent *d;
+	while ((d = readdir(dir)) != NULL) {
+		/* Skip '.' and '..' */
+		if (strcmp(d->d_name, ".") == 0 || strcmp(d->d_name, "..") == 0)
+			continue;
+
+		char entity_path[PATH_MAX];
+		int len = snprintf(entity_path, PATH_MAX, "%s/%s", path,
+				   d->d_name);
+		if (len < 0 || len >= PATH_MAX) {
+			vaccel_error("Entity path for %s too long", d->d_name);
+			ret = VACCEL_ENAMETOOLONG;
+			break;
+		}
+
+		struct stat st;
+		if (lstat(entity_path, &st) < 0) {
+			ret = errno;
+			break;
+		}
+
+		if (S_ISDIR(st.st_mode))
+			ret = fs_dir_remove_all(entity_path);
+		else if (unlink(entity_path))
+			ret = errno;
+		if (ret)
+			break;
+	}
+
+	closedir(dir);
+	if (ret)
+		return ret;
+
+	return fs_dir_remove(path);
+}
+
 int fs_file_create(const char *path, int *fd)
 {
 	if (!path)
@@ -441,6 +559,207 @@ int fs_file_remove(const char *path)
 	return VACCEL_OK;
 }
 
+int fs_file_write(int fd, const void *buf, size_t size)
+{
+	if (fd < 0 || (!buf && size))
+		return VACCEL_EINVAL;
+
+	size_t ptr = 0;
+	while (ptr < size) {
+		ssize_t wret = write(fd, (const char *)buf + ptr, size - ptr);
+		if (wret < 0) {
+			if (errno == EINTR)
+				continue;
+			return errno;
+		}
+		ptr += wret;
+	}
+
+	return VACCEL_OK;
+}
+
+/* Check if a kernel-side copy failed because the files don't support it, so
+ * the copy can continue another way */
+static bool file_copy_unsupported(int err)
+{
+	return err == EXDEV || err == EINVAL || err == ENOSYS ||
+	       err == EOPNOTSUPP || err == EBADF;
+}
+
+/* Copy the rest of in_fd to out_fd, from and to their file offsets. The data
+ * is copied in the kernel where possible, else through large reads and
+ * writes */
+static int file_copy_fd(int in_fd, int out_fd)
+{
+	ssize_t cret;
+
+	/* Filesystems may share extents or copy server-side */
+	do {
+		cret = copy_file_range(in_fd, NULL, out_fd, NULL,
+				       FILE_COPY_CHUNK, 0);
+	} while (cret > 0 || (cret < 0 && errno == EINTR));
+	if (!cret)
+		return VACCEL_OK;
+	if (!file_copy_unsupported(errno))
+		return errno;
+
+	/* Older kernels can't copy_file_range() across filesystems */
+	do {
+		cret = sendfile(out_fd, in_fd, NULL, FILE_COPY_CHUNK);
+	} while (cret > 0 || (cret < 0 && errno == EINTR));
+	if (!cret)
+		return VACCEL_OK;
+	if (!file_copy_unsupported(errno))
+		return errno;
+
+	char *buf = (char *)malloc(FILE_COPY_BUF_SIZE);
+	if (!buf)
+		return VACCEL_ENOMEM;
+
+	int ret = VACCEL_OK;
+	while (true) {
+		ssize_t rret = read(in_fd, buf, FILE_COPY_BUF_SIZE);
+		if (rret < 0) {
+			if (errno == EINTR)
+				continue;
+			ret = errno;
+			break;
+		}
+		if (!rret)
+			break;
+
+		ret = fs_file_write(out_fd, buf, rret);
+		if (ret)
+			break;
+	}
+
+	free(buf);
+
+	return ret;
+}
+
+int fs_file_copy(const char *src, const char *dst)
+{
+	if (!src || !dst)
+		return VACCEL_EINVAL;
+
+	int in_fd = open(src, O_RDONLY);
+	if (in_fd < 0) {
+		vaccel_error("Could not open file %s: %s", src,
+			     strerror(errno));
+		return errno;
+	}
+
+	int ret;
+	int out_fd;
+	ret = fs_file_create(dst, &out_fd);
+	if (ret)
+		goto close_in;
+
+	if (ioctl(out_fd, FICLONE, in_fd)) {
+		ret = file_copy_fd(in_fd, out_fd);
+		if (ret)
+			vaccel_error("Could not copy %s to %s: %s", src, dst,
+				     strerror(ret));
+	}
+
+	close(out_fd);
+	if (ret)
+		remove(dst);
+close_in:
+	close(in_fd);
+
+	return ret;
+}
+
+int fs_file_clone(const char *src, const char *dst)
+{
+	if (!src || !dst)
+		return VACCEL_EINVAL;
+
+	if (!link(src, dst))
+		return VACCEL_OK;
+	if (errno == EEXIST)
+		return VACCEL_EEXIST;
+
+	/* Hardlinks don't cross filesystems */
+	return fs_file_copy(src, dst);
+}
+
+int fs_memfd_create(const char *name, const void *data, size_t size, int *fd)
+{
+	if (!name || !data || !size || !fd)
+		return VACCEL_EINVAL;
+
+	int mfd = memfd_create(name, MFD_CLOEXEC | MFD_ALLOW_SEALING);
+	if (mfd < 0) {
+		vaccel_error("Could not create memory file %s: %s", name,
+			     strerror(errno));
+		return errno;
+	}
+
+	int ret = fs_file_write(mfd, data, size);
+	if (ret) {
+		vaccel_error("Could not write memory file %s: %s", name,
+			     strerror(ret));
+		goto close_file;
+	}
+
+	/* Freeze the content, so readers can map it without copies */
+	if (fcntl(mfd, F_ADD_SEALS,
+		  F_SEAL_SHRINK | F_SEAL_GROW | F_SEAL_WRITE | F_SEAL_SEAL)) {
+		vaccel_error("Could not seal memory file %s: %s", name,
+			     strerror(errno));
+		ret = errno;
+		goto close_file;
+	}
+
+	*fd = mfd;
+
+	return VACCEL_OK;
+
+close_file:
+	close(mfd);
+
+	return ret;
+}
+
+int fs_file_readahead(const char *path)
+{
+	if (!path)
+		return VACCEL_EINVAL;
+
+	int fd = open(path, O_RDONLY);
+	if (fd == -1) {
+		vaccel_error("Could not open file %s: %s", path,
+			     strerror(errno));
+		return errno;
+	}
+
+	struct stat stat;
+	int ret = fstat(fd, &stat);
+	if (ret < 0) {
+		vaccel_error("Could not fstat file %s: %s", path,
+			     strerror(errno));
+		ret = errno;
+		goto close_file;
+	}
+
+	/* readahead() returns once the data have been read in; if the
+	 * filesystem doesn't support it, only ask for them */
+	if (readahead(fd, 0, stat.st_size)) {
+		ret = posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+		if (ret)
+			vaccel_error("Could not read ahead file %s: %s", path,
+				     strerror(ret));
+	}
+
+close_file:
+	close(fd);
+
+	return ret;
+}
+
 int fs_file_read(const char *path, void **data, size_t *size)
 {
 	if (!path || !data)
@@ -503,7 +822,60 @@ close_file:
 	return VACCEL_OK;
 }
 
-int fs_file_read_mmap(const char *path, void **data, size_t *size)
+/* Apply access advice to a mapped file. Advice is only a hint, so failures
+ * are not fatal */
+static void file_mmap_advise(const char *path, void *ptr, size_t size,
+			     unsigned int flags)
+{
+	if ((flags & FS_MMAP_WILLNEED) && madvise(ptr, size, MADV_WILLNEED))
+		vaccel_debug("Could not advise WILLNEED for %s: %s", path,
+			     strerror(errno));
+
+	if ((flags & FS_MMAP_SEQUENTIAL) &&
+	    madvise(ptr, size, MADV_SEQUENTIAL))
+		vaccel_debug("Could not advise SEQUENTIAL for %s: %s", path,
+			     strerror(errno));
+
+	if ((flags & FS_MMAP_HUGEPAGE) && madvise(ptr, size, MADV_HUGEPAGE))
+		vaccel_debug("Could not advise HUGEPAGE for %s: %s", path,
+			     strerror(errno));
+}
+
+/* Map an open file of a known, non-zero size in memory */
+static int file_mmap_fd(const char *path, int fd, size_t size,
+			unsigned int flags, void **data)
+{
+	/* Start readahead before the pages are faulted in */
+	if (flags & FS_MMAP_SEQUENTIAL)
+		posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+	if (flags & FS_MMAP_WILLNEED)
+		posix_fadvise(fd, 0, 0, POSIX_FADV_WILLNEED);
+
+	int prot = PROT_READ;
+	int map_flags = MAP_SHARED;
+	if (!(flags & FS_MMAP_SHARED)) {
+		prot |= PROT_WRITE;
+		map_flags = MAP_PRIVATE;
+	}
+	if (flags & FS_MMAP_POPULATE)
+		map_flags |= MAP_POPULATE;
+
+	void *ptr = mmap(NULL, size, prot, map_flags, fd, 0);
+	if (ptr == MAP_FAILED) {
+		vaccel_error("Could not mmap file %s: %s", path,
+			     strerror(errno));
+		return VACCEL_ENOMEM;
+	}
+
+	file_mmap_advise(path, ptr, size, flags);
+
+	*data = ptr;
+
+	return VACCEL_OK;
+}
+
+int fs_file_mmap(const char *path, unsigned int flags, void **data,
+		 size_t *size)
 {
 	if (!path || !data)
 		return VACCEL_EINVAL;
@@ -530,17 +902,8 @@ int fs_file_read_mmap(const char *path, void **data, size_t *size)
 		goto close_file;
 	}
 
-	void *ptr = mmap(NULL, stat.st_size, PROT_READ | PROT_WRITE,
-			 MAP_PRIVATE, fd, 0);
-	if (!ptr) {
-		vaccel_error("Could not mmap file %s: %s", path,
-			     strerror(errno));
-		ret = VACCEL_ENOMEM;
-		goto close_file;
-	}
-
-	*data = ptr;
-	if (size)
+	ret = file_mmap_fd(path, fd, stat.st_size, flags, data);
+	if (!ret && size)
 		*size = stat.st_size;
 
 close_file:
@@ -550,3 +913,195 @@ close_file:
 		return ret;
 	return VACCEL_OK;
 }
+
+int fs_file_read_mmap(const char *path, void **data, size_t *size)
+{
+	return fs_file_mmap(path, 0, data, size);
+}
+
+/* Map files in memory one at a time */
+static int files_mmap(const char **paths, size_t nr_files,
+		      const unsigned int *flags, void **data, size_t *sizes)
+{
+	size_t i;
+	int ret = VACCEL_OK;
+	for (i = 0; i < nr_files; i++) {
+		ret = fs_file_mmap(paths[i], flags[i], &data[i], &sizes[i]);
+		if (ret)
+			break;
+	}
+
+	if (ret) {
+		while (i--)
+			munmap(data[i], sizes[i]);
+	}
+
+	return ret;
+}
+
+#ifdef USE_LIBURING
+/* Submit `nr` queued requests and wait for their completions, storing their
+ * results at the index of their user data. Everything that was submitted is
+ * reaped even on errors, so no opened file goes unseen. On errors the ring
+ * may still hold requests that were not submitted, so it can't be reused. */
+static int files_uring_complete(struct io_uring *ring, unsigned int nr,
+				int *res)
+{
+	int ret = VACCEL_OK;
+	unsigned int nr_submitted = 0;
+	while (nr_submitted < nr) {
+		int n = io_uring_submit(ring);
+		if (n == -EINTR)
+			continue;
+		if (n <= 0) {
+			ret = n ? -n : VACCEL_EIO;
+			break;
+		}
+		nr_submitted += (unsigned int)n;
+	}
+
+	for (unsigned int i = 0; i < nr_submitted; i++) {
+		struct io_uring_cqe *cqe = NULL;
+		int err;
+		do {
+			err = io_uring_wait_cqe(ring, &cqe);
+		} while (err == -EINTR);
+		if (err < 0)
+			return ret ? ret : -err;
+
+		res[io_uring_cqe_get_data64(cqe)] = cqe->res;
+		io_uring_cqe_seen(ring, cqe);
+	}
+
+	return ret;
+}
+
+/* Map up to FILES_URING_BATCH files in memory. The files are opened and
+ * stat'ed with one submission and closed with another, so only the mappings
+ * take a syscall per file. */
+static int files_mmap_uring(struct io_uring *ring, const char **paths,
+			    size_t nr_files, const unsigned int *flags,
+			    void **data, size_t *sizes)
+{
+	struct statx stx[FILES_URING_BATCH];
+	/* open results at even indices, statx results at odd ones */
+	int res[2 * FILES_URING_BATCH];
+
+	for (size_t i = 0; i < nr_files; i++) {
+		res[2 * i] = -ECANCELED;
+		res[2 * i + 1] = -ECANCELED;
+
+		struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+		io_uring_prep_openat(sqe, AT_FDCWD, paths[i], O_RDONLY, 0);
+		io_uring_sqe_set_data64(sqe, 2 * i);
+
+		sqe = io_uring_get_sqe(ring);
+		io_uring_prep_statx(sqe, AT_FDCWD, paths[i], 0, STATX_SIZE,
+				    &stx[i]);
+		io_uring_sqe_set_data64(sqe, 2 * i + 1);
+	}
+
+	int ret = files_uring_complete(ring, 2 * nr_files, res);
+	const bool ring_ok = !ret;
+
+	size_t nr_mapped = 0;
+	for (size_t i = 0; !ret && i < nr_files; i++) {
+		if (res[2 * i] < 0) {
+			ret = -res[2 * i];
+			vaccel_error("Could not open file %s: %s", paths[i],
+				     strerror(ret));
+			break;
+		}
+		if (res[2 * i + 1] < 0) {
+			ret = -res[2 * i + 1];
+			vaccel_error("Could not stat file %s: %s", paths[i],
+				     strerror(ret));
+			break;
+		}
+		if (!stx[i].stx_size) {
+			vaccel_error("File %s is empty", paths[i]);
+			ret = VACCEL_EINVAL;
+			break;
+		}
+
+		ret = file_mmap_fd(paths[i], res[2 * i], stx[i].stx_size,
+				   flags[i], &data[i]);
+		if (ret)
+			break;
+		sizes[i] = stx[i].stx_size;
+		nr_mapped++;
+	}
+
+	/* The mappings keep the files open. If the ring failed, files are
+	 * closed directly, as it may still hold unsubmitted requests. */
+	unsigned int nr_close = 0;
+	for (size_t i = 0; i < nr_files; i++) {
+		if (res[2 * i] < 0)
+			continue;
+
+		if (!ring_ok) {
+			close(res[2 * i]);
+			continue;
+		}
+
+		struct io_uring_sqe *sqe = io_uring_get_sqe(ring);
+		io_uring_prep_close(sqe, res[2 * i]);
+		io_uring_sqe_set_data64(sqe, 2 * i);
+		nr_close++;
+	}
+	if (nr_close && files_uring_complete(ring, nr_close, res))
+		vaccel_warn("Could not close mapped files");
+
+	if (ret) {
+		while (nr_mapped--)
+			munmap(data[nr_mapped], sizes[nr_mapped]);
+	}
+
+	return ret;
+}
+#endif /* USE_LIBURING */
+
+int fs_files_mmap(const char **paths, size_t nr_files,
+		  const unsigned int *flags, void **data, size_t *sizes)
+{
+	if (!paths || !nr_files || !flags || !data || !sizes)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < nr_files; i++) {
+		if (!paths[i])
+			return VACCEL_EINVAL;
+	}
+
+#ifdef USE_LIBURING
+	struct io_uring ring;
+	if (nr_files > 1 &&
+	    !io_uring_queue_init(2 * FILES_URING_BATCH, &ring, 0)) {
+		size_t i;
+		int ret = VACCEL_OK;
+		for (i = 0; i < nr_files; i += FILES_URING_BATCH) {
+			size_t nr = nr_files - i;
+			if (nr > FILES_URING_BATCH)
+				nr = FILES_URING_BATCH;
+
+			ret = files_mmap_uring(&ring, &paths[i], nr, &flags[i],
+					       &data[i], &sizes[i]);
+			if (ret)
+				break;
+		}
+
+		io_uring_queue_exit(&ring);
+
+		/* Failed batches unmap their own files */
+		if (ret) {
+			while (i--)
+				munmap(data[i], sizes[i]);
+		}
+
+		return ret;
+	}
+
+	/* io_uring may be unavailable at runtime, e.g. disabled by the
+	 * kernel, so fall back to plain syscalls */
+#endif
+	return files_mmap(paths, nr_files, flags, data, sizes);
+}
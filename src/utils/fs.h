@@ -10,6 +10,19 @@
 extern "C" {
 #endif
 
+/* fs_file_mmap() flags */
+/* Map read-only and shared with other mappings of the file, instead of
+ * privately with copy-on-write */
+#define FS_MMAP_SHARED 0x1
+/* Prefault the mapping */
+#define FS_MMAP_POPULATE 0x2
+/* Advise that the data will be accessed soon */
+#define FS_MMAP_WILLNEED 0x4
+/* Advise that the data will be accessed sequentially */
+#define FS_MMAP_SEQUENTIAL 0x8
+/* Advise that the mapping should be backed by huge pages */
+#define FS_MMAP_HUGEPAGE 0x10
+
 typedef int (*fs_path_callback_t)(const char *path, int idx, va_list args);
 
 /* Check if path exists */
@@ -24,6 +37,11 @@ bool fs_path_is_file(const char *path);
 /* Process files in directory path recursively with func */
 int fs_dir_process_files(const char *path, fs_path_callback_t func, ...);
 
+/* List files in directory path recursively, in the order they are processed
+ * by fs_dir_process_files(). The list and its paths are allocated and must
+ * be freed by the caller */
+int fs_dir_list_files(const char *path, char ***files, size_t *nr_files);
+
 /* Create a directory in the fs recursively (if it does't exist) */
 int fs_dir_create(const char *path);
 
@@ -41,6 +59,10 @@ int fs_dir_create_unique(char *path, size_t size, char **final_path);
 /* Remove a directory if empty */
 int fs_dir_remove(const char *path);
 
+/* Remove a directory and all of its contents. Symbolic links are removed, not
+ * followed. */
+int fs_dir_remove_all(const char *path);
+
 /* Create a file in the fs
  * IMPORTANT: The parent directories of path must exist in the fs */
 int fs_file_create(const char *path, int *fd);
@@ -59,6 +81,27 @@ int fs_file_create_unique(char *path, size_t size, char **final_path, int *fd);
 /* Remove a path */
 int fs_file_remove(const char *path);
 
+/* Write all of buf to an open file, without buffering */
+int fs_file_write(int fd, const void *buf, size_t size);
+
+/* Create dst with a copy of src. The file is reflinked if the filesystem
+ * supports it, else copied in the kernel where possible */
+int fs_file_copy(const char *src, const char *dst);
+
+/* Create dst with the contents of src, sharing storage with it where possible:
+ * the file is hardlinked, else copied as with fs_file_copy().
+ * IMPORTANT: As the files may share storage, neither should be modified in
+ * place afterwards */
+int fs_file_clone(const char *src, const char *dst);
+
+/* Create an anonymous in-memory file with a copy of data and seal it, so it
+ * can't be modified anymore. The file can be opened through
+ * `/proc/self/fd/<fd>` for as long as fd is open */
+int fs_memfd_create(const char *name, const void *data, size_t size, int *fd);
+
+/* Read a whole file into the page cache */
+int fs_file_readahead(const char *path);
+
 /* Read a file into a buffer */
 int fs_file_read(const char *path, void **data, size_t *size);
 
@@ -67,6 +110,19 @@ int fs_file_read(const char *path, void **data, size_t *size);
  * and return the mapped memory and the size of the file */
 int fs_file_read_mmap(const char *path, void **data, size_t *size);
 
+/* Map a file in memory, as selected by FS_MMAP_* flags, and return the mapped
+ * memory and the size of the file. With no flags this is the same as
+ * fs_file_read_mmap() */
+int fs_file_mmap(const char *path, unsigned int flags, void **data,
+		 size_t *size);
+
+/* Map many files in memory, each as selected by its FS_MMAP_* flags, and
+ * return the mapped memory and the sizes of the files. If built with
+ * io_uring, the files are opened, stat'ed and closed in batches instead of
+ * one syscall at a time. On failure none of the files stays mapped */
+int fs_files_mmap(const char **paths, size_t nr_files,
+		  const unsigned int *flags, void **data, size_t *sizes);
+
 #ifdef __cplusplus
 }
 #endif
@@ -5,6 +5,7 @@
 #include "error.h"
 #include "fs.h"
 #include "log.h"
+#include "net.h"
 #include <limits.h>
 #include <linux/limits.h>
 #include <stdio.h>
@@ -14,10 +15,15 @@
 
 #include <curl/curl.h>
 #include <curl/easy.h>
+#include <curl/multi.h>
 #include <curl/system.h>
 #include <curl/urlapi.h>
 #include <errno.h>
 #include <stdbool.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <strings.h>
+#include <time.h>
 
 bool net_curl_path_is_url(const char *path)
 {
@@ -213,6 +219,427 @@ int net_curl_file_download(const char *path, const char *download_path)
 	return (ret == CURLE_OK) ? VACCEL_OK : VACCEL_EREMOTEIO;
 }
 
+/* Connections kept open to a single host. Transfers over HTTP/2 are
+ * multiplexed on them, while HTTP/1.1 ones reuse them with keep-alive */
+#define MAX_HOST_CONNECTIONS 6
+
+/* Initial size of download buffers when the length of a file is unknown */
+#define DOWNLOAD_BUF_SIZE (64 * KB)
+
+struct transfer {
+	CURL *curl;
+	FILE *fp;
+	const char *path;
+	const char *download_path;
+
+	/* download buffer; used instead of a file if download_path is NULL */
+	uint8_t *data;
+	size_t size;
+	size_t capacity;
+
+	struct net_file_validators *validators;
+	struct curl_slist *headers;
+	curl_off_t dlnow;
+	curl_off_t dltotal;
+};
+
+/* Copy the value of a header line to dst if it is the named header */
+static void header_value_copy(const char *line, size_t len, const char *name,
+			      char *dst, size_t dst_size)
+{
+	size_t name_len = strlen(name);
+	if (len <= name_len || strncasecmp(line, name, name_len) != 0 ||
+	    line[name_len] != ':')
+		return;
+
+	const char *value = line + name_len + 1;
+	const char *end = line + len;
+	while (value < end && (*value == ' ' || *value == '\t'))
+		value++;
+	while (end > value && (end[-1] == '\r' || end[-1] == '\n' ||
+			       end[-1] == ' ' || end[-1] == '\t'))
+		end--;
+
+	/* Validators that don't fit can't be sent back; drop them */
+	size_t value_len = (size_t)(end - value);
+	if (value_len + 1 > dst_size) {
+		dst[0] = '\0';
+		return;
+	}
+
+	memcpy(dst, value, value_len);
+	dst[value_len] = '\0';
+}
+
+static size_t transfer_header_callback(char *buf, size_t size, size_t nitems,
+				       void *p)
+{
+	struct transfer *t = (struct transfer *)p;
+	struct net_file_validators *v = t->validators;
+	size_t len = size * nitems;
+
+	/* A new status line starts the headers of a redirected response */
+	if (len > 5 && strncmp(buf, "HTTP/", 5) == 0) {
+		v->etag[0] = '\0';
+		v->last_modified[0] = '\0';
+		return len;
+	}
+
+	header_value_copy(buf, len, "ETag", v->etag, sizeof(v->etag));
+	header_value_copy(buf, len, "Last-Modified", v->last_modified,
+			  sizeof(v->last_modified));
+
+	return len;
+}
+
+static int transfer_validators_set(struct transfer *t)
+{
+	struct net_file_validators *v = t->validators;
+	char header[NET_VALIDATOR_MAX + 32];
+
+	if (v->etag[0]) {
+		snprintf(header, sizeof(header), "If-None-Match: %s", v->etag);
+		struct curl_slist *h = curl_slist_append(t->headers, header);
+		if (!h)
+			return VACCEL_ENOMEM;
+		t->headers = h;
+	}
+
+	if (v->last_modified[0]) {
+		snprintf(header, sizeof(header), "If-Modified-Since: %s",
+			 v->last_modified);
+		struct curl_slist *h = curl_slist_append(t->headers, header);
+		if (!h)
+			return VACCEL_ENOMEM;
+		t->headers = h;
+	}
+
+	if (t->headers)
+		curl_easy_setopt(t->curl, CURLOPT_HTTPHEADER, t->headers);
+
+	curl_easy_setopt(t->curl, CURLOPT_HEADERFUNCTION,
+			 transfer_header_callback);
+	curl_easy_setopt(t->curl, CURLOPT_HEADERDATA, t);
+
+	return VACCEL_OK;
+}
+
+static void transfer_release(struct transfer *t)
+{
+	curl_easy_cleanup(t->curl);
+	curl_slist_free_all(t->headers);
+	if (t->fp)
+		fclose(t->fp);
+	t->curl = NULL;
+	t->headers = NULL;
+	t->fp = NULL;
+}
+
+static size_t transfer_write_buf_callback(char *ptr, size_t size,
+					  size_t nmemb, void *p)
+{
+	struct transfer *t = (struct transfer *)p;
+	size_t len = size * nmemb;
+	size_t needed = t->size + len;
+
+	if (needed > t->capacity) {
+		/* Size the buffer for the whole file if its length is known,
+		 * else grow it geometrically */
+		curl_off_t length = -1;
+		curl_easy_getinfo(t->curl, CURLINFO_CONTENT_LENGTH_DOWNLOAD_T,
+				  &length);
+
+		size_t capacity = t->capacity ? 2 * t->capacity :
+						DOWNLOAD_BUF_SIZE;
+		if (length > 0 && (size_t)length >= needed)
+			capacity = (size_t)length;
+		if (capacity < needed)
+			capacity = needed;
+
+		uint8_t *data = (uint8_t *)realloc(t->data, capacity);
+		if (!data) {
+			vaccel_error("Could not allocate download buffer for %s",
+				     t->path);
+			/* Abort the transfer */
+			return 0;
+		}
+
+		t->data = data;
+		t->capacity = capacity;
+	}
+
+	memcpy(&t->data[t->size], ptr, len);
+	t->size += len;
+
+	return len;
+}
+
+static int transfer_progress_callback(void *p, curl_off_t dltotal,
+				      curl_off_t dlnow, curl_off_t ultotal,
+				      curl_off_t ulnow)
+{
+	(void)ultotal;
+	(void)ulnow;
+
+	struct transfer *t = (struct transfer *)p;
+	t->dlnow = dlnow;
+	t->dltotal = dltotal;
+
+	return 0;
+}
+
+static double elapsed_sec(const struct timespec *start)
+{
+	struct timespec now;
+	clock_gettime(CLOCK_MONOTONIC, &now);
+
+	return (double)(now.tv_sec - start->tv_sec) +
+	       (double)(now.tv_nsec - start->tv_nsec) / 1e9;
+}
+
+/* Print the progress of all transfers together */
+static void multi_progress_print(const struct transfer *transfers,
+				 size_t nr_transfers, size_t nr_done,
+				 double runtime)
+{
+	curl_off_t dlnow = 0;
+	curl_off_t dltotal = 0;
+	for (size_t i = 0; i < nr_transfers; i++) {
+		dlnow += transfers[i].dlnow;
+		dltotal += transfers[i].dltotal;
+	}
+
+	const char *unit_downloaded;
+	double downloaded = convert_bytes(dlnow, &unit_downloaded);
+	const char *unit_speed;
+	double speed = (runtime > 0) ? convert_bytes(dlnow / runtime,
+						     &unit_speed) :
+				       convert_bytes(0, &unit_speed);
+
+	if (dltotal > 0) {
+		const char *unit_total;
+		double total = convert_bytes(dltotal, &unit_total);
+
+		vaccel_debug(
+			"Downloaded: %.1f %s of %.1f %s (%zu/%zu files) | Speed: %.2f %s/sec",
+			downloaded, unit_downloaded, total, unit_total, nr_done,
+			nr_transfers, speed, unit_speed);
+	} else {
+		vaccel_debug(
+			"Downloaded: %.1f %s (%zu/%zu files) | Speed: %.2f %s/sec",
+			downloaded, unit_downloaded, nr_done, nr_transfers,
+			speed, unit_speed);
+	}
+}
+
+static int transfer_init(struct transfer *t, const char *path,
+			 const char *download_path,
+			 struct net_file_validators *validators)
+{
+	t->path = path;
+	t->download_path = download_path;
+	t->validators = validators;
+	t->headers = NULL;
+	t->fp = NULL;
+	t->data = NULL;
+	t->size = 0;
+	t->capacity = 0;
+	t->dlnow = 0;
+	t->dltotal = 0;
+
+	t->curl = curl_easy_init();
+	if (!t->curl)
+		return VACCEL_ENOMEM;
+
+	if (download_path) {
+		t->fp = fopen(download_path, "wb");
+		if (!t->fp) {
+			vaccel_error("Could not open file %s: %s",
+				     download_path, strerror(errno));
+			curl_easy_cleanup(t->curl);
+			t->curl = NULL;
+			return VACCEL_EIO;
+		}
+		curl_easy_setopt(t->curl, CURLOPT_WRITEDATA, t->fp);
+	} else {
+		curl_easy_setopt(t->curl, CURLOPT_WRITEFUNCTION,
+				 transfer_write_buf_callback);
+		curl_easy_setopt(t->curl, CURLOPT_WRITEDATA, t);
+	}
+
+	curl_easy_setopt(t->curl, CURLOPT_URL, path);
+	curl_easy_setopt(t->curl, CURLOPT_FAILONERROR, 1L);
+	curl_easy_setopt(t->curl, CURLOPT_FOLLOWLOCATION, 1L);
+	curl_easy_setopt(t->curl, CURLOPT_PRIVATE, t);
+
+	/* Prefer waiting for a connection to multiplex on over opening a new
+	 * one */
+	curl_easy_setopt(t->curl, CURLOPT_PIPEWAIT, 1L);
+
+	curl_easy_setopt(t->curl, CURLOPT_NOPROGRESS, 0L);
+	curl_easy_setopt(t->curl, CURLOPT_XFERINFOFUNCTION,
+			 transfer_progress_callback);
+	curl_easy_setopt(t->curl, CURLOPT_XFERINFODATA, t);
+
+	if (validators) {
+		int ret = transfer_validators_set(t);
+		if (ret) {
+			transfer_release(t);
+			return ret;
+		}
+	}
+
+	return VACCEL_OK;
+}
+
+/* Download files to download_paths, or into memory if download_paths is
+ * NULL */
+static int curl_files_transfer(const char **paths, const char **download_paths,
+			       struct net_file_validators *validators,
+			       uint8_t **data, size_t *sizes, size_t nr_files)
+{
+	struct transfer *transfers =
+		(struct transfer *)calloc(nr_files, sizeof(*transfers));
+	if (!transfers)
+		return VACCEL_ENOMEM;
+
+	int ret = VACCEL_OK;
+	CURLM *multi = curl_multi_init();
+	if (!multi) {
+		ret = VACCEL_ENOMEM;
+		goto free;
+	}
+
+	curl_multi_setopt(multi, CURLMOPT_PIPELINING, CURLPIPE_MULTIPLEX);
+	curl_multi_setopt(multi, CURLMOPT_MAX_HOST_CONNECTIONS,
+			  (long)MAX_HOST_CONNECTIONS);
+
+	size_t nr_transfers = 0;
+	for (; nr_transfers < nr_files; nr_transfers++) {
+		struct transfer *t = &transfers[nr_transfers];
+
+		ret = transfer_init(t, paths[nr_transfers],
+				    download_paths ?
+					    download_paths[nr_transfers] :
+					    NULL,
+				    validators ? &validators[nr_transfers] :
+						 NULL);
+		if (ret)
+			goto cleanup;
+
+		if (curl_multi_add_handle(multi, t->curl) != CURLM_OK) {
+			transfer_release(t);
+			ret = VACCEL_ENOMEM;
+			goto cleanup;
+		}
+
+		vaccel_debug("Downloading %s", t->path);
+	}
+
+	struct timespec start;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+	double last_runtime = 0;
+	size_t nr_done = 0;
+	int running;
+	do {
+		CURLMcode mret = curl_multi_perform(multi, &running);
+		if (mret == CURLM_OK && running)
+			mret = curl_multi_poll(multi, NULL, 0, 1000, NULL);
+		if (mret != CURLM_OK) {
+			vaccel_error("CURL: %s", curl_multi_strerror(mret));
+			ret = VACCEL_EREMOTEIO;
+			break;
+		}
+
+		CURLMsg *msg;
+		int nr_msgs;
+		while ((msg = curl_multi_info_read(multi, &nr_msgs))) {
+			if (msg->msg != CURLMSG_DONE)
+				continue;
+
+			struct transfer *t;
+			curl_easy_getinfo(msg->easy_handle, CURLINFO_PRIVATE,
+					  (char **)&t);
+			nr_done++;
+
+			if (msg->data.result != CURLE_OK) {
+				vaccel_error(
+					"CURL: %s: %s", t->path,
+					curl_easy_strerror(msg->data.result));
+				ret = VACCEL_EREMOTEIO;
+				continue;
+			}
+
+			long code = 0;
+			curl_easy_getinfo(msg->easy_handle,
+					  CURLINFO_RESPONSE_CODE, &code);
+			if (t->validators && code == 304) {
+				vaccel_debug("%s is not modified", t->path);
+				t->validators->not_modified = true;
+			}
+		}
+
+		/* Print progress on interval or when done */
+		double runtime = elapsed_sec(&start);
+		if (runtime - last_runtime >= DEFAULT_INTERVAL || !running) {
+			multi_progress_print(transfers, nr_transfers, nr_done,
+					     runtime);
+			last_runtime = runtime;
+		}
+	} while (running && !ret);
+
+	if (!ret)
+		vaccel_debug("Downloads completed successfully");
+
+cleanup:
+	for (size_t i = 0; i < nr_transfers; i++) {
+		struct transfer *t = &transfers[i];
+
+		curl_multi_remove_handle(multi, t->curl);
+		transfer_release(t);
+
+		/* Nothing was downloaded for files not modified */
+		if (t->validators && t->validators->not_modified)
+			fs_file_remove(t->download_path);
+
+		if (download_paths)
+			continue;
+
+		if (ret) {
+			free(t->data);
+			continue;
+		}
+
+		/* Drop the slack of grown buffers */
+		if (t->size && t->size < t->capacity) {
+			uint8_t *shrunk = (uint8_t *)realloc(t->data, t->size);
+			if (shrunk)
+				t->data = shrunk;
+		}
+		data[i] = t->data;
+		sizes[i] = t->size;
+	}
+	curl_multi_cleanup(multi);
+free:
+	free(transfers);
+
+	return ret;
+}
+
+int net_curl_files_download(const char **paths, const char **download_paths,
+			    struct net_file_validators *validators,
+			    size_t nr_files)
+{
+	return curl_files_transfer(paths, download_paths, validators, NULL,
+				   NULL, nr_files);
+}
+
+int net_curl_files_download_to_buf(const char **paths, uint8_t **data,
+				   size_t *sizes, size_t nr_files)
+{
+	return curl_files_transfer(paths, NULL, NULL, data, sizes, nr_files);
+}
+
 #else
 
 bool net_nocurl_path_is_url(const char *path)
@@ -234,6 +661,28 @@ int net_nocurl_file_download(const char *path, const char *download_path)
 	return VACCEL_ENOTSUP;
 }
 
+int net_nocurl_files_download(const char **paths, const char **download_paths,
+			      size_t nr_files)
+{
+	for (size_t i = 0; i < nr_files; i++) {
+		int ret = net_nocurl_file_download(paths[i], download_paths[i]);
+		if (ret)
+			return ret;
+	}
+
+	return VACCEL_OK;
+}
+
+int net_nocurl_files_download_to_buf(const char **paths, uint8_t **data,
+				     size_t *sizes, size_t nr_files)
+{
+	(void)paths;
+	(void)data;
+	(void)sizes;
+	(void)nr_files;
+	return VACCEL_ENOTSUP;
+}
+
 #endif /* USE_LIBCURL */
 
 bool net_path_is_url(const char *path)
@@ -282,3 +731,89 @@ int net_file_download(const char *path, const char *download_path)
 	return net_nocurl_file_download(path, download_path);
 #endif
 }
+
+int net_files_download(const char **paths, const char **download_paths,
+		       size_t nr_files)
+{
+	return net_files_download_validated(paths, download_paths, NULL,
+					    nr_files);
+}
+
+int net_files_download_validated(const char **paths,
+				 const char **download_paths,
+				 struct net_file_validators *validators,
+				 size_t nr_files)
+{
+	if (!paths || !download_paths || !nr_files)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < nr_files; i++) {
+		if (!paths[i] || !download_paths[i])
+			return VACCEL_EINVAL;
+
+		if (strlen(download_paths[i]) + 1 > PATH_MAX) {
+			vaccel_error("Path %s name too long", download_paths[i]);
+			return VACCEL_ENAMETOOLONG;
+		}
+
+		if (fs_path_is_file(download_paths[i]))
+			return VACCEL_EEXIST;
+
+		if (fs_path_exists(download_paths[i])) {
+			vaccel_error("Path %s exists but is not a file",
+				     download_paths[i]);
+			return VACCEL_EINVAL;
+		}
+
+		/* Concurrent downloads to the same file would corrupt it */
+		for (size_t j = 0; j < i; j++) {
+			if (strcmp(download_paths[i], download_paths[j]) == 0) {
+				vaccel_error("Path %s is downloaded twice",
+					     download_paths[i]);
+				return VACCEL_EEXIST;
+			}
+		}
+	}
+
+	for (size_t i = 0; validators && i < nr_files; i++)
+		validators[i].not_modified = false;
+
+#ifdef USE_LIBCURL
+	int ret = net_curl_files_download(paths, download_paths, validators,
+					  nr_files);
+#else
+	int ret = net_nocurl_files_download(paths, download_paths, nr_files);
+#endif
+	if (ret) {
+		/* None of the files existed before */
+		for (size_t i = 0; i < nr_files; i++) {
+			if (fs_path_is_file(download_paths[i]))
+				fs_file_remove(download_paths[i]);
+		}
+	}
+
+	return ret;
+}
+
+int net_file_download_to_buf(const char *path, uint8_t **data, size_t *size)
+{
+	return net_files_download_to_buf(&path, data, size, 1);
+}
+
+int net_files_download_to_buf(const char **paths, uint8_t **data,
+			      size_t *sizes, size_t nr_files)
+{
+	if (!paths || !data || !sizes || !nr_files)
+		return VACCEL_EINVAL;
+
+	for (size_t i = 0; i < nr_files; i++) {
+		if (!paths[i])
+			return VACCEL_EINVAL;
+	}
+
+#ifdef USE_LIBCURL
+	return net_curl_files_download_to_buf(paths, data, sizes, nr_files);
+#else
+	return net_nocurl_files_download_to_buf(paths, data, sizes, nr_files);
+#endif
+}
@@ -3,6 +3,8 @@
 #pragma once
 
 #include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -20,6 +22,49 @@ bool net_path_exists(const char *path);
  * NOTE: Only supported if libcurl is available */
 int net_file_download(const char *path, const char *download_path);
 
+/* Download files from URLs concurrently, reusing connections to the same
+ * hosts. On failure none of the files is left behind.
+ * NOTE: Only supported if libcurl is available */
+int net_files_download(const char **paths, const char **download_paths,
+		       size_t nr_files);
+
+/* Download a file from a URL into memory. The buffer is allocated and must be
+ * freed by the caller.
+ * NOTE: Only supported if libcurl is available */
+int net_file_download_to_buf(const char *path, uint8_t **data, size_t *size);
+
+/* Download files from URLs into memory concurrently, like
+ * net_files_download(). Buffers are sized from the length of the files where
+ * the server reports it. They are allocated and must be freed by the caller;
+ * on failure none is returned.
+ * NOTE: Only supported if libcurl is available */
+int net_files_download_to_buf(const char **paths, uint8_t **data,
+			      size_t *sizes, size_t nr_files);
+
+#define NET_VALIDATOR_MAX 256
+
+/* Validators of a downloaded file, to revalidate it with conditional
+ * requests */
+struct net_file_validators {
+	/* ETag and Last-Modified headers; empty if unknown */
+	char etag[NET_VALIDATOR_MAX];
+	char last_modified[NET_VALIDATOR_MAX];
+
+	/* true if the file was not modified since the validators were
+	 * returned */
+	bool not_modified;
+};
+
+/* Download files like net_files_download(), revalidating the ones with
+ * validators. Files that were not modified are not downloaded and have
+ * `not_modified` set; the rest have their validators updated from the
+ * response.
+ * NOTE: Only supported if libcurl is available */
+int net_files_download_validated(const char **paths,
+				 const char **download_paths,
+				 struct net_file_validators *validators,
+				 size_t nr_files);
+
 #ifdef __cplusplus
 }
 #endif
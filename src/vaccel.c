@@ -100,12 +100,36 @@ static int do_bootstrap(void)
 		return ret;
 	}
 
+	ret = reaper_bootstrap();
+	if (ret) {
+		vaccel_error("Could not bootstrap rundir reaper");
+		return ret;
+	}
+
 	ret = sessions_bootstrap();
 	if (ret) {
 		vaccel_error("Could not bootstrap sessions");
 		return ret;
 	}
 
+	ret = download_cache_bootstrap();
+	if (ret) {
+		vaccel_error("Could not bootstrap download cache");
+		return ret;
+	}
+
+	ret = model_cache_bootstrap();
+	if (ret) {
+		vaccel_error("Could not bootstrap model cache");
+		return ret;
+	}
+
+	ret = blob_cache_bootstrap();
+	if (ret) {
+		vaccel_error("Could not bootstrap blob cache");
+		return ret;
+	}
+
 	ret = resources_bootstrap();
 	if (ret) {
 		vaccel_error("Could not bootstrap resources");
@@ -118,6 +142,12 @@ static int do_bootstrap(void)
 		return ret;
 	}
 
+	ret = async_bootstrap();
+	if (ret) {
+		vaccel_error("Could not bootstrap async workers");
+		return ret;
+	}
+
 	if (vaccel.config.plugins) {
 		ret = vaccel_plugin_parse_and_load(vaccel.config.plugins);
 		if (ret) {
@@ -179,6 +209,12 @@ static int do_cleanup(void)
 
 	vaccel_debug("Cleaning up vAccel");
 
+	ret = async_cleanup();
+	if (ret) {
+		vaccel_error("Could not cleanup async workers");
+		return ret;
+	}
+
 	ret = sessions_cleanup();
 	if (ret) {
 		vaccel_error("Could not cleanup sessions");
@@ -191,6 +227,32 @@ static int do_cleanup(void)
 		return ret;
 	}
 
+	ret = blob_cache_cleanup();
+	if (ret) {
+		vaccel_error("Could not cleanup blob cache");
+		return ret;
+	}
+
+	/* Models are unloaded by plugin code, so before plugins go away */
+	ret = model_cache_cleanup();
+	if (ret) {
+		vaccel_error("Could not cleanup model cache");
+		return ret;
+	}
+
+	ret = download_cache_cleanup();
+	if (ret) {
+		vaccel_error("Could not cleanup download cache");
+		return ret;
+	}
+
+	/* Wait for released rundirs to be removed */
+	ret = reaper_cleanup();
+	if (ret) {
+		vaccel_error("Could not cleanup rundir reaper");
+		return ret;
+	}
+
 	ret = plugins_cleanup();
 	if (ret) {
 		vaccel_error("Could not cleanup plugins");
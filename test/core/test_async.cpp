@@ -0,0 +1,296 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to asynchronous op submission.
+ *
+ * 1) vaccel_cq_init()
+ * 2) vaccel_cq_release()
+ * 3) vaccel_cq_new()
+ * 4) vaccel_cq_delete()
+ * 5) vaccel_op_submit()
+ * 6) vaccel_cq_poll()
+ * 7) vaccel_cq_wait()
+ *
+ */
+
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdlib>
+#include <vector>
+
+static auto init() -> int
+{
+	return VACCEL_OK;
+}
+static auto fini() -> int
+{
+	return VACCEL_OK;
+}
+
+static auto exec_op(struct vaccel_session *sess, const char *library,
+		    const char *fn_symbol, struct vaccel_arg *read,
+		    size_t nr_read, struct vaccel_arg *write,
+		    size_t nr_write) -> int
+{
+	(void)sess;
+	(void)library;
+	(void)fn_symbol;
+	(void)read;
+	(void)nr_read;
+	(void)write;
+	(void)nr_write;
+	return 2;
+}
+
+static auto submit_async_inline(struct vaccel_session *sess,
+				vaccel_op_type_t op_type,
+				struct vaccel_arg *read, int nr_read,
+				struct vaccel_arg *write, int nr_write,
+				vaccel_op_complete_fn_t complete,
+				void *ctx) -> int
+{
+	(void)sess;
+	(void)read;
+	(void)nr_read;
+	(void)write;
+	(void)nr_write;
+
+	complete(ctx, (int)op_type + 100);
+	return VACCEL_OK;
+}
+
+static vaccel_op_complete_fn_t deferred_complete;
+static void *deferred_ctx;
+
+static auto submit_async_deferred(struct vaccel_session *sess,
+				  vaccel_op_type_t op_type,
+				  struct vaccel_arg *read, int nr_read,
+				  struct vaccel_arg *write, int nr_write,
+				  vaccel_op_complete_fn_t complete,
+				  void *ctx) -> int
+{
+	(void)sess;
+	(void)op_type;
+	(void)read;
+	(void)nr_read;
+	(void)write;
+	(void)nr_write;
+
+	deferred_complete = complete;
+	deferred_ctx = ctx;
+	return VACCEL_OK;
+}
+
+static auto submit_async_unsupported(struct vaccel_session *sess,
+				     vaccel_op_type_t op_type,
+				     struct vaccel_arg *read, int nr_read,
+				     struct vaccel_arg *write, int nr_write,
+				     vaccel_op_complete_fn_t complete,
+				     void *ctx) -> int
+{
+	(void)sess;
+	(void)op_type;
+	(void)read;
+	(void)nr_read;
+	(void)write;
+	(void)nr_write;
+	(void)complete;
+	(void)ctx;
+
+	return VACCEL_ENOTSUP;
+}
+
+TEST_CASE("vaccel_cq_init", "[core][async]")
+{
+	struct vaccel_cq cq;
+	struct vaccel_completion completion;
+	size_t nr = 1;
+
+	REQUIRE(vaccel_cq_init(&cq) == VACCEL_OK);
+	REQUIRE(cq.nr_inflight == 0);
+	REQUIRE(cq.nr_completed == 0);
+
+	SECTION("empty")
+	{
+		REQUIRE(vaccel_cq_poll(&cq, &completion, 1, &nr) == VACCEL_OK);
+		REQUIRE(nr == 0);
+		REQUIRE(vaccel_cq_wait(&cq, &completion, 1, &nr, -1) ==
+			VACCEL_ENOENT);
+		REQUIRE(nr == 0);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_cq_init(nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_cq_release(nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_cq_poll(nullptr, &completion, 1, &nr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_cq_poll(&cq, nullptr, 1, &nr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_cq_poll(&cq, &completion, 0, &nr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_cq_wait(&cq, &completion, 1, nullptr, 0) ==
+			VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_cq_release(&cq) == VACCEL_OK);
+}
+
+TEST_CASE("vaccel_cq_new", "[core][async]")
+{
+	struct vaccel_cq *cq = nullptr;
+
+	REQUIRE(vaccel_cq_new(&cq) == VACCEL_OK);
+	REQUIRE(cq != nullptr);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_cq_new(nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_cq_delete(nullptr) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_cq_delete(cq) == VACCEL_OK);
+}
+
+TEST_CASE("vaccel_op_submit", "[core][async]")
+{
+	const size_t nr_ops = 256;
+	struct vaccel_session sess;
+	struct vaccel_cq cq;
+	struct vaccel_arg_array read_args;
+
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+	REQUIRE(vaccel_cq_init(&cq) == VACCEL_OK);
+
+	/* Noop has no genop unpacker; use exec, which the noop plugin also
+	 * implements */
+	auto op_type = (uint8_t)VACCEL_OP_EXEC;
+	REQUIRE(vaccel_arg_array_init(&read_args, 3) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_uint8(&read_args, &op_type) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_string(&read_args, (char *)"lib.so") ==
+		VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_string(&read_args, (char *)"func") ==
+		VACCEL_OK);
+
+	SECTION("worker pool")
+	{
+		std::vector<size_t> tags(nr_ops);
+		std::vector<unsigned int> seen(nr_ops, 0);
+
+		for (size_t i = 0; i < nr_ops; i++) {
+			tags[i] = i;
+			REQUIRE(vaccel_op_submit(&sess, &cq, read_args.args,
+						 (int)read_args.count, nullptr,
+						 0, &tags[i]) == VACCEL_OK);
+		}
+
+		size_t reaped = 0;
+		std::vector<struct vaccel_completion> completions(16);
+
+		while (reaped < nr_ops) {
+			size_t nr = 0;
+			REQUIRE(vaccel_cq_wait(&cq, completions.data(),
+					       completions.size(), &nr,
+					       -1) == VACCEL_OK);
+			REQUIRE(nr > 0);
+			REQUIRE(nr <= completions.size());
+
+			for (size_t i = 0; i < nr; i++) {
+				REQUIRE(completions[i].ret == VACCEL_OK);
+				seen[*(size_t *)completions[i].user_data]++;
+			}
+			reaped += nr;
+		}
+
+		for (auto s : seen)
+			REQUIRE(s == 1);
+
+		size_t nr = 1;
+		REQUIRE(vaccel_cq_wait(&cq, completions.data(),
+				       completions.size(), &nr,
+				       0) == VACCEL_ENOENT);
+		REQUIRE(nr == 0);
+	}
+
+	SECTION("plugin async")
+	{
+		struct vaccel_plugin_info info = {};
+		info.name = "mock_async";
+		info.version = "0.0.0";
+		info.vaccel_version = VACCEL_VERSION;
+		info.init = init;
+		info.fini = fini;
+		info.type = VACCEL_PLUGIN_GENERIC;
+
+		struct vaccel_plugin mock = {};
+		mock.entry = LIST_ENTRY_INIT(mock.entry);
+		mock.info = &info;
+		vaccel_op mock_op = { .type = VACCEL_OP_EXEC,
+				      .func = (void *)exec_op,
+				      .owner = &mock };
+		mock.ops[VACCEL_OP_EXEC] = &mock_op;
+
+		struct vaccel_plugin *sess_plugin = sess.plugin;
+		sess.plugin = &mock;
+
+		struct vaccel_completion completion;
+		size_t nr = 0;
+
+		/* Completed by the plugin itself */
+		info.submit_async = submit_async_inline;
+		REQUIRE(vaccel_op_submit(&sess, &cq, read_args.args,
+					 (int)read_args.count, nullptr, 0,
+					 &cq) == VACCEL_OK);
+		REQUIRE(vaccel_cq_poll(&cq, &completion, 1, &nr) == VACCEL_OK);
+		REQUIRE(nr == 1);
+		REQUIRE(completion.user_data == &cq);
+		REQUIRE(completion.ret == VACCEL_OP_EXEC + 100);
+
+		/* Completed later; can't release with ops in flight */
+		info.submit_async = submit_async_deferred;
+		REQUIRE(vaccel_op_submit(&sess, &cq, read_args.args,
+					 (int)read_args.count, nullptr, 0,
+					 &sess) == VACCEL_OK);
+		REQUIRE(cq.nr_inflight == 1);
+		REQUIRE(vaccel_cq_release(&cq) == VACCEL_EBUSY);
+		REQUIRE(vaccel_cq_wait(&cq, &completion, 1, &nr, 10) ==
+			VACCEL_EAGAIN);
+		REQUIRE(nr == 0);
+		deferred_complete(deferred_ctx, VACCEL_OK);
+		REQUIRE(vaccel_cq_wait(&cq, &completion, 1, &nr, 10) ==
+			VACCEL_OK);
+		REQUIRE(nr == 1);
+		REQUIRE(completion.user_data == &sess);
+		REQUIRE(completion.ret == VACCEL_OK);
+
+		/* Falls back to running the op synchronously in a worker */
+		info.submit_async = submit_async_unsupported;
+		REQUIRE(vaccel_op_submit(&sess, &cq, read_args.args,
+					 (int)read_args.count, nullptr, 0,
+					 nullptr) == VACCEL_OK);
+		REQUIRE(vaccel_cq_wait(&cq, &completion, 1, &nr, -1) ==
+			VACCEL_OK);
+		REQUIRE(nr == 1);
+		REQUIRE(completion.user_data == nullptr);
+		REQUIRE(completion.ret == 2);
+
+		sess.plugin = sess_plugin;
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_op_submit(nullptr, &cq, read_args.args,
+					 (int)read_args.count, nullptr, 0,
+					 nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_op_submit(&sess, nullptr, read_args.args,
+					 (int)read_args.count, nullptr, 0,
+					 nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_op_submit(&sess, &cq, nullptr, 0, nullptr, 0,
+					 nullptr) == VACCEL_EINVAL);
+		REQUIRE(cq.nr_inflight == 0);
+	}
+
+	REQUIRE(vaccel_arg_array_release(&read_args) == VACCEL_OK);
+	REQUIRE(vaccel_cq_release(&cq) == VACCEL_OK);
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+}
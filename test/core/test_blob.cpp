@@ -14,16 +14,23 @@
  * 9)  vaccel_blob_read()
  * 10)  vaccel_blob_data()
  * 11)  vaccel_blob_path()
+ * 12)  vaccel_blob_persist_memfd()
+ * 13)  vaccel_blob_read(), with map flags
+ * 14)  vaccel_blob_read_multi()
  *
  */
 
 #include "utils.hpp"
 #include "vaccel.h"
 #include <catch2/catch_test_macros.hpp>
+#include <cerrno>
 #include <cstddef>
+#include <cstdint>
 #include <cstdlib>
 #include <cstring>
+#include <fcntl.h>
 #include <linux/limits.h>
+#include <unistd.h>
 
 TEST_CASE("blob_from_path", "[core][blob]")
 {
@@ -44,6 +51,7 @@ TEST_CASE("blob_from_path", "[core][blob]")
 	REQUIRE(strcmp(blob.name, "libmytestlib.so") == 0);
 	REQUIRE(strcmp(blob.path, path) == 0);
 	REQUIRE(blob.path_owned == false);
+	REQUIRE(blob.memfd == -1);
 	REQUIRE(blob.data == nullptr);
 	REQUIRE(blob.size == 0);
 	REQUIRE(blob.type == VACCEL_BLOB_FILE);
@@ -648,3 +656,223 @@ TEST_CASE("blob_from_buffer_owned_data", "[core][blob]")
 
 	free(buf);
 }
+
+TEST_CASE("blob_persist_memfd", "[core][blob]")
+{
+	int ret;
+	const char *file_name = "file";
+
+	size_t len;
+	unsigned char *buf;
+	char path[PATH_MAX];
+	ret = path_init_from_parts(path, PATH_MAX, BUILD_ROOT,
+				   "examples/libmytestlib.so", nullptr);
+	REQUIRE(ret == VACCEL_OK);
+	ret = fs_file_read(path, (void **)&buf, &len);
+	REQUIRE(ret == VACCEL_OK);
+
+	struct vaccel_blob *blob;
+	ret = vaccel_blob_from_buf(&blob, buf, len, true, file_name, nullptr,
+				   false);
+	REQUIRE(ret == VACCEL_OK);
+
+	SECTION("success")
+	{
+		ret = vaccel_blob_persist_memfd(blob, file_name);
+		REQUIRE(ret == VACCEL_OK);
+		REQUIRE(strcmp(blob->name, file_name) == 0);
+		REQUIRE(strncmp(blob->path, "/proc/self/fd/", 14) == 0);
+		REQUIRE(blob->path_owned == true);
+		REQUIRE(blob->memfd >= 0);
+		REQUIRE(atoi(blob->path + 14) == blob->memfd);
+		REQUIRE(blob->data != nullptr);
+		REQUIRE(blob->data != buf);
+		REQUIRE(blob->size == len);
+		REQUIRE(blob->type == VACCEL_BLOB_MAPPED);
+		REQUIRE(blob->data_owned);
+		REQUIRE(vaccel_blob_path(blob) == blob->path);
+
+		for (size_t i = 0; i < len; i++)
+			REQUIRE(blob->data[i] == buf[i]);
+
+		/* The file can be read through its path, but not modified */
+		unsigned char *fbuf;
+		size_t flen;
+		ret = fs_file_read(blob->path, (void **)&fbuf, &flen);
+		REQUIRE(ret == VACCEL_OK);
+		REQUIRE(flen == len);
+		REQUIRE(memcmp(fbuf, buf, len) == 0);
+		free(fbuf);
+
+		int const fd = open(blob->path, O_WRONLY);
+		REQUIRE(fd >= 0);
+		REQUIRE(write(fd, buf, 1) < 0);
+		close(fd);
+
+		/* The file is gone with the blob */
+		char *fpath = strdup(blob->path);
+		REQUIRE(fpath != nullptr);
+		ret = vaccel_blob_delete(blob);
+		REQUIRE(ret == VACCEL_OK);
+		REQUIRE_FALSE(fs_path_exists(fpath));
+		free(fpath);
+	}
+
+	SECTION("invalid arguments")
+	{
+		ret = vaccel_blob_persist_memfd(nullptr, file_name);
+		REQUIRE(ret == VACCEL_EINVAL);
+		ret = vaccel_blob_persist_memfd(blob, nullptr);
+		REQUIRE(ret == VACCEL_EINVAL);
+
+		ret = vaccel_blob_persist_memfd(blob, file_name);
+		REQUIRE(ret == VACCEL_OK);
+		ret = vaccel_blob_persist_memfd(blob, file_name);
+		REQUIRE(ret == VACCEL_EEXIST);
+
+		ret = vaccel_blob_delete(blob);
+		REQUIRE(ret == VACCEL_OK);
+	}
+
+	free(buf);
+}
+
+TEST_CASE("blob_map_flags", "[core][blob]")
+{
+	int ret;
+
+	char path[PATH_MAX];
+	ret = path_init_from_parts(path, PATH_MAX, BUILD_ROOT,
+				   "examples/libmytestlib.so", nullptr);
+	REQUIRE(ret == VACCEL_OK);
+
+	size_t len;
+	unsigned char *buf;
+	ret = fs_file_read(path, (void **)&buf, &len);
+	REQUIRE(ret == VACCEL_OK);
+
+	uint32_t const flags = VACCEL_BLOB_MAP_SHARED |
+			       VACCEL_BLOB_MAP_POPULATE |
+			       VACCEL_BLOB_MAP_WILLNEED;
+
+	SECTION("file")
+	{
+		struct vaccel_blob *blob;
+		ret = vaccel_blob_new(&blob, path);
+		REQUIRE(ret == VACCEL_OK);
+		REQUIRE(blob->map_flags == 0);
+
+		blob->map_flags = flags;
+		size_t size;
+		unsigned char *data = vaccel_blob_data(blob, &size);
+		REQUIRE(data != nullptr);
+		REQUIRE(blob->type == VACCEL_BLOB_MAPPED);
+		REQUIRE(size == len);
+		REQUIRE(memcmp(data, buf, len) == 0);
+
+		ret = vaccel_blob_delete(blob);
+		REQUIRE(ret == VACCEL_OK);
+	}
+
+	SECTION("memory file")
+	{
+		struct vaccel_blob *blob;
+		ret = vaccel_blob_from_buf(&blob, buf, len, false, "file",
+					   nullptr, false);
+		REQUIRE(ret == VACCEL_OK);
+		REQUIRE(blob->map_flags == 0);
+
+		blob->map_flags = flags;
+		ret = vaccel_blob_persist_memfd(blob, "file");
+		REQUIRE(ret == VACCEL_OK);
+		REQUIRE(blob->type == VACCEL_BLOB_MAPPED);
+		REQUIRE(blob->size == len);
+		REQUIRE(memcmp(blob->data, buf, len) == 0);
+
+		ret = vaccel_blob_delete(blob);
+		REQUIRE(ret == VACCEL_OK);
+	}
+
+	free(buf);
+}
+
+TEST_CASE("blob_read_multi", "[core][blob]")
+{
+	/* More than the file operations batched at once */
+	const size_t nr_blobs = 40;
+	struct vaccel_blob *blobs[nr_blobs];
+	char *paths[2] = {
+		abs_path(BUILD_ROOT, "examples/libmytestlib.so"),
+		abs_path(SOURCE_ROOT,
+			 "examples/models/tf/lstm2/variables/variables.index")
+	};
+	unsigned char *bufs[2];
+	size_t lens[2];
+
+	for (size_t i = 0; i < 2; i++)
+		REQUIRE(fs_file_read(paths[i], (void **)&bufs[i], &lens[i]) ==
+			VACCEL_OK);
+
+	for (size_t i = 0; i < nr_blobs; i++) {
+		REQUIRE(vaccel_blob_new(&blobs[i], paths[i % 2]) ==
+			VACCEL_OK);
+		if (i % 3 == 0)
+			blobs[i]->map_flags = VACCEL_BLOB_MAP_SHARED;
+	}
+
+	SECTION("read")
+	{
+		/* Blobs already read are left as they are */
+		REQUIRE(vaccel_blob_read(blobs[1]) == VACCEL_OK);
+		uint8_t *data = blobs[1]->data;
+
+		REQUIRE(vaccel_blob_read_multi(blobs, nr_blobs) == VACCEL_OK);
+		REQUIRE(blobs[1]->data == data);
+		for (size_t i = 0; i < nr_blobs; i++) {
+			REQUIRE(blobs[i]->type == VACCEL_BLOB_MAPPED);
+			REQUIRE(blobs[i]->size == lens[i % 2]);
+			REQUIRE(memcmp(blobs[i]->data, bufs[i % 2],
+				       lens[i % 2]) == 0);
+		}
+	}
+
+	SECTION("missing file")
+	{
+		char path[PATH_MAX];
+		struct vaccel_blob *missing;
+
+		REQUIRE(path_init_from_parts(path, PATH_MAX, vaccel_rundir(),
+					     "blob_read_multi",
+					     nullptr) == VACCEL_OK);
+		REQUIRE(fs_file_create(path, nullptr) == VACCEL_OK);
+		REQUIRE(vaccel_blob_new(&missing, path) == VACCEL_OK);
+		REQUIRE(fs_file_remove(path) == VACCEL_OK);
+
+		/* None of the blobs is read if one can't be */
+		struct vaccel_blob *last = blobs[nr_blobs - 1];
+		blobs[nr_blobs - 1] = missing;
+		REQUIRE(vaccel_blob_read_multi(blobs, nr_blobs) == ENOENT);
+		for (size_t i = 0; i < nr_blobs; i++) {
+			REQUIRE(blobs[i]->type == VACCEL_BLOB_FILE);
+			REQUIRE(blobs[i]->data == nullptr);
+		}
+		blobs[nr_blobs - 1] = last;
+
+		REQUIRE(vaccel_blob_delete(missing) == VACCEL_OK);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_blob_read_multi(nullptr, nr_blobs) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_blob_read_multi(blobs, 0) == VACCEL_EINVAL);
+	}
+
+	for (size_t i = 0; i < nr_blobs; i++)
+		REQUIRE(vaccel_blob_delete(blobs[i]) == VACCEL_OK);
+
+	for (size_t i = 0; i < 2; i++) {
+		free(bufs[i]);
+		free(paths[i]);
+	}
+}
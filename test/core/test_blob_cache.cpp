@@ -0,0 +1,150 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to the blob cache.
+ *
+ * 1) vaccel_blob_cache_set_budget()
+ * 2) vaccel_blob_cache_stats()
+ *
+ */
+
+#include "utils.hpp"
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <linux/limits.h>
+
+TEST_CASE("vaccel_blob_cache", "[core][blob_cache]")
+{
+	char path[PATH_MAX];
+	REQUIRE(path_init_from_parts(path, PATH_MAX, BUILD_ROOT,
+				     "examples/libmytestlib.so",
+				     nullptr) == VACCEL_OK);
+
+	struct vaccel_blob blob1;
+	struct vaccel_blob blob2;
+	struct vaccel_blob_cache_stats before;
+	struct vaccel_blob_cache_stats after;
+	size_t size = 0;
+
+	REQUIRE(vaccel_blob_init(&blob1, path) == VACCEL_OK);
+	REQUIRE(vaccel_blob_init(&blob2, path) == VACCEL_OK);
+	REQUIRE(vaccel_blob_cache_stats(&before) == VACCEL_OK);
+
+	SECTION("private mappings")
+	{
+		/* Changes made through private mappings would be lost */
+		REQUIRE(vaccel_blob_cache_set_budget(1) == VACCEL_OK);
+		REQUIRE(vaccel_blob_data(&blob1, &size) != nullptr);
+		REQUIRE(blob1.cache_entry == nullptr);
+
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.nr_blobs == before.nr_blobs);
+		REQUIRE(after.size == before.size);
+		REQUIRE(after.evictions == before.evictions);
+
+		REQUIRE(vaccel_blob_cache_set_budget(0) == VACCEL_OK);
+	}
+
+	blob1.map_flags = VACCEL_BLOB_MAP_SHARED;
+	blob2.map_flags = VACCEL_BLOB_MAP_SHARED;
+
+	SECTION("no budget")
+	{
+		/* Blobs are counted when mapped, but never evicted */
+		REQUIRE(vaccel_blob_read(&blob1) == VACCEL_OK);
+		REQUIRE(blob1.cache_entry != nullptr);
+
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.nr_blobs == before.nr_blobs + 1);
+		REQUIRE(after.size == before.size + blob1.size);
+
+		REQUIRE(vaccel_blob_data(&blob2, nullptr) != nullptr);
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.nr_blobs == before.nr_blobs + 2);
+		REQUIRE(after.evictions == before.evictions);
+	}
+
+	SECTION("read multi")
+	{
+		struct vaccel_blob *blobs[] = { &blob1, &blob2 };
+
+		REQUIRE(vaccel_blob_read_multi(blobs, 2) == VACCEL_OK);
+		REQUIRE(blob1.cache_entry != nullptr);
+		REQUIRE(blob2.cache_entry != nullptr);
+
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.nr_blobs == before.nr_blobs + 2);
+		REQUIRE(after.size == before.size + blob1.size + blob2.size);
+	}
+
+	SECTION("evict and refault")
+	{
+		REQUIRE(vaccel_blob_read(&blob1) == VACCEL_OK);
+		REQUIRE(vaccel_blob_cache_set_budget(blob1.size) == VACCEL_OK);
+
+		uint8_t *data1 = vaccel_blob_data(&blob1, &size);
+		REQUIRE(data1 != nullptr);
+		REQUIRE(blob1.cache_entry != nullptr);
+		const uint8_t byte = data1[0];
+
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.nr_blobs == before.nr_blobs + 1);
+		REQUIRE(after.size == before.size + size);
+
+		/* The least recently used blob makes room for the new one */
+		REQUIRE(vaccel_blob_data(&blob2, nullptr) != nullptr);
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.evictions == before.evictions + 1);
+		REQUIRE(after.nr_blobs == before.nr_blobs + 1);
+		REQUIRE(after.size == before.size + size);
+
+		/* and its data is read back from the file */
+		REQUIRE(vaccel_blob_data(&blob1, nullptr) == data1);
+		REQUIRE(data1[0] == byte);
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.refaults == before.refaults + 1);
+		REQUIRE(after.evictions == before.evictions + 2);
+
+		/* Lowering the budget evicts right away */
+		REQUIRE(vaccel_blob_cache_set_budget(1) == VACCEL_OK);
+		REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.evictions == before.evictions + 3);
+		REQUIRE(after.nr_blobs == before.nr_blobs);
+		REQUIRE(after.size == before.size);
+
+		REQUIRE(vaccel_blob_cache_set_budget(0) == VACCEL_OK);
+	}
+
+	SECTION("in-memory blobs")
+	{
+		uint8_t buf[] = { 1, 2, 3, 4 };
+		struct vaccel_blob blob3;
+
+		REQUIRE(vaccel_blob_init_from_buf(&blob3, buf, sizeof(buf),
+						  false, "blob", nullptr,
+						  false) == VACCEL_OK);
+		blob3.map_flags = VACCEL_BLOB_MAP_SHARED;
+		REQUIRE(vaccel_blob_persist_memfd(&blob3, "blob") ==
+			VACCEL_OK);
+		REQUIRE(vaccel_blob_cache_set_budget(1) == VACCEL_OK);
+
+		/* Data of in-memory files would not leave memory */
+		REQUIRE(vaccel_blob_data(&blob3, nullptr) != nullptr);
+		REQUIRE(blob3.cache_entry == nullptr);
+
+		REQUIRE(vaccel_blob_cache_set_budget(0) == VACCEL_OK);
+		REQUIRE(vaccel_blob_release(&blob3) == VACCEL_OK);
+	}
+
+	/* Released blobs leave the cache */
+	REQUIRE(vaccel_blob_release(&blob1) == VACCEL_OK);
+	REQUIRE(vaccel_blob_release(&blob2) == VACCEL_OK);
+	REQUIRE(vaccel_blob_cache_stats(&after) == VACCEL_OK);
+	REQUIRE(after.nr_blobs == before.nr_blobs);
+	REQUIRE(after.size == before.size);
+
+	REQUIRE(vaccel_blob_cache_stats(nullptr) == VACCEL_EINVAL);
+}
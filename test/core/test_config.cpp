@@ -46,7 +46,16 @@ TEST_CASE("vaccel_config_init_from_env", "[core][config]")
 		.log_level = CONFIG_LOG_LEVEL_DEFAULT,
 		.log_file = CONFIG_LOG_FILE_DEFAULT,
 		.profiling_enabled = CONFIG_PROFILING_ENABLED_DEFAULT,
-		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT
+		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT,
+		.sched_policy = CONFIG_SCHED_POLICY_DEFAULT,
+		.max_sessions = CONFIG_MAX_SESSIONS_DEFAULT,
+		.max_resources = CONFIG_MAX_RESOURCES_DEFAULT,
+		.model_cache_size = CONFIG_MODEL_CACHE_SIZE_DEFAULT,
+		.download_cache_dir = CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT,
+		.download_cache_size = CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT,
+		.download_in_memory = CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT,
+		.blobs_in_memory = CONFIG_BLOBS_IN_MEMORY_DEFAULT,
+		.blob_cache_size = CONFIG_BLOB_CACHE_SIZE_DEFAULT
 	};
 
 	SECTION("success")
@@ -86,7 +95,16 @@ TEST_CASE("vaccel_config_init_from", "[core][config]")
 		.log_level = CONFIG_LOG_LEVEL_DEFAULT,
 		.log_file = CONFIG_LOG_FILE_DEFAULT,
 		.profiling_enabled = CONFIG_PROFILING_ENABLED_DEFAULT,
-		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT
+		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT,
+		.sched_policy = CONFIG_SCHED_POLICY_DEFAULT,
+		.max_sessions = CONFIG_MAX_SESSIONS_DEFAULT,
+		.max_resources = CONFIG_MAX_RESOURCES_DEFAULT,
+		.model_cache_size = CONFIG_MODEL_CACHE_SIZE_DEFAULT,
+		.download_cache_dir = CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT,
+		.download_cache_size = CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT,
+		.download_in_memory = CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT,
+		.blobs_in_memory = CONFIG_BLOBS_IN_MEMORY_DEFAULT,
+		.blob_cache_size = CONFIG_BLOB_CACHE_SIZE_DEFAULT
 	};
 
 	REQUIRE(vaccel_config_init_from_env(&config_env) == VACCEL_OK);
@@ -103,6 +121,21 @@ TEST_CASE("vaccel_config_init_from", "[core][config]")
 		REQUIRE(config.profiling_enabled ==
 			config_env.profiling_enabled);
 		REQUIRE(config.version_ignore == config_env.version_ignore);
+		REQUIRE(config.sched_policy == config_env.sched_policy);
+		REQUIRE(config.max_sessions == config_env.max_sessions);
+		REQUIRE(config.max_resources == config_env.max_resources);
+		REQUIRE(config.model_cache_size ==
+			config_env.model_cache_size);
+		REQUIRE((config.download_cache_dir ==
+				 config_env.download_cache_dir ||
+			 strcmp(config.download_cache_dir,
+				config_env.download_cache_dir) == 0));
+		REQUIRE(config.download_cache_size ==
+			config_env.download_cache_size);
+		REQUIRE(config.download_in_memory ==
+			config_env.download_in_memory);
+		REQUIRE(config.blobs_in_memory == config_env.blobs_in_memory);
+		REQUIRE(config.blob_cache_size == config_env.blob_cache_size);
 
 		REQUIRE(vaccel_config_release(&config) == VACCEL_OK);
 	}
@@ -197,7 +230,16 @@ TEST_CASE("vaccel_config_init", "[core][config]")
 		.log_level = CONFIG_LOG_LEVEL_DEFAULT,
 		.log_file = CONFIG_LOG_FILE_DEFAULT,
 		.profiling_enabled = CONFIG_PROFILING_ENABLED_DEFAULT,
-		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT
+		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT,
+		.sched_policy = CONFIG_SCHED_POLICY_DEFAULT,
+		.max_sessions = CONFIG_MAX_SESSIONS_DEFAULT,
+		.max_resources = CONFIG_MAX_RESOURCES_DEFAULT,
+		.model_cache_size = CONFIG_MODEL_CACHE_SIZE_DEFAULT,
+		.download_cache_dir = CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT,
+		.download_cache_size = CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT,
+		.download_in_memory = CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT,
+		.blobs_in_memory = CONFIG_BLOBS_IN_MEMORY_DEFAULT,
+		.blob_cache_size = CONFIG_BLOB_CACHE_SIZE_DEFAULT
 	};
 
 	SECTION("success")
@@ -210,6 +252,21 @@ TEST_CASE("vaccel_config_init", "[core][config]")
 		REQUIRE(strcmp(config.log_file, log_file) == 0);
 		REQUIRE(config.profiling_enabled == profiling_enabled);
 		REQUIRE(config.version_ignore == version_ignore);
+		REQUIRE(config.sched_policy == CONFIG_SCHED_POLICY_DEFAULT);
+		REQUIRE(config.max_sessions == CONFIG_MAX_SESSIONS_DEFAULT);
+		REQUIRE(config.max_resources == CONFIG_MAX_RESOURCES_DEFAULT);
+		REQUIRE(config.model_cache_size ==
+			CONFIG_MODEL_CACHE_SIZE_DEFAULT);
+		REQUIRE(config.download_cache_dir ==
+			CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT);
+		REQUIRE(config.download_cache_size ==
+			CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT);
+		REQUIRE(config.download_in_memory ==
+			CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT);
+		REQUIRE(config.blobs_in_memory ==
+			CONFIG_BLOBS_IN_MEMORY_DEFAULT);
+		REQUIRE(config.blob_cache_size ==
+			CONFIG_BLOB_CACHE_SIZE_DEFAULT);
 
 		REQUIRE(vaccel_config_release(&config) == VACCEL_OK);
 	}
@@ -255,7 +312,16 @@ TEST_CASE("vaccel_config_release", "[core][config]")
 		.log_level = CONFIG_LOG_LEVEL_DEFAULT,
 		.log_file = CONFIG_LOG_FILE_DEFAULT,
 		.profiling_enabled = CONFIG_PROFILING_ENABLED_DEFAULT,
-		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT
+		.version_ignore = CONFIG_VERSION_IGNORE_DEFAULT,
+		.sched_policy = CONFIG_SCHED_POLICY_DEFAULT,
+		.max_sessions = CONFIG_MAX_SESSIONS_DEFAULT,
+		.max_resources = CONFIG_MAX_RESOURCES_DEFAULT,
+		.model_cache_size = CONFIG_MODEL_CACHE_SIZE_DEFAULT,
+		.download_cache_dir = CONFIG_DOWNLOAD_CACHE_DIR_DEFAULT,
+		.download_cache_size = CONFIG_DOWNLOAD_CACHE_SIZE_DEFAULT,
+		.download_in_memory = CONFIG_DOWNLOAD_IN_MEMORY_DEFAULT,
+		.blobs_in_memory = CONFIG_BLOBS_IN_MEMORY_DEFAULT,
+		.blob_cache_size = CONFIG_BLOB_CACHE_SIZE_DEFAULT
 	};
 
 	ret = vaccel_config_init(&config, plugins, log_level, log_file,
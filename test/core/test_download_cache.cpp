@@ -0,0 +1,221 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to the download cache.
+ *
+ * 1) download_cache_files_download()
+ * 2) vaccel_download_cache_stats()
+ *
+ */
+
+#include "http_server.hpp"
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <linux/limits.h>
+#include <string>
+
+static auto cache_bootstrap(const char *dir, size_t size) -> int
+{
+	struct vaccel_config config;
+
+	int ret = vaccel_config_init_from_env(&config);
+	if (ret)
+		return ret;
+
+	free(config.download_cache_dir);
+	config.download_cache_dir = strdup(dir);
+	config.download_cache_size = size;
+
+	ret = vaccel_bootstrap_with_config(&config);
+	vaccel_config_release(&config);
+
+	return ret;
+}
+
+static auto file_content(const char *path) -> std::string
+{
+	char *data;
+	size_t size;
+	if (fs_file_read(path, (void **)&data, &size) != VACCEL_OK)
+		return "";
+
+	std::string content(data, size);
+	free(data);
+
+	return content;
+}
+
+TEST_CASE("download_cache", "[core][download_cache]")
+{
+	enum { NR_FILES = 2 };
+	const char *names[NR_FILES] = { "/model.bin", "/weights.bin" };
+	std::string urls[NR_FILES];
+	const char *url_ptrs[NR_FILES];
+	char download_paths[NR_FILES][PATH_MAX];
+	const char *download_ptrs[NR_FILES];
+	struct vaccel_download_cache_stats stats;
+	char *root_dir;
+	char cache_dir[PATH_MAX];
+	char dl_dir[PATH_MAX];
+
+	HttpServer server;
+
+	/* Downloads outlive rundirs, which change with every bootstrap */
+	char root_base[] = "/tmp/vaccel_test_download_cache";
+	REQUIRE(fs_dir_create_unique(root_base, 0, &root_dir) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(cache_dir, PATH_MAX, root_dir, "cache",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(dl_dir, PATH_MAX, root_dir, "downloads",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(fs_dir_create(dl_dir) == VACCEL_OK);
+
+	REQUIRE(cache_bootstrap(cache_dir, 0) == VACCEL_OK);
+
+	for (int i = 0; i < NR_FILES; i++) {
+		urls[i] = server.url(names[i]);
+		url_ptrs[i] = urls[i].c_str();
+		REQUIRE(path_init_from_parts(download_paths[i], PATH_MAX,
+					     dl_dir, names[i] + 1,
+					     nullptr) == VACCEL_OK);
+		download_ptrs[i] = download_paths[i];
+	}
+
+	auto download = [&]() -> int {
+		int const ret = download_cache_files_download(
+			url_ptrs, download_ptrs, NR_FILES);
+		if (ret)
+			return ret;
+
+		for (int i = 0; i < NR_FILES; i++) {
+			REQUIRE(file_content(download_paths[i]) ==
+				server.content(names[i]));
+			REQUIRE(fs_file_remove(download_paths[i]) ==
+				VACCEL_OK);
+		}
+		return VACCEL_OK;
+	};
+
+#ifdef USE_LIBCURL
+	/* Files are downloaded and kept */
+	REQUIRE(download() == VACCEL_OK);
+	REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+	REQUIRE(stats.misses == NR_FILES);
+	REQUIRE(stats.hits == 0);
+	REQUIRE(stats.nr_files == NR_FILES);
+	size_t const size = stats.size;
+	REQUIRE(size > 0);
+
+	SECTION("reused across runs")
+	{
+		/* Kept files survive a restart and are revalidated instead
+		 * of downloaded */
+		REQUIRE(cache_bootstrap(cache_dir, 0) == VACCEL_OK);
+		REQUIRE(download() == VACCEL_OK);
+		REQUIRE(server.nr_not_modified == NR_FILES);
+
+		REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+		REQUIRE(stats.hits == NR_FILES);
+		REQUIRE(stats.misses == 0);
+		REQUIRE(stats.nr_files == NR_FILES);
+	}
+
+	SECTION("written files")
+	{
+		/* Served files are copies, so writing to them leaves the kept
+		 * ones intact */
+		REQUIRE(download_cache_files_download(url_ptrs, download_ptrs,
+						      NR_FILES) == VACCEL_OK);
+		for (auto &download_path : download_paths) {
+			FILE *fp = fopen(download_path, "wb");
+			REQUIRE(fp != nullptr);
+			REQUIRE(fputs("overwritten", fp) >= 0);
+			REQUIRE(fclose(fp) == 0);
+			REQUIRE(fs_file_remove(download_path) == VACCEL_OK);
+		}
+
+		REQUIRE(download() == VACCEL_OK);
+		REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+		REQUIRE(stats.hits == 2 * NR_FILES);
+		REQUIRE(stats.size == size);
+	}
+
+	SECTION("modified files")
+	{
+		/* New versions replace the kept ones */
+		server.modify();
+		REQUIRE(download() == VACCEL_OK);
+		REQUIRE(server.nr_not_modified == 0);
+
+		REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+		REQUIRE(stats.misses == 2 * NR_FILES);
+		REQUIRE(stats.nr_files == NR_FILES);
+	}
+
+	SECTION("size limit")
+	{
+		/* Least recently used files are evicted to fit */
+		REQUIRE(cache_bootstrap(cache_dir, size - 1) == VACCEL_OK);
+		REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+		REQUIRE(stats.evictions == 1);
+		REQUIRE(stats.nr_files == NR_FILES - 1);
+
+		/* and are downloaded again */
+		REQUIRE(download() == VACCEL_OK);
+		REQUIRE(server.nr_not_modified == NR_FILES - 1);
+		REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+		REQUIRE(stats.hits == NR_FILES - 1);
+		REQUIRE(stats.misses == 1);
+	}
+
+	SECTION("files without validators")
+	{
+		/* can't be revalidated, so they are not kept */
+		std::string const url = server.url("/novalidators.bin");
+		const char *url_ptr = url.c_str();
+		REQUIRE(download_cache_files_download(
+				&url_ptr, download_ptrs, 1) == VACCEL_OK);
+		REQUIRE(fs_file_remove(download_paths[0]) == VACCEL_OK);
+
+		REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+		REQUIRE(stats.misses == NR_FILES + 1);
+		REQUIRE(stats.nr_files == NR_FILES);
+	}
+
+	SECTION("failed download")
+	{
+		std::string const url = server.url("/missing");
+		url_ptrs[NR_FILES - 1] = url.c_str();
+		REQUIRE(download_cache_files_download(url_ptrs, download_ptrs,
+						      NR_FILES) ==
+			VACCEL_EREMOTEIO);
+
+		/* No file is left behind */
+		for (auto &path : download_paths)
+			REQUIRE_FALSE(fs_path_exists(path));
+	}
+#else
+	REQUIRE(download() == VACCEL_ENOTSUP);
+	REQUIRE(vaccel_download_cache_stats(&stats) == VACCEL_OK);
+	REQUIRE(stats.nr_files == 0);
+#endif
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_download_cache_stats(nullptr) == VACCEL_EINVAL);
+		REQUIRE(download_cache_files_download(nullptr, download_ptrs,
+						      NR_FILES) ==
+			VACCEL_EINVAL);
+		REQUIRE(download_cache_files_download(url_ptrs, download_ptrs,
+						      0) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(fs_dir_remove(dl_dir) == VACCEL_OK);
+	REQUIRE(fs_dir_remove_all(root_dir) == VACCEL_OK);
+	free(root_dir);
+
+	/* Drop the cache config */
+	REQUIRE(vaccel_bootstrap() == VACCEL_OK);
+}
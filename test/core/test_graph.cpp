@@ -0,0 +1,279 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to op graphs.
+ *
+ * 1) vaccel_graph_init()
+ * 2) vaccel_graph_release()
+ * 3) vaccel_graph_new()
+ * 4) vaccel_graph_delete()
+ * 5) vaccel_graph_add_node()
+ * 6) vaccel_graph_connect()
+ * 7) vaccel_graph_depend()
+ * 8) vaccel_graph_run()
+ *
+ */
+
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <vector>
+
+/* Exec node args; the noop plugin copies the input to the output */
+struct exec_node {
+	struct vaccel_arg read[4];
+	struct vaccel_arg write;
+	int32_t input;
+	int32_t output;
+};
+
+static uint8_t exec_op_type = VACCEL_OP_EXEC;
+static char exec_lib[] = "lib.so";
+static char exec_fn[] = "func";
+
+static void exec_node_init(struct exec_node *node, int32_t input)
+{
+	node->input = input;
+	node->output = 0;
+	REQUIRE(vaccel_arg_init_from_buf(&node->read[0], &exec_op_type,
+					 sizeof(exec_op_type),
+					 VACCEL_ARG_UINT8, 0) == VACCEL_OK);
+	REQUIRE(vaccel_arg_init_from_buf(&node->read[1], exec_lib,
+					 sizeof(exec_lib), VACCEL_ARG_STRING,
+					 0) == VACCEL_OK);
+	REQUIRE(vaccel_arg_init_from_buf(&node->read[2], exec_fn,
+					 sizeof(exec_fn), VACCEL_ARG_STRING,
+					 0) == VACCEL_OK);
+	REQUIRE(vaccel_arg_init_from_buf(&node->read[3], &node->input,
+					 sizeof(node->input), VACCEL_ARG_INT32,
+					 0) == VACCEL_OK);
+	REQUIRE(vaccel_arg_init_from_buf(&node->write, &node->output,
+					 sizeof(node->output), VACCEL_ARG_INT32,
+					 0) == VACCEL_OK);
+}
+
+static auto exec_node_add(struct vaccel_graph *graph, struct exec_node *node)
+	-> size_t
+{
+	size_t id = SIZE_MAX;
+	REQUIRE(vaccel_graph_add_node(graph, node->read, 4, &node->write, 1,
+				      &id) == VACCEL_OK);
+	return id;
+}
+
+TEST_CASE("vaccel_graph_init", "[core][graph]")
+{
+	struct vaccel_graph graph;
+
+	REQUIRE(vaccel_graph_init(&graph) == VACCEL_OK);
+	REQUIRE(graph.nodes == nullptr);
+	REQUIRE(graph.nr_nodes == 0);
+	REQUIRE(graph.edges == nullptr);
+	REQUIRE(graph.nr_edges == 0);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_graph_init(nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_release(nullptr) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_graph_release(&graph) == VACCEL_OK);
+}
+
+TEST_CASE("vaccel_graph_new", "[core][graph]")
+{
+	struct vaccel_graph *graph = nullptr;
+
+	REQUIRE(vaccel_graph_new(&graph) == VACCEL_OK);
+	REQUIRE(graph != nullptr);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_graph_new(nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_delete(nullptr) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_graph_delete(graph) == VACCEL_OK);
+}
+
+TEST_CASE("vaccel_graph_add_node", "[core][graph]")
+{
+	struct vaccel_graph graph;
+	struct exec_node a;
+	struct exec_node b;
+
+	REQUIRE(vaccel_graph_init(&graph) == VACCEL_OK);
+	exec_node_init(&a, 1);
+	exec_node_init(&b, 2);
+
+	const size_t id_a = exec_node_add(&graph, &a);
+	const size_t id_b = exec_node_add(&graph, &b);
+	REQUIRE(id_a == 0);
+	REQUIRE(id_b == 1);
+	REQUIRE(graph.nr_nodes == 2);
+
+	/* The graph keeps its own read arg descriptors */
+	REQUIRE(graph.nodes[id_a].read != a.read);
+	REQUIRE(graph.nodes[id_a].read[3].buf == &a.input);
+
+	SECTION("connect")
+	{
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 0, id_b, 3) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_graph_depend(&graph, id_a, id_b) == VACCEL_OK);
+		REQUIRE(graph.nr_edges == 2);
+		REQUIRE(graph.edges[1].src_write == -1);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_graph_add_node(nullptr, a.read, 4, &a.write, 1,
+					      nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_add_node(&graph, nullptr, 4, &a.write, 1,
+					      nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_add_node(&graph, a.read, 4, nullptr, 1,
+					      nullptr) == VACCEL_EINVAL);
+
+		/* Out of range args, the op type or unknown nodes */
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 1, id_b, 3) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 0, id_b, 4) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 0, id_b, 0) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 0, 2, 3) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_depend(&graph, id_a, id_a) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_depend(nullptr, id_a, id_b) ==
+			VACCEL_EINVAL);
+		REQUIRE(graph.nr_edges == 0);
+	}
+
+	REQUIRE(vaccel_graph_release(&graph) == VACCEL_OK);
+}
+
+TEST_CASE("vaccel_graph_run", "[core][graph]")
+{
+	struct vaccel_session sess;
+	struct vaccel_graph graph;
+
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+	REQUIRE(vaccel_graph_init(&graph) == VACCEL_OK);
+
+	SECTION("diamond")
+	{
+		/* a -> (b, c) -> d, with outputs passed by reference */
+		struct exec_node a;
+		struct exec_node b;
+		struct exec_node c;
+		struct exec_node d;
+		exec_node_init(&a, 7);
+		exec_node_init(&b, 0);
+		exec_node_init(&c, 0);
+		exec_node_init(&d, 0);
+
+		const size_t id_a = exec_node_add(&graph, &a);
+		const size_t id_b = exec_node_add(&graph, &b);
+		const size_t id_c = exec_node_add(&graph, &c);
+		const size_t id_d = exec_node_add(&graph, &d);
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 0, id_b, 3) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_graph_connect(&graph, id_a, 0, id_c, 3) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_graph_connect(&graph, id_b, 0, id_d, 3) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_graph_depend(&graph, id_c, id_d) == VACCEL_OK);
+
+		REQUIRE(vaccel_graph_run(&sess, &graph) == VACCEL_OK);
+		for (size_t i = 0; i < graph.nr_nodes; i++)
+			REQUIRE(graph.nodes[i].ret == VACCEL_OK);
+		REQUIRE(a.output == 7);
+		REQUIRE(b.output == 7);
+		REQUIRE(c.output == 7);
+		REQUIRE(d.output == 7);
+
+		/* Caller's arg arrays are not rewired */
+		REQUIRE(b.read[3].buf == &b.input);
+		REQUIRE(b.input == 0);
+
+		/* Graphs can be run again */
+		a.input = 9;
+		REQUIRE(vaccel_graph_run(&sess, &graph) == VACCEL_OK);
+		REQUIRE(d.output == 9);
+	}
+
+	SECTION("wide")
+	{
+		const size_t nr_nodes = 64;
+		std::vector<struct exec_node> nodes(nr_nodes + 1);
+		std::vector<size_t> ids(nr_nodes + 1);
+
+		for (size_t i = 0; i <= nr_nodes; i++) {
+			exec_node_init(&nodes[i], (int32_t)i);
+			ids[i] = exec_node_add(&graph, &nodes[i]);
+		}
+		for (size_t i = 0; i < nr_nodes; i++)
+			REQUIRE(vaccel_graph_depend(&graph, ids[i],
+						    ids[nr_nodes]) ==
+				VACCEL_OK);
+
+		REQUIRE(vaccel_graph_run(&sess, &graph) == VACCEL_OK);
+		for (size_t i = 0; i <= nr_nodes; i++) {
+			REQUIRE(graph.nodes[ids[i]].ret == VACCEL_OK);
+			REQUIRE(nodes[i].output == (int32_t)i);
+		}
+	}
+
+	SECTION("failed node")
+	{
+		/* A minmax node with missing args fails when run */
+		uint8_t minmax_op_type = VACCEL_OP_MINMAX;
+		struct vaccel_arg minmax_read;
+		REQUIRE(vaccel_arg_init_from_buf(&minmax_read, &minmax_op_type,
+						 sizeof(minmax_op_type),
+						 VACCEL_ARG_UINT8,
+						 0) == VACCEL_OK);
+		size_t id_f = SIZE_MAX;
+		REQUIRE(vaccel_graph_add_node(&graph, &minmax_read, 1, nullptr,
+					      0, &id_f) == VACCEL_OK);
+
+		struct exec_node g;
+		exec_node_init(&g, 5);
+		const size_t id_g = exec_node_add(&graph, &g);
+		REQUIRE(vaccel_graph_depend(&graph, id_f, id_g) == VACCEL_OK);
+
+		REQUIRE(vaccel_graph_run(&sess, &graph) == VACCEL_EINVAL);
+		REQUIRE(graph.nodes[id_f].ret == VACCEL_EINVAL);
+		REQUIRE(graph.nodes[id_g].ret == VACCEL_ECANCELED);
+		REQUIRE(g.output == 0);
+	}
+
+	SECTION("cycle")
+	{
+		struct exec_node a;
+		struct exec_node b;
+		exec_node_init(&a, 1);
+		exec_node_init(&b, 2);
+
+		const size_t id_a = exec_node_add(&graph, &a);
+		const size_t id_b = exec_node_add(&graph, &b);
+		REQUIRE(vaccel_graph_depend(&graph, id_a, id_b) == VACCEL_OK);
+		REQUIRE(vaccel_graph_depend(&graph, id_b, id_a) == VACCEL_OK);
+
+		REQUIRE(vaccel_graph_run(&sess, &graph) == VACCEL_EINVAL);
+		REQUIRE(graph.nodes[id_a].ret == VACCEL_ECANCELED);
+		REQUIRE(graph.nodes[id_b].ret == VACCEL_ECANCELED);
+		REQUIRE(a.output == 0);
+		REQUIRE(b.output == 0);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_graph_run(nullptr, &graph) == VACCEL_EINVAL);
+		REQUIRE(vaccel_graph_run(&sess, nullptr) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_graph_release(&graph) == VACCEL_OK);
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+}
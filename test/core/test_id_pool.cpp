@@ -10,16 +10,22 @@
  * 5) id_pool_get()
  * 6) id_pool_put()
  *
+ * It also checks the pool grows on demand and includes a multi-threaded
+ * allocation throughput benchmark.
+ *
  */
 
 #include "vaccel.h"
+#include <atomic>
 #include <bits/pthreadtypes.h>
 #include <catch2/catch_test_macros.hpp>
+#include <chrono>
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
 #include <pthread.h>
 #include <unistd.h>
+#include <vector>
 
 enum { TEST_IDS_MAX = 100 };
 
@@ -27,12 +33,12 @@ enum { TEST_IDS_MAX = 100 };
 TEST_CASE("id_pool_init", "[core][id_pool]")
 {
 	id_pool_t test_pool;
-	test_pool.ids = nullptr;
+	test_pool.dirs = nullptr;
 
 	SECTION("success")
 	{
 		REQUIRE(id_pool_init(&test_pool, TEST_IDS_MAX) == VACCEL_OK);
-		REQUIRE(test_pool.ids != nullptr);
+		REQUIRE(test_pool.dirs != nullptr);
 		REQUIRE(test_pool.max == TEST_IDS_MAX);
 		REQUIRE(test_pool.last == 0);
 		REQUIRE(id_pool_release(&test_pool) == VACCEL_OK);
@@ -49,7 +55,7 @@ TEST_CASE("id_pool_init", "[core][id_pool]")
 TEST_CASE("id_pool_release", "[core][id_pool]")
 {
 	id_pool_t test_pool;
-	test_pool.ids = nullptr;
+	test_pool.dirs = nullptr;
 
 	SECTION("success")
 	{
@@ -72,7 +78,7 @@ TEST_CASE("id_pool_new", "[core][id_pool]")
 	{
 		REQUIRE(id_pool_new(&test_pool, TEST_IDS_MAX) == VACCEL_OK);
 		REQUIRE(test_pool != nullptr);
-		REQUIRE(test_pool->ids != nullptr);
+		REQUIRE(test_pool->dirs != nullptr);
 		REQUIRE(test_pool->max == TEST_IDS_MAX);
 		REQUIRE(test_pool->last == 0);
 		REQUIRE(id_pool_delete(test_pool) == VACCEL_OK);
@@ -377,6 +383,78 @@ TEST_CASE("id_pool_get_and_put", "[core][id_pool]")
 	REQUIRE(id_pool_release(&test_pool) == VACCEL_OK);
 }
 
+// Grow the pool past its first chunk
+TEST_CASE("id_pool_grow", "[core][id_pool]")
+{
+	const vaccel_id_t max_ids = (2 * ID_POOL_CHUNK_IDS) + 10;
+	id_pool_t test_pool;
+	REQUIRE(id_pool_init(&test_pool, max_ids) == VACCEL_OK);
+
+	// Only the first chunk is available initially
+	REQUIRE(test_pool.size == ID_POOL_CHUNK_IDS);
+
+	for (vaccel_id_t i = 1; i <= ID_POOL_CHUNK_IDS; i++)
+		REQUIRE(id_pool_get(&test_pool) == i);
+	REQUIRE(test_pool.size == ID_POOL_CHUNK_IDS);
+
+	SECTION("reuse before growing")
+	{
+		REQUIRE(id_pool_put(&test_pool, 7) == VACCEL_OK);
+		REQUIRE(id_pool_get(&test_pool) == 7);
+		REQUIRE(test_pool.size == ID_POOL_CHUNK_IDS);
+
+		// Ids of chunks not allocated yet can't be returned
+		REQUIRE(id_pool_put(&test_pool, ID_POOL_CHUNK_IDS + 1) ==
+			VACCEL_EINVAL);
+	}
+
+	SECTION("grow to max")
+	{
+		for (vaccel_id_t i = ID_POOL_CHUNK_IDS + 1; i <= max_ids; i++)
+			REQUIRE(id_pool_get(&test_pool) == i);
+		REQUIRE(test_pool.size == max_ids);
+		REQUIRE(id_pool_get(&test_pool) == -VACCEL_EUSERS);
+
+		// Ids of all the chunks can be returned and reused
+		REQUIRE(id_pool_put(&test_pool, 3) == VACCEL_OK);
+		REQUIRE(id_pool_put(&test_pool, max_ids) == VACCEL_OK);
+		REQUIRE(id_pool_get(&test_pool) == 3);
+		REQUIRE(id_pool_get(&test_pool) == max_ids);
+	}
+
+	REQUIRE(id_pool_release(&test_pool) == VACCEL_OK);
+}
+
+TEST_CASE("id_pool_grow_dirs", "[core][id_pool]")
+{
+	const vaccel_id_t dir_ids =
+		(vaccel_id_t)ID_POOL_DIR_CHUNKS * ID_POOL_CHUNK_IDS;
+	const vaccel_id_t max_ids = dir_ids + 10;
+	id_pool_t test_pool;
+	REQUIRE(id_pool_init(&test_pool, max_ids) == VACCEL_OK);
+
+	// Growing past the first block of the chunk directory
+	vaccel_id_t last = 0;
+	for (vaccel_id_t i = 1; i <= dir_ids + 1; i++) {
+		last = id_pool_get(&test_pool);
+		if (last != i)
+			break;
+	}
+	REQUIRE(last == dir_ids + 1);
+
+	for (vaccel_id_t i = dir_ids + 2; i <= max_ids; i++)
+		REQUIRE(id_pool_get(&test_pool) == i);
+	REQUIRE(id_pool_get(&test_pool) == -VACCEL_EUSERS);
+
+	// Ids of both blocks can be returned and reused
+	REQUIRE(id_pool_put(&test_pool, 1) == VACCEL_OK);
+	REQUIRE(id_pool_put(&test_pool, dir_ids + 1) == VACCEL_OK);
+	REQUIRE(id_pool_get(&test_pool) == 1);
+	REQUIRE(id_pool_get(&test_pool) == dir_ids + 1);
+
+	REQUIRE(id_pool_release(&test_pool) == VACCEL_OK);
+}
+
 enum { TEST_THREADS_NUM = 50, TEST_THREAD_IDS_NUM = 20 };
 
 struct thread_data {
@@ -424,3 +502,116 @@ TEST_CASE("id_pool_get_and_put_concurrent", "[core][id_pool]")
 
 	REQUIRE(id_pool_release(&test_pool) == VACCEL_OK);
 }
+
+enum {
+	BENCH_IDS_MAX = 4096,
+	BENCH_THREADS_MAX = 16,
+	BENCH_ITERATIONS = 100000,
+	BENCH_HELD_IDS = 8,
+	BENCH_FREE_STRIDE = 16
+};
+
+struct bench_data {
+	id_pool_t *pool;
+	std::atomic<int> *owners;
+	int id;
+	bool ok;
+};
+
+static auto bench_ids(void *arg) -> void *
+{
+	auto *data = (struct bench_data *)arg;
+	vaccel_id_t held[BENCH_HELD_IDS] = { 0 };
+
+	/* Keep a few ids per thread so the pool is churned, not just
+	 * ping-ponged on one id */
+	for (int i = 0; i < BENCH_ITERATIONS && data->ok; i++) {
+		vaccel_id_t &slot = held[i % BENCH_HELD_IDS];
+
+		if (slot) {
+			data->owners[slot - 1].store(-1);
+			if (id_pool_put(data->pool, slot) != VACCEL_OK)
+				data->ok = false;
+		}
+
+		slot = id_pool_get(data->pool);
+		if (slot <= 0) {
+			data->ok = false;
+			break;
+		}
+
+		/* Every id must have exactly one owner */
+		int expected = -1;
+		if (!data->owners[slot - 1].compare_exchange_strong(expected,
+								    data->id))
+			data->ok = false;
+	}
+
+	for (vaccel_id_t const id : held) {
+		if (id > 0) {
+			data->owners[id - 1].store(-1);
+			id_pool_put(data->pool, id);
+		}
+	}
+
+	return nullptr;
+}
+
+// Measure concurrent allocation/free throughput
+TEST_CASE("id_pool_get_and_put_throughput", "[core][id_pool]")
+{
+	id_pool_t test_pool;
+	REQUIRE(id_pool_init(&test_pool, BENCH_IDS_MAX) == VACCEL_OK);
+
+	std::vector<std::atomic<int> > owners(BENCH_IDS_MAX);
+	for (auto &o : owners)
+		o.store(-1);
+
+	/* Keep most of the pool in use, with the free ids scattered */
+	std::vector<vaccel_id_t> used;
+	for (vaccel_id_t i = 0; i < BENCH_IDS_MAX; i++) {
+		vaccel_id_t const id = id_pool_get(&test_pool);
+		REQUIRE(id > 0);
+		owners[id - 1].store(BENCH_THREADS_MAX);
+		used.push_back(id);
+	}
+	for (vaccel_id_t const id : used) {
+		if (id % BENCH_FREE_STRIDE == 0) {
+			owners[id - 1].store(-1);
+			REQUIRE(id_pool_put(&test_pool, id) == VACCEL_OK);
+		}
+	}
+
+	for (int nr_threads = 1; nr_threads <= BENCH_THREADS_MAX;
+	     nr_threads *= 2) {
+		std::vector<pthread_t> threads(nr_threads);
+		std::vector<struct bench_data> data(nr_threads);
+
+		auto start = std::chrono::steady_clock::now();
+		for (int i = 0; i < nr_threads; i++) {
+			data[i] = { &test_pool, owners.data(), i, true };
+			pthread_create(&threads[i], nullptr, bench_ids,
+				       &data[i]);
+		}
+		for (auto const thread : threads)
+			pthread_join(thread, nullptr);
+		auto elapsed = std::chrono::duration<double>(
+				       std::chrono::steady_clock::now() - start)
+				       .count();
+
+		for (auto const &d : data)
+			REQUIRE(d.ok);
+
+		printf("%2d threads, %d/%d ids free: %.0f get/put pairs/s\n",
+		       nr_threads, BENCH_IDS_MAX / BENCH_FREE_STRIDE,
+		       BENCH_IDS_MAX,
+		       (double)nr_threads * BENCH_ITERATIONS / elapsed);
+	}
+
+	for (vaccel_id_t const id : used) {
+		if (id % BENCH_FREE_STRIDE != 0)
+			REQUIRE(id_pool_put(&test_pool, id) == VACCEL_OK);
+	}
+
+	REQUIRE(id_pool_release(&test_pool) == VACCEL_OK);
+}
@@ -0,0 +1,153 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to id_table.
+ *
+ * 1) id_table_init()
+ * 2) id_table_release()
+ * 3) id_table_id()
+ * 4) id_table_set()
+ * 5) id_table_clear()
+ * 6) id_table_get()
+ *
+ */
+
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+
+enum { TEST_IDS_MAX = 100 };
+
+TEST_CASE("id_table_init", "[core][id_table]")
+{
+	id_table_t table;
+
+	SECTION("success")
+	{
+		REQUIRE(id_table_init(&table, TEST_IDS_MAX) == VACCEL_OK);
+		REQUIRE(table.dirs != nullptr);
+		REQUIRE(table.size == TEST_IDS_MAX);
+		REQUIRE(id_table_release(&table) == VACCEL_OK);
+		REQUIRE(table.dirs == nullptr);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(id_table_init(&table, 0) == VACCEL_EINVAL);
+		REQUIRE(id_table_init(nullptr, TEST_IDS_MAX) == VACCEL_EINVAL);
+		REQUIRE(id_table_release(nullptr) == VACCEL_EINVAL);
+	}
+}
+
+TEST_CASE("id_table_get", "[core][id_table]")
+{
+	id_table_t table;
+	int obj1 = 1;
+	int obj2 = 2;
+
+	REQUIRE(id_table_init(&table, TEST_IDS_MAX) == VACCEL_OK);
+
+	/* First generation ids are the slots themselves */
+	const vaccel_id_t id1 = id_table_id(&table, 1);
+	REQUIRE(id1 == 1);
+	REQUIRE(id_table_slot(id1) == 1);
+
+	REQUIRE(id_table_get(&table, id1) == nullptr);
+	REQUIRE(id_table_set(&table, id1, &obj1) == VACCEL_OK);
+	REQUIRE(id_table_get(&table, id1) == &obj1);
+
+	SECTION("stale id")
+	{
+		REQUIRE(id_table_clear(&table, id1) == VACCEL_OK);
+		REQUIRE(id_table_get(&table, id1) == nullptr);
+
+		/* Reusing the slot gives a new id */
+		const vaccel_id_t id2 = id_table_id(&table, 1);
+		REQUIRE(id2 != id1);
+		REQUIRE(id2 > 0);
+		REQUIRE(id_table_slot(id2) == 1);
+		REQUIRE(id_table_set(&table, id2, &obj2) == VACCEL_OK);
+
+		REQUIRE(id_table_get(&table, id2) == &obj2);
+		REQUIRE(id_table_get(&table, id1) == nullptr);
+		REQUIRE(id_table_set(&table, id1, &obj1) == VACCEL_EINVAL);
+		REQUIRE(id_table_clear(&table, id1) == VACCEL_ENOENT);
+		REQUIRE(id_table_get(&table, id2) == &obj2);
+	}
+
+	SECTION("busy slot")
+	{
+		REQUIRE(id_table_set(&table, id1, &obj2) == VACCEL_EBUSY);
+		REQUIRE(id_table_get(&table, id1) == &obj1);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(id_table_id(&table, TEST_IDS_MAX + 1) ==
+			-VACCEL_EINVAL);
+		REQUIRE(id_table_id(&table, -VACCEL_EUSERS) == -VACCEL_EUSERS);
+		REQUIRE(id_table_set(&table, 2, nullptr) == VACCEL_EINVAL);
+		REQUIRE(id_table_set(&table, TEST_IDS_MAX + 1, &obj1) ==
+			VACCEL_EINVAL);
+		REQUIRE(id_table_clear(&table, 0) == VACCEL_EINVAL);
+		REQUIRE(id_table_get(&table, 0) == nullptr);
+		REQUIRE(id_table_get(&table, -1) == nullptr);
+		REQUIRE(id_table_get(&table, TEST_IDS_MAX + 1) == nullptr);
+		REQUIRE(id_table_get(nullptr, id1) == nullptr);
+	}
+
+	REQUIRE(id_table_release(&table) == VACCEL_OK);
+}
+
+TEST_CASE("id_table_grow", "[core][id_table]")
+{
+	const vaccel_id_t size = (2 * ID_TABLE_CHUNK_ENTRIES) + 10;
+	id_table_t table;
+	int obj1 = 1;
+	int obj2 = 2;
+
+	REQUIRE(id_table_init(&table, size) == VACCEL_OK);
+
+	/* Slots of chunks not allocated yet are valid and empty */
+	const vaccel_id_t id1 = id_table_id(&table, size);
+	REQUIRE(id1 == size);
+	REQUIRE(id_table_get(&table, id1) == nullptr);
+	REQUIRE(id_table_clear(&table, id1) == VACCEL_ENOENT);
+
+	REQUIRE(id_table_set(&table, id1, &obj1) == VACCEL_OK);
+	REQUIRE(id_table_get(&table, id1) == &obj1);
+
+	/* Other chunks are not affected */
+	const vaccel_id_t id2 = id_table_id(&table, ID_TABLE_CHUNK_ENTRIES);
+	REQUIRE(id_table_get(&table, id2) == nullptr);
+	REQUIRE(id_table_set(&table, id2, &obj2) == VACCEL_OK);
+	REQUIRE(id_table_get(&table, id2) == &obj2);
+	REQUIRE(id_table_get(&table, id1) == &obj1);
+
+	REQUIRE(id_table_clear(&table, id1) == VACCEL_OK);
+	REQUIRE(id_table_get(&table, id1) == nullptr);
+	REQUIRE(id_table_id(&table, size) != id1);
+
+	REQUIRE(id_table_release(&table) == VACCEL_OK);
+}
+
+TEST_CASE("id_table_grow_max", "[core][id_table]")
+{
+	const vaccel_id_t size = ID_TABLE_SLOT_MASK;
+	id_table_t table;
+	int obj1 = 1;
+	int obj2 = 2;
+
+	/* Only the chunk directory is allocated for the maximum size */
+	REQUIRE(id_table_init(&table, size) == VACCEL_OK);
+
+	const vaccel_id_t id1 = id_table_id(&table, 1);
+	const vaccel_id_t id2 = id_table_id(&table, size);
+	REQUIRE(id_table_get(&table, id2) == nullptr);
+	REQUIRE(id_table_set(&table, id1, &obj1) == VACCEL_OK);
+	REQUIRE(id_table_set(&table, id2, &obj2) == VACCEL_OK);
+	REQUIRE(id_table_get(&table, id1) == &obj1);
+	REQUIRE(id_table_get(&table, id2) == &obj2);
+
+	REQUIRE(id_table_release(&table) == VACCEL_OK);
+}
@@ -0,0 +1,141 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to the model cache.
+ *
+ * 1) vaccel_model_cache_get()
+ * 2) vaccel_model_cache_add()
+ * 3) vaccel_model_cache_put()
+ * 4) vaccel_model_cache_set_budget()
+ * 5) vaccel_model_cache_stats()
+ *
+ */
+
+#include "utils.hpp"
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+
+static int unloaded;
+
+static void unload_model(void *model)
+{
+	(void)model;
+	unloaded++;
+}
+
+static int owner;
+
+TEST_CASE("vaccel_model_cache", "[core][model_cache]")
+{
+	char *lib_path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	struct vaccel_resource res;
+	struct vaccel_session sess1;
+	struct vaccel_session sess2;
+	struct vaccel_model_cache_stats before;
+	struct vaccel_model_cache_stats after;
+	int model;
+	void *cached = nullptr;
+
+	unloaded = 0;
+	REQUIRE(vaccel_resource_init(&res, lib_path, VACCEL_RESOURCE_LIB) ==
+		VACCEL_OK);
+	REQUIRE(vaccel_session_init(&sess1, 0) == VACCEL_OK);
+	REQUIRE(vaccel_session_init(&sess2, 0) == VACCEL_OK);
+	REQUIRE(vaccel_resource_register(&res, &sess1) == VACCEL_OK);
+	REQUIRE(vaccel_model_cache_stats(&before) == VACCEL_OK);
+
+	/* The first session loads the model */
+	REQUIRE(vaccel_model_cache_get(&res, &owner, &cached) ==
+		VACCEL_ENOENT);
+	REQUIRE(vaccel_model_cache_add(&res, &owner, &model, 100,
+				       unload_model) == VACCEL_OK);
+	REQUIRE(vaccel_model_cache_add(&res, &owner, &model, 100,
+				       unload_model) == VACCEL_EEXIST);
+
+	SECTION("shared across sessions")
+	{
+		REQUIRE(vaccel_resource_register(&res, &sess2) == VACCEL_OK);
+		REQUIRE(vaccel_model_cache_put(&res, &owner) == VACCEL_OK);
+
+		/* and later sessions reuse it while the resource is
+		 * registered */
+		REQUIRE(vaccel_model_cache_get(&res, &owner, &cached) ==
+			VACCEL_OK);
+		REQUIRE(cached == &model);
+		REQUIRE(vaccel_model_cache_put(&res, &owner) == VACCEL_OK);
+		REQUIRE(vaccel_resource_unregister(&res, &sess1) == VACCEL_OK);
+		REQUIRE(unloaded == 0);
+
+		/* Other owners have models of their own */
+		REQUIRE(vaccel_model_cache_get(&res, nullptr, &cached) ==
+			VACCEL_ENOENT);
+
+		REQUIRE(vaccel_model_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.hits - before.hits == 1);
+		REQUIRE(after.misses - before.misses == 2);
+		REQUIRE(after.nr_models == before.nr_models + 1);
+		REQUIRE(after.size == before.size + 100);
+
+		/* The model is unloaded with the last registration */
+		REQUIRE(vaccel_resource_unregister(&res, &sess2) == VACCEL_OK);
+		REQUIRE(unloaded == 1);
+		REQUIRE(vaccel_model_cache_get(&res, &owner, &cached) ==
+			VACCEL_ENOENT);
+	}
+
+	SECTION("budget")
+	{
+		struct vaccel_resource res2;
+		int model2;
+
+		REQUIRE(vaccel_resource_init(&res2, lib_path,
+					     VACCEL_RESOURCE_LIB) == VACCEL_OK);
+		REQUIRE(vaccel_resource_register(&res2, &sess1) == VACCEL_OK);
+		REQUIRE(vaccel_model_cache_add(&res2, &owner, &model2, 100,
+					       unload_model) == VACCEL_OK);
+		REQUIRE(vaccel_model_cache_put(&res2, &owner) == VACCEL_OK);
+
+		/* Only models with no references are evicted, least recently
+		 * used first */
+		REQUIRE(vaccel_model_cache_set_budget(150) == VACCEL_OK);
+		REQUIRE(unloaded == 1);
+		REQUIRE(vaccel_model_cache_get(&res2, &owner, &cached) ==
+			VACCEL_ENOENT);
+		REQUIRE(vaccel_model_cache_get(&res, &owner, &cached) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_model_cache_put(&res, &owner) == VACCEL_OK);
+
+		REQUIRE(vaccel_model_cache_stats(&after) == VACCEL_OK);
+		REQUIRE(after.evictions - before.evictions == 1);
+		REQUIRE(vaccel_model_cache_set_budget(0) == VACCEL_OK);
+
+		REQUIRE(vaccel_resource_release(&res2) == VACCEL_OK);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_model_cache_get(nullptr, &owner, &cached) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_model_cache_get(&res, &owner, nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_model_cache_add(nullptr, &owner, &model, 0,
+					       nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_model_cache_add(&res, &owner, nullptr, 0,
+					       nullptr) == VACCEL_EINVAL);
+		REQUIRE(vaccel_model_cache_put(nullptr, &owner) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_model_cache_put(&res, nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_model_cache_stats(nullptr) == VACCEL_EINVAL);
+	}
+
+	/* Releasing the resource unloads its models, referenced or not */
+	REQUIRE(vaccel_session_release(&sess1) == VACCEL_OK);
+	REQUIRE(vaccel_session_release(&sess2) == VACCEL_OK);
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+	REQUIRE(vaccel_model_cache_get(&res, &owner, &cached) ==
+		VACCEL_ENOENT);
+
+	free(lib_path);
+}
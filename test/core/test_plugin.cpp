@@ -9,10 +9,11 @@
  * 4) vaccel_plugin_register_ops()
  * 5) vaccel_plugin_register_op()
  * 6) plugin_find()
- * 7) plugin_get_op_func()
- * 8) plugin_count()
- * 9) vaccel_plugin_load()
- * 10) vaccel_plugin_parse_and_load()
+ * 7) plugin_route_ops()
+ * 8) plugin_get_op_func()
+ * 9) plugin_count()
+ * 10) vaccel_plugin_load()
+ * 11) vaccel_plugin_parse_and_load()
  *
  */
 
@@ -506,6 +507,80 @@ TEST_CASE("plugin_find", "[core][plugin]")
 	mock_plugin_delete(virtio_plugin);
 }
 
+TEST_CASE("plugin_route_ops", "[core][plugin]")
+{
+	struct vaccel_plugin *op_plugins[VACCEL_OP_MAX];
+
+	struct vaccel_plugin *generic_plugin = mock_plugin_new();
+	REQUIRE(generic_plugin != nullptr);
+
+	struct vaccel_plugin *gpu_plugin = mock_plugin_new();
+	REQUIRE(gpu_plugin != nullptr);
+	gpu_plugin->info->type = VACCEL_PLUGIN_GPU;
+
+	struct vaccel_plugin *virtio_plugin = mock_plugin_new();
+	REQUIRE(virtio_plugin != nullptr);
+	virtio_plugin->info->is_virtio = true;
+
+	SECTION("not_registered")
+	{
+		REQUIRE(plugin_route_ops(0, op_plugins) == 0);
+		for (auto *p : op_plugins)
+			REQUIRE(p == nullptr);
+	}
+
+	REQUIRE(plugin_register(generic_plugin) == VACCEL_OK);
+	REQUIRE(plugin_register(gpu_plugin) == VACCEL_OK);
+	REQUIRE(plugin_register(virtio_plugin) == VACCEL_OK);
+
+	vaccel_op generic_ops[] = {
+		{ .type = VACCEL_OP_NOOP,
+		  .func = (void *)no_op,
+		  .owner = generic_plugin },
+		{ .type = VACCEL_OP_EXEC,
+		  .func = (void *)exec_op,
+		  .owner = generic_plugin },
+	};
+	vaccel_op gpu_ops[] = {
+		{ .type = VACCEL_OP_NOOP,
+		  .func = (void *)no_op,
+		  .owner = gpu_plugin },
+	};
+	vaccel_op virtio_ops[] = {
+		{ .type = VACCEL_OP_IMAGE_CLASSIFY,
+		  .func = (void *)no_op,
+		  .owner = virtio_plugin },
+	};
+	REQUIRE(vaccel_plugin_register_ops(generic_ops, 2) == VACCEL_OK);
+	REQUIRE(vaccel_plugin_register_ops(gpu_ops, 1) == VACCEL_OK);
+	REQUIRE(vaccel_plugin_register_ops(virtio_ops, 1) == VACCEL_OK);
+
+	SECTION("invalid_arguments")
+	{
+		REQUIRE(plugin_route_ops(0, nullptr) == 0);
+	}
+
+	/* No hint: first local plugin implementing each op */
+	REQUIRE(plugin_route_ops(0, op_plugins) == 2);
+	REQUIRE(op_plugins[VACCEL_OP_NOOP] == generic_plugin);
+	REQUIRE(op_plugins[VACCEL_OP_EXEC] == generic_plugin);
+	REQUIRE(op_plugins[VACCEL_OP_IMAGE_CLASSIFY] == nullptr);
+
+	/* Hinted plugin is preferred, others are used as fallback */
+	REQUIRE(plugin_route_ops(VACCEL_PLUGIN_GPU, op_plugins) == 2);
+	REQUIRE(op_plugins[VACCEL_OP_NOOP] == gpu_plugin);
+	REQUIRE(op_plugins[VACCEL_OP_EXEC] == generic_plugin);
+	REQUIRE(op_plugins[VACCEL_OP_IMAGE_CLASSIFY] == nullptr);
+
+	REQUIRE(plugin_unregister(generic_plugin) == VACCEL_OK);
+	REQUIRE(plugin_unregister(gpu_plugin) == VACCEL_OK);
+	REQUIRE(plugin_unregister(virtio_plugin) == VACCEL_OK);
+
+	mock_plugin_delete(generic_plugin);
+	mock_plugin_delete(gpu_plugin);
+	mock_plugin_delete(virtio_plugin);
+}
+
 TEST_CASE("plugin_get_op_func", "[core][plugin]")
 {
 	int ret;
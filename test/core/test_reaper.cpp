@@ -0,0 +1,69 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to the rundir reaper.
+ *
+ * 1) reaper_bury()
+ * 2) reaper_flush()
+ *
+ */
+
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <cstring>
+#include <dirent.h>
+#include <linux/limits.h>
+
+static auto dir_nr_entries(const char *path) -> int
+{
+	DIR *dir = opendir(path);
+	if (dir == nullptr)
+		return -1;
+
+	int nr = 0;
+	struct dirent *entry;
+	while ((entry = readdir(dir)) != nullptr) {
+		if (strcmp(entry->d_name, ".") != 0 &&
+		    strcmp(entry->d_name, "..") != 0)
+			nr++;
+	}
+	closedir(dir);
+
+	return nr;
+}
+
+TEST_CASE("reaper_bury", "[core][reaper]")
+{
+	char dirpath[PATH_MAX];
+	char subpath[PATH_MAX];
+	char filepath[PATH_MAX];
+	char graveyard[PATH_MAX];
+
+	REQUIRE(path_init_from_parts(dirpath, PATH_MAX, vaccel_rundir(),
+				     "test_reaper", nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(subpath, PATH_MAX, dirpath, "sub",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(filepath, PATH_MAX, subpath, "file",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(graveyard, PATH_MAX, vaccel_rundir(),
+				     "graveyard", nullptr) == VACCEL_OK);
+
+	REQUIRE(fs_dir_create(subpath) == VACCEL_OK);
+	REQUIRE(fs_file_create(filepath, nullptr) == VACCEL_OK);
+
+	/* The directory is moved away before returning */
+	REQUIRE(reaper_bury(dirpath) == VACCEL_OK);
+	REQUIRE_FALSE(fs_path_exists(dirpath));
+
+	/* and removed in the background */
+	REQUIRE(reaper_flush() == VACCEL_OK);
+	REQUIRE(fs_path_is_dir(graveyard));
+	REQUIRE(dir_nr_entries(graveyard) == 0);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(reaper_bury(nullptr) == VACCEL_EINVAL);
+		REQUIRE(reaper_bury(dirpath) == ENOENT);
+	}
+}
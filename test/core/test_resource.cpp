@@ -20,22 +20,36 @@
  * 15) vaccel_session_has_resource()
  * 16) vaccel_resource_get_by_type()
  * 17) vaccel_resource_get_all_by_type()
+ * 18) vaccel_resource_new_shared()
+ * 19) vaccel_resource_from_buf_shared()
+ * 20) vaccel_resource_delete_shared()
+ * 21) vaccel_resource_register(), from URL into memory
+ * 22) vaccel_resource_init_from_buf(), into memory files
+ * 23) vaccel_resource_set_map_flags()
+ * 24) vaccel_resource_prefetch()
+ * 25) vaccel_resource_init_from_blobs(), from blob files
  *
  */
 
+#include "http_server.hpp"
 #include "utils.hpp"
 #include "vaccel.h"
+#include <atomic>
 #include <catch2/catch_test_macros.hpp>
 #include <cerrno>
 #include <cinttypes>
 #include <climits>
 #include <cstddef>
+#include <cstdint>
 #include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <dlfcn.h>
 #include <fff.h>
 #include <mock_virtio.hpp>
 #include <pthread.h>
+#include <string>
+#include <sys/stat.h>
 #include <unistd.h>
 
 DEFINE_FFF_GLOBALS;
@@ -360,6 +374,8 @@ TEST_CASE("resource_from_file_paths", "[core][resource]")
 		REQUIRE(resource->nr_blobs == 2);
 		REQUIRE(resource->blobs);
 		REQUIRE(resource->refcount == 1);
+		/* Local files don't need a rundir */
+		REQUIRE(resource->rundir == nullptr);
 	}
 
 	for (auto &resource : resources) {
@@ -478,6 +494,233 @@ TEST_CASE("resource_from_file_paths", "[core][resource]")
 }
 
 // Test case for resource from url path operations
+TEST_CASE("resource_map_flags", "[core][resource]")
+{
+	char *dir = abs_path(SOURCE_ROOT, "examples/models/tf/lstm2");
+	char *file = abs_path(SOURCE_ROOT,
+			      "examples/models/tf/lstm2/variables/variables.index");
+	uint32_t const flags = VACCEL_BLOB_MAP_SHARED |
+			       VACCEL_BLOB_MAP_WILLNEED |
+			       VACCEL_BLOB_MAP_SEQUENTIAL;
+
+	struct vaccel_resource dir_res;
+	REQUIRE(vaccel_resource_init(&dir_res, dir, VACCEL_RESOURCE_MODEL) ==
+		VACCEL_OK);
+	REQUIRE(dir_res.map_flags == 0);
+	struct vaccel_resource file_res;
+	REQUIRE(vaccel_resource_init(&file_res, file, VACCEL_RESOURCE_DATA) ==
+		VACCEL_OK);
+	struct vaccel_resource *resources[] = { &dir_res, &file_res };
+
+	struct vaccel_session sess;
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+
+	/* Blobs created on registration are mapped with the flags */
+	for (auto *res : resources) {
+		REQUIRE(vaccel_resource_set_map_flags(res, flags) ==
+			VACCEL_OK);
+		REQUIRE(res->map_flags == flags);
+
+		REQUIRE(vaccel_resource_register(res, &sess) == VACCEL_OK);
+		REQUIRE(res->nr_blobs > 0);
+		for (size_t i = 0; i < res->nr_blobs; i++) {
+			struct vaccel_blob *blob = res->blobs[i];
+			REQUIRE(blob->map_flags == flags);
+
+			size_t size;
+			REQUIRE(vaccel_blob_data(blob, &size) != nullptr);
+			REQUIRE(blob->type == VACCEL_BLOB_MAPPED);
+			REQUIRE(size > 0);
+		}
+		REQUIRE(vaccel_resource_unregister(res, &sess) == VACCEL_OK);
+	}
+
+	/* Blobs already mapped keep the flags they were mapped with */
+	REQUIRE(vaccel_resource_set_map_flags(&file_res, 0) == VACCEL_OK);
+	REQUIRE(file_res.map_flags == 0);
+	REQUIRE(file_res.blobs[0]->data != nullptr);
+	REQUIRE(file_res.blobs[0]->map_flags == flags);
+
+	SECTION("invalid arguments")
+	{
+		struct vaccel_resource uninit_res;
+		uninit_res.id = 0;
+		REQUIRE(vaccel_resource_set_map_flags(nullptr, flags) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_set_map_flags(&uninit_res, flags) ==
+			VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE(vaccel_resource_release(&dir_res) == VACCEL_OK);
+	REQUIRE(vaccel_resource_release(&file_res) == VACCEL_OK);
+
+	free(file);
+	free(dir);
+}
+
+static std::atomic<int> nr_warmups{ 0 };
+static std::atomic<int> nr_warmups_started{ 0 };
+static std::atomic<bool> warmup_blocked{ false };
+static std::atomic<int> warmup_ret{ VACCEL_OK };
+
+static auto warmup_fake(struct vaccel_resource *res,
+			struct vaccel_session *sess) -> int
+{
+	(void)res;
+	(void)sess;
+
+	nr_warmups_started++;
+	while (warmup_blocked)
+		usleep(1000);
+
+	nr_warmups++;
+	return warmup_ret;
+}
+
+struct unregister_data {
+	struct vaccel_resource *resource;
+	struct vaccel_session *session;
+	std::atomic<bool> done;
+	int ret;
+};
+
+static auto unregister_in_background(void *arg) -> void *
+{
+	auto *data = (struct unregister_data *)arg;
+
+	data->ret = vaccel_resource_unregister(data->resource, data->session);
+	data->done = true;
+
+	return nullptr;
+}
+
+TEST_CASE("resource_prefetch", "[core][resource]")
+{
+	char *dir = abs_path(SOURCE_ROOT, "examples/models/tf/lstm2");
+
+	struct vaccel_resource res;
+	REQUIRE(vaccel_resource_init(&res, dir, VACCEL_RESOURCE_MODEL) ==
+		VACCEL_OK);
+
+	/* Blobs are only there once registered */
+	REQUIRE(vaccel_resource_prefetch_poll(&res) == VACCEL_ENOENT);
+	REQUIRE(vaccel_resource_prefetch(&res, 0) == VACCEL_EINVAL);
+
+	struct vaccel_session sess;
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+	REQUIRE(vaccel_resource_register(&res, &sess) == VACCEL_OK);
+
+	struct vaccel_plugin_info *info = sess.plugin->info;
+	auto *resource_warmup = info->resource_warmup;
+	info->resource_warmup = warmup_fake;
+	nr_warmups = 0;
+	nr_warmups_started = 0;
+	warmup_ret = VACCEL_OK;
+
+	SECTION("read ahead")
+	{
+		REQUIRE(vaccel_resource_prefetch(&res, 0) == VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_wait(&res, -1) == VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_poll(&res) == VACCEL_OK);
+		REQUIRE(nr_warmups == 0);
+
+		/* Mapped blobs are faulted in */
+		for (size_t i = 0; i < res.nr_blobs; i++)
+			REQUIRE(vaccel_blob_data(res.blobs[i], nullptr) !=
+				nullptr);
+		REQUIRE(vaccel_resource_prefetch(&res, 0) == VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_wait(&res, -1) == VACCEL_OK);
+	}
+
+	SECTION("warmup")
+	{
+		REQUIRE(vaccel_resource_prefetch(
+				&res, VACCEL_RESOURCE_PREFETCH_WARMUP) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_wait(&res, -1) == VACCEL_OK);
+		REQUIRE(nr_warmups == 1);
+	}
+
+	SECTION("failed warmup")
+	{
+		warmup_ret = VACCEL_EIO;
+		REQUIRE(vaccel_resource_prefetch(
+				&res, VACCEL_RESOURCE_PREFETCH_WARMUP) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_wait(&res, -1) == VACCEL_EIO);
+		REQUIRE(nr_warmups == 1);
+	}
+
+	SECTION("in progress")
+	{
+		warmup_blocked = true;
+		REQUIRE(vaccel_resource_prefetch(
+				&res, VACCEL_RESOURCE_PREFETCH_WARMUP) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_poll(&res) == VACCEL_EAGAIN);
+		REQUIRE(vaccel_resource_prefetch_wait(&res, 10) ==
+			VACCEL_EAGAIN);
+		REQUIRE(vaccel_resource_prefetch(&res, 0) == VACCEL_EBUSY);
+
+		warmup_blocked = false;
+		REQUIRE(vaccel_resource_prefetch_wait(&res, -1) == VACCEL_OK);
+		REQUIRE(nr_warmups == 1);
+	}
+
+	SECTION("unregister while warming up")
+	{
+		warmup_blocked = true;
+		REQUIRE(vaccel_resource_prefetch(
+				&res, VACCEL_RESOURCE_PREFETCH_WARMUP) ==
+			VACCEL_OK);
+		while (nr_warmups_started == 0)
+			usleep(1000);
+
+		/* The sessions lock is not held across the warmup */
+		REQUIRE(vaccel_session_has_resource(&sess, &res));
+
+		/* but the session stays registered until it is done */
+		struct unregister_data data = {
+			.resource = &res,
+			.session = &sess,
+			.done = false,
+			.ret = VACCEL_OK,
+		};
+		pthread_t thread;
+		REQUIRE(pthread_create(&thread, nullptr,
+				       unregister_in_background, &data) == 0);
+		usleep(10000);
+		REQUIRE_FALSE(data.done);
+
+		warmup_blocked = false;
+		pthread_join(thread, nullptr);
+		REQUIRE(data.ret == VACCEL_OK);
+		REQUIRE(vaccel_resource_prefetch_wait(&res, -1) == VACCEL_OK);
+		REQUIRE(nr_warmups == 1);
+
+		REQUIRE(vaccel_resource_register(&res, &sess) == VACCEL_OK);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_resource_prefetch(nullptr, 0) == VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_prefetch_poll(nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_prefetch_wait(nullptr, -1) ==
+			VACCEL_EINVAL);
+	}
+
+	info->resource_warmup = resource_warmup;
+
+	REQUIRE(vaccel_resource_unregister(&res, &sess) == VACCEL_OK);
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+	REQUIRE(res.prefetch == nullptr);
+
+	free(dir);
+}
+
 TEST_CASE("resource_from_url_path", "[core][resource]")
 {
 	int ret;
@@ -646,6 +889,69 @@ TEST_CASE("resource_from_url_path", "[core][resource]")
 	REQUIRE(res.plugin_priv == nullptr);
 }
 
+static auto in_memory_bootstrap(bool download_in_memory,
+				bool blobs_in_memory) -> int
+{
+	struct vaccel_config config;
+
+	int ret = vaccel_config_init_from_env(&config);
+	if (ret)
+		return ret;
+
+	config.download_in_memory = download_in_memory;
+	config.blobs_in_memory = blobs_in_memory;
+
+	ret = vaccel_bootstrap_with_config(&config);
+	vaccel_config_release(&config);
+
+	return ret;
+}
+
+TEST_CASE("resource_from_url_path_in_memory", "[core][resource]")
+{
+	HttpServer server;
+	std::string const url1 = server.url("/model.bin");
+	std::string const url2 = server.url("/weights.bin");
+	const char *urls[] = { url1.c_str(), url2.c_str() };
+
+	REQUIRE(in_memory_bootstrap(true, false) == VACCEL_OK);
+
+	struct vaccel_resource res;
+	REQUIRE(vaccel_resource_init_multi(&res, urls, 2,
+					   VACCEL_RESOURCE_DATA) == VACCEL_OK);
+
+	struct vaccel_session sess;
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+
+#ifdef USE_LIBCURL
+	/* Files are downloaded straight into buffer blobs */
+	REQUIRE(vaccel_resource_register(&res, &sess) == VACCEL_OK);
+	REQUIRE(res.nr_blobs == 2);
+	REQUIRE(res.rundir == nullptr);
+	for (size_t i = 0; i < res.nr_blobs; i++) {
+		struct vaccel_blob *blob = res.blobs[i];
+		REQUIRE(blob->type == VACCEL_BLOB_BUFFER);
+		REQUIRE(blob->path == nullptr);
+		REQUIRE(blob->data_owned);
+
+		std::string const name = (i == 0) ? "model.bin" :
+						    "weights.bin";
+		REQUIRE(strcmp(blob->name, name.c_str()) == 0);
+		REQUIRE(std::string((char *)blob->data, blob->size) ==
+			server.content("/" + name));
+	}
+
+	REQUIRE(vaccel_resource_unregister(&res, &sess) == VACCEL_OK);
+#else
+	REQUIRE(vaccel_resource_register(&res, &sess) == VACCEL_ENOTSUP);
+#endif
+
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+
+	REQUIRE(in_memory_bootstrap(false, false) == VACCEL_OK);
+}
+
 // Test case for resource from buffer operations
 TEST_CASE("resource_from_buffer", "[core][resource]")
 {
@@ -760,6 +1066,71 @@ TEST_CASE("resource_from_buffer", "[core][resource]")
 	free(file);
 }
 
+TEST_CASE("resource_from_buffer_in_memory", "[core][resource]")
+{
+	char *file = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+
+	size_t len;
+	unsigned char *buff;
+	REQUIRE(fs_file_read(file, (void **)&buff, &len) == VACCEL_OK);
+
+	REQUIRE(in_memory_bootstrap(false, true) == VACCEL_OK);
+
+	/* The buffer is kept in a memory file instead of the rundir */
+	struct vaccel_resource res;
+	REQUIRE(vaccel_resource_init_from_buf(&res, buff, len,
+					      VACCEL_RESOURCE_LIB, "lib.so",
+					      false) == VACCEL_OK);
+	REQUIRE(res.rundir == nullptr);
+	REQUIRE(res.nr_blobs == 1);
+
+	struct vaccel_blob *blob = res.blobs[0];
+	REQUIRE(blob->type == VACCEL_BLOB_MAPPED);
+	REQUIRE(strcmp(blob->name, "lib.so") == 0);
+	REQUIRE(strncmp(blob->path, "/proc/self/fd/", 14) == 0);
+	REQUIRE(blob->path_owned);
+	REQUIRE(blob->data_owned);
+	REQUIRE(blob->data != buff);
+	REQUIRE(blob->size == len);
+	REQUIRE(memcmp(blob->data, buff, len) == 0);
+
+	/* Plugins can open it by path */
+	void *handle = dlopen(vaccel_blob_path(blob), RTLD_NOW);
+	REQUIRE(handle != nullptr);
+	dlclose(handle);
+
+	struct vaccel_session sess;
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+	REQUIRE(vaccel_resource_register(&res, &sess) == VACCEL_OK);
+	REQUIRE(vaccel_resource_unregister(&res, &sess) == VACCEL_OK);
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+
+	/* Mapped blobs are moved to memory files too */
+	struct vaccel_resource blobs_res;
+	const struct vaccel_blob *blobs[] = { blob };
+	REQUIRE(vaccel_resource_init_from_blobs(&blobs_res, blobs, 1,
+						VACCEL_RESOURCE_LIB) ==
+		VACCEL_OK);
+	REQUIRE(blobs_res.rundir == nullptr);
+	REQUIRE(blobs_res.blobs[0]->type == VACCEL_BLOB_MAPPED);
+	REQUIRE(strncmp(blobs_res.blobs[0]->path, "/proc/self/fd/", 14) ==
+		0);
+	REQUIRE(strcmp(blobs_res.blobs[0]->path, blob->path) != 0);
+	REQUIRE(memcmp(blobs_res.blobs[0]->data, buff, len) == 0);
+	REQUIRE(vaccel_resource_release(&blobs_res) == VACCEL_OK);
+
+	char *path = strdup(blob->path);
+	REQUIRE(path != nullptr);
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+	REQUIRE_FALSE(fs_path_exists(path));
+	free(path);
+
+	REQUIRE(in_memory_bootstrap(false, false) == VACCEL_OK);
+
+	free(buff);
+	free(file);
+}
+
 TEST_CASE("resource_from_blobs_mem_only", "[core][resource]")
 {
 	int ret;
@@ -1062,6 +1433,94 @@ TEST_CASE("resource_from_blobs", "[core][resource]")
 	free(path2);
 }
 
+TEST_CASE("resource_from_blob_files", "[core][resource]")
+{
+	char *path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	struct vaccel_blob user_blob;
+	struct vaccel_blob *owned_blob;
+	struct vaccel_resource res;
+	struct stat src_st;
+	struct stat st;
+
+	/* A user file and a file owned by vAccel, mapped read-only shared */
+	REQUIRE(vaccel_blob_init(&user_blob, path) == VACCEL_OK);
+	user_blob.map_flags = VACCEL_BLOB_MAP_SHARED;
+	REQUIRE(vaccel_blob_read(&user_blob) == VACCEL_OK);
+	REQUIRE(vaccel_blob_from_buf(&owned_blob, user_blob.data,
+				     user_blob.size, false, "owned", nullptr,
+				     false) == VACCEL_OK);
+	owned_blob->map_flags = VACCEL_BLOB_MAP_SHARED;
+	REQUIRE(vaccel_blob_persist(owned_blob, vaccel_rundir(), "owned",
+				    true) == VACCEL_OK);
+	REQUIRE(owned_blob->type == VACCEL_BLOB_MAPPED);
+	REQUIRE(owned_blob->path_owned);
+
+	const struct vaccel_blob *blobs[2] = { &user_blob, owned_blob };
+	REQUIRE(vaccel_resource_init_from_blobs(&res, blobs, 2,
+						VACCEL_RESOURCE_DATA) ==
+		VACCEL_OK);
+	REQUIRE(res.rundir);
+	REQUIRE(res.nr_blobs == 2);
+	for (size_t i = 0; i != res.nr_blobs; ++i) {
+		REQUIRE(res.blobs[i]->type == VACCEL_BLOB_MAPPED);
+		REQUIRE(strncmp(res.blobs[i]->path, res.rundir,
+				strlen(res.rundir)) == 0);
+		REQUIRE(strcmp(res.blobs[i]->name, blobs[i]->name) == 0);
+		REQUIRE(res.blobs[i]->path_owned);
+		REQUIRE(res.blobs[i]->data_owned);
+		REQUIRE(res.blobs[i]->size == blobs[i]->size);
+		REQUIRE(memcmp(res.blobs[i]->data, blobs[i]->data,
+			       blobs[i]->size) == 0);
+	}
+
+	/* User files are copied */
+	REQUIRE(stat(user_blob.path, &src_st) == 0);
+	REQUIRE(stat(res.blobs[0]->path, &st) == 0);
+	REQUIRE(st.st_ino != src_st.st_ino);
+
+	/* while files owned by vAccel share storage */
+	REQUIRE(stat(owned_blob->path, &src_st) == 0);
+	REQUIRE(stat(res.blobs[1]->path, &st) == 0);
+	REQUIRE(st.st_ino == src_st.st_ino);
+
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+	REQUIRE(vaccel_blob_delete(owned_blob) == VACCEL_OK);
+	REQUIRE(vaccel_blob_release(&user_blob) == VACCEL_OK);
+	free(path);
+}
+
+TEST_CASE("resource_from_blob_files_private", "[core][resource]")
+{
+	char *path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	struct vaccel_blob blob;
+	struct vaccel_resource res;
+	struct stat src_st;
+	struct stat st;
+
+	/* Changes made through a private mapping are not in the file */
+	REQUIRE(vaccel_blob_init(&blob, path) == VACCEL_OK);
+	REQUIRE(vaccel_blob_read(&blob) == VACCEL_OK);
+	blob.data[0] ^= 0xff;
+
+	const struct vaccel_blob *blobs[1] = { &blob };
+	REQUIRE(vaccel_resource_init_from_blobs(&res, blobs, 1,
+						VACCEL_RESOURCE_DATA) ==
+		VACCEL_OK);
+	REQUIRE(res.nr_blobs == 1);
+	REQUIRE(res.blobs[0]->type == VACCEL_BLOB_MAPPED);
+	REQUIRE(res.blobs[0]->size == blob.size);
+
+	/* so the data is persisted instead of the file */
+	REQUIRE(memcmp(res.blobs[0]->data, blob.data, blob.size) == 0);
+	REQUIRE(stat(blob.path, &src_st) == 0);
+	REQUIRE(stat(res.blobs[0]->path, &st) == 0);
+	REQUIRE(st.st_ino != src_st.st_ino);
+
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+	REQUIRE(vaccel_blob_release(&blob) == VACCEL_OK);
+	free(path);
+}
+
 TEST_CASE("resource_from_blobs_mixed", "[core][resource]")
 {
 	int ret;
@@ -1456,6 +1915,173 @@ TEST_CASE("resource_multiple_sessions", "[core][resource]")
 	free(test_path);
 }
 
+static auto failing_resource_unregister(struct vaccel_resource *res,
+					struct vaccel_session *sess) -> int
+{
+	(void)res;
+	(void)sess;
+
+	return VACCEL_EIO;
+}
+
+// Test case for resources shared by content
+TEST_CASE("resource_shared", "[core][resource]")
+{
+	char *test_path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	vaccel_resource_type_t const test_type = VACCEL_RESOURCE_LIB;
+
+	SECTION("from path")
+	{
+		struct vaccel_resource *res1 = nullptr;
+		struct vaccel_resource *res2 = nullptr;
+		struct vaccel_session sess1;
+		struct vaccel_session sess2;
+
+		REQUIRE(vaccel_resource_new_shared(&res1, test_path,
+						   test_type) == VACCEL_OK);
+		REQUIRE(vaccel_resource_new_shared(&res2, test_path,
+						   test_type) == VACCEL_OK);
+		REQUIRE(res1 == res2);
+		REQUIRE(res1->share != nullptr);
+
+		// Sessions register the same resource
+		REQUIRE(vaccel_session_init(&sess1, 0) == VACCEL_OK);
+		REQUIRE(vaccel_session_init(&sess2, 0) == VACCEL_OK);
+		REQUIRE(vaccel_resource_register(res1, &sess1) == VACCEL_OK);
+		REQUIRE(vaccel_resource_register(res2, &sess2) == VACCEL_OK);
+		REQUIRE(vaccel_resource_refcount(res1) == 2);
+
+		// Other references keep it from being released directly
+		REQUIRE(vaccel_resource_delete(res1) == VACCEL_EBUSY);
+		REQUIRE(res1->share != nullptr);
+
+		// A different type is a different resource
+		struct vaccel_resource *res3 = nullptr;
+		REQUIRE(vaccel_resource_new_shared(&res3, test_path,
+						   VACCEL_RESOURCE_DATA) ==
+			VACCEL_OK);
+		REQUIRE(res3 != res1);
+		REQUIRE(vaccel_resource_delete_shared(res3) == VACCEL_OK);
+
+		// The resource lives until the last reference is dropped
+		const vaccel_id_t id = res1->id;
+		struct vaccel_resource *found;
+		REQUIRE(vaccel_resource_delete_shared(res1) == VACCEL_OK);
+		REQUIRE(vaccel_resource_get_by_id(&found, id) == VACCEL_OK);
+		REQUIRE(found == res2);
+		REQUIRE(vaccel_resource_delete_shared(res2) == VACCEL_OK);
+		REQUIRE(vaccel_resource_get_by_id(&found, id) == VACCEL_ENOENT);
+
+		REQUIRE(vaccel_session_release(&sess1) == VACCEL_OK);
+		REQUIRE(vaccel_session_release(&sess2) == VACCEL_OK);
+	}
+
+	SECTION("failed delete")
+	{
+		struct vaccel_resource *res1 = nullptr;
+		struct vaccel_resource *res2 = nullptr;
+		struct vaccel_session sess;
+
+		REQUIRE(vaccel_resource_new_shared(&res1, test_path,
+						   test_type) == VACCEL_OK);
+		REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+		REQUIRE(vaccel_resource_register(res1, &sess) == VACCEL_OK);
+
+		struct vaccel_plugin_info *info = sess.plugin->info;
+		auto *const unregister = info->resource_unregister;
+		info->resource_unregister = failing_resource_unregister;
+
+		// A resource that can't be deleted stays shared
+		REQUIRE(vaccel_resource_delete_shared(res1) == VACCEL_EIO);
+		info->resource_unregister = unregister;
+		REQUIRE(res1->share != nullptr);
+		REQUIRE(vaccel_resource_new_shared(&res2, test_path,
+						   test_type) == VACCEL_OK);
+		REQUIRE(res2 == res1);
+
+		const vaccel_id_t id = res1->id;
+		struct vaccel_resource *found;
+		REQUIRE(vaccel_resource_delete_shared(res2) == VACCEL_OK);
+		REQUIRE(vaccel_resource_get_by_id(&found, id) == VACCEL_OK);
+		REQUIRE(vaccel_resource_delete_shared(res1) == VACCEL_OK);
+		REQUIRE(vaccel_resource_get_by_id(&found, id) == VACCEL_ENOENT);
+
+		REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	}
+
+	SECTION("from buffer")
+	{
+		unsigned char *buf1;
+		size_t len;
+		REQUIRE(fs_file_read(test_path, (void **)&buf1, &len) ==
+			VACCEL_OK);
+		auto *buf2 = (unsigned char *)malloc(len);
+		REQUIRE(buf2 != nullptr);
+		memcpy(buf2, buf1, len);
+
+		struct vaccel_resource *res1 = nullptr;
+		struct vaccel_resource *res2 = nullptr;
+		REQUIRE(vaccel_resource_from_buf_shared(&res1, buf1, len,
+							test_type, "lib.so",
+							true) == VACCEL_OK);
+
+		// Equal data in another buffer is shared too
+		REQUIRE(vaccel_resource_from_buf_shared(&res2, buf2, len,
+							test_type, "lib.so",
+							true) == VACCEL_OK);
+		REQUIRE(res1 == res2);
+
+		// and outlives the buffer it was created from
+		free(buf1);
+		REQUIRE(memcmp(res1->blobs[0]->data, buf2, len) == 0);
+
+		// Different data is not shared
+		buf2[0] ^= 0xff;
+		struct vaccel_resource *res3 = nullptr;
+		REQUIRE(vaccel_resource_from_buf_shared(&res3, buf2, len,
+							test_type, "lib.so",
+							true) == VACCEL_OK);
+		REQUIRE(res3 != res1);
+
+		REQUIRE(vaccel_resource_delete_shared(res3) == VACCEL_OK);
+		REQUIRE(vaccel_resource_delete_shared(res2) == VACCEL_OK);
+		REQUIRE(vaccel_resource_delete_shared(res1) == VACCEL_OK);
+		free(buf2);
+	}
+
+	SECTION("invalid arguments")
+	{
+		struct vaccel_resource *res = nullptr;
+		struct vaccel_resource unshared;
+
+		REQUIRE(vaccel_resource_new_shared(nullptr, test_path,
+						   test_type) == VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_new_shared(&res, nullptr, test_type) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_new_shared(&res, "/nonexistent/file",
+						   test_type) != VACCEL_OK);
+
+		// Only regular files are shared by path
+		char *dir_path = abs_path(SOURCE_ROOT, "examples/models");
+		REQUIRE(vaccel_resource_new_shared(&res, dir_path, test_type) ==
+			VACCEL_ENOTSUP);
+		free(dir_path);
+		REQUIRE(vaccel_resource_from_buf_shared(&res, nullptr, 1,
+							test_type, nullptr,
+							true) == VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_delete_shared(nullptr) ==
+			VACCEL_EINVAL);
+
+		REQUIRE(vaccel_resource_init(&unshared, test_path, test_type) ==
+			VACCEL_OK);
+		REQUIRE(vaccel_resource_delete_shared(&unshared) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_resource_release(&unshared) == VACCEL_OK);
+	}
+
+	free(test_path);
+}
+
 // Test case for resource sync
 TEST_CASE("resource_sync", "[core][resource]")
 {
@@ -2096,6 +2722,57 @@ static auto unregister_resource(void *arg) -> void *
 	return nullptr;
 }
 
+static auto register_resource(void *arg) -> void *
+{
+	auto *data = (struct thread_data *)arg;
+	struct vaccel_resource *res = data->resource;
+	struct vaccel_session *sess = data->session;
+
+	REQUIRE(vaccel_resource_register(res, sess) == VACCEL_OK);
+	printf("Thread %zu: Registered resource %" PRId64 "\n", data->id,
+	       res->id);
+
+	return nullptr;
+}
+
+TEST_CASE("resource_register_concurrent", "[core][resource]")
+{
+	char *lib_path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	struct vaccel_session sessions[TEST_THREADS_NUM];
+	struct vaccel_resource res;
+
+	for (auto &sess : sessions)
+		REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+
+	REQUIRE(vaccel_resource_init(&res, lib_path, VACCEL_RESOURCE_LIB) ==
+		VACCEL_OK);
+
+	pthread_t threads[TEST_THREADS_NUM];
+	struct thread_data thread_data[TEST_THREADS_NUM];
+
+	for (size_t i = 0; i < TEST_THREADS_NUM; i++) {
+		thread_data[i].id = i;
+		thread_data[i].session = &sessions[i];
+		thread_data[i].resource = &res;
+		pthread_create(&threads[i], nullptr, register_resource,
+			       &thread_data[i]);
+	}
+
+	for (unsigned long const thread : threads)
+		pthread_join(thread, nullptr);
+
+	// The data is loaded once for all the sessions
+	REQUIRE(res.nr_blobs == 1);
+	REQUIRE(vaccel_resource_refcount(&res) == TEST_THREADS_NUM);
+
+	for (auto &sess : sessions)
+		REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+
+	REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+
+	free(lib_path);
+}
+
 TEST_CASE("resource_unregister_concurrent", "[core][resource]")
 {
 	char *lib_path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
@@ -0,0 +1,335 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to the plugin scheduler.
+ *
+ * 1) sched_op_start()
+ * 2) sched_op_stop()
+ * 3) sched_ops_start(), sched_ops_stop() and sched_ops_cancel()
+ * 4) sched_latency_ns()
+ * 5) sched_inflight()
+ * 6) sched_expected_ns()
+ * 7) vaccel_sched_override()
+ * 8) plugin_find() with the adaptive policy
+ * 9) plugin_route_ops() with the adaptive policy
+ *
+ */
+
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdlib>
+
+static auto init() -> int
+{
+	return VACCEL_OK;
+}
+static auto fini() -> int
+{
+	return VACCEL_OK;
+}
+
+static auto no_op() -> int
+{
+	return 2;
+}
+
+static auto mock_plugin_new(const char *name) -> struct vaccel_plugin *
+{
+	auto *pinfo = (struct vaccel_plugin_info *)calloc(
+		1, sizeof(struct vaccel_plugin_info));
+	if (pinfo == nullptr)
+		return nullptr;
+
+	pinfo->name = name;
+	pinfo->version = "0.0.0";
+	pinfo->vaccel_version = VACCEL_VERSION;
+	pinfo->init = init;
+	pinfo->fini = fini;
+	pinfo->is_virtio = false;
+	pinfo->type = VACCEL_PLUGIN_GENERIC;
+
+	auto *plugin =
+		(struct vaccel_plugin *)calloc(1, sizeof(struct vaccel_plugin));
+	if (plugin == nullptr) {
+		free(pinfo);
+		return nullptr;
+	}
+
+	plugin->dl_handle = nullptr;
+	plugin->entry = LIST_ENTRY_INIT(plugin->entry);
+	plugin->info = pinfo;
+	for (auto &op : plugin->ops)
+		op = nullptr;
+
+	return plugin;
+}
+
+static auto mock_plugin_delete(struct vaccel_plugin *plugin) -> void
+{
+	if (plugin == nullptr)
+		return;
+
+	free(plugin->info);
+	free(plugin);
+}
+
+static auto sched_bootstrap(vaccel_sched_policy_t policy) -> int
+{
+	struct vaccel_config config;
+
+	int ret = vaccel_config_init_from_env(&config);
+	if (ret)
+		return ret;
+
+	/* Register only the mock plugins */
+	free(config.plugins);
+	config.plugins = nullptr;
+	config.sched_policy = policy;
+
+	ret = vaccel_bootstrap_with_config(&config);
+	vaccel_config_release(&config);
+
+	return ret;
+}
+
+/* Record a call of an op on a plugin with the given latency */
+static auto sched_op_sample(struct vaccel_plugin *plugin,
+			    vaccel_op_type_t op_type, uint64_t latency_ns)
+	-> void
+{
+	uint64_t const start = sched_op_start(plugin, op_type);
+	REQUIRE(start > latency_ns);
+	sched_op_stop(plugin, op_type, start - latency_ns);
+}
+
+TEST_CASE("sched_stats", "[core][sched]")
+{
+	struct vaccel_plugin *plugin = mock_plugin_new("mock_sched");
+	REQUIRE(plugin != nullptr);
+
+	SECTION("static policy")
+	{
+		REQUIRE(sched_bootstrap(VACCEL_SCHED_STATIC) == VACCEL_OK);
+		REQUIRE_FALSE(sched_adaptive());
+		REQUIRE(plugin_register(plugin) == VACCEL_OK);
+
+		/* Nothing is recorded */
+		REQUIRE(sched_op_start(plugin, VACCEL_OP_NOOP) == 0);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_NOOP) == 0);
+		sched_op_stop(plugin, VACCEL_OP_NOOP, 0);
+		REQUIRE(sched_latency_ns(plugin, VACCEL_OP_NOOP) == 0);
+	}
+
+	SECTION("adaptive policy")
+	{
+		REQUIRE(sched_bootstrap(VACCEL_SCHED_ADAPTIVE) == VACCEL_OK);
+		REQUIRE(sched_adaptive());
+		REQUIRE(plugin_register(plugin) == VACCEL_OK);
+
+		REQUIRE(sched_latency_ns(plugin, VACCEL_OP_NOOP) == 0);
+		REQUIRE(sched_expected_ns(plugin, VACCEL_OP_NOOP) == 0);
+
+		uint64_t const start = sched_op_start(plugin, VACCEL_OP_NOOP);
+		REQUIRE(start > 0);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_NOOP) == 1);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_MAX) == 1);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_EXEC) == 0);
+		sched_op_stop(plugin, VACCEL_OP_NOOP, start);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_NOOP) == 0);
+
+		/* First sample initializes the average, then it converges */
+		sched_op_sample(plugin, VACCEL_OP_EXEC, 1000000);
+		uint64_t const first = sched_latency_ns(plugin, VACCEL_OP_EXEC);
+		REQUIRE(first >= 1000000);
+		sched_op_sample(plugin, VACCEL_OP_EXEC, 9000000);
+		uint64_t const second =
+			sched_latency_ns(plugin, VACCEL_OP_EXEC);
+		REQUIRE(second > first);
+		REQUIRE(second < 9000000);
+		REQUIRE(sched_latency_ns(plugin, VACCEL_OP_MAX) > 0);
+
+		/* Expected time accounts for the calls in flight */
+		uint64_t const pending = sched_op_start(plugin, VACCEL_OP_EXEC);
+		REQUIRE(sched_expected_ns(plugin, VACCEL_OP_EXEC) ==
+			2 * sched_latency_ns(plugin, VACCEL_OP_EXEC));
+		sched_op_stop(plugin, VACCEL_OP_EXEC, pending);
+	}
+
+	SECTION("batched calls")
+	{
+		REQUIRE(sched_bootstrap(VACCEL_SCHED_ADAPTIVE) == VACCEL_OK);
+		REQUIRE(plugin_register(plugin) == VACCEL_OK);
+
+		/* A cancelled batch records nothing */
+		uint64_t start = sched_ops_start(plugin, VACCEL_OP_EXEC, 10);
+		REQUIRE(start > 0);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_EXEC) == 10);
+		sched_ops_cancel(plugin, VACCEL_OP_EXEC, start, 10);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_EXEC) == 0);
+		REQUIRE(sched_latency_ns(plugin, VACCEL_OP_EXEC) == 0);
+
+		/* Each call of a batch counts as a share of its latency */
+		start = sched_ops_start(plugin, VACCEL_OP_EXEC, 10);
+		REQUIRE(start > 10000000);
+		sched_ops_stop(plugin, VACCEL_OP_EXEC, start - 10000000, 10);
+		REQUIRE(sched_inflight(plugin, VACCEL_OP_EXEC) == 0);
+		uint64_t const latency =
+			sched_latency_ns(plugin, VACCEL_OP_EXEC);
+		REQUIRE(latency >= 1000000);
+		REQUIRE(latency < 2000000);
+	}
+
+	SECTION("untracked plugin")
+	{
+		REQUIRE(sched_bootstrap(VACCEL_SCHED_ADAPTIVE) == VACCEL_OK);
+
+		REQUIRE(sched_op_start(plugin, VACCEL_OP_NOOP) == 0);
+		REQUIRE(sched_op_start(nullptr, VACCEL_OP_NOOP) == 0);
+		REQUIRE(sched_expected_ns(plugin, VACCEL_OP_NOOP) == 0);
+	}
+
+	if (plugin_count())
+		REQUIRE(plugin_unregister(plugin) == VACCEL_OK);
+	mock_plugin_delete(plugin);
+
+	REQUIRE(sched_bootstrap(CONFIG_SCHED_POLICY_DEFAULT) == VACCEL_OK);
+}
+
+TEST_CASE("sched_plugin_find", "[core][sched]")
+{
+	struct vaccel_plugin *fast_plugin = mock_plugin_new("mock_fast");
+	REQUIRE(fast_plugin != nullptr);
+	struct vaccel_plugin *slow_plugin = mock_plugin_new("mock_slow");
+	REQUIRE(slow_plugin != nullptr);
+
+	REQUIRE(sched_bootstrap(VACCEL_SCHED_ADAPTIVE) == VACCEL_OK);
+
+	REQUIRE(plugin_register(slow_plugin) == VACCEL_OK);
+	REQUIRE(plugin_register(fast_plugin) == VACCEL_OK);
+
+	/* Plugins with no ops in common keep the registration order */
+	sched_op_sample(fast_plugin, VACCEL_OP_EXEC, 1000000);
+	REQUIRE(plugin_find(0) == slow_plugin);
+
+	vaccel_op slow_ops[] = {
+		{ .type = VACCEL_OP_NOOP,
+		  .func = (void *)no_op,
+		  .owner = slow_plugin },
+		{ .type = VACCEL_OP_EXEC,
+		  .func = (void *)no_op,
+		  .owner = slow_plugin },
+	};
+	vaccel_op fast_ops[] = {
+		{ .type = VACCEL_OP_EXEC,
+		  .func = (void *)no_op,
+		  .owner = fast_plugin },
+	};
+	REQUIRE(vaccel_plugin_register_ops(slow_ops, 2) == VACCEL_OK);
+	REQUIRE(vaccel_plugin_register_ops(fast_ops, 1) == VACCEL_OK);
+
+	/* No samples of the slow plugin yet, so it is expected to be faster */
+	REQUIRE(plugin_find(0) == slow_plugin);
+
+	sched_op_sample(slow_plugin, VACCEL_OP_EXEC, 10000000);
+	REQUIRE(plugin_find(0) == fast_plugin);
+
+	sched_op_sample(fast_plugin, VACCEL_OP_EXEC, 1000000);
+	REQUIRE(plugin_find(0) == fast_plugin);
+
+	/* Only ops both plugins implement are compared */
+	for (int i = 0; i < 100; i++)
+		sched_op_sample(slow_plugin, VACCEL_OP_NOOP, 1);
+	REQUIRE(sched_latency_ns(slow_plugin, VACCEL_OP_MAX) <
+		sched_latency_ns(fast_plugin, VACCEL_OP_MAX));
+	REQUIRE(plugin_find(0) == fast_plugin);
+
+	/* Enough calls in flight make the slow plugin the better choice */
+	uint64_t pending[20];
+	for (auto &ts : pending)
+		ts = sched_op_start(fast_plugin, VACCEL_OP_EXEC);
+	REQUIRE(plugin_find(0) == slow_plugin);
+	for (auto &ts : pending)
+		sched_op_stop(fast_plugin, VACCEL_OP_EXEC, ts);
+
+	REQUIRE(plugin_unregister(fast_plugin) == VACCEL_OK);
+	REQUIRE(plugin_unregister(slow_plugin) == VACCEL_OK);
+	mock_plugin_delete(fast_plugin);
+	mock_plugin_delete(slow_plugin);
+
+	REQUIRE(sched_bootstrap(CONFIG_SCHED_POLICY_DEFAULT) == VACCEL_OK);
+}
+
+TEST_CASE("sched_route_ops", "[core][sched]")
+{
+	struct vaccel_plugin *op_plugins[VACCEL_OP_MAX];
+
+	struct vaccel_plugin *fast_plugin = mock_plugin_new("mock_fast");
+	REQUIRE(fast_plugin != nullptr);
+	struct vaccel_plugin *slow_plugin = mock_plugin_new("mock_slow");
+	REQUIRE(slow_plugin != nullptr);
+
+	REQUIRE(sched_bootstrap(VACCEL_SCHED_ADAPTIVE) == VACCEL_OK);
+
+	REQUIRE(plugin_register(slow_plugin) == VACCEL_OK);
+	REQUIRE(plugin_register(fast_plugin) == VACCEL_OK);
+
+	vaccel_op slow_ops[] = {
+		{ .type = VACCEL_OP_NOOP,
+		  .func = (void *)no_op,
+		  .owner = slow_plugin },
+		{ .type = VACCEL_OP_EXEC,
+		  .func = (void *)no_op,
+		  .owner = slow_plugin },
+	};
+	vaccel_op fast_ops[] = {
+		{ .type = VACCEL_OP_NOOP,
+		  .func = (void *)no_op,
+		  .owner = fast_plugin },
+	};
+	REQUIRE(vaccel_plugin_register_ops(slow_ops, 2) == VACCEL_OK);
+	REQUIRE(vaccel_plugin_register_ops(fast_ops, 1) == VACCEL_OK);
+
+	sched_op_sample(slow_plugin, VACCEL_OP_NOOP, 10000000);
+	sched_op_sample(fast_plugin, VACCEL_OP_NOOP, 1000000);
+
+	SECTION("adaptive")
+	{
+		REQUIRE(plugin_route_ops(0, op_plugins) == 2);
+		REQUIRE(op_plugins[VACCEL_OP_NOOP] == fast_plugin);
+		REQUIRE(op_plugins[VACCEL_OP_EXEC] == slow_plugin);
+	}
+
+	SECTION("override")
+	{
+		REQUIRE(vaccel_sched_override(VACCEL_OP_NOOP, "mock_slow") ==
+			VACCEL_OK);
+		REQUIRE(sched_override_check(VACCEL_OP_NOOP, nullptr, nullptr));
+		REQUIRE(plugin_route_ops(0, op_plugins) == 2);
+		REQUIRE(op_plugins[VACCEL_OP_NOOP] == slow_plugin);
+
+		/* Overrides to plugins not implementing the op are ignored */
+		REQUIRE(vaccel_sched_override(VACCEL_OP_NOOP, "mock_none") ==
+			VACCEL_OK);
+		REQUIRE(plugin_route_ops(0, op_plugins) == 2);
+		REQUIRE(op_plugins[VACCEL_OP_NOOP] == fast_plugin);
+
+		REQUIRE(vaccel_sched_override(VACCEL_OP_NOOP, nullptr) ==
+			VACCEL_OK);
+		REQUIRE_FALSE(
+			sched_override_check(VACCEL_OP_NOOP, nullptr, nullptr));
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_sched_override(VACCEL_OP_MAX, "mock_slow") ==
+			VACCEL_EINVAL);
+	}
+
+	REQUIRE(plugin_unregister(fast_plugin) == VACCEL_OK);
+	REQUIRE(plugin_unregister(slow_plugin) == VACCEL_OK);
+	mock_plugin_delete(fast_plugin);
+	mock_plugin_delete(slow_plugin);
+
+	REQUIRE(sched_bootstrap(CONFIG_SCHED_POLICY_DEFAULT) == VACCEL_OK);
+}
@@ -13,6 +13,7 @@
  * 8) vaccel_session_resource_by_type()
  * 9) vaccel_session_resource_by_id()
  * 10) vaccel_session_resources_by_type()
+ * 11) vaccel_session_rundir()
  *
  */
 
@@ -25,6 +26,7 @@
 #include <cinttypes>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 #include <mock_virtio.hpp>
 #include <pthread.h>
 #include <unistd.h>
@@ -41,6 +43,7 @@ TEST_CASE("vaccel_session_init", "[core][session]")
 	for (auto &resource : sess.resources)
 		REQUIRE(list_empty(&resource));
 	REQUIRE(sess.priv == nullptr);
+	REQUIRE(sess.op_plugins == nullptr);
 
 	SECTION("invalid arguments")
 	{
@@ -51,6 +54,49 @@ TEST_CASE("vaccel_session_init", "[core][session]")
 	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
 }
 
+TEST_CASE("vaccel_session_init_op_routing", "[core][session]")
+{
+	int ret;
+
+	struct vaccel_session sess;
+	ret = vaccel_session_init(&sess, VACCEL_SESSION_OP_ROUTING);
+	REQUIRE(ret == VACCEL_OK);
+	REQUIRE(sess.id > 0);
+	REQUIRE(sess.hint == VACCEL_SESSION_OP_ROUTING);
+	REQUIRE(sess.op_plugins != nullptr);
+	REQUIRE(sess.op_plugins[VACCEL_OP_NOOP] == sess.plugin);
+
+	REQUIRE(vaccel_noop(&sess) == VACCEL_OK);
+
+	SECTION("registered resources")
+	{
+		char *lib_path =
+			abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+		struct vaccel_resource res;
+		REQUIRE(vaccel_resource_init(&res, lib_path,
+					     VACCEL_RESOURCE_LIB) == VACCEL_OK);
+		REQUIRE(vaccel_resource_register(&res, &sess) == VACCEL_OK);
+		REQUIRE(vaccel_session_has_resource(&sess, &res));
+
+		/* Routing is kept while resources are registered */
+		struct vaccel_plugin **op_plugins = sess.op_plugins;
+		REQUIRE(vaccel_session_update(&sess, 0) == VACCEL_ENOTSUP);
+		REQUIRE(vaccel_session_update(&sess, VACCEL_SESSION_OP_ROUTING) ==
+			VACCEL_ENOTSUP);
+		REQUIRE(sess.op_plugins == op_plugins);
+		REQUIRE(sess.hint == VACCEL_SESSION_OP_ROUTING);
+
+		REQUIRE(vaccel_resource_unregister(&res, &sess) == VACCEL_OK);
+		REQUIRE_FALSE(vaccel_session_has_resource(&sess, &res));
+
+		REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+		free(lib_path);
+	}
+
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE(sess.op_plugins == nullptr);
+}
+
 TEST_CASE("vaccel_session_release", "[core][session]")
 {
 	int ret;
@@ -158,6 +204,34 @@ TEST_CASE("vaccel_session_update", "[core][session]")
 	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
 }
 
+TEST_CASE("vaccel_session_rundir", "[core][session]")
+{
+	struct vaccel_session sess;
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+
+	/* The rundir is only created on demand */
+	REQUIRE_FALSE(sess.rundir_created);
+	REQUIRE_FALSE(fs_path_exists(sess.rundir));
+
+	const char *rundir = vaccel_session_rundir(&sess);
+	REQUIRE(rundir == sess.rundir);
+	REQUIRE(sess.rundir_created);
+	REQUIRE(fs_path_is_dir(rundir));
+	REQUIRE(vaccel_session_rundir(&sess) == rundir);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_session_rundir(nullptr) == nullptr);
+	}
+
+	char path[PATH_MAX];
+	strncpy(path, sess.rundir, PATH_MAX - 1);
+	path[PATH_MAX - 1] = '\0';
+
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE_FALSE(fs_path_exists(path));
+}
+
 TEST_CASE("vaccel_session_get_by_id", "[core][session]")
 {
 	struct vaccel_session sess;
@@ -175,6 +249,17 @@ TEST_CASE("vaccel_session_get_by_id", "[core][session]")
 		REQUIRE(ret == VACCEL_ENOENT);
 	}
 
+	SECTION("released")
+	{
+		struct vaccel_session sess2;
+		REQUIRE(vaccel_session_init(&sess2, 0) == VACCEL_OK);
+		const vaccel_id_t id = sess2.id;
+		REQUIRE(vaccel_session_release(&sess2) == VACCEL_OK);
+
+		ret = vaccel_session_get_by_id(&req_sess, id);
+		REQUIRE(ret == VACCEL_ENOENT);
+	}
+
 	SECTION("invalid arguments")
 	{
 		ret = vaccel_session_get_by_id(nullptr, 1);
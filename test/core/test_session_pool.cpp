@@ -0,0 +1,178 @@
+// SPDX-License-Identifier: Apache-2.0
+
+/*
+ * The code below performs unit testing to session pools.
+ *
+ * 1) vaccel_session_pool_init()
+ * 2) vaccel_session_pool_release()
+ * 3) vaccel_session_pool_new()
+ * 4) vaccel_session_pool_delete()
+ * 5) vaccel_session_pool_get()
+ * 6) vaccel_session_pool_put()
+ *
+ */
+
+#include "utils.hpp"
+#include "vaccel.h"
+#include <catch2/catch_test_macros.hpp>
+#include <cstdlib>
+#include <string>
+#include <unistd.h>
+
+enum { TEST_POOL_CAPACITY = 4 };
+
+TEST_CASE("vaccel_session_pool_init", "[core][session_pool]")
+{
+	struct vaccel_session_pool pool;
+
+	REQUIRE(vaccel_session_pool_init(&pool, 0, TEST_POOL_CAPACITY) ==
+		VACCEL_OK);
+	REQUIRE(pool.nr_idle == TEST_POOL_CAPACITY);
+	REQUIRE(pool.capacity == TEST_POOL_CAPACITY);
+
+	/* Idle sessions are fully initialized */
+	for (size_t i = 0; i < pool.nr_idle; i++) {
+		struct vaccel_session *sess;
+		REQUIRE(pool.idle[i]->id > 0);
+		REQUIRE(vaccel_session_get_by_id(&sess, pool.idle[i]->id) ==
+			VACCEL_OK);
+		REQUIRE(sess == pool.idle[i]);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_session_pool_init(nullptr, 0,
+						 TEST_POOL_CAPACITY) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_session_pool_release(nullptr) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_session_pool_release(&pool) == VACCEL_OK);
+	REQUIRE(pool.idle == nullptr);
+	REQUIRE(pool.nr_idle == 0);
+}
+
+TEST_CASE("vaccel_session_pool_new", "[core][session_pool]")
+{
+	struct vaccel_session_pool *pool = nullptr;
+
+	REQUIRE(vaccel_session_pool_new(&pool, 0, TEST_POOL_CAPACITY) ==
+		VACCEL_OK);
+	REQUIRE(pool != nullptr);
+	REQUIRE(pool->nr_idle == TEST_POOL_CAPACITY);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_session_pool_new(nullptr, 0,
+						TEST_POOL_CAPACITY) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_session_pool_new(&pool, 0, 0) == VACCEL_EINVAL);
+		REQUIRE(vaccel_session_pool_delete(nullptr) == VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_session_pool_delete(pool) == VACCEL_OK);
+}
+
+TEST_CASE("vaccel_session_pool_get_and_put", "[core][session_pool]")
+{
+	struct vaccel_session_pool pool;
+	struct vaccel_session *sess = nullptr;
+
+	REQUIRE(vaccel_session_pool_init(&pool, 0, TEST_POOL_CAPACITY) ==
+		VACCEL_OK);
+
+	REQUIRE(vaccel_session_pool_get(&pool, &sess) == VACCEL_OK);
+	REQUIRE(sess != nullptr);
+	REQUIRE(pool.nr_idle == TEST_POOL_CAPACITY - 1);
+	const vaccel_id_t id = sess->id;
+
+	SECTION("reuse")
+	{
+		const char *rundir = vaccel_session_rundir(sess);
+		REQUIRE(rundir != nullptr);
+		const std::string old_rundir = rundir;
+
+		/* Returned sessions are cleared and get a new id */
+		REQUIRE(vaccel_session_pool_put(&pool, sess) == VACCEL_OK);
+		REQUIRE(pool.nr_idle == TEST_POOL_CAPACITY);
+		REQUIRE(sess->id != id);
+		REQUIRE_FALSE(sess->rundir_created);
+		REQUIRE(access(old_rundir.c_str(), F_OK) != 0);
+
+		struct vaccel_session *found = nullptr;
+		REQUIRE(vaccel_session_get_by_id(&found, id) == VACCEL_ENOENT);
+		REQUIRE(vaccel_session_get_by_id(&found, sess->id) ==
+			VACCEL_OK);
+		REQUIRE(found == sess);
+
+		struct vaccel_session *reused = nullptr;
+		REQUIRE(vaccel_session_pool_get(&pool, &reused) == VACCEL_OK);
+		REQUIRE(reused == sess);
+		REQUIRE(vaccel_noop(reused) == VACCEL_OK);
+		sess = reused;
+	}
+
+	SECTION("registered resources")
+	{
+		char *lib_path =
+			abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+		struct vaccel_resource res;
+		REQUIRE(vaccel_resource_init(&res, lib_path,
+					     VACCEL_RESOURCE_LIB) == VACCEL_OK);
+		REQUIRE(vaccel_resource_register(&res, sess) == VACCEL_OK);
+
+		/* Resources are unregistered on put */
+		REQUIRE(vaccel_session_pool_put(&pool, sess) == VACCEL_OK);
+		REQUIRE_FALSE(vaccel_session_has_resource(sess, &res));
+		REQUIRE(vaccel_session_pool_get(&pool, &sess) == VACCEL_OK);
+
+		REQUIRE(vaccel_resource_release(&res) == VACCEL_OK);
+		free(lib_path);
+	}
+
+	SECTION("private data")
+	{
+		int data = 0;
+		sess->priv = &data;
+
+		/* Sessions with private data can't be reset and are deleted */
+		REQUIRE(vaccel_session_pool_put(&pool, sess) == VACCEL_OK);
+		REQUIRE(pool.nr_idle == TEST_POOL_CAPACITY - 1);
+		REQUIRE(vaccel_session_get_by_id(&sess, id) == VACCEL_ENOENT);
+		REQUIRE(vaccel_session_pool_get(&pool, &sess) == VACCEL_OK);
+	}
+
+	SECTION("drained pool")
+	{
+		struct vaccel_session *extra[TEST_POOL_CAPACITY];
+		for (auto &e : extra)
+			REQUIRE(vaccel_session_pool_get(&pool, &e) ==
+				VACCEL_OK);
+		REQUIRE(pool.nr_idle == 0);
+
+		/* Sessions past the capacity are deleted on put */
+		for (auto &e : extra)
+			REQUIRE(vaccel_session_pool_put(&pool, e) ==
+				VACCEL_OK);
+		REQUIRE(pool.nr_idle == TEST_POOL_CAPACITY);
+		REQUIRE(vaccel_session_pool_put(&pool, sess) == VACCEL_OK);
+		REQUIRE(pool.nr_idle == TEST_POOL_CAPACITY);
+		REQUIRE(vaccel_session_get_by_id(&sess, id) == VACCEL_ENOENT);
+		REQUIRE(vaccel_session_pool_get(&pool, &sess) == VACCEL_OK);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_session_pool_get(nullptr, &sess) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_session_pool_get(&pool, nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_session_pool_put(nullptr, sess) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_session_pool_put(&pool, nullptr) ==
+			VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_session_pool_put(&pool, sess) == VACCEL_OK);
+	REQUIRE(vaccel_session_pool_release(&pool) == VACCEL_OK);
+}
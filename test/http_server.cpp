@@ -0,0 +1,159 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#include "http_server.hpp"
+#include <arpa/inet.h>
+#include <cstddef>
+#include <netinet/in.h>
+#include <stdexcept>
+#include <string>
+#include <sys/socket.h>
+#include <unistd.h>
+
+HttpServer::HttpServer()
+{
+	listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+	if (listen_fd < 0)
+		throw std::runtime_error("Could not create server socket");
+
+	struct sockaddr_in addr = {};
+	addr.sin_family = AF_INET;
+	addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+	addr.sin_port = 0;
+
+	socklen_t len = sizeof(addr);
+	if (bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0 ||
+	    listen(listen_fd, 16) != 0 ||
+	    getsockname(listen_fd, (struct sockaddr *)&addr, &len) != 0) {
+		close(listen_fd);
+		throw std::runtime_error("Could not set up server socket");
+	}
+	port = ntohs(addr.sin_port);
+
+	acceptor = std::thread([this] { accept_loop(); });
+}
+
+HttpServer::~HttpServer()
+{
+	shutdown(listen_fd, SHUT_RDWR);
+	close(listen_fd);
+	acceptor.join();
+
+	std::lock_guard<std::mutex> const lock(mutex);
+	for (auto &fd : connection_fds)
+		shutdown(fd, SHUT_RDWR);
+	for (auto &t : connections)
+		t.join();
+	for (auto &fd : connection_fds)
+		close(fd);
+}
+
+auto HttpServer::url(const char *path) const -> std::string
+{
+	return "http://127.0.0.1:" + std::to_string(port) + path;
+}
+
+auto HttpServer::content(const std::string &path) const -> std::string
+{
+	int const v = version;
+	return (v != 0) ? path + "@" + std::to_string(v) : path;
+}
+
+void HttpServer::modify()
+{
+	version++;
+}
+
+void HttpServer::accept_loop()
+{
+	while (true) {
+		int const fd = accept(listen_fd, nullptr, nullptr);
+		if (fd < 0)
+			return;
+
+		nr_connections++;
+		std::lock_guard<std::mutex> const lock(mutex);
+		connection_fds.push_back(fd);
+		connections.emplace_back([this, fd] { serve(fd); });
+	}
+}
+
+void HttpServer::serve(int fd)
+{
+	std::string buf;
+	char chunk[1024];
+
+	while (true) {
+		size_t const end = buf.find("\r\n\r\n");
+		if (end == std::string::npos) {
+			ssize_t const n = recv(fd, chunk, sizeof(chunk), 0);
+			if (n <= 0)
+				return;
+			buf.append(chunk, (size_t)n);
+			continue;
+		}
+
+		std::string const request = buf.substr(0, end);
+		buf.erase(0, end + 4);
+		nr_requests++;
+
+		std::string const response = respond(request);
+		if (send(fd, response.data(), response.size(), MSG_NOSIGNAL) <
+		    0)
+			return;
+	}
+}
+
+static auto header_value(const std::string &request, const std::string &name)
+	-> std::string
+{
+	size_t const pos = request.find("\r\n" + name + ": ");
+	if (pos == std::string::npos)
+		return "";
+
+	size_t const start = pos + name.size() + 4;
+	size_t const end = request.find("\r\n", start);
+	return request.substr(start, end - start);
+}
+
+auto HttpServer::respond(const std::string &request) -> std::string
+{
+	size_t const start = request.find(' ') + 1;
+	std::string const path =
+		request.substr(start, request.find(' ', start) - start);
+
+	if (path.rfind("/missing", 0) == 0)
+		return "HTTP/1.1 404 Not Found\r\n"
+		       "Content-Length: 0\r\n\r\n";
+
+	std::string headers;
+	if (path.rfind("/novalidators", 0) != 0) {
+		int const v = version;
+		std::string const etag = "\"v" + std::to_string(v) + "\"";
+		std::string const last_modified =
+			"Thu, 0" + std::to_string(1 + v % 9) +
+			" Jan 2026 00:00:00 GMT";
+
+		/* If-None-Match takes precedence when both are sent */
+		std::string const if_none_match =
+			header_value(request, "If-None-Match");
+		bool const not_modified =
+			!if_none_match.empty() ?
+				if_none_match == etag :
+				header_value(request, "If-Modified-Since") ==
+					last_modified;
+		if (not_modified) {
+			nr_not_modified++;
+			return "HTTP/1.1 304 Not Modified\r\n"
+			       "ETag: " +
+			       etag + "\r\n\r\n";
+		}
+
+		headers = "ETag: " + etag + "\r\nLast-Modified: " +
+			  last_modified + "\r\n";
+	}
+
+	std::string const body = content(path);
+	return "HTTP/1.1 200 OK\r\n" + headers +
+	       "Content-Length: " + std::to_string(body.size()) + "\r\n\r\n" +
+	       body;
+}
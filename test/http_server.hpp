@@ -0,0 +1,50 @@
+// SPDX-License-Identifier: Apache-2.0
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+/* A minimal HTTP/1.1 server with keep-alive, standing in for an artifact
+ * server on the loopback interface. Files are served with their path as
+ * content, along with ETag and Last-Modified validators that are honored in
+ * conditional requests. Paths starting with `/missing` are not found and ones
+ * starting with `/novalidators` are served without validators. */
+class HttpServer {
+    public:
+	HttpServer();
+	~HttpServer();
+
+	HttpServer(const HttpServer &) = delete;
+	auto operator=(const HttpServer &) -> HttpServer & = delete;
+
+	[[nodiscard]] auto url(const char *path) const -> std::string;
+
+	/* Content of a path for the current version of the files */
+	[[nodiscard]] auto content(const std::string &path) const
+		-> std::string;
+
+	/* Change all files, and with them their validators */
+	void modify();
+
+	std::atomic<int> nr_connections{ 0 };
+	std::atomic<int> nr_requests{ 0 };
+	std::atomic<int> nr_not_modified{ 0 };
+
+    private:
+	void accept_loop();
+	void serve(int fd);
+	auto respond(const std::string &request) -> std::string;
+
+	int listen_fd;
+	uint16_t port;
+	std::atomic<int> version{ 0 };
+	std::thread acceptor;
+	std::mutex mutex;
+	std::vector<int> connection_fds;
+	std::vector<std::thread> connections;
+};
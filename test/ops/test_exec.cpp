@@ -4,8 +4,8 @@
  * Unit Testing for exec
  *
  * The code below performs unit testing for VAccel library executions.
- * It includes test cases for the `exec`, `exec_generic`, and
- * `exec_with_resources` functions.
+ * It includes test cases for the `exec`, `exec_generic`, `exec_generic_batch`
+ * and `exec_with_resources` functions.
  *
  */
 
@@ -15,6 +15,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <vector>
 
 // TODO: Add arg_helpers tests
 
@@ -52,6 +53,47 @@ TEST_CASE("exec", "[ops][exec]")
 	free(lib_path);
 }
 
+TEST_CASE("exec_prepared", "[ops][exec]")
+{
+	int ret;
+	int32_t input = 10;
+	int32_t output = 0;
+	struct vaccel_session sess;
+	struct vaccel_op_handle handle;
+
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+	REQUIRE(vaccel_op_prepare(&sess, VACCEL_OP_EXEC, &handle) ==
+		VACCEL_OK);
+
+	struct vaccel_arg_array read_args;
+	struct vaccel_arg_array write_args;
+	REQUIRE(vaccel_arg_array_init(&read_args, 1) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_init(&write_args, 1) == VACCEL_OK);
+
+	REQUIRE(vaccel_arg_array_add_int32(&read_args, &input) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_int32(&write_args, &output) == VACCEL_OK);
+
+	char *lib_path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	const char function_name[] = "mytestfunc";
+
+	for (int i = 0; i < 2; i++) {
+		output = 0;
+		ret = vaccel_op_call_exec(&handle, lib_path, function_name,
+					  read_args.args, read_args.count,
+					  write_args.args, write_args.count);
+		REQUIRE(ret == VACCEL_OK);
+		if (strcmp(sess.plugin->info->name, "noop") == 0)
+			REQUIRE(output == input);
+		else
+			REQUIRE(output == 2 * input);
+	}
+
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_release(&read_args) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_release(&write_args) == VACCEL_OK);
+	free(lib_path);
+}
+
 TEST_CASE("exec_generic", "[ops][exec]")
 {
 	int ret;
@@ -92,6 +134,89 @@ TEST_CASE("exec_generic", "[ops][exec]")
 	free(lib_path);
 }
 
+TEST_CASE("exec_generic_batch", "[ops][exec]")
+{
+	const size_t nr_reqs = 8;
+	int32_t input = 10;
+	std::vector<int32_t> outputs(nr_reqs, 0);
+	std::vector<struct vaccel_arg> write(nr_reqs);
+	std::vector<struct vaccel_genop_req> reqs(nr_reqs);
+	struct vaccel_session sess;
+
+	REQUIRE(vaccel_session_init(&sess, 0) == VACCEL_OK);
+
+	char *lib_path = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	const char function_name[] = "mytestfunc";
+
+	struct vaccel_arg_array read_args;
+	REQUIRE(vaccel_arg_array_init(&read_args, 4) == VACCEL_OK);
+
+	auto op_type = (uint8_t)VACCEL_OP_EXEC;
+	REQUIRE(vaccel_arg_array_add_uint8(&read_args, &op_type) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_string(&read_args, lib_path) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_string(
+			&read_args, (char *)function_name) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_add_int32(&read_args, &input) == VACCEL_OK);
+
+	for (size_t i = 0; i < nr_reqs; i++) {
+		REQUIRE(vaccel_arg_init_from_buf(&write[i], &outputs[i],
+						 sizeof(outputs[i]),
+						 VACCEL_ARG_INT32,
+						 0) == VACCEL_OK);
+		reqs[i].read = read_args.args;
+		reqs[i].nr_read = (int)read_args.count;
+		reqs[i].write = &write[i];
+		reqs[i].nr_write = 1;
+		reqs[i].ret = -1;
+	}
+
+	SECTION("success")
+	{
+		REQUIRE(vaccel_genop_batch(&sess, reqs.data(), nr_reqs) ==
+			VACCEL_OK);
+		for (size_t i = 0; i < nr_reqs; i++) {
+			REQUIRE(reqs[i].ret == VACCEL_OK);
+			if (strcmp(sess.plugin->info->name, "noop") == 0)
+				REQUIRE(outputs[i] == input);
+			else
+				REQUIRE(outputs[i] == 2 * input);
+		}
+	}
+
+	SECTION("invalid request")
+	{
+		struct vaccel_arg bad_op = read_args.args[0];
+		auto bad_op_type = (uint8_t)VACCEL_OP_MAX;
+		bad_op.buf = &bad_op_type;
+		reqs[nr_reqs / 2].read = &bad_op;
+		reqs[nr_reqs / 2].nr_read = 1;
+
+		REQUIRE(vaccel_genop_batch(&sess, reqs.data(), nr_reqs) ==
+			VACCEL_EINVAL);
+		for (size_t i = 0; i < nr_reqs; i++) {
+			if (i == nr_reqs / 2)
+				REQUIRE(reqs[i].ret == VACCEL_EINVAL);
+			else
+				REQUIRE(reqs[i].ret == VACCEL_ECANCELED);
+			REQUIRE(outputs[i] == 0);
+		}
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(vaccel_genop_batch(nullptr, reqs.data(), nr_reqs) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_genop_batch(&sess, nullptr, nr_reqs) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_genop_batch(&sess, reqs.data(), 0) ==
+			VACCEL_EINVAL);
+	}
+
+	REQUIRE(vaccel_session_release(&sess) == VACCEL_OK);
+	REQUIRE(vaccel_arg_array_release(&read_args) == VACCEL_OK);
+	free(lib_path);
+}
+
 TEST_CASE("exec_with_resource", "[ops][exec]")
 {
 	int32_t input = 10;
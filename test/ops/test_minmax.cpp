@@ -19,6 +19,7 @@
 #include <cstdint>
 #include <cstdio>
 #include <cstdlib>
+#include <cstring>
 
 TEST_CASE("min_max", "[ops][minmax]")
 {
@@ -145,6 +146,30 @@ TEST_CASE("min_max_generic", "[ops][minmax]")
 	ret = vaccel_genop(&session, &read[0], 5, &write[0], 3);
 	REQUIRE(ret == VACCEL_OK);
 
+	/* A batched request with truncated data fails on its own */
+	if (strcmp(session.plugin->info->name, "noop") == 0) {
+		struct vaccel_arg bad_read[5];
+		memcpy(bad_read, read, sizeof(read));
+		bad_read[1].size = sizeof(double);
+
+		struct vaccel_genop_req reqs[2] = {
+			{ .read = &read[0],
+			  .nr_read = 5,
+			  .write = &write[0],
+			  .nr_write = 3,
+			  .ret = -1 },
+			{ .read = &bad_read[0],
+			  .nr_read = 5,
+			  .write = &write[0],
+			  .nr_write = 3,
+			  .ret = -1 },
+		};
+		REQUIRE(vaccel_genop_batch(&session, reqs, 2) ==
+			VACCEL_EINVAL);
+		REQUIRE(reqs[0].ret == VACCEL_OK);
+		REQUIRE(reqs[1].ret == VACCEL_EINVAL);
+	}
+
 	REQUIRE(vaccel_session_release(&session) == VACCEL_OK);
 
 	ret = fclose(fp);
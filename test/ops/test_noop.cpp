@@ -26,3 +26,43 @@ TEST_CASE("noop", "[ops][noop]")
 	ret = vaccel_session_release(&sess);
 	REQUIRE(ret == VACCEL_OK);
 }
+
+TEST_CASE("noop_prepared", "[ops][noop]")
+{
+	int ret;
+	struct vaccel_session sess;
+	struct vaccel_op_handle handle;
+
+	ret = vaccel_session_init(&sess, 0);
+	REQUIRE(ret == VACCEL_OK);
+
+	ret = vaccel_op_prepare(&sess, VACCEL_OP_NOOP, &handle);
+	REQUIRE(ret == VACCEL_OK);
+	REQUIRE(handle.sess == &sess);
+	REQUIRE(handle.type == VACCEL_OP_NOOP);
+	REQUIRE(handle.func != nullptr);
+
+	for (int i = 0; i < 10; i++) {
+		ret = vaccel_op_call_noop(&handle);
+		REQUIRE(ret == VACCEL_OK);
+	}
+
+	SECTION("invalid arguments")
+	{
+		struct vaccel_op_handle exec_handle;
+		REQUIRE(vaccel_op_prepare(nullptr, VACCEL_OP_NOOP, &handle) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_op_prepare(&sess, VACCEL_OP_NOOP, nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_op_prepare(&sess, VACCEL_OP_MAX, &handle) ==
+			VACCEL_EINVAL);
+		REQUIRE(vaccel_op_call_noop(nullptr) == VACCEL_EINVAL);
+
+		REQUIRE(vaccel_op_prepare(&sess, VACCEL_OP_EXEC,
+					  &exec_handle) == VACCEL_OK);
+		REQUIRE(vaccel_op_call_noop(&exec_handle) == VACCEL_EINVAL);
+	}
+
+	ret = vaccel_session_release(&sess);
+	REQUIRE(ret == VACCEL_OK);
+}
@@ -13,6 +13,14 @@
  * 8)  fs_file_remove()
  * 9)  fs_file_read()
  * 10) fs_file_read_mmap()
+ * 11) fs_dir_remove_all()
+ * 12) fs_dir_list_files()
+ * 13) fs_file_mmap()
+ * 14) fs_file_readahead()
+ * 15) fs_file_write()
+ * 16) fs_file_copy()
+ * 17) fs_file_clone()
+ * 18) fs_files_mmap()
  *
  */
 
@@ -21,12 +29,19 @@
 #include "utils.hpp"
 #include "vaccel.h"
 #include <catch2/catch_test_macros.hpp>
+#include <cerrno>
+#include <cinttypes>
 #include <cstdarg>
 #include <cstddef>
+#include <cstdint>
+#include <cstdio>
 #include <cstdlib>
 #include <cstring>
+#include <dirent.h>
 #include <linux/limits.h>
+#include <string>
 #include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 
 auto process_files_callback(const char *path, int idx, va_list args) -> int
@@ -248,6 +263,28 @@ TEST_CASE("fs_ops", "[utils][fs]")
 		}
 	}
 
+	SECTION("List dir files (2)")
+	{
+		char **files;
+		size_t nr_files;
+		REQUIRE(fs_dir_list_files(dirpath, &files, &nr_files) ==
+			VACCEL_OK);
+		REQUIRE(nr_files == 2);
+		for (size_t i = 0; i < nr_files; i++) {
+			REQUIRE((strcmp(files[i], filepath1) == 0 ||
+				 strcmp(files[i], filepath2) == 0));
+			free(files[i]);
+		}
+		free(files);
+
+		REQUIRE(fs_dir_list_files(nullptr, &files, &nr_files) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_dir_list_files(dirpath, nullptr, &nr_files) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_dir_list_files(dirpath, &files, nullptr) ==
+			VACCEL_EINVAL);
+	}
+
 	SECTION("Remove files")
 	{
 		REQUIRE(fs_file_remove(filepath1) == VACCEL_OK);
@@ -383,3 +420,271 @@ TEST_CASE("fs_file_read", "[utils][fs]")
 	free(std_handle);
 	free(existing_file);
 }
+
+/* Get the permissions of the mapping containing ptr from /proc/self/maps */
+static auto mapping_perms(const void *ptr) -> std::string
+{
+	FILE *fp = fopen("/proc/self/maps", "r");
+	if (fp == nullptr)
+		return "";
+
+	std::string perms;
+	char line[PATH_MAX + 128];
+	while (fgets(line, sizeof(line), fp) != nullptr) {
+		uintptr_t start;
+		uintptr_t end;
+		char p[5];
+		if (sscanf(line, "%" SCNxPTR "-%" SCNxPTR " %4s", &start, &end,
+			   p) == 3 &&
+		    start <= (uintptr_t)ptr && (uintptr_t)ptr < end) {
+			perms = p;
+			break;
+		}
+	}
+	fclose(fp);
+
+	return perms;
+}
+
+/* Get the number of open file descriptors of the process */
+static auto nr_open_fds() -> size_t
+{
+	DIR *dir = opendir("/proc/self/fd");
+	if (dir == nullptr)
+		return 0;
+
+	size_t nr = 0;
+	while (readdir(dir) != nullptr)
+		nr++;
+	closedir(dir);
+
+	return nr;
+}
+
+TEST_CASE("fs_file_mmap", "[utils][fs]")
+{
+	char *existing_file = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	unsigned char *std_handle;
+	size_t std_size;
+
+	REQUIRE(fs_file_read(existing_file, (void **)&std_handle, &std_size) ==
+		VACCEL_OK);
+
+	unsigned char *mmap_handle;
+	size_t mmap_size;
+
+	SECTION("private")
+	{
+		REQUIRE(fs_file_mmap(existing_file, 0, (void **)&mmap_handle,
+				     &mmap_size) == VACCEL_OK);
+		REQUIRE(mmap_size == std_size);
+		REQUIRE(memcmp(mmap_handle, std_handle, std_size) == 0);
+		REQUIRE(mapping_perms(mmap_handle) == "rw-p");
+		REQUIRE(munmap(mmap_handle, mmap_size) == 0);
+	}
+
+	SECTION("shared with hints")
+	{
+		unsigned int const flags = FS_MMAP_SHARED | FS_MMAP_POPULATE |
+					   FS_MMAP_WILLNEED |
+					   FS_MMAP_SEQUENTIAL |
+					   FS_MMAP_HUGEPAGE;
+		REQUIRE(fs_file_mmap(existing_file, flags,
+				     (void **)&mmap_handle,
+				     &mmap_size) == VACCEL_OK);
+		REQUIRE(mmap_size == std_size);
+		REQUIRE(memcmp(mmap_handle, std_handle, std_size) == 0);
+		REQUIRE(mapping_perms(mmap_handle) == "r--s");
+		REQUIRE(munmap(mmap_handle, mmap_size) == 0);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(fs_file_mmap(nullptr, 0, (void **)&mmap_handle,
+				     &mmap_size) == VACCEL_EINVAL);
+		REQUIRE(fs_file_mmap(existing_file, 0, nullptr, &mmap_size) ==
+			VACCEL_EINVAL);
+	}
+
+	free(std_handle);
+	free(existing_file);
+}
+
+TEST_CASE("fs_files_mmap", "[utils][fs]")
+{
+	char *existing_file = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	char *non_existing_file =
+		abs_path(BUILD_ROOT, "examples/libmytestlib.so.not");
+	unsigned char *std_handle;
+	size_t std_size;
+
+	REQUIRE(fs_file_read(existing_file, (void **)&std_handle, &std_size) ==
+		VACCEL_OK);
+
+	/* More than the files batched at once */
+	const size_t nr_files = 40;
+	const char *paths[nr_files];
+	unsigned int flags[nr_files];
+	void *data[nr_files];
+	size_t sizes[nr_files];
+	for (size_t i = 0; i < nr_files; i++) {
+		paths[i] = existing_file;
+		flags[i] = (i % 2) ? FS_MMAP_SHARED : 0;
+	}
+
+	SECTION("map")
+	{
+		REQUIRE(fs_files_mmap(paths, nr_files, flags, data, sizes) ==
+			VACCEL_OK);
+		for (size_t i = 0; i < nr_files; i++) {
+			REQUIRE(sizes[i] == std_size);
+			REQUIRE(memcmp(data[i], std_handle, std_size) == 0);
+			REQUIRE(mapping_perms(data[i]) ==
+				((i % 2) ? "r--s" : "rw-p"));
+			REQUIRE(munmap(data[i], sizes[i]) == 0);
+		}
+	}
+
+	SECTION("missing file")
+	{
+		/* Files opened before the failure are closed */
+		const size_t nr_fds = nr_open_fds();
+		paths[nr_files - 1] = non_existing_file;
+		REQUIRE(fs_files_mmap(paths, nr_files, flags, data, sizes) ==
+			ENOENT);
+		REQUIRE(nr_open_fds() == nr_fds);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(fs_files_mmap(nullptr, nr_files, flags, data, sizes) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_files_mmap(paths, 0, flags, data, sizes) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_files_mmap(paths, nr_files, nullptr, data, sizes) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_files_mmap(paths, nr_files, flags, nullptr, sizes) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_files_mmap(paths, nr_files, flags, data, nullptr) ==
+			VACCEL_EINVAL);
+		paths[0] = nullptr;
+		REQUIRE(fs_files_mmap(paths, nr_files, flags, data, sizes) ==
+			VACCEL_EINVAL);
+	}
+
+	free(std_handle);
+	free(non_existing_file);
+	free(existing_file);
+}
+
+TEST_CASE("fs_file_readahead", "[utils][fs]")
+{
+	char *existing_file = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	char *non_existing_file =
+		abs_path(BUILD_ROOT, "examples/libmytestlib.so.not");
+
+	REQUIRE(fs_file_readahead(existing_file) == VACCEL_OK);
+	REQUIRE(fs_file_readahead(non_existing_file) == ENOENT);
+	REQUIRE(fs_file_readahead(nullptr) == VACCEL_EINVAL);
+
+	free(non_existing_file);
+	free(existing_file);
+}
+
+TEST_CASE("fs_file_copy", "[utils][fs]")
+{
+	char *existing_file = abs_path(BUILD_ROOT, "examples/libmytestlib.so");
+	char rootpath[PATH_MAX];
+	char copypath[PATH_MAX];
+	char clonepath[PATH_MAX];
+	char writepath[PATH_MAX];
+	unsigned char *src_data;
+	size_t src_size;
+	unsigned char *data;
+	size_t size;
+	struct stat src_st;
+	struct stat st;
+
+	REQUIRE(path_init_from_parts(rootpath, PATH_MAX, vaccel_rundir(),
+				     "test_copy", nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(copypath, PATH_MAX, rootpath, "copy",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(clonepath, PATH_MAX, rootpath, "clone",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(writepath, PATH_MAX, rootpath, "write",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(fs_dir_create(rootpath) == VACCEL_OK);
+	REQUIRE(fs_file_read(existing_file, (void **)&src_data, &src_size) ==
+		VACCEL_OK);
+
+	/* Copies get storage of their own */
+	REQUIRE(fs_file_copy(existing_file, copypath) == VACCEL_OK);
+	REQUIRE(fs_file_read(copypath, (void **)&data, &size) == VACCEL_OK);
+	REQUIRE(size == src_size);
+	REQUIRE(memcmp(data, src_data, size) == 0);
+	free(data);
+	REQUIRE(stat(existing_file, &src_st) == 0);
+	REQUIRE(stat(copypath, &st) == 0);
+	REQUIRE(st.st_ino != src_st.st_ino);
+	REQUIRE(fs_file_copy(existing_file, copypath) == VACCEL_EEXIST);
+
+	/* while clones within a filesystem are hardlinks */
+	REQUIRE(fs_file_clone(copypath, clonepath) == VACCEL_OK);
+	REQUIRE(stat(copypath, &src_st) == 0);
+	REQUIRE(stat(clonepath, &st) == 0);
+	REQUIRE(st.st_ino == src_st.st_ino);
+	REQUIRE(fs_file_clone(copypath, clonepath) == VACCEL_EEXIST);
+
+	int fd;
+	REQUIRE(fs_file_create(writepath, &fd) == VACCEL_OK);
+	REQUIRE(fs_file_write(fd, src_data, src_size) == VACCEL_OK);
+	close(fd);
+	REQUIRE(fs_file_read(writepath, (void **)&data, &size) == VACCEL_OK);
+	REQUIRE(size == src_size);
+	REQUIRE(memcmp(data, src_data, size) == 0);
+	free(data);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(fs_file_copy(nullptr, copypath) == VACCEL_EINVAL);
+		REQUIRE(fs_file_copy(existing_file, nullptr) == VACCEL_EINVAL);
+		REQUIRE(fs_file_clone(nullptr, clonepath) == VACCEL_EINVAL);
+		REQUIRE(fs_file_clone(existing_file, nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(fs_file_write(-1, src_data, src_size) ==
+			VACCEL_EINVAL);
+	}
+
+	REQUIRE(fs_dir_remove_all(rootpath) == VACCEL_OK);
+	free(src_data);
+	free(existing_file);
+}
+
+TEST_CASE("fs_dir_remove_all", "[utils][fs]")
+{
+	char rootpath[PATH_MAX];
+	char subpath[PATH_MAX];
+	char filepath[PATH_MAX];
+
+	REQUIRE(path_init_from_parts(rootpath, PATH_MAX, vaccel_rundir(),
+				     "test_remove_all", nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(subpath, PATH_MAX, rootpath, "a", "b",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(fs_dir_create(subpath) == VACCEL_OK);
+
+	REQUIRE(path_init_from_parts(filepath, PATH_MAX, rootpath, "file",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(fs_file_create(filepath, nullptr) == VACCEL_OK);
+	REQUIRE(path_init_from_parts(filepath, PATH_MAX, subpath, "file",
+				     nullptr) == VACCEL_OK);
+	REQUIRE(fs_file_create(filepath, nullptr) == VACCEL_OK);
+
+	REQUIRE(fs_dir_remove_all(rootpath) == VACCEL_OK);
+	REQUIRE_FALSE(fs_path_exists(rootpath));
+
+	SECTION("Invalid arguments")
+	{
+		REQUIRE(fs_dir_remove_all(nullptr) == VACCEL_EINVAL);
+		REQUIRE(fs_dir_remove_all(rootpath) == ENOENT);
+	}
+}
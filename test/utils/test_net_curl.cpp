@@ -6,14 +6,22 @@
  * 1) net_path_is_url()
  * 2) net_path_exists()
  * 3) net_file_download()
+ * 4) net_files_download()
+ * 5) net_files_download_to_buf()
  *
  */
 
+#include "http_server.hpp"
 #include "utils.hpp"
 #include "vaccel.h"
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
 #include <fff.h>
 #include <linux/limits.h>
+#include <string>
 
 DEFINE_FFF_GLOBALS;
 
@@ -21,6 +29,10 @@ extern "C" {
 FAKE_VALUE_FUNC(bool, net_nocurl_path_is_url, const char *);
 FAKE_VALUE_FUNC(bool, net_nocurl_path_exists, const char *);
 FAKE_VALUE_FUNC(int, net_nocurl_file_download, const char *, const char *);
+FAKE_VALUE_FUNC(int, net_nocurl_files_download, const char **, const char **,
+		size_t);
+FAKE_VALUE_FUNC(int, net_nocurl_files_download_to_buf, const char **,
+		uint8_t **, size_t *, size_t);
 }
 
 TEST_CASE("net_path_is_url", "[utils][net][curl]")
@@ -201,3 +213,162 @@ TEST_CASE("net_file_download", "[utils][net][curl]")
 
 	REQUIRE(fs_dir_remove(root_path) == VACCEL_OK);
 }
+
+TEST_CASE("net_files_download", "[utils][net][curl]")
+{
+	RESET_FAKE(net_nocurl_files_download);
+
+	enum { NR_FILES = 8 };
+	char root_path[PATH_MAX];
+	char download_paths[NR_FILES][PATH_MAX];
+	std::string urls[NR_FILES];
+	const char *url_ptrs[NR_FILES];
+	const char *download_ptrs[NR_FILES];
+
+	HttpServer server;
+
+	REQUIRE(path_init_from_parts(root_path, PATH_MAX, vaccel_rundir(),
+				     "test_files_download",
+				     nullptr) == VACCEL_OK);
+	int const ret = fs_dir_create(root_path);
+	REQUIRE((ret == VACCEL_OK || ret == VACCEL_EEXIST));
+
+	for (int i = 0; i < NR_FILES; i++) {
+		std::string const name = "file" + std::to_string(i);
+		urls[i] = server.url(("/" + name).c_str());
+		url_ptrs[i] = urls[i].c_str();
+		REQUIRE(path_init_from_parts(download_paths[i], PATH_MAX,
+					     root_path, name.c_str(),
+					     nullptr) == VACCEL_OK);
+		download_ptrs[i] = download_paths[i];
+	}
+
+	SECTION("all files exist")
+	{
+		net_nocurl_files_download_fake.return_val = VACCEL_OK;
+		REQUIRE(net_files_download(url_ptrs, download_ptrs,
+					   NR_FILES) == VACCEL_OK);
+#ifdef USE_LIBCURL
+		for (int i = 0; i < NR_FILES; i++) {
+			char *data;
+			size_t size;
+			REQUIRE(fs_file_read(download_paths[i], (void **)&data,
+					     &size) == VACCEL_OK);
+			std::string const expected =
+				"/file" + std::to_string(i);
+			REQUIRE(std::string(data, size) == expected);
+			free(data);
+			REQUIRE(fs_file_remove(download_paths[i]) ==
+				VACCEL_OK);
+		}
+
+		/* Files are fetched over a bounded set of reused
+		 * connections */
+		REQUIRE(server.nr_requests == NR_FILES);
+		REQUIRE(server.nr_connections <= 6);
+		REQUIRE(net_nocurl_files_download_fake.call_count == 0);
+#else
+		// emulate net_curl_files_download()
+		REQUIRE(net_nocurl_files_download_fake.call_count == 1);
+#endif
+	}
+
+	SECTION("a file doesn't exist")
+	{
+		std::string const missing = server.url("/missing");
+		url_ptrs[NR_FILES - 1] = missing.c_str();
+
+		net_nocurl_files_download_fake.return_val = VACCEL_EREMOTEIO;
+		REQUIRE(net_files_download(url_ptrs, download_ptrs,
+					   NR_FILES) == VACCEL_EREMOTEIO);
+
+		/* No file is left behind */
+		for (auto &path : download_paths)
+			REQUIRE_FALSE(fs_path_exists(path));
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(net_files_download(nullptr, download_ptrs, NR_FILES) ==
+			VACCEL_EINVAL);
+		REQUIRE(net_files_download(url_ptrs, nullptr, NR_FILES) ==
+			VACCEL_EINVAL);
+		REQUIRE(net_files_download(url_ptrs, download_ptrs, 0) ==
+			VACCEL_EINVAL);
+
+		/* Files can't be downloaded to the same path */
+		download_ptrs[1] = download_ptrs[0];
+		REQUIRE(net_files_download(url_ptrs, download_ptrs,
+					   NR_FILES) == VACCEL_EEXIST);
+		REQUIRE(net_nocurl_files_download_fake.call_count == 0);
+	}
+
+	REQUIRE(fs_dir_remove(root_path) == VACCEL_OK);
+}
+
+TEST_CASE("net_files_download_to_buf", "[utils][net][curl]")
+{
+	RESET_FAKE(net_nocurl_files_download_to_buf);
+
+	enum { NR_FILES = 4 };
+	std::string urls[NR_FILES];
+	const char *url_ptrs[NR_FILES];
+	uint8_t *data[NR_FILES] = {};
+	size_t sizes[NR_FILES] = {};
+
+	HttpServer server;
+
+	for (int i = 0; i < NR_FILES; i++) {
+		urls[i] = server.url(("/file" + std::to_string(i)).c_str());
+		url_ptrs[i] = urls[i].c_str();
+	}
+
+	SECTION("all files exist")
+	{
+		net_nocurl_files_download_to_buf_fake.return_val = VACCEL_OK;
+		REQUIRE(net_files_download_to_buf(url_ptrs, data, sizes,
+						  NR_FILES) == VACCEL_OK);
+#ifdef USE_LIBCURL
+		for (int i = 0; i < NR_FILES; i++) {
+			std::string const expected =
+				"/file" + std::to_string(i);
+			REQUIRE(std::string((char *)data[i], sizes[i]) ==
+				expected);
+			free(data[i]);
+		}
+		REQUIRE(net_nocurl_files_download_to_buf_fake.call_count ==
+			0);
+#else
+		// emulate net_curl_files_download_to_buf()
+		REQUIRE(net_nocurl_files_download_to_buf_fake.call_count == 1);
+#endif
+	}
+
+	SECTION("a file doesn't exist")
+	{
+		std::string const missing = server.url("/missing");
+		url_ptrs[NR_FILES - 1] = missing.c_str();
+
+		net_nocurl_files_download_to_buf_fake.return_val =
+			VACCEL_EREMOTEIO;
+		REQUIRE(net_files_download_to_buf(url_ptrs, data, sizes,
+						  NR_FILES) == VACCEL_EREMOTEIO);
+
+		/* No buffer is returned */
+		for (auto *d : data)
+			REQUIRE(d == nullptr);
+	}
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(net_files_download_to_buf(nullptr, data, sizes,
+						  NR_FILES) == VACCEL_EINVAL);
+		REQUIRE(net_files_download_to_buf(url_ptrs, nullptr, sizes,
+						  NR_FILES) == VACCEL_EINVAL);
+		REQUIRE(net_files_download_to_buf(url_ptrs, data, nullptr,
+						  NR_FILES) == VACCEL_EINVAL);
+		REQUIRE(net_files_download_to_buf(url_ptrs, data, sizes, 0) ==
+			VACCEL_EINVAL);
+		REQUIRE(net_nocurl_files_download_to_buf_fake.call_count == 0);
+	}
+}
@@ -6,12 +6,14 @@
  * 1) net_path_is_url()
  * 2) net_path_exists()
  * 3) net_file_download()
+ * 4) net_file_download_to_buf()
  *
  */
 
 #include "utils.hpp"
 #include "vaccel.h"
 #include <catch2/catch_test_macros.hpp>
+#include <cstdint>
 #include <fff.h>
 #include <linux/limits.h>
 
@@ -21,6 +23,8 @@ extern "C" {
 FAKE_VALUE_FUNC(bool, net_curl_path_is_url, const char *);
 FAKE_VALUE_FUNC(bool, net_curl_path_exists, const char *);
 FAKE_VALUE_FUNC(int, net_curl_file_download, const char *, const char *);
+FAKE_VALUE_FUNC(int, net_curl_files_download_to_buf, const char **,
+		uint8_t **, size_t *, size_t);
 }
 
 TEST_CASE("net_path_is_url", "[utils][net][nocurl]")
@@ -191,3 +195,44 @@ TEST_CASE("net_file_download", "[utils][net][nocurl]")
 
 	REQUIRE(fs_dir_remove(root_path) == VACCEL_OK);
 }
+
+TEST_CASE("net_file_download_to_buf", "[utils][net][nocurl]")
+{
+	char url[PATH_MAX];
+	uint8_t *data = nullptr;
+	size_t size = 0;
+
+	REQUIRE(path_init_from_parts(url, PATH_MAX, REPO_RAWURL,
+				     "examples/models/torch/cnn_trace.pt",
+				     nullptr) == VACCEL_OK);
+
+	RESET_FAKE(net_curl_files_download_to_buf);
+
+	SECTION("url exists")
+	{
+		net_curl_files_download_to_buf_fake.return_val =
+			VACCEL_ENOTSUP;
+		REQUIRE(net_file_download_to_buf(url, &data, &size) ==
+			VACCEL_ENOTSUP);
+		REQUIRE(data == nullptr);
+#ifdef USE_LIBCURL
+		// emulate net_nocurl_files_download_to_buf()
+		REQUIRE(net_curl_files_download_to_buf_fake.call_count == 1);
+#else
+		REQUIRE(net_curl_files_download_to_buf_fake.call_count == 0);
+#endif
+	}
+
+	RESET_FAKE(net_curl_files_download_to_buf);
+
+	SECTION("invalid arguments")
+	{
+		REQUIRE(net_file_download_to_buf(nullptr, &data, &size) ==
+			VACCEL_EINVAL);
+		REQUIRE(net_file_download_to_buf(url, nullptr, &size) ==
+			VACCEL_EINVAL);
+		REQUIRE(net_file_download_to_buf(url, &data, nullptr) ==
+			VACCEL_EINVAL);
+		REQUIRE(net_curl_files_download_to_buf_fake.call_count == 0);
+	}
+}